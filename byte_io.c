@@ -0,0 +1,393 @@
+// Copyright © 2024-25 Mark Summerfield. All rights reserved.
+// License: GPL-3
+
+#include "byte_io.h"
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+
+static void put_le(ByteWriter* writer, uint64_t value, int n);
+static void put_be(ByteWriter* writer, uint64_t value, int n);
+static bool get_le(ByteReader* reader, int n, uint64_t* value);
+static bool get_be(ByteReader* reader, int n, uint64_t* value);
+static inline byte* put_uvarint(byte* p, uint64_t value);
+static inline const byte* get_uvarint(const byte* p, const byte* end,
+                                      uint64_t* value);
+static inline uint64_t zigzag(int64_t value);
+static inline int64_t unzigzag(uint64_t value);
+static bool get_vec_int(ByteReader* reader, VecInt* vec);
+static bool get_vec_str(ByteReader* reader, VecStr* vec);
+
+ByteWriter byte_writer(VecByte* vec) {
+    assert_notnull(vec);
+    return (ByteWriter){vec};
+}
+
+void byte_writer_reserve(ByteWriter* writer, ptrdiff_t n) {
+    assert_notnull(writer);
+    vec_byte_spare(writer->_vec, n);
+}
+
+void byte_writer_u8(ByteWriter* writer, uint8_t value) {
+    assert_notnull(writer);
+    vec_byte_push(writer->_vec, value);
+}
+
+void byte_writer_u16_le(ByteWriter* writer, uint16_t value) {
+    put_le(writer, value, 2);
+}
+
+void byte_writer_u16_be(ByteWriter* writer, uint16_t value) {
+    put_be(writer, value, 2);
+}
+
+void byte_writer_u32_le(ByteWriter* writer, uint32_t value) {
+    put_le(writer, value, 4);
+}
+
+void byte_writer_u32_be(ByteWriter* writer, uint32_t value) {
+    put_be(writer, value, 4);
+}
+
+void byte_writer_u64_le(ByteWriter* writer, uint64_t value) {
+    put_le(writer, value, 8);
+}
+
+void byte_writer_u64_be(ByteWriter* writer, uint64_t value) {
+    put_be(writer, value, 8);
+}
+
+void byte_writer_f64_le(ByteWriter* writer, double value) {
+    uint64_t bits;
+    memcpy(&bits, &value, 8);
+    put_le(writer, bits, 8);
+}
+
+void byte_writer_f64_be(ByteWriter* writer, double value) {
+    uint64_t bits;
+    memcpy(&bits, &value, 8);
+    put_be(writer, bits, 8);
+}
+
+void byte_writer_uvarint(ByteWriter* writer, uint64_t value) {
+    assert_notnull(writer);
+    byte* p = vec_byte_spare(writer->_vec, BYTE_VARINT_MAX);
+    vec_byte_commit(writer->_vec, put_uvarint(p, value) - p);
+}
+
+void byte_writer_varint(ByteWriter* writer, int64_t value) {
+    byte_writer_uvarint(writer, zigzag(value));
+}
+
+void byte_writer_raw(ByteWriter* writer, const void* data, ptrdiff_t n) {
+    assert_notnull(writer);
+    vec_byte_append(writer->_vec, data, n);
+}
+
+void byte_writer_bytes(ByteWriter* writer, const void* data, ptrdiff_t n) {
+    assert_notnull(writer);
+    assert(n >= 0 && "can't write a negative number of bytes");
+    byte* p = vec_byte_spare(writer->_vec, BYTE_VARINT_MAX + n);
+    byte* q = put_uvarint(p, n);
+    memcpy(q, data, n);
+    vec_byte_commit(writer->_vec, q + n - p);
+}
+
+void byte_writer_str(ByteWriter* writer, const char* s) {
+    assert_notnull(s);
+    byte_writer_bytes(writer, s, strlen(s));
+}
+
+void byte_writer_vec_int(ByteWriter* writer, const VecInt* vec) {
+    assert_notnull(writer);
+    assert_notnull(vec);
+    // An int's zigzag varint takes at most 5 bytes
+    byte* p = vec_byte_spare(writer->_vec,
+                             BYTE_VARINT_MAX + 5 * vec->_size);
+    byte* q = put_uvarint(p, vec->_size);
+    for (ptrdiff_t i = 0; i < vec->_size; ++i)
+        q = put_uvarint(q, zigzag(vec->_values[i]));
+    vec_byte_commit(writer->_vec, q - p);
+}
+
+void byte_writer_vec_str(ByteWriter* writer, const VecStr* vec) {
+    assert_notnull(writer);
+    assert_notnull(vec);
+    ptrdiff_t size = BYTE_VARINT_MAX;
+    for (ptrdiff_t i = 0; i < vec->_size; ++i)
+        size += BYTE_VARINT_MAX + vec_str_len(vec, i);
+    byte* p = vec_byte_spare(writer->_vec, size);
+    byte* q = put_uvarint(p, vec->_size);
+    for (ptrdiff_t i = 0; i < vec->_size; ++i) {
+        ptrdiff_t n = vec_str_len(vec, i);
+        q = put_uvarint(q, n);
+        memcpy(q, vec->_values[i], n);
+        q += n;
+    }
+    vec_byte_commit(writer->_vec, q - p);
+}
+
+ByteReader byte_reader(const byte* data, ptrdiff_t n) {
+    assert(n >= 0 && "can't read a negative number of bytes");
+    assert((data || !n) && "expected non-NULL data");
+    return (ByteReader){data, n, 0};
+}
+
+inline ptrdiff_t byte_reader_remaining(const ByteReader* reader) {
+    assert_notnull(reader);
+    return reader->_size - reader->_pos;
+}
+
+inline ptrdiff_t byte_reader_pos(const ByteReader* reader) {
+    assert_notnull(reader);
+    return reader->_pos;
+}
+
+bool byte_reader_u8(ByteReader* reader, uint8_t* value) {
+    assert_notnull(reader);
+    if (reader->_pos >= reader->_size)
+        return false;
+    *value = reader->_data[reader->_pos++];
+    return true;
+}
+
+bool byte_reader_u16_le(ByteReader* reader, uint16_t* value) {
+    uint64_t x;
+    if (!get_le(reader, 2, &x))
+        return false;
+    *value = x;
+    return true;
+}
+
+bool byte_reader_u16_be(ByteReader* reader, uint16_t* value) {
+    uint64_t x;
+    if (!get_be(reader, 2, &x))
+        return false;
+    *value = x;
+    return true;
+}
+
+bool byte_reader_u32_le(ByteReader* reader, uint32_t* value) {
+    uint64_t x;
+    if (!get_le(reader, 4, &x))
+        return false;
+    *value = x;
+    return true;
+}
+
+bool byte_reader_u32_be(ByteReader* reader, uint32_t* value) {
+    uint64_t x;
+    if (!get_be(reader, 4, &x))
+        return false;
+    *value = x;
+    return true;
+}
+
+bool byte_reader_u64_le(ByteReader* reader, uint64_t* value) {
+    return get_le(reader, 8, value);
+}
+
+bool byte_reader_u64_be(ByteReader* reader, uint64_t* value) {
+    return get_be(reader, 8, value);
+}
+
+bool byte_reader_f64_le(ByteReader* reader, double* value) {
+    uint64_t bits;
+    if (!get_le(reader, 8, &bits))
+        return false;
+    memcpy(value, &bits, 8);
+    return true;
+}
+
+bool byte_reader_f64_be(ByteReader* reader, double* value) {
+    uint64_t bits;
+    if (!get_be(reader, 8, &bits))
+        return false;
+    memcpy(value, &bits, 8);
+    return true;
+}
+
+bool byte_reader_uvarint(ByteReader* reader, uint64_t* value) {
+    assert_notnull(reader);
+    const byte* p = reader->_data + reader->_pos;
+    p = get_uvarint(p, reader->_data + reader->_size, value);
+    if (!p)
+        return false;
+    reader->_pos = p - reader->_data;
+    return true;
+}
+
+bool byte_reader_varint(ByteReader* reader, int64_t* value) {
+    uint64_t x;
+    if (!byte_reader_uvarint(reader, &x))
+        return false;
+    *value = unzigzag(x);
+    return true;
+}
+
+bool byte_reader_raw(ByteReader* reader, ptrdiff_t n, const byte** data) {
+    assert_notnull(reader);
+    if (n < 0 || n > reader->_size - reader->_pos)
+        return false;
+    *data = reader->_data + reader->_pos;
+    reader->_pos += n;
+    return true;
+}
+
+bool byte_reader_bytes(ByteReader* reader, const byte** data,
+                       ptrdiff_t* n) {
+    ptrdiff_t pos = byte_reader_pos(reader);
+    uint64_t size;
+    if (byte_reader_uvarint(reader, &size) &&
+        size <= (uint64_t)byte_reader_remaining(reader) &&
+        byte_reader_raw(reader, size, data)) {
+        *n = size;
+        return true;
+    }
+    reader->_pos = pos;
+    return false;
+}
+
+bool byte_reader_str(ByteReader* reader, const char** s, ptrdiff_t* n) {
+    return byte_reader_bytes(reader, (const byte**)s, n);
+}
+
+bool byte_reader_vec_int(ByteReader* reader, VecInt* vec) {
+    assert_notnull(reader);
+    assert_notnull(vec);
+    ptrdiff_t pos = reader->_pos;
+    ptrdiff_t size = vec->_size;
+    if (get_vec_int(reader, vec))
+        return true;
+    reader->_pos = pos;
+    vec_int_resize(vec, size, 0);
+    return false;
+}
+
+bool byte_reader_vec_str(ByteReader* reader, VecStr* vec) {
+    assert_notnull(reader);
+    assert_notnull(vec);
+    assert((vec->_ownership == Owns || vec->_packed) &&
+           "can only read into an owning or packed vec");
+    ptrdiff_t pos = reader->_pos;
+    ptrdiff_t size = vec->_size;
+    if (get_vec_str(reader, vec))
+        return true;
+    reader->_pos = pos;
+    vec_str_resize(vec, size, NULL);
+    return false;
+}
+
+static void put_le(ByteWriter* writer, uint64_t value, int n) {
+    assert_notnull(writer);
+    byte* p = vec_byte_spare(writer->_vec, n);
+    for (int i = 0; i < n; ++i)
+        p[i] = value >> (8 * i);
+    vec_byte_commit(writer->_vec, n);
+}
+
+static void put_be(ByteWriter* writer, uint64_t value, int n) {
+    assert_notnull(writer);
+    byte* p = vec_byte_spare(writer->_vec, n);
+    for (int i = 0; i < n; ++i)
+        p[i] = value >> (8 * (n - 1 - i));
+    vec_byte_commit(writer->_vec, n);
+}
+
+static bool get_le(ByteReader* reader, int n, uint64_t* value) {
+    assert_notnull(reader);
+    if (n > reader->_size - reader->_pos)
+        return false;
+    const byte* p = reader->_data + reader->_pos;
+    uint64_t x = 0;
+    for (int i = 0; i < n; ++i)
+        x |= (uint64_t)p[i] << (8 * i);
+    reader->_pos += n;
+    *value = x;
+    return true;
+}
+
+static bool get_be(ByteReader* reader, int n, uint64_t* value) {
+    assert_notnull(reader);
+    if (n > reader->_size - reader->_pos)
+        return false;
+    const byte* p = reader->_data + reader->_pos;
+    uint64_t x = 0;
+    for (int i = 0; i < n; ++i)
+        x = x << 8 | p[i];
+    reader->_pos += n;
+    *value = x;
+    return true;
+}
+
+// p must have room for BYTE_VARINT_MAX bytes.
+static inline byte* put_uvarint(byte* p, uint64_t value) {
+    for (; value >= 0x80; value >>= 7)
+        *p++ = value | 0x80;
+    *p++ = value;
+    return p;
+}
+
+// Returns where the uvarint at p ends, or NULL if it runs past end or is
+// too big.
+static inline const byte* get_uvarint(const byte* p, const byte* end,
+                                      uint64_t* value) {
+    uint64_t x = 0;
+    for (int shift = 0; shift < 64 && p < end; shift += 7) {
+        byte b = *p++;
+        if (shift == 63 && b > 1)
+            return NULL;
+        x |= (uint64_t)(b & 0x7F) << shift;
+        if (!(b & 0x80)) {
+            *value = x;
+            return p;
+        }
+    }
+    return NULL;
+}
+
+static inline uint64_t zigzag(int64_t value) {
+    return ((uint64_t)value << 1) ^ -((uint64_t)value >> 63);
+}
+
+static inline int64_t unzigzag(uint64_t value) {
+    return (int64_t)((value >> 1) ^ -(value & 1));
+}
+
+static bool get_vec_int(ByteReader* reader, VecInt* vec) {
+    uint64_t size;
+    // Each int takes at least a byte so a bigger size must be corrupt
+    if (!byte_reader_uvarint(reader, &size) ||
+        size > (uint64_t)byte_reader_remaining(reader))
+        return false;
+    vec_int_reserve(vec, vec->_size + size);
+    const byte* p = reader->_data + reader->_pos;
+    const byte* end = reader->_data + reader->_size;
+    for (uint64_t i = 0; i < size; ++i) {
+        uint64_t x;
+        if (!(p = get_uvarint(p, end, &x)))
+            return false;
+        int64_t value = unzigzag(x);
+        if (value < INT_MIN || value > INT_MAX)
+            return false;
+        vec_int_push(vec, value);
+    }
+    reader->_pos = p - reader->_data;
+    return true;
+}
+
+static bool get_vec_str(ByteReader* reader, VecStr* vec) {
+    uint64_t size;
+    if (!byte_reader_uvarint(reader, &size) ||
+        size > (uint64_t)byte_reader_remaining(reader))
+        return false;
+    vec_str_reserve(vec, vec->_size + size);
+    for (uint64_t i = 0; i < size; ++i) {
+        const char* s;
+        ptrdiff_t n;
+        if (!byte_reader_str(reader, &s, &n))
+            return false;
+        vec_str_push_n(vec, s, n);
+    }
+    return true;
+}
@@ -0,0 +1,142 @@
+// Copyright © 2024-25 Mark Summerfield. All rights reserved.
+// License: GPL-3
+#pragma once
+
+#include "cx.h"
+#include "vec_byte.h"
+#include "vec_int.h"
+#include "vec_str.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+// Binary serialization: a ByteWriter appends encoded values to a VecByte
+// and a ByteReader decodes them from a byte buffer (e.g., a VecByte's
+// values) from a cursor that advances past each value read.
+//
+// Fixed-width ints are little- (_le) or big-endian (_be); signed values
+// can be written and read by casting to and from the unsigned types.
+// Varints are LEB128 (7 bits per byte, least significant first), with
+// signed ints zigzag-encoded first so that small negative values are
+// short too. Doubles are their IEEE 754 bits as a u64. Strings and byte
+// runs are prefixed with their length as a uvarint.
+//
+// Each read returns true and sets its out value and advances the cursor,
+// or if the value is truncated or invalid, returns false and leaves the
+// cursor (and any vec being appended to) unchanged.
+//
+// ```
+// VecByte buf = vec_byte_alloc();
+// ByteWriter writer = byte_writer(&buf);
+// byte_writer_varint(&writer, -5);
+// byte_writer_str(&writer, "hello");
+// ByteReader reader = byte_reader(buf._values, VEC_SIZE(&buf));
+// int64_t i;
+// const char* s;
+// ptrdiff_t n;
+// if (byte_reader_varint(&reader, &i) && byte_reader_str(&reader, &s, &n))
+//     printf("%" PRId64 " %.*s\n", i, (int)n, s); // -5 hello
+// ```
+
+// The most bytes a uvarint or varint takes.
+#define BYTE_VARINT_MAX 10
+
+typedef struct ByteWriter {
+    VecByte* _vec; // borrowed
+} ByteWriter;
+
+typedef struct ByteReader {
+    const byte* _data; // borrowed
+    ptrdiff_t _size;
+    ptrdiff_t _pos;
+} ByteReader;
+
+// Returns a ByteWriter that appends to vec (which must outlive it).
+ByteWriter byte_writer(VecByte* vec);
+
+// Ensures that at least n more bytes can be written without
+// reallocating, e.g., before writing many small values.
+void byte_writer_reserve(ByteWriter* writer, ptrdiff_t n);
+
+void byte_writer_u8(ByteWriter* writer, uint8_t value);
+void byte_writer_u16_le(ByteWriter* writer, uint16_t value);
+void byte_writer_u16_be(ByteWriter* writer, uint16_t value);
+void byte_writer_u32_le(ByteWriter* writer, uint32_t value);
+void byte_writer_u32_be(ByteWriter* writer, uint32_t value);
+void byte_writer_u64_le(ByteWriter* writer, uint64_t value);
+void byte_writer_u64_be(ByteWriter* writer, uint64_t value);
+void byte_writer_f64_le(ByteWriter* writer, double value);
+void byte_writer_f64_be(ByteWriter* writer, double value);
+
+// Writes value in 1 to BYTE_VARINT_MAX bytes.
+void byte_writer_uvarint(ByteWriter* writer, uint64_t value);
+
+// Writes value zigzag-encoded (0, -1, 1, -2, ... as 0, 1, 2, 3, ...) as a
+// uvarint.
+void byte_writer_varint(ByteWriter* writer, int64_t value);
+
+// Writes the n bytes from data as is (with no length prefix).
+void byte_writer_raw(ByteWriter* writer, const void* data, ptrdiff_t n);
+
+// Writes n as a uvarint followed by the n bytes from data.
+void byte_writer_bytes(ByteWriter* writer, const void* data, ptrdiff_t n);
+
+// Writes the string's length as a uvarint followed by its chars (but not
+// its NUL).
+void byte_writer_str(ByteWriter* writer, const char* s);
+
+// Writes the vec's size as a uvarint followed by its values as varints,
+// reserving room for them all first.
+void byte_writer_vec_int(ByteWriter* writer, const VecInt* vec);
+
+// Writes the vec's size as a uvarint followed by its strings (as for
+// byte_writer_str()), reserving room for them all first.
+void byte_writer_vec_str(ByteWriter* writer, const VecStr* vec);
+
+// Returns a ByteReader of the n bytes at data (which must outlive it)
+// with its cursor at the start.
+ByteReader byte_reader(const byte* data, ptrdiff_t n);
+
+// Returns the number of bytes left to read.
+ptrdiff_t byte_reader_remaining(const ByteReader* reader);
+
+// Returns the cursor's position, i.e., the number of bytes read.
+ptrdiff_t byte_reader_pos(const ByteReader* reader);
+
+bool byte_reader_u8(ByteReader* reader, uint8_t* value);
+bool byte_reader_u16_le(ByteReader* reader, uint16_t* value);
+bool byte_reader_u16_be(ByteReader* reader, uint16_t* value);
+bool byte_reader_u32_le(ByteReader* reader, uint32_t* value);
+bool byte_reader_u32_be(ByteReader* reader, uint32_t* value);
+bool byte_reader_u64_le(ByteReader* reader, uint64_t* value);
+bool byte_reader_u64_be(ByteReader* reader, uint64_t* value);
+bool byte_reader_f64_le(ByteReader* reader, double* value);
+bool byte_reader_f64_be(ByteReader* reader, double* value);
+
+// Reads a uvarint, rejecting any longer than BYTE_VARINT_MAX bytes or
+// that don't fit a uint64_t.
+bool byte_reader_uvarint(ByteReader* reader, uint64_t* value);
+
+// Reads a zigzag-encoded varint.
+bool byte_reader_varint(ByteReader* reader, int64_t* value);
+
+// Sets data to point to the next n bytes (in the reader's buffer, so
+// they're not copied) and skips past them.
+bool byte_reader_raw(ByteReader* reader, ptrdiff_t n, const byte** data);
+
+// Reads a uvarint length n and sets data to point to the n bytes that
+// follow (in the reader's buffer, so they're not copied).
+bool byte_reader_bytes(ByteReader* reader, const byte** data,
+                       ptrdiff_t* n);
+
+// Reads a string as written by byte_writer_str(), setting s to point to
+// its n chars in the reader's buffer (so they're not copied but nor are
+// they NUL-terminated).
+bool byte_reader_str(ByteReader* reader, const char** s, ptrdiff_t* n);
+
+// Reads ints as written by byte_writer_vec_int() and appends them to vec,
+// failing if any doesn't fit an int.
+bool byte_reader_vec_int(ByteReader* reader, VecInt* vec);
+
+// Reads strings as written by byte_writer_vec_str() and appends copies
+// of them to vec (which must own its strings or be packed).
+bool byte_reader_vec_str(ByteReader* reader, VecStr* vec);
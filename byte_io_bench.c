@@ -0,0 +1,127 @@
+// Copyright © 2024-25 Mark Summerfield. All rights reserved.
+// License: GPL-3
+
+#include "byte_io_bench.h"
+#include "byte_io.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+static void vec_int_benchmarks(binfo* binfo, int n, int reps);
+static void vec_str_benchmarks(binfo* binfo, int n, int reps);
+
+// Serializing whole containers in one call is compared with writing
+// their values one at a time; rates are of values.
+void byte_io_benchmarks(binfo* binfo) {
+    int reps = binfo->quick ? 5 : 100;
+    vec_int_benchmarks(binfo, 1000000, reps);
+    vec_str_benchmarks(binfo, 200000, reps);
+}
+
+static void vec_int_benchmarks(binfo* binfo, int n, int reps) {
+    uint64_t seed = 1;
+    VecInt vec = vec_int_alloc_cap(n);
+    for (int i = 0; i < n; ++i) // mostly small with some large
+        vec_int_push(&vec, (int)(bench_rand(&seed) >> (33 + i % 24)));
+    VecByte buf = vec_byte_alloc();
+    ByteWriter writer = byte_writer(&buf);
+    int64_t total = (int64_t)n * reps;
+
+    double begin = bench_now();
+    for (int r = 0; r < reps; ++r) {
+        vec_byte_clear(&buf);
+        byte_writer_uvarint(&writer, VEC_SIZE(&vec));
+        for (ptrdiff_t i = 0; i < VEC_SIZE(&vec); ++i)
+            byte_writer_varint(&writer, VEC_GET(&vec, i));
+    }
+    bench_report(binfo, "byte_writer_varint each", total,
+                 bench_now() - begin, "");
+
+    begin = bench_now();
+    for (int r = 0; r < reps; ++r) {
+        vec_byte_clear(&buf);
+        byte_writer_vec_int(&writer, &vec);
+    }
+    bench_report(binfo, "byte_writer_vec_int", total, bench_now() - begin,
+                 "");
+
+    VecInt out = vec_int_alloc();
+    bool ok = true;
+    begin = bench_now();
+    for (int r = 0; r < reps; ++r) {
+        vec_int_clear(&out);
+        ByteReader reader = byte_reader(buf._values, VEC_SIZE(&buf));
+        uint64_t size;
+        ok &= byte_reader_uvarint(&reader, &size);
+        for (uint64_t i = 0; i < size; ++i) {
+            int64_t value;
+            ok &= byte_reader_varint(&reader, &value);
+            vec_int_push(&out, value);
+        }
+    }
+    bench_report(binfo, "byte_reader_varint each", total,
+                 bench_now() - begin, "");
+
+    begin = bench_now();
+    for (int r = 0; r < reps; ++r) {
+        vec_int_clear(&out);
+        ByteReader reader = byte_reader(buf._values, VEC_SIZE(&buf));
+        ok &= byte_reader_vec_int(&reader, &out);
+    }
+    bench_report(binfo, "byte_reader_vec_int", total, bench_now() - begin,
+                 "");
+    if (!ok || !vec_int_equal(&vec, &out))
+        puts("byte_reader_vec_int failed");
+
+    vec_int_free(&out);
+    vec_byte_free(&buf);
+    vec_int_free(&vec);
+}
+
+static void vec_str_benchmarks(binfo* binfo, int n, int reps) {
+    uint64_t seed = 1;
+    VecStr vec = vec_str_alloc_custom(n, Owns);
+    char s[32];
+    for (int i = 0; i < n; ++i) {
+        snprintf(s, sizeof(s), "item-%llx",
+                 (unsigned long long)(bench_rand(&seed) >> (i % 40)));
+        vec_str_push(&vec, strdup(s));
+    }
+    VecByte buf = vec_byte_alloc();
+    ByteWriter writer = byte_writer(&buf);
+    int64_t total = (int64_t)n * reps;
+
+    double begin = bench_now();
+    for (int r = 0; r < reps; ++r) {
+        vec_byte_clear(&buf);
+        byte_writer_uvarint(&writer, VEC_SIZE(&vec));
+        for (ptrdiff_t i = 0; i < VEC_SIZE(&vec); ++i)
+            byte_writer_str(&writer, VEC_GET(&vec, i));
+    }
+    bench_report(binfo, "byte_writer_str each", total, bench_now() - begin,
+                 "");
+
+    begin = bench_now();
+    for (int r = 0; r < reps; ++r) {
+        vec_byte_clear(&buf);
+        byte_writer_vec_str(&writer, &vec);
+    }
+    bench_report(binfo, "byte_writer_vec_str", total, bench_now() - begin,
+                 "");
+
+    VecStr out = vec_str_alloc();
+    bool ok = true;
+    begin = bench_now();
+    for (int r = 0; r < reps; ++r) {
+        vec_str_clear(&out);
+        ByteReader reader = byte_reader(buf._values, VEC_SIZE(&buf));
+        ok &= byte_reader_vec_str(&reader, &out);
+    }
+    bench_report(binfo, "byte_reader_vec_str", total, bench_now() - begin,
+                 "");
+    if (!ok || !vec_str_equal(&vec, &out))
+        puts("byte_reader_vec_str failed");
+
+    vec_str_free(&out);
+    vec_byte_free(&buf);
+    vec_str_free(&vec);
+}
@@ -0,0 +1,298 @@
+// Copyright © 2024-25 Mark Summerfield. All rights reserved.
+// License: GPL-3
+
+#include "byte_io_test.h"
+#include "byte_io.h"
+#include "exit.h"
+#include <float.h>
+#include <limits.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static void fixed_tests(tinfo* tinfo);
+static void varint_tests(tinfo* tinfo);
+static void bytes_tests(tinfo* tinfo);
+static void vec_tests(tinfo* tinfo);
+static void truncated_tests(tinfo* tinfo);
+static void match(tinfo* tinfo, const VecByte* vec, const char* expected);
+
+void byte_io_tests(tinfo* tinfo) {
+    if (tinfo->verbose)
+        puts(tinfo->tag);
+    fixed_tests(tinfo);
+    varint_tests(tinfo);
+    bytes_tests(tinfo);
+    vec_tests(tinfo);
+    truncated_tests(tinfo);
+}
+
+static void fixed_tests(tinfo* tinfo) {
+    VecByte vec = vec_byte_alloc();
+    ByteWriter writer = byte_writer(&vec);
+    byte_writer_reserve(&writer, 64);
+    check_bool_eq(tinfo, VEC_CAP(&vec) >= 64, true);
+    byte_writer_u8(&writer, 0xAB);
+    byte_writer_u16_le(&writer, 0x1234);
+    byte_writer_u16_be(&writer, 0x1234);
+    byte_writer_u32_le(&writer, 0x12345678);
+    byte_writer_u32_be(&writer, 0x12345678);
+    match(tinfo, &vec, "AB 34 12 12 34 78 56 34 12 12 34 56 78");
+    vec_byte_clear(&vec);
+    byte_writer_u64_le(&writer, 0x0102030405060708);
+    byte_writer_u64_be(&writer, 0x0102030405060708);
+    match(tinfo, &vec,
+          "08 07 06 05 04 03 02 01 01 02 03 04 05 06 07 08");
+    vec_byte_clear(&vec);
+    byte_writer_f64_be(&writer, 1.0);
+    byte_writer_f64_le(&writer, -2.5);
+    byte_writer_f64_be(&writer, DBL_MAX);
+    byte_writer_f64_le(&writer, NAN);
+    match(tinfo, &vec,
+          "3F F0 00 00 00 00 00 00 00 00 00 00 00 00 04 C0 7F EF FF FF FF "
+          "FF FF FF 00 00 00 00 00 00 F8 7F");
+    byte_writer_u32_be(&writer, (uint32_t)-7);
+
+    ByteReader reader = byte_reader(vec._values, VEC_SIZE(&vec));
+    double d;
+    check_bool_eq(tinfo, byte_reader_f64_be(&reader, &d), true);
+    check_real_eq(tinfo, d, 1.0);
+    check_bool_eq(tinfo, byte_reader_f64_le(&reader, &d), true);
+    check_real_eq(tinfo, d, -2.5);
+    check_bool_eq(tinfo, byte_reader_f64_be(&reader, &d), true);
+    check_bool_eq(tinfo, d == DBL_MAX, true);
+    check_bool_eq(tinfo, byte_reader_f64_le(&reader, &d), true);
+    check_bool_eq(tinfo, isnan(d), true);
+    uint32_t u32;
+    check_bool_eq(tinfo, byte_reader_u32_be(&reader, &u32), true);
+    check_int_eq(tinfo, (int32_t)u32, -7);
+    check_int_eq(tinfo, byte_reader_remaining(&reader), 0);
+    check_bool_eq(tinfo, byte_reader_u8(&reader, (uint8_t*)&u32), false);
+
+    vec_byte_clear(&vec);
+    byte_writer_u16_be(&writer, 0xBEEF);
+    byte_writer_u64_le(&writer, UINT64_MAX - 1);
+    byte_writer_u16_le(&writer, 0xCAFE);
+    byte_writer_u64_be(&writer, 42);
+    reader = byte_reader(vec._values, VEC_SIZE(&vec));
+    uint16_t u16;
+    uint64_t u64;
+    check_bool_eq(tinfo, byte_reader_u16_be(&reader, &u16), true);
+    check_int_eq(tinfo, u16, 0xBEEF);
+    check_bool_eq(tinfo, byte_reader_u64_le(&reader, &u64), true);
+    check_bool_eq(tinfo, u64 == UINT64_MAX - 1, true);
+    check_bool_eq(tinfo, byte_reader_u16_le(&reader, &u16), true);
+    check_int_eq(tinfo, u16, 0xCAFE);
+    check_bool_eq(tinfo, byte_reader_u64_be(&reader, &u64), true);
+    check_bool_eq(tinfo, u64 == 42, true);
+    check_int_eq(tinfo, byte_reader_pos(&reader), 20);
+    vec_byte_free(&vec);
+}
+
+static void varint_tests(tinfo* tinfo) {
+    VecByte vec = vec_byte_alloc();
+    ByteWriter writer = byte_writer(&vec);
+    byte_writer_uvarint(&writer, 0);
+    byte_writer_uvarint(&writer, 127);
+    byte_writer_uvarint(&writer, 128);
+    byte_writer_uvarint(&writer, 300);
+    match(tinfo, &vec, "00 7F 80 01 AC 02");
+    vec_byte_clear(&vec);
+    byte_writer_varint(&writer, 0);
+    byte_writer_varint(&writer, -1);
+    byte_writer_varint(&writer, 1);
+    byte_writer_varint(&writer, -2);
+    byte_writer_varint(&writer, -64);
+    byte_writer_varint(&writer, 64);
+    match(tinfo, &vec, "00 01 02 03 7F 80 01");
+    vec_byte_clear(&vec);
+    byte_writer_uvarint(&writer, UINT64_MAX);
+    check_int_eq(tinfo, VEC_SIZE(&vec), BYTE_VARINT_MAX);
+    match(tinfo, &vec, "FF FF FF FF FF FF FF FF FF 01");
+
+    const int64_t VALUES[] = {0,         1,          -1,
+                              63,        -64,        64,
+                              8191,      -8192,      INT_MAX,
+                              INT_MIN,   INT64_MAX,  INT64_MIN,
+                              1LL << 35, -(1LL << 49)};
+    const int COUNT = sizeof(VALUES) / sizeof(VALUES[0]);
+    vec_byte_clear(&vec);
+    for (int i = 0; i < COUNT; ++i) {
+        byte_writer_varint(&writer, VALUES[i]);
+        byte_writer_uvarint(&writer, (uint64_t)VALUES[i]);
+    }
+    ByteReader reader = byte_reader(vec._values, VEC_SIZE(&vec));
+    for (int i = 0; i < COUNT; ++i) {
+        int64_t value;
+        uint64_t uvalue;
+        check_bool_eq(tinfo, byte_reader_varint(&reader, &value), true);
+        check_bool_eq(tinfo, value == VALUES[i], true);
+        check_bool_eq(tinfo, byte_reader_uvarint(&reader, &uvalue), true);
+        check_bool_eq(tinfo, uvalue == (uint64_t)VALUES[i], true);
+    }
+    check_int_eq(tinfo, byte_reader_remaining(&reader), 0);
+
+    // Too long, too big, or unterminated
+    const byte OVERLONG[] = {0x80, 0x80, 0x80, 0x80, 0x80, 0x80,
+                             0x80, 0x80, 0x80, 0x80, 0x00};
+    const byte TOO_BIG[] = {0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+                            0xFF, 0xFF, 0xFF, 0xFF, 0x02};
+    const byte UNTERMINATED[] = {0x80, 0x80};
+    uint64_t u64;
+    reader = byte_reader(OVERLONG, sizeof(OVERLONG));
+    check_bool_eq(tinfo, byte_reader_uvarint(&reader, &u64), false);
+    check_int_eq(tinfo, byte_reader_pos(&reader), 0);
+    reader = byte_reader(TOO_BIG, sizeof(TOO_BIG));
+    check_bool_eq(tinfo, byte_reader_uvarint(&reader, &u64), false);
+    reader = byte_reader(UNTERMINATED, sizeof(UNTERMINATED));
+    check_bool_eq(tinfo, byte_reader_uvarint(&reader, &u64), false);
+    check_int_eq(tinfo, byte_reader_pos(&reader), 0);
+    vec_byte_free(&vec);
+}
+
+static void bytes_tests(tinfo* tinfo) {
+    VecByte vec = vec_byte_alloc();
+    ByteWriter writer = byte_writer(&vec);
+    byte_writer_str(&writer, "");
+    byte_writer_str(&writer, "hello");
+    byte_writer_bytes(&writer, "a\0b", 3);
+    byte_writer_raw(&writer, "xyz", 3);
+    match(tinfo, &vec, "00 05 68 65 6C 6C 6F 03 61 00 62 78 79 7A");
+
+    ByteReader reader = byte_reader(vec._values, VEC_SIZE(&vec));
+    const char* s;
+    const byte* data;
+    ptrdiff_t n;
+    check_bool_eq(tinfo, byte_reader_str(&reader, &s, &n), true);
+    check_int_eq(tinfo, n, 0);
+    check_bool_eq(tinfo, byte_reader_str(&reader, &s, &n), true);
+    check_int_eq(tinfo, n, 5);
+    check_bool_eq(tinfo, !memcmp(s, "hello", 5), true);
+    check_bool_eq(tinfo, (const byte*)s == vec._values + 2, true);
+    check_bool_eq(tinfo, byte_reader_bytes(&reader, &data, &n), true);
+    check_int_eq(tinfo, n, 3);
+    check_bool_eq(tinfo, !memcmp(data, "a\0b", 3), true);
+    check_bool_eq(tinfo, byte_reader_raw(&reader, 4, &data), false);
+    check_bool_eq(tinfo, byte_reader_raw(&reader, 3, &data), true);
+    check_bool_eq(tinfo, !memcmp(data, "xyz", 3), true);
+    check_int_eq(tinfo, byte_reader_remaining(&reader), 0);
+
+    const byte LONG[] = {0x05, 'a', 'b'}; // says 5 but only has 2
+    reader = byte_reader(LONG, sizeof(LONG));
+    check_bool_eq(tinfo, byte_reader_str(&reader, &s, &n), false);
+    check_int_eq(tinfo, byte_reader_pos(&reader), 0);
+    vec_byte_free(&vec);
+}
+
+static void vec_tests(tinfo* tinfo) {
+    VecInt ints = vec_int_alloc();
+    const int INTS[] = {0, 1, -1, 1000, -1000, INT_MAX, INT_MIN};
+    for (int i = 0; i < 7; ++i)
+        vec_int_push(&ints, INTS[i]);
+    for (int i = 0; i < 1000; ++i)
+        vec_int_push(&ints, i * i - 500000);
+    VecStr strs = vec_str_alloc();
+    vec_str_push(&strs, strdup(""));
+    vec_str_push(&strs, strdup("one"));
+    vec_str_push(&strs, strdup("a somewhat longer string of text"));
+    VecByte vec = vec_byte_alloc();
+    ByteWriter writer = byte_writer(&vec);
+    byte_writer_vec_int(&writer, &ints);
+    byte_writer_vec_str(&writer, &strs);
+    byte_writer_u8(&writer, 0xEE);
+
+    ByteReader reader = byte_reader(vec._values, VEC_SIZE(&vec));
+    VecInt ints2 = vec_int_alloc();
+    vec_int_push(&ints2, 99);
+    check_bool_eq(tinfo, byte_reader_vec_int(&reader, &ints2), true);
+    check_int_eq(tinfo, VEC_SIZE(&ints2), VEC_SIZE(&ints) + 1);
+    check_bool_eq(tinfo,
+                  !memcmp(ints2._values + 1, ints._values,
+                          VEC_SIZE(&ints) * sizeof(int)),
+                  true);
+    VecStr strs2 = vec_str_alloc();
+    check_bool_eq(tinfo, byte_reader_vec_str(&reader, &strs2), true);
+    check_bool_eq(tinfo, vec_str_equal(&strs, &strs2), true);
+    uint8_t u8;
+    check_bool_eq(tinfo, byte_reader_u8(&reader, &u8), true);
+    check_int_eq(tinfo, u8, 0xEE);
+
+    // An int that doesn't fit leaves the vec and reader unchanged
+    vec_byte_clear(&vec);
+    byte_writer_uvarint(&writer, 2);
+    byte_writer_varint(&writer, 5);
+    byte_writer_varint(&writer, (int64_t)INT_MAX + 1);
+    reader = byte_reader(vec._values, VEC_SIZE(&vec));
+    check_bool_eq(tinfo, byte_reader_vec_int(&reader, &ints2), false);
+    check_int_eq(tinfo, VEC_SIZE(&ints2), VEC_SIZE(&ints) + 1);
+    check_int_eq(tinfo, byte_reader_pos(&reader), 0);
+
+    // A truncated string leaves the vec and reader unchanged
+    vec_byte_clear(&vec);
+    byte_writer_vec_str(&writer, &strs);
+    reader = byte_reader(vec._values, VEC_SIZE(&vec) - 1);
+    check_bool_eq(tinfo, byte_reader_vec_str(&reader, &strs2), false);
+    check_int_eq(tinfo, VEC_SIZE(&strs2), 3);
+    check_int_eq(tinfo, byte_reader_pos(&reader), 0);
+
+    vec_byte_free(&vec);
+    vec_str_free(&strs2);
+    vec_str_free(&strs);
+    vec_int_free(&ints2);
+    vec_int_free(&ints);
+}
+
+// Every read of every prefix of a valid encoding either succeeds or
+// fails without moving the cursor.
+static void truncated_tests(tinfo* tinfo) {
+    VecByte vec = vec_byte_alloc();
+    ByteWriter writer = byte_writer(&vec);
+    byte_writer_u8(&writer, 1);
+    byte_writer_u16_le(&writer, 2);
+    byte_writer_u32_be(&writer, 3);
+    byte_writer_u64_le(&writer, 4);
+    byte_writer_f64_be(&writer, 5.5);
+    byte_writer_uvarint(&writer, 1 << 20);
+    byte_writer_varint(&writer, -(1 << 20));
+    byte_writer_str(&writer, "six");
+    int ok = 0;
+    for (ptrdiff_t n = 0; n <= VEC_SIZE(&vec); ++n) {
+        ByteReader reader = byte_reader(vec._values, n);
+        uint8_t u8;
+        uint16_t u16;
+        uint32_t u32;
+        uint64_t u64;
+        double d;
+        int64_t i64;
+        const char* s;
+        ptrdiff_t size;
+        ptrdiff_t pos;
+        int count = 0;
+#define READ(call)                                                         \
+    pos = byte_reader_pos(&reader);                                        \
+    if (!(call)) {                                                         \
+        ok += byte_reader_pos(&reader) == pos;                             \
+        continue;                                                          \
+    }                                                                      \
+    ++count;
+        READ(byte_reader_u8(&reader, &u8));
+        READ(byte_reader_u16_le(&reader, &u16));
+        READ(byte_reader_u32_be(&reader, &u32));
+        READ(byte_reader_u64_le(&reader, &u64));
+        READ(byte_reader_f64_be(&reader, &d));
+        READ(byte_reader_uvarint(&reader, &u64));
+        READ(byte_reader_varint(&reader, &i64));
+        READ(byte_reader_str(&reader, &s, &size));
+#undef READ
+        ok += count == 8 && n == VEC_SIZE(&vec) && i64 == -(1 << 20);
+    }
+    check_int_eq(tinfo, ok, VEC_SIZE(&vec) + 1);
+    vec_byte_free(&vec);
+}
+
+static void match(tinfo* tinfo, const VecByte* vec, const char* expected) {
+    char* s = vec_byte_to_str(vec);
+    check_str_eq(tinfo, s, expected);
+    free(s);
+}
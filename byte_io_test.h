@@ -0,0 +1,7 @@
+// Copyright © 2024-25 Mark Summerfield. All rights reserved.
+// License: GPL-3
+#pragma once
+
+#include "cx_util_test.h"
+
+void byte_io_tests(tinfo* tinfo);
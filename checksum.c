@@ -0,0 +1,503 @@
+// Copyright © 2024-25 Mark Summerfield. All rights reserved.
+// License: GPL-3
+
+#include "checksum.h"
+#include "simd.h"
+#include <pthread.h>
+#include <string.h>
+
+#ifdef SIMD_X86
+#include <immintrin.h>
+#endif
+
+#define CRC32C_POLY 0x82F63B78 // reflected Castagnoli polynomial
+
+// The hardware CRC32C runs three independent streams of CRC32C_BLOCK
+// bytes each since crc32 has a latency of 3 cycles but can issue every
+// cycle; the three CRCs are then combined using CRC_SHIFT.
+#define CRC32C_BLOCK 1024
+
+#define XXH64_P1 0x9E3779B185EBCA87ULL
+#define XXH64_P2 0xC2B2AE3D27D4EB4FULL
+#define XXH64_P3 0x165667B19E3779F9ULL
+#define XXH64_P4 0x85EBCA77C2B2AE63ULL
+#define XXH64_P5 0x27D4EB2F165667C5ULL
+
+// The SHA-256 round constants and initial state.
+static const uint32_t SHA256_K[64] = {
+    0x428A2F98, 0x71374491, 0xB5C0FBCF, 0xE9B5DBA5, 0x3956C25B, 0x59F111F1,
+    0x923F82A4, 0xAB1C5ED5, 0xD807AA98, 0x12835B01, 0x243185BE, 0x550C7DC3,
+    0x72BE5D74, 0x80DEB1FE, 0x9BDC06A7, 0xC19BF174, 0xE49B69C1, 0xEFBE4786,
+    0x0FC19DC6, 0x240CA1CC, 0x2DE92C6F, 0x4A7484AA, 0x5CB0A9DC, 0x76F988DA,
+    0x983E5152, 0xA831C66D, 0xB00327C8, 0xBF597FC7, 0xC6E00BF3, 0xD5A79147,
+    0x06CA6351, 0x14292967, 0x27B70A85, 0x2E1B2138, 0x4D2C6DFC, 0x53380D13,
+    0x650A7354, 0x766A0ABB, 0x81C2C92E, 0x92722C85, 0xA2BFE8A1, 0xA81A664B,
+    0xC24B8B70, 0xC76C51A3, 0xD192E819, 0xD6990624, 0xF40E3585, 0x106AA070,
+    0x19A4C116, 0x1E376C08, 0x2748774C, 0x34B0BCB5, 0x391C0CB3, 0x4ED8AA4A,
+    0x5B9CCA4F, 0x682E6FF3, 0x748F82EE, 0x78A5636F, 0x84C87814, 0x8CC70208,
+    0x90BEFFFA, 0xA4506CEB, 0xBEF9A3F7, 0xC67178F2};
+static const uint32_t SHA256_H0[8] = {0x6A09E667, 0xBB67AE85, 0x3C6EF372,
+                                      0xA54FF53A, 0x510E527F, 0x9B05688C,
+                                      0x1F83D9AB, 0x5BE0CD19};
+
+// CRC_TABLES[k][b] is the CRC of byte b followed by k zero bytes (for
+// slicing-by-8); CRC_SHIFT[k][b] is the CRC of (b << 8k) followed by
+// CRC32C_BLOCK zero bytes. Both are built once on first use.
+static uint32_t CRC_TABLES[8][256];
+static uint32_t CRC_SHIFT[4][256];
+static pthread_once_t crc_tables_once = PTHREAD_ONCE_INIT;
+
+static void make_crc_tables(void);
+static uint32_t crc32c_update_raw(uint32_t crc, const byte* data,
+                                  ptrdiff_t n);
+static uint32_t scalar_crc32c_update(uint32_t crc, const byte* data,
+                                     ptrdiff_t n);
+#ifdef SIMD_X86
+SIMD_SSE42 static uint32_t sse42_crc32c_update(uint32_t crc,
+                                               const byte* data,
+                                               ptrdiff_t n);
+#endif
+static inline uint32_t crc_shift(uint32_t crc);
+static inline uint32_t read_u32(const byte* p);
+static inline uint64_t read_u64(const byte* p);
+static inline uint64_t rotl(uint64_t x, int r);
+static inline uint64_t xxh64_round(uint64_t acc, uint64_t input);
+static inline uint64_t xxh64_merge_round(uint64_t h, uint64_t acc);
+static void xxh64_start(uint64_t acc[4], uint64_t seed);
+static const byte* xxh64_stripes(uint64_t acc[4], const byte* data,
+                                 ptrdiff_t n);
+static uint64_t xxh64_finish(const uint64_t acc[4], uint64_t seed,
+                             uint64_t total, const byte* tail,
+                             ptrdiff_t n);
+static void sha256_blocks(uint32_t state[8], const byte* data,
+                          ptrdiff_t blocks);
+static void scalar_sha256_blocks(uint32_t state[8], const byte* data,
+                                 ptrdiff_t blocks);
+#ifdef SIMD_X86
+SIMD_SHA static void shani_sha256_blocks(uint32_t state[8],
+                                         const byte* data,
+                                         ptrdiff_t blocks);
+#endif
+static inline uint32_t read_u32_be(const byte* p);
+static inline uint32_t rotr32(uint32_t x, int r);
+
+uint32_t crc32c(const void* data, ptrdiff_t n) {
+    return ~crc32c_update_raw(0xFFFFFFFF, data, n);
+}
+
+void crc32c_init(Crc32c* crc) {
+    assert_notnull(crc);
+    crc->_crc = 0xFFFFFFFF;
+}
+
+void crc32c_update(Crc32c* crc, const void* data, ptrdiff_t n) {
+    assert_notnull(crc);
+    crc->_crc = crc32c_update_raw(crc->_crc, data, n);
+}
+
+uint32_t crc32c_final(const Crc32c* crc) {
+    assert_notnull(crc);
+    return ~crc->_crc;
+}
+
+uint64_t xxh64(const void* data, ptrdiff_t n, uint64_t seed) {
+    uint64_t acc[4];
+    xxh64_start(acc, seed);
+    const byte* tail = xxh64_stripes(acc, data, n);
+    return xxh64_finish(acc, seed, n, tail, n % 32);
+}
+
+void xxh64_init(Xxh64* hash, uint64_t seed) {
+    assert_notnull(hash);
+    xxh64_start(hash->_acc, seed);
+    hash->_seed = seed;
+    hash->_total = 0;
+    hash->_buf_size = 0;
+}
+
+void xxh64_update(Xxh64* hash, const void* data, ptrdiff_t n) {
+    assert_notnull(hash);
+    if (n <= 0)
+        return;
+    const byte* p = data;
+    hash->_total += n;
+    if (hash->_buf_size) { // top up the buffer to a whole stripe
+        ptrdiff_t size = 32 - hash->_buf_size;
+        if (size > n)
+            size = n;
+        memcpy(hash->_buf + hash->_buf_size, p, size);
+        hash->_buf_size += size;
+        p += size;
+        n -= size;
+        if (hash->_buf_size < 32)
+            return;
+        xxh64_stripes(hash->_acc, hash->_buf, 32);
+        hash->_buf_size = 0;
+    }
+    const byte* tail = xxh64_stripes(hash->_acc, p, n);
+    hash->_buf_size = n % 32;
+    memcpy(hash->_buf, tail, hash->_buf_size);
+}
+
+uint64_t xxh64_final(const Xxh64* hash) {
+    assert_notnull(hash);
+    return xxh64_finish(hash->_acc, hash->_seed, hash->_total, hash->_buf,
+                        hash->_buf_size);
+}
+
+void sha256(const void* data, ptrdiff_t n, byte digest[SHA256_SIZE]) {
+    Sha256 hash;
+    sha256_init(&hash);
+    sha256_update(&hash, data, n);
+    sha256_final(&hash, digest);
+}
+
+void sha256_init(Sha256* hash) {
+    assert_notnull(hash);
+    memcpy(hash->_state, SHA256_H0, sizeof(SHA256_H0));
+    hash->_total = 0;
+    hash->_buf_size = 0;
+}
+
+void sha256_update(Sha256* hash, const void* data, ptrdiff_t n) {
+    assert_notnull(hash);
+    if (n <= 0)
+        return;
+    const byte* p = data;
+    hash->_total += n;
+    if (hash->_buf_size) { // top up the buffer to a whole block
+        ptrdiff_t size = 64 - hash->_buf_size;
+        if (size > n)
+            size = n;
+        memcpy(hash->_buf + hash->_buf_size, p, size);
+        hash->_buf_size += size;
+        p += size;
+        n -= size;
+        if (hash->_buf_size < 64)
+            return;
+        sha256_blocks(hash->_state, hash->_buf, 1);
+        hash->_buf_size = 0;
+    }
+    sha256_blocks(hash->_state, p, n / 64);
+    hash->_buf_size = n % 64;
+    memcpy(hash->_buf, p + (n - hash->_buf_size), hash->_buf_size);
+}
+
+void sha256_final(const Sha256* hash, byte digest[SHA256_SIZE]) {
+    assert_notnull(hash);
+    uint32_t state[8];
+    memcpy(state, hash->_state, sizeof(state));
+    // Pad with 0x80, zeros, and the bit length (big-endian) to a whole
+    // number of blocks (one or two).
+    byte tail[128] = {0};
+    memcpy(tail, hash->_buf, hash->_buf_size);
+    tail[hash->_buf_size] = 0x80;
+    int size = hash->_buf_size < 56 ? 64 : 128;
+    uint64_t bits = hash->_total * 8;
+    for (int i = 0; i < 8; ++i)
+        tail[size - 1 - i] = (byte)(bits >> (8 * i));
+    sha256_blocks(state, tail, size / 64);
+    for (int i = 0; i < 8; ++i) {
+        digest[4 * i] = (byte)(state[i] >> 24);
+        digest[4 * i + 1] = (byte)(state[i] >> 16);
+        digest[4 * i + 2] = (byte)(state[i] >> 8);
+        digest[4 * i + 3] = (byte)state[i];
+    }
+}
+
+static void make_crc_tables(void) {
+    for (int i = 0; i < 256; ++i) {
+        uint32_t crc = i;
+        for (int j = 0; j < 8; ++j)
+            crc = (crc >> 1) ^ (CRC32C_POLY & -(crc & 1));
+        CRC_TABLES[0][i] = crc;
+    }
+    for (int k = 1; k < 8; ++k)
+        for (int i = 0; i < 256; ++i) {
+            uint32_t crc = CRC_TABLES[k - 1][i];
+            CRC_TABLES[k][i] = (crc >> 8) ^ CRC_TABLES[0][crc & 0xFF];
+        }
+    // Appending zero bytes is linear in the CRC so each table entry is
+    // the xor of the shifted CRCs of its set bits.
+    uint32_t bits[32];
+    for (int i = 0; i < 32; ++i) {
+        uint32_t crc = (uint32_t)1 << i;
+        for (int j = 0; j < CRC32C_BLOCK; ++j)
+            crc = (crc >> 8) ^ CRC_TABLES[0][crc & 0xFF];
+        bits[i] = crc;
+    }
+    for (int k = 0; k < 4; ++k)
+        for (int i = 0; i < 256; ++i) {
+            uint32_t crc = 0;
+            for (int j = 0; j < 8; ++j)
+                if (i & (1 << j))
+                    crc ^= bits[8 * k + j];
+            CRC_SHIFT[k][i] = crc;
+        }
+}
+
+// Updates a CRC that's kept inverted between calls (as the streaming
+// API does) so that the one-shot and streaming versions share the code.
+static uint32_t crc32c_update_raw(uint32_t crc, const byte* data,
+                                  ptrdiff_t n) {
+    if (n <= 0)
+        return crc;
+    pthread_once(&crc_tables_once, make_crc_tables);
+#ifdef SIMD_X86
+    if (simd_level() >= SimdSse42)
+        return sse42_crc32c_update(crc, data, n);
+#endif
+    return scalar_crc32c_update(crc, data, n);
+}
+
+static uint32_t scalar_crc32c_update(uint32_t crc, const byte* data,
+                                     ptrdiff_t n) {
+    uint32_t(*t)[256] = CRC_TABLES;
+    for (; n >= 8; n -= 8, data += 8) {
+        crc ^= read_u32(data);
+        crc = t[7][crc & 0xFF] ^ t[6][(crc >> 8) & 0xFF] ^
+              t[5][(crc >> 16) & 0xFF] ^ t[4][crc >> 24] ^ t[3][data[4]] ^
+              t[2][data[5]] ^ t[1][data[6]] ^ t[0][data[7]];
+    }
+    for (; n; --n)
+        crc = (crc >> 8) ^ t[0][(crc ^ *data++) & 0xFF];
+    return crc;
+}
+
+#ifdef SIMD_X86
+SIMD_SSE42 static uint32_t sse42_crc32c_update(uint32_t crc,
+                                               const byte* data,
+                                               ptrdiff_t n) {
+    for (; n >= 3 * CRC32C_BLOCK; n -= 3 * CRC32C_BLOCK) {
+        uint64_t a = crc;
+        uint64_t b = 0;
+        uint64_t c = 0;
+        for (int i = 0; i < CRC32C_BLOCK; i += 8) {
+            a = _mm_crc32_u64(a, read_u64(data + i));
+            b = _mm_crc32_u64(b, read_u64(data + CRC32C_BLOCK + i));
+            c = _mm_crc32_u64(c, read_u64(data + 2 * CRC32C_BLOCK + i));
+        }
+        crc = crc_shift(crc_shift(a) ^ b) ^ c;
+        data += 3 * CRC32C_BLOCK;
+    }
+    uint64_t crc64 = crc;
+    for (; n >= 8; n -= 8, data += 8)
+        crc64 = _mm_crc32_u64(crc64, read_u64(data));
+    crc = crc64;
+    for (; n; --n)
+        crc = _mm_crc32_u8(crc, *data++);
+    return crc;
+}
+#endif
+
+// Returns the CRC with CRC32C_BLOCK zero bytes appended.
+static inline uint32_t crc_shift(uint32_t crc) {
+    return CRC_SHIFT[0][crc & 0xFF] ^ CRC_SHIFT[1][(crc >> 8) & 0xFF] ^
+           CRC_SHIFT[2][(crc >> 16) & 0xFF] ^ CRC_SHIFT[3][crc >> 24];
+}
+
+// Little-endian reads regardless of alignment or host byte order (which
+// compilers turn into single loads where they can).
+static inline uint32_t read_u32(const byte* p) {
+    return (uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 |
+           (uint32_t)p[3] << 24;
+}
+
+static inline uint64_t read_u64(const byte* p) {
+    return (uint64_t)read_u32(p) | (uint64_t)read_u32(p + 4) << 32;
+}
+
+static inline uint64_t rotl(uint64_t x, int r) {
+    return (x << r) | (x >> (64 - r));
+}
+
+static inline uint64_t xxh64_round(uint64_t acc, uint64_t input) {
+    acc += input * XXH64_P2;
+    return rotl(acc, 31) * XXH64_P1;
+}
+
+static inline uint64_t xxh64_merge_round(uint64_t h, uint64_t acc) {
+    h ^= xxh64_round(0, acc);
+    return h * XXH64_P1 + XXH64_P4;
+}
+
+static void xxh64_start(uint64_t acc[4], uint64_t seed) {
+    acc[0] = seed + XXH64_P1 + XXH64_P2;
+    acc[1] = seed + XXH64_P2;
+    acc[2] = seed;
+    acc[3] = seed - XXH64_P1;
+}
+
+// Consumes all the whole 32-byte stripes and returns the rest.
+static const byte* xxh64_stripes(uint64_t acc[4], const byte* data,
+                                 ptrdiff_t n) {
+    const byte* end = data + (n - n % 32);
+    uint64_t a = acc[0];
+    uint64_t b = acc[1];
+    uint64_t c = acc[2];
+    uint64_t d = acc[3];
+    for (; data < end; data += 32) {
+        a = xxh64_round(a, read_u64(data));
+        b = xxh64_round(b, read_u64(data + 8));
+        c = xxh64_round(c, read_u64(data + 16));
+        d = xxh64_round(d, read_u64(data + 24));
+    }
+    acc[0] = a;
+    acc[1] = b;
+    acc[2] = c;
+    acc[3] = d;
+    return data;
+}
+
+// Mixes in the n (< 32) tail bytes and avalanches.
+static uint64_t xxh64_finish(const uint64_t acc[4], uint64_t seed,
+                             uint64_t total, const byte* tail,
+                             ptrdiff_t n) {
+    uint64_t h;
+    if (total >= 32) {
+        h = rotl(acc[0], 1) + rotl(acc[1], 7) + rotl(acc[2], 12) +
+            rotl(acc[3], 18);
+        for (int i = 0; i < 4; ++i)
+            h = xxh64_merge_round(h, acc[i]);
+    } else
+        h = seed + XXH64_P5;
+    h += total;
+    for (; n >= 8; n -= 8, tail += 8) {
+        h ^= xxh64_round(0, read_u64(tail));
+        h = rotl(h, 27) * XXH64_P1 + XXH64_P4;
+    }
+    if (n >= 4) {
+        h ^= read_u32(tail) * XXH64_P1;
+        h = rotl(h, 23) * XXH64_P2 + XXH64_P3;
+        n -= 4;
+        tail += 4;
+    }
+    for (; n; --n) {
+        h ^= *tail++ * XXH64_P5;
+        h = rotl(h, 11) * XXH64_P1;
+    }
+    h ^= h >> 33;
+    h *= XXH64_P2;
+    h ^= h >> 29;
+    h *= XXH64_P3;
+    return h ^ (h >> 32);
+}
+
+static void sha256_blocks(uint32_t state[8], const byte* data,
+                          ptrdiff_t blocks) {
+    if (blocks <= 0)
+        return;
+#ifdef SIMD_X86
+    if (simd_has_sha()) {
+        shani_sha256_blocks(state, data, blocks);
+        return;
+    }
+#endif
+    scalar_sha256_blocks(state, data, blocks);
+}
+
+static void scalar_sha256_blocks(uint32_t state[8], const byte* data,
+                                 ptrdiff_t blocks) {
+    for (; blocks; --blocks, data += 64) {
+        uint32_t w[64];
+        for (int i = 0; i < 16; ++i)
+            w[i] = read_u32_be(data + 4 * i);
+        for (int i = 16; i < 64; ++i) {
+            uint32_t s0 = rotr32(w[i - 15], 7) ^ rotr32(w[i - 15], 18) ^
+                          (w[i - 15] >> 3);
+            uint32_t s1 = rotr32(w[i - 2], 17) ^ rotr32(w[i - 2], 19) ^
+                          (w[i - 2] >> 10);
+            w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+        }
+        uint32_t a = state[0];
+        uint32_t b = state[1];
+        uint32_t c = state[2];
+        uint32_t d = state[3];
+        uint32_t e = state[4];
+        uint32_t f = state[5];
+        uint32_t g = state[6];
+        uint32_t h = state[7];
+        for (int i = 0; i < 64; ++i) {
+            uint32_t s1 = rotr32(e, 6) ^ rotr32(e, 11) ^ rotr32(e, 25);
+            uint32_t ch = (e & f) ^ (~e & g);
+            uint32_t t1 = h + s1 + ch + SHA256_K[i] + w[i];
+            uint32_t s0 = rotr32(a, 2) ^ rotr32(a, 13) ^ rotr32(a, 22);
+            uint32_t maj = (a & b) ^ (a & c) ^ (b & c);
+            h = g;
+            g = f;
+            f = e;
+            e = d + t1;
+            d = c;
+            c = b;
+            b = a;
+            a = t1 + s0 + maj;
+        }
+        state[0] += a;
+        state[1] += b;
+        state[2] += c;
+        state[3] += d;
+        state[4] += e;
+        state[5] += f;
+        state[6] += g;
+        state[7] += h;
+    }
+}
+
+#ifdef SIMD_X86
+// The sha256rnds2 instruction does two rounds and keeps the state as
+// ABEF and CDGH halves; each group of four rounds takes four message
+// words (in w[g % 4]) that sha256msg1/sha256msg2 extend from the
+// previous 16.
+SIMD_SHA static void shani_sha256_blocks(uint32_t state[8],
+                                         const byte* data,
+                                         ptrdiff_t blocks) {
+    const __m128i bswap =
+        _mm_set_epi64x(0x0C0D0E0F08090A0BLL, 0x0405060700010203LL);
+    __m128i tmp = _mm_shuffle_epi32(
+        _mm_loadu_si128((const __m128i*)state), 0xB1); // CDAB
+    __m128i cdgh = _mm_shuffle_epi32(
+        _mm_loadu_si128((const __m128i*)(state + 4)), 0x1B); // EFGH
+    __m128i abef = _mm_alignr_epi8(tmp, cdgh, 8);
+    cdgh = _mm_blend_epi16(cdgh, tmp, 0xF0);
+    for (; blocks; --blocks, data += 64) {
+        __m128i abef_start = abef;
+        __m128i cdgh_start = cdgh;
+        __m128i w[4];
+#pragma GCC unroll 16
+        for (int g = 0; g < 16; ++g) {
+            if (g < 4)
+                w[g] = _mm_shuffle_epi8(
+                    _mm_loadu_si128((const __m128i*)(data + 16 * g)),
+                    bswap);
+            else
+                w[g % 4] = _mm_sha256msg2_epu32(
+                    _mm_add_epi32(
+                        _mm_sha256msg1_epu32(w[g % 4], w[(g + 1) % 4]),
+                        _mm_alignr_epi8(w[(g + 3) % 4], w[(g + 2) % 4],
+                                        4)),
+                    w[(g + 3) % 4]);
+            __m128i msg = _mm_add_epi32(
+                w[g % 4], _mm_loadu_si128((const __m128i*)(SHA256_K +
+                                                           4 * g)));
+            cdgh = _mm_sha256rnds2_epu32(cdgh, abef, msg);
+            abef = _mm_sha256rnds2_epu32(abef, cdgh,
+                                         _mm_shuffle_epi32(msg, 0x0E));
+        }
+        abef = _mm_add_epi32(abef, abef_start);
+        cdgh = _mm_add_epi32(cdgh, cdgh_start);
+    }
+    tmp = _mm_shuffle_epi32(abef, 0x1B);  // FEBA
+    cdgh = _mm_shuffle_epi32(cdgh, 0xB1); // DCHG
+    _mm_storeu_si128((__m128i*)state, _mm_blend_epi16(tmp, cdgh, 0xF0));
+    _mm_storeu_si128((__m128i*)(state + 4), _mm_alignr_epi8(cdgh, tmp, 8));
+}
+#endif
+
+static inline uint32_t read_u32_be(const byte* p) {
+    return (uint32_t)p[0] << 24 | (uint32_t)p[1] << 16 |
+           (uint32_t)p[2] << 8 | (uint32_t)p[3];
+}
+
+static inline uint32_t rotr32(uint32_t x, int r) {
+    return (x >> r) | (x << (32 - r));
+}
@@ -0,0 +1,84 @@
+// Copyright © 2024-25 Mark Summerfield. All rights reserved.
+// License: GPL-3
+#pragma once
+
+#include "cx.h"
+#include "vec_byte.h"
+#include <stddef.h>
+#include <stdint.h>
+
+// Non-cryptographic checksums of byte buffers: CRC32C (Castagnoli, as
+// used by iSCSI, ext4, etc.) and XXH64 (compatible with xxHash's
+// XXH64). Each has a one-shot function and a streaming API (init,
+// update any number of times, final) for data that arrives in pieces;
+// both give the same result however the data is split. CRC32C uses the
+// SSE4.2 crc32 instruction if available (see simd.h), otherwise
+// slicing-by-8 tables. See vec_byte.h for VecByte versions.
+//
+// Also SHA-256 (FIPS 180-4), a cryptographic hash for when collisions
+// must be practically impossible, e.g., to identify content by its hash.
+// It has the same one-shot and streaming APIs and uses the x86 SHA
+// extensions if available (see simd.h), which makes it several times
+// faster than the portable version.
+
+// The size in bytes of a SHA-256 digest.
+#define SHA256_SIZE 32
+
+typedef struct Crc32c {
+    uint32_t _crc;
+} Crc32c;
+
+typedef struct Xxh64 {
+    uint64_t _acc[4];
+    uint64_t _seed;
+    uint64_t _total;
+    byte _buf[32];
+    int _buf_size;
+} Xxh64;
+
+typedef struct Sha256 {
+    uint32_t _state[8];
+    uint64_t _total;
+    byte _buf[64];
+    int _buf_size;
+} Sha256;
+
+// Returns the CRC32C of the n bytes at data, e.g., 0xE3069283 for
+// "123456789".
+uint32_t crc32c(const void* data, ptrdiff_t n);
+
+// Starts a streaming CRC32C.
+void crc32c_init(Crc32c* crc);
+
+// Adds the n bytes at data to the streaming CRC32C.
+void crc32c_update(Crc32c* crc, const void* data, ptrdiff_t n);
+
+// Returns the CRC32C of all the bytes added so far; more may be added.
+uint32_t crc32c_final(const Crc32c* crc);
+
+// Returns the XXH64 hash of the n bytes at data using the given seed
+// (0 is usual).
+uint64_t xxh64(const void* data, ptrdiff_t n, uint64_t seed);
+
+// Starts a streaming XXH64 hash using the given seed.
+void xxh64_init(Xxh64* hash, uint64_t seed);
+
+// Adds the n bytes at data to the streaming XXH64 hash.
+void xxh64_update(Xxh64* hash, const void* data, ptrdiff_t n);
+
+// Returns the XXH64 hash of all the bytes added so far; more may be
+// added.
+uint64_t xxh64_final(const Xxh64* hash);
+
+// Sets digest to the SHA-256 of the n bytes at data.
+void sha256(const void* data, ptrdiff_t n, byte digest[SHA256_SIZE]);
+
+// Starts a streaming SHA-256.
+void sha256_init(Sha256* hash);
+
+// Adds the n bytes at data to the streaming SHA-256.
+void sha256_update(Sha256* hash, const void* data, ptrdiff_t n);
+
+// Sets digest to the SHA-256 of all the bytes added so far; more may be
+// added.
+void sha256_final(const Sha256* hash, byte digest[SHA256_SIZE]);
@@ -0,0 +1,140 @@
+// Copyright © 2024-25 Mark Summerfield. All rights reserved.
+// License: GPL-3
+
+#include "checksum_bench.h"
+#include "checksum.h"
+#include "simd.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+static void crc32c_benchmarks(binfo* binfo, const byte* data, int n,
+                              int reps);
+static void xxh64_benchmarks(binfo* binfo, const byte* data, int n,
+                             int reps);
+static void sha256_benchmarks(binfo* binfo, const byte* data, int n,
+                              int reps);
+
+// Each checksum is of a whole buffer repeated many times: a 1MB buffer
+// (so it stays in cache) for throughput and 64-byte ones for per-call
+// overhead. CRC32C is run at each level the CPU supports and SHA-256
+// with and without the SHA extensions (if the CPU has them).
+void checksum_benchmarks(binfo* binfo) {
+    const int n = 1000000;
+    int reps = binfo->quick ? 20 : 2000;
+    uint64_t seed = 1;
+    byte* data = malloc(n);
+    for (int i = 0; i < n; ++i)
+        data[i] = (byte)bench_rand(&seed);
+    crc32c_benchmarks(binfo, data, n, reps);
+    xxh64_benchmarks(binfo, data, n, reps);
+    sha256_benchmarks(binfo, data, n, reps / 10 + 1);
+    free(data);
+}
+
+static void crc32c_benchmarks(binfo* binfo, const byte* data, int n,
+                              int reps) {
+    int64_t total = (int64_t)n * reps;
+    char name[64];
+    simd_set_max_level(SimdAvx2);
+    SimdLevel best = simd_level();
+    for (SimdLevel level = SimdScalar; level <= best; ++level) {
+        if (level == SimdSse2 || level == SimdAvx2)
+            continue; // same as the level below
+        simd_set_max_level(level);
+        const char* level_name = simd_level_name(level);
+        uint32_t sum = 0; // so the calls can't be optimized away
+
+        double begin = bench_now();
+        for (int r = 0; r < reps; ++r)
+            sum += crc32c(data, n);
+        snprintf(name, sizeof(name), "crc32c 1MB %s", level_name);
+        bench_report(binfo, name, total, bench_now() - begin, "B");
+
+        begin = bench_now();
+        for (int i = 0; i + 64 <= n; i += 64)
+            for (int r = 0; r < reps; ++r)
+                sum += crc32c(data + i, 64);
+        snprintf(name, sizeof(name), "crc32c 64B %s", level_name);
+        bench_report(binfo, name, total, bench_now() - begin, "B");
+
+        begin = bench_now();
+        for (int r = 0; r < reps; ++r) {
+            Crc32c crc;
+            crc32c_init(&crc);
+            for (int i = 0; i < n; i += 4096)
+                crc32c_update(&crc, data + i, n - i < 4096 ? n - i : 4096);
+            sum += crc32c_final(&crc);
+        }
+        snprintf(name, sizeof(name), "crc32c streaming 4KB %s", level_name);
+        bench_report(binfo, name, total, bench_now() - begin, "B");
+
+        if (sum == 42)
+            puts("");
+    }
+    simd_set_max_level(SimdAvx2);
+}
+
+static void xxh64_benchmarks(binfo* binfo, const byte* data, int n,
+                             int reps) {
+    int64_t total = (int64_t)n * reps;
+    uint64_t sum = 0;
+
+    double begin = bench_now();
+    for (int r = 0; r < reps; ++r)
+        sum += xxh64(data, n, 0);
+    bench_report(binfo, "xxh64 1MB", total, bench_now() - begin, "B");
+
+    begin = bench_now();
+    for (int i = 0; i + 64 <= n; i += 64)
+        for (int r = 0; r < reps; ++r)
+            sum += xxh64(data + i, 64, 0);
+    bench_report(binfo, "xxh64 64B", total, bench_now() - begin, "B");
+
+    begin = bench_now();
+    for (int r = 0; r < reps; ++r) {
+        Xxh64 hash;
+        xxh64_init(&hash, 0);
+        for (int i = 0; i < n; i += 4096)
+            xxh64_update(&hash, data + i, n - i < 4096 ? n - i : 4096);
+        sum += xxh64_final(&hash);
+    }
+    bench_report(binfo, "xxh64 streaming 4KB", total, bench_now() - begin,
+                 "B");
+
+    if (sum == 42)
+        puts("");
+}
+
+static void sha256_benchmarks(binfo* binfo, const byte* data, int n,
+                              int reps) {
+    int64_t total = (int64_t)n * reps;
+    byte digest[SHA256_SIZE];
+    uint64_t sum = 0;
+    simd_set_max_level(SimdAvx2);
+    bool has_sha = simd_has_sha();
+    for (int use_sha = 0; use_sha <= has_sha; ++use_sha) {
+        simd_set_max_level(use_sha ? SimdAvx2 : SimdScalar);
+        const char* kind = use_sha ? "sha" : "scalar";
+        char name[64];
+
+        double begin = bench_now();
+        for (int r = 0; r < reps; ++r) {
+            sha256(data, n, digest);
+            sum += digest[0];
+        }
+        snprintf(name, sizeof(name), "sha256 1MB %s", kind);
+        bench_report(binfo, name, total, bench_now() - begin, "B");
+
+        begin = bench_now();
+        for (int i = 0; i + 64 <= n; i += 64)
+            for (int r = 0; r < reps; ++r) {
+                sha256(data + i, 64, digest);
+                sum += digest[0];
+            }
+        snprintf(name, sizeof(name), "sha256 64B %s", kind);
+        bench_report(binfo, name, total, bench_now() - begin, "B");
+    }
+    simd_set_max_level(SimdAvx2);
+    if (sum == 42)
+        puts("");
+}
@@ -0,0 +1,212 @@
+// Copyright © 2024-25 Mark Summerfield. All rights reserved.
+// License: GPL-3
+
+#include "checksum_test.h"
+#include "checksum.h"
+#include "codec.h"
+#include "exit.h"
+#include "simd.h"
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static void known_tests(tinfo* tinfo);
+static void crc32c_tests(tinfo* tinfo, const byte* data, int n);
+static void xxh64_tests(tinfo* tinfo, const byte* data, int n);
+static void sha256_tests(tinfo* tinfo, const byte* data, int n);
+static void vec_byte_tests(tinfo* tinfo);
+static void check_sha256(tinfo* tinfo, const char* what, const void* data,
+                         int n, const char* expected);
+static uint32_t reference_crc32c(const byte* data, int n);
+static void check(tinfo* tinfo, const char* what, int n, uint64_t got,
+                  uint64_t expected);
+
+#define MAX_SIZE 20000
+
+// Every level the CPU supports is tested against published results and
+// against a bitwise CRC32C at sizes around the block sizes, and the
+// streaming APIs are tested with the data split at various places.
+void checksum_tests(tinfo* tinfo) {
+    if (tinfo->verbose)
+        puts(tinfo->tag);
+    byte* data = malloc(MAX_SIZE);
+    uint32_t x = 1;
+    for (int i = 0; i < MAX_SIZE; ++i) {
+        x = x * 1103515245u + 12345u;
+        data[i] = (byte)(x >> 16);
+    }
+    const int SIZES[] = {0,    1,    7,    8,    9,    31,   32,
+                         33,   63,   64,   100,  1023, 1024, 3071,
+                         3072, 3073, 6144, 9999, MAX_SIZE};
+    simd_set_max_level(SimdAvx2);
+    SimdLevel best = simd_level();
+    for (SimdLevel level = SimdScalar; level <= best; ++level) {
+        simd_set_max_level(level);
+        if (tinfo->verbose)
+            printf("  %s\n", simd_level_name(level));
+        known_tests(tinfo);
+        for (int s = 0; s < (int)(sizeof(SIZES) / sizeof(SIZES[0])); ++s) {
+            crc32c_tests(tinfo, data, SIZES[s]);
+            // Misaligned too
+            crc32c_tests(tinfo, data + 3, SIZES[s] - (SIZES[s] > 3) * 3);
+            xxh64_tests(tinfo, data, SIZES[s]);
+            sha256_tests(tinfo, data, SIZES[s]);
+        }
+        vec_byte_tests(tinfo);
+    }
+    simd_set_max_level(SimdAvx2);
+    free(data);
+}
+
+static void known_tests(tinfo* tinfo) {
+    // RFC 3720 (iSCSI) test vectors
+    byte a[32];
+    memset(a, 0, 32);
+    check(tinfo, "crc32c zeros", 32, crc32c(a, 32), 0x8A9136AA);
+    memset(a, 0xFF, 32);
+    check(tinfo, "crc32c ones", 32, crc32c(a, 32), 0x62A8AB43);
+    for (int i = 0; i < 32; ++i)
+        a[i] = i;
+    check(tinfo, "crc32c incrementing", 32, crc32c(a, 32), 0x46DD794E);
+    check(tinfo, "crc32c check", 9, crc32c("123456789", 9), 0xE3069283);
+    check(tinfo, "crc32c empty", 0, crc32c("", 0), 0);
+    // Results from the reference xxHash implementation
+    const char* FOX = "The quick brown fox jumps over the lazy dog";
+    check(tinfo, "xxh64 empty", 0, xxh64("", 0, 0), 0xEF46DB3751D8E999);
+    check(tinfo, "xxh64 empty seed", 0, xxh64("", 0, 42),
+          0x98B1582B0977E704);
+    check(tinfo, "xxh64 a", 1, xxh64("a", 1, 0), 0xD24EC4F1A98C6E5B);
+    check(tinfo, "xxh64 abc", 3, xxh64("abc", 3, 0), 0x44BC2CF5AD770999);
+    check(tinfo, "xxh64 fox", 43, xxh64(FOX, 43, 0), 0x0B242D361FDA71BC);
+    check(tinfo, "xxh64 fox seed", 43, xxh64(FOX, 43, 42),
+          0xAA9F288A8BAA3D3F);
+    byte b[1024];
+    for (int i = 0; i < 1024; ++i)
+        b[i] = i;
+    check(tinfo, "xxh64 1K", 1024, xxh64(b, 1024, 0), 0x6F3914F18FE4DF57);
+    check(tinfo, "xxh64 1K seed", 1024, xxh64(b, 1024, 42),
+          0x4CB9B11211D5B1A0);
+    // FIPS 180-4 examples (and the padding boundary at 55/56 bytes)
+    check_sha256(
+        tinfo, "sha256 empty", "", 0,
+        "E3B0C44298FC1C149AFBF4C8996FB92427AE41E4649B934CA495991B7852B855");
+    check_sha256(
+        tinfo, "sha256 abc", "abc", 3,
+        "BA7816BF8F01CFEA414140DE5DAE2223B00361A396177A9CB410FF61F20015AD");
+    check_sha256(
+        tinfo, "sha256 448 bits",
+        "abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq", 56,
+        "248D6A61D20638B8E5C026930C3E6039A33CE45964FF2167F6ECEDD419DB06C1");
+    check_sha256(
+        tinfo, "sha256 fox", FOX, 43,
+        "D7A8FBB307D7809469CA9ABCB0082E4F8D5651E46D3CDB762D02D0BF37C9E592");
+    check_sha256(
+        tinfo, "sha256 1K", b, 1024,
+        "785B0751FC2C53DC14A4CE3D800E69EF9CE1009EB327CCF458AFE09C242C26C9");
+}
+
+static void crc32c_tests(tinfo* tinfo, const byte* data, int n) {
+    uint32_t expected = reference_crc32c(data, n);
+    check(tinfo, "crc32c", n, crc32c(data, n), expected);
+    const int PIECES[] = {1, 3, 8, 100, 1024, 3072, 5000};
+    for (int p = 0; p < (int)(sizeof(PIECES) / sizeof(PIECES[0])); ++p) {
+        Crc32c crc;
+        crc32c_init(&crc);
+        for (int i = 0; i < n; i += PIECES[p])
+            crc32c_update(&crc, data + i,
+                          (i + PIECES[p] <= n) ? PIECES[p] : n - i);
+        check(tinfo, "crc32c streaming", n, crc32c_final(&crc), expected);
+    }
+}
+
+static void xxh64_tests(tinfo* tinfo, const byte* data, int n) {
+    uint64_t expected = xxh64(data, n, 7);
+    check(tinfo, "xxh64 seed differs", n, xxh64(data, n, 8) != expected,
+          true);
+    const int PIECES[] = {1, 5, 31, 32, 33, 100, 4096};
+    for (int p = 0; p < (int)(sizeof(PIECES) / sizeof(PIECES[0])); ++p) {
+        Xxh64 hash;
+        xxh64_init(&hash, 7);
+        for (int i = 0; i < n; i += PIECES[p]) {
+            xxh64_update(&hash, data + i,
+                         (i + PIECES[p] <= n) ? PIECES[p] : n - i);
+            if (i == n / 2) // final doesn't end the stream
+                xxh64_final(&hash);
+        }
+        check(tinfo, "xxh64 streaming", n, xxh64_final(&hash), expected);
+    }
+}
+
+static void sha256_tests(tinfo* tinfo, const byte* data, int n) {
+    byte expected[SHA256_SIZE];
+    sha256(data, n, expected);
+    const int PIECES[] = {1, 7, 63, 64, 65, 1000, 4096};
+    for (int p = 0; p < (int)(sizeof(PIECES) / sizeof(PIECES[0])); ++p) {
+        Sha256 hash;
+        sha256_init(&hash);
+        byte digest[SHA256_SIZE];
+        for (int i = 0; i < n; i += PIECES[p]) {
+            sha256_update(&hash, data + i,
+                          (i + PIECES[p] <= n) ? PIECES[p] : n - i);
+            if (i == n / 2) // final doesn't end the stream
+                sha256_final(&hash, digest);
+        }
+        sha256_final(&hash, digest);
+        check(tinfo, "sha256 streaming", n,
+              memcmp(digest, expected, SHA256_SIZE) == 0, true);
+    }
+}
+
+static void vec_byte_tests(tinfo* tinfo) {
+    VecByte vec = vec_byte_alloc();
+    check(tinfo, "vec_byte_crc32c empty", 0, vec_byte_crc32c(&vec), 0);
+    check(tinfo, "vec_byte_xxh64 empty", 0, vec_byte_xxh64(&vec, 0),
+          0xEF46DB3751D8E999);
+    vec_byte_append(&vec, "123456789", 9);
+    check(tinfo, "vec_byte_crc32c", 9, vec_byte_crc32c(&vec), 0xE3069283);
+    check(tinfo, "vec_byte_xxh64", 9, vec_byte_xxh64(&vec, 3),
+          xxh64("123456789", 9, 3));
+    byte digest[SHA256_SIZE];
+    byte expected[SHA256_SIZE];
+    vec_byte_sha256(&vec, digest);
+    sha256("123456789", 9, expected);
+    check(tinfo, "vec_byte_sha256", 9,
+          memcmp(digest, expected, SHA256_SIZE) == 0, true);
+    vec_byte_free(&vec);
+}
+
+static uint32_t reference_crc32c(const byte* data, int n) {
+    uint32_t crc = 0xFFFFFFFF;
+    for (int i = 0; i < n; ++i) {
+        crc ^= data[i];
+        for (int j = 0; j < 8; ++j)
+            crc = (crc >> 1) ^ (0x82F63B78 & -(crc & 1));
+    }
+    return ~crc;
+}
+
+static void check_sha256(tinfo* tinfo, const char* what, const void* data,
+                         int n, const char* expected) {
+    byte digest[SHA256_SIZE];
+    sha256(data, n, digest);
+    char hex[2 * SHA256_SIZE + 1];
+    hex[hex_encode(hex, digest, SHA256_SIZE, 0)] = 0;
+    tinfo->total++;
+    if (strcmp(hex, expected))
+        WARN("FAIL: %s %s %s n=%d expected %s got %s\n", tinfo->tag,
+             simd_level_name(simd_level()), what, n, expected, hex);
+    else
+        tinfo->ok++;
+}
+
+static void check(tinfo* tinfo, const char* what, int n, uint64_t got,
+                  uint64_t expected) {
+    tinfo->total++;
+    if (got != expected)
+        WARN("FAIL: %s %s %s n=%d expected %" PRIX64 " got %" PRIX64 "\n",
+             tinfo->tag, simd_level_name(simd_level()), what, n, expected,
+             got);
+    else
+        tinfo->ok++;
+}
@@ -0,0 +1,191 @@
+// Copyright © 2024-25 Mark Summerfield. All rights reserved.
+// License: GPL-3
+
+#include "chunk.h"
+#include <pthread.h>
+
+// The fd chunker's minimum buffer size.
+#define FD_BUFFER (1024 * 1024)
+
+// The mask bits are spread over the hash's bits 15 to 62 so that each
+// boundary depends on about the last 48 bytes (bit k of a Gear hash only
+// depends on the last k + 1 bytes); bit 63 is kept clear so the masks
+// can be shifted left by one (see gear_scan()).
+#define MASK_TOP 62
+#define MASK_SPAN 48
+
+// GEAR[b] is a random 64-bit value for byte b and GEAR_LS[b] is it
+// shifted left by one; both are built once on first use from a fixed
+// seed so that boundaries are the same everywhere.
+static uint64_t GEAR[256];
+static uint64_t GEAR_LS[256];
+static pthread_once_t gear_once = PTHREAD_ONCE_INIT;
+
+static void make_gear(void);
+static uint64_t spread_mask(int bits);
+static inline ptrdiff_t gear_scan(const byte* data, ptrdiff_t i,
+                                  ptrdiff_t end, uint64_t* hash,
+                                  uint64_t mask);
+static bool emit(const byte* data, int64_t offset, ptrdiff_t size,
+                 ChunkFn fn, void* state);
+static ptrdiff_t read_full(VecByte* vec, int fd, ptrdiff_t n);
+
+Chunker chunker(ptrdiff_t min, ptrdiff_t avg, ptrdiff_t max) {
+    assert(64 <= min && min <= avg && avg <= max && max <= (1 << 30) &&
+           "need 64 <= min <= avg <= max <= 1GB");
+    int bits = 0;
+    while (((ptrdiff_t)2 << bits) <= avg)
+        ++bits;
+    // Normalization level 2: 4x less likely to cut before avg and 4x
+    // more likely after it.
+    return (Chunker){._min = min,
+                     ._avg = (ptrdiff_t)1 << bits,
+                     ._max = max,
+                     ._mask_s = spread_mask(bits + 2),
+                     ._mask_l = spread_mask(bits - 2)};
+}
+
+ptrdiff_t chunker_next(const Chunker* chunker, const byte* data,
+                       ptrdiff_t n) {
+    assert_notnull(chunker);
+    if (n <= chunker->_min)
+        return n;
+    pthread_once(&gear_once, make_gear);
+    if (n > chunker->_max)
+        n = chunker->_max;
+    ptrdiff_t normal = n < chunker->_avg ? n : chunker->_avg;
+    uint64_t hash = 0;
+    ptrdiff_t i =
+        gear_scan(data, chunker->_min, normal, &hash, chunker->_mask_s);
+    if (i < normal)
+        return i + 1;
+    i = gear_scan(data, i, n, &hash, chunker->_mask_l);
+    return i < n ? i + 1 : n;
+}
+
+bool chunker_buffer(const Chunker* chunker, const byte* data, ptrdiff_t n,
+                    ChunkFn fn, void* state) {
+    assert_notnull(fn);
+    for (ptrdiff_t offset = 0; offset < n;) {
+        ptrdiff_t size = chunker_next(chunker, data + offset, n - offset);
+        if (!emit(data + offset, offset, size, fn, state))
+            return false;
+        offset += size;
+    }
+    return true;
+}
+
+bool chunker_vec_byte(const Chunker* chunker, const VecByte* vec,
+                      ChunkFn fn, void* state) {
+    assert_notnull(vec);
+    return chunker_buffer(chunker, vec->_values, vec->_size, fn, state);
+}
+
+// Whenever less than a maximum chunk size is buffered the unchunked
+// bytes are moved to the front and the buffer refilled, so every chunk
+// boundary is found with as much data in view as chunker_buffer() has.
+int64_t chunker_fd(const Chunker* chunker, int fd, ChunkFn fn,
+                   void* state) {
+    assert_notnull(chunker);
+    assert_notnull(fn);
+    ptrdiff_t cap = 4 * chunker->_max;
+    if (cap < FD_BUFFER)
+        cap = FD_BUFFER;
+    VecByte buf = vec_byte_alloc_cap(cap);
+    int64_t offset = 0;
+    ptrdiff_t start = 0;
+    bool eof = false;
+    for (;;) {
+        if (!eof && buf._size - start < chunker->_max) {
+            vec_byte_remove_range(&buf, 0, start);
+            start = 0;
+            ptrdiff_t count = read_full(&buf, fd, cap - buf._size);
+            if (count < 0) {
+                offset = -1;
+                break;
+            }
+            eof = buf._size < cap;
+        }
+        if (start == buf._size)
+            break;
+        ptrdiff_t size = chunker_next(chunker, buf._values + start,
+                                      buf._size - start);
+        if (!emit(buf._values + start, offset, size, fn, state)) {
+            offset += size;
+            break;
+        }
+        start += size;
+        offset += size;
+    }
+    vec_byte_free(&buf);
+    return offset;
+}
+
+// splitmix64 from a fixed seed.
+static void make_gear(void) {
+    uint64_t x = 0x6A09E667F3BCC908ULL;
+    for (int i = 0; i < 256; ++i) {
+        uint64_t z = (x += 0x9E3779B97F4A7C15ULL);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        GEAR[i] = z ^ (z >> 31);
+        GEAR_LS[i] = GEAR[i] << 1;
+    }
+}
+
+// Returns a mask of bits bits spread evenly from MASK_TOP down.
+static uint64_t spread_mask(int bits) {
+    uint64_t mask = 0;
+    for (int k = 0; k < bits; ++k)
+        mask |= (uint64_t)1 << (MASK_TOP - k * MASK_SPAN / bits);
+    return mask;
+}
+
+// Rolls each byte from i up to end into the hash and returns the index
+// of the first byte after which none of the mask's bits are set, or end
+// (having updated the hash) if there isn't one. Two bytes are rolled per
+// iteration with a single shift by two: after the first the hash is one
+// bit further left than the true hash so it is tested with the mask
+// shifted left by one (this needs GEAR_LS and bit 63 of the mask clear).
+static inline ptrdiff_t gear_scan(const byte* data, ptrdiff_t i,
+                                  ptrdiff_t end, uint64_t* hash,
+                                  uint64_t mask) {
+    uint64_t h = *hash;
+    uint64_t mask_ls = mask << 1;
+    for (; i + 2 <= end; i += 2) {
+        h = (h << 2) + GEAR_LS[data[i]];
+        if (!(h & mask_ls))
+            return i;
+        h += GEAR[data[i + 1]];
+        if (!(h & mask))
+            return i + 1;
+    }
+    if (i < end) {
+        h = (h << 1) + GEAR[data[i]];
+        if (!(h & mask))
+            return i;
+        ++i;
+    }
+    *hash = h;
+    return i;
+}
+
+static bool emit(const byte* data, int64_t offset, ptrdiff_t size,
+                 ChunkFn fn, void* state) {
+    Chunk chunk = {.offset = offset, .size = size};
+    sha256(data, size, chunk.hash);
+    return fn(&chunk, data, state);
+}
+
+static ptrdiff_t read_full(VecByte* vec, int fd, ptrdiff_t n) {
+    ptrdiff_t total = 0;
+    while (total < n) {
+        ptrdiff_t count = vec_byte_read_fd(vec, fd, n - total);
+        if (count < 0)
+            return -1;
+        if (!count)
+            break;
+        total += count;
+    }
+    return total;
+}
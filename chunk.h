@@ -0,0 +1,74 @@
+// Copyright © 2024-25 Mark Summerfield. All rights reserved.
+// License: GPL-3
+#pragma once
+
+#include "checksum.h"
+#include "cx.h"
+#include "vec_byte.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+// Content-defined chunking (FastCDC): splits data into chunks whose
+// boundaries depend on the bytes near them rather than on their offsets,
+// so that inserting or deleting bytes only changes the chunks around the
+// edit. This makes chunks good units for deduplication, delta sync, and
+// content-addressed storage.
+//
+// A Gear rolling hash (a shift and add of a random 64-bit value per byte)
+// is updated for each byte after the minimum chunk size and a boundary is
+// declared where its masked bits are all zero. Normalized chunking uses a
+// mask with more bits before the average size and one with fewer after
+// it, which pulls chunk sizes towards the average. Each Chunk has its
+// offset, size, and SHA-256 (see checksum.h).
+//
+// ```
+// Chunker cdc = chunker(2048, 8192, 65536);
+// chunker_vec_byte(&cdc, &vec, store_chunk, &store);
+// ```
+
+typedef struct Chunker {
+    ptrdiff_t _min;
+    ptrdiff_t _avg;
+    ptrdiff_t _max;
+    uint64_t _mask_s; // used before _avg
+    uint64_t _mask_l; // used from _avg
+} Chunker;
+
+typedef struct Chunk {
+    int64_t offset;
+    ptrdiff_t size;
+    byte hash[SHA256_SIZE];
+} Chunk;
+
+// Called for each chunk in order with the chunk's data (which is only
+// valid during the call). Returns true to continue or false to stop.
+typedef bool (*ChunkFn)(const Chunk* chunk, const byte* data,
+                        void* state);
+
+// Returns a Chunker that makes chunks of between min and max bytes
+// (except that the last may be smaller than min) and of avg bytes on
+// average (rounded down to a power of 2); 64 <= min <= avg <= max <= 1GB.
+Chunker chunker(ptrdiff_t min, ptrdiff_t avg, ptrdiff_t max);
+
+// Returns the size of the first chunk of the n bytes at data; this is n
+// if n is at most the minimum chunk size, and at most the maximum.
+ptrdiff_t chunker_next(const Chunker* chunker, const byte* data,
+                       ptrdiff_t n);
+
+// Calls fn for each chunk of the n bytes at data. Returns true, or false
+// if fn stopped it.
+bool chunker_buffer(const Chunker* chunker, const byte* data, ptrdiff_t n,
+                    ChunkFn fn, void* state);
+
+// Calls fn for each chunk of the vec's bytes. Returns true, or false if
+// fn stopped it.
+bool chunker_vec_byte(const Chunker* chunker, const VecByte* vec,
+                      ChunkFn fn, void* state);
+
+// Reads from the file descriptor fd until end of file (or until fn
+// returns false) and calls fn for each chunk, using a buffer of a few
+// maximum chunk sizes (but at least 1MB) however big the file is; the
+// chunks are the same as for chunker_buffer() of the whole file. Returns
+// the number of bytes chunked, or -1 on error (with errno set).
+int64_t chunker_fd(const Chunker* chunker, int fd, ChunkFn fn,
+                   void* state);
@@ -0,0 +1,77 @@
+// Copyright © 2024-25 Mark Summerfield. All rights reserved.
+// License: GPL-3
+
+#include "chunk_bench.h"
+#include "chunk.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+static void chunk_sizes_benchmarks(binfo* binfo, const Chunker* chunker,
+                                   const char* label, const byte* data,
+                                   int n, int reps);
+static bool count_chunk(const Chunk* chunk, const byte* data,
+                        void* state);
+
+// Finding boundaries alone (which is what the rolling hash costs) is
+// compared with whole chunking (which adds SHA-256 per chunk), from a
+// buffer and from a file, over random data at small and typical sizes.
+void chunk_benchmarks(binfo* binfo) {
+    const int n = 16 * 1000 * 1000;
+    int reps = binfo->quick ? 1 : 10;
+    uint64_t seed = 1;
+    byte* data = malloc(n);
+    for (int i = 0; i < n; ++i)
+        data[i] = (byte)bench_rand(&seed);
+    Chunker small = chunker(512, 2048, 8192);
+    Chunker typical = chunker(2048, 8192, 65536);
+    chunk_sizes_benchmarks(binfo, &small, "2KB", data, n, reps);
+    chunk_sizes_benchmarks(binfo, &typical, "8KB", data, n, reps);
+    free(data);
+}
+
+static void chunk_sizes_benchmarks(binfo* binfo, const Chunker* chunker,
+                                   const char* label, const byte* data,
+                                   int n, int reps) {
+    int64_t total = (int64_t)n * reps;
+    int64_t count = 0; // so the calls can't be optimized away
+    char name[64];
+
+    double begin = bench_now();
+    for (int r = 0; r < reps; ++r)
+        for (ptrdiff_t i = 0; i < n; ++count)
+            i += chunker_next(chunker, data + i, n - i);
+    snprintf(name, sizeof(name), "chunker_next %s", label);
+    bench_report(binfo, name, total, bench_now() - begin, "B");
+
+    begin = bench_now();
+    for (int r = 0; r < reps; ++r)
+        chunker_buffer(chunker, data, n, count_chunk, &count);
+    snprintf(name, sizeof(name), "chunker_buffer %s", label);
+    bench_report(binfo, name, total, bench_now() - begin, "B");
+
+    FILE* file = tmpfile();
+    if (file) {
+        int fd = fileno(file);
+        if (write(fd, data, n) == n) {
+            begin = bench_now();
+            for (int r = 0; r < reps; ++r) {
+                lseek(fd, 0, SEEK_SET);
+                chunker_fd(chunker, fd, count_chunk, &count);
+            }
+            snprintf(name, sizeof(name), "chunker_fd %s", label);
+            bench_report(binfo, name, total, bench_now() - begin, "B");
+        }
+        fclose(file);
+    }
+    if (count == 42)
+        puts("");
+}
+
+static bool count_chunk(const Chunk* chunk, const byte* data,
+                        void* state) {
+    (void)chunk;
+    (void)data;
+    ++*(int64_t*)state;
+    return true;
+}
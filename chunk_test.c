@@ -0,0 +1,256 @@
+// Copyright © 2024-25 Mark Summerfield. All rights reserved.
+// License: GPL-3
+
+#include "chunk_test.h"
+#include "chunk.h"
+#include "exit.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+typedef enum { Text, Zeros, Random } Kind;
+
+typedef struct {
+    int count;
+    int64_t size;
+} Seen;
+
+static void fill(byte* data, ptrdiff_t n, Kind kind);
+static void chunk_list_tests(tinfo* tinfo, const Chunker* chunker,
+                             const byte* data, ptrdiff_t n);
+static void stability_tests(tinfo* tinfo, const byte* data, ptrdiff_t n);
+static void fd_tests(tinfo* tinfo, const Chunker* chunker,
+                     const byte* data, ptrdiff_t n);
+static void stop_tests(tinfo* tinfo, const byte* data, ptrdiff_t n);
+static bool collect(const Chunk* chunk, const byte* data, void* state);
+static bool stop_after_3(const Chunk* chunk, const byte* data,
+                         void* state);
+static ptrdiff_t reference_next(const Chunker* chunker, const byte* data,
+                                ptrdiff_t n);
+static void check(tinfo* tinfo, const char* what, ptrdiff_t n, bool ok);
+
+#define MAX_SIZE (3 * 1000 * 1000) // more than the fd chunker's buffer
+
+// Chunks are collected in a VecByte as an array of Chunk structs.
+#define CHUNKS(vec) ((const Chunk*)(vec)._values)
+#define CHUNK_COUNT(vec) ((ptrdiff_t)(VEC_SIZE(&(vec)) / sizeof(Chunk)))
+
+// Each kind of data is chunked with small and typical sizes and checked
+// against a byte-at-a-time Gear chunker; then chunks must survive an
+// insertion, the fd chunker must agree with the buffer chunker, and
+// callbacks must be able to stop chunking.
+void chunk_tests(tinfo* tinfo) {
+    if (tinfo->verbose)
+        puts(tinfo->tag);
+    byte* data = malloc(MAX_SIZE);
+    const Chunker CHUNKERS[] = {chunker(64, 64, 64),
+                                chunker(64, 256, 1024),
+                                chunker(2048, 8192, 65536)};
+    const int COUNT = sizeof(CHUNKERS) / sizeof(CHUNKERS[0]);
+    for (Kind kind = Text; kind <= Random; ++kind) {
+        fill(data, MAX_SIZE, kind);
+        for (int c = 0; c < COUNT; ++c) {
+            for (int n = 0; n <= 200; n += 7)
+                chunk_list_tests(tinfo, &CHUNKERS[c], data, n);
+            chunk_list_tests(tinfo, &CHUNKERS[c], data, 300000);
+        }
+        fd_tests(tinfo, &CHUNKERS[1], data, 100000);
+        fd_tests(tinfo, &CHUNKERS[2], data, MAX_SIZE);
+    }
+    stability_tests(tinfo, data, 2000000);
+    stop_tests(tinfo, data, 100000);
+    free(data);
+}
+
+static void fill(byte* data, ptrdiff_t n, Kind kind) {
+    const char* WORDS[] = {"the ", "quick ", "brown ", "fox ", "jumps ",
+                           "over ", "lazy ", "dog\n"};
+    uint32_t x = 1;
+    for (ptrdiff_t i = 0; i < n;) {
+        x = x * 1103515245u + 12345u;
+        switch (kind) {
+        case Text:
+            for (const char* p = WORDS[(x >> 16) % 8]; *p && i < n; ++p)
+                data[i++] = *p;
+            break;
+        case Zeros:
+            data[i++] = 0;
+            break;
+        case Random:
+            data[i++] = (byte)(x >> 16);
+            break;
+        }
+    }
+}
+
+static void chunk_list_tests(tinfo* tinfo, const Chunker* chunker,
+                             const byte* data, ptrdiff_t n) {
+    VecByte chunks = vec_byte_alloc();
+    check(tinfo, "buffer", n,
+          chunker_buffer(chunker, data, n, collect, &chunks));
+    const Chunk* chunk = CHUNKS(chunks);
+    ptrdiff_t count = CHUNK_COUNT(chunks);
+    bool contiguous = true;
+    bool sized = true;
+    bool hashed = true;
+    bool cuts = true;
+    int64_t offset = 0;
+    for (ptrdiff_t i = 0; i < count; ++i) {
+        contiguous &= chunk[i].offset == offset;
+        sized &= chunk[i].size > 0 && chunk[i].size <= chunker->_max &&
+                 (chunk[i].size >= chunker->_min || i == count - 1);
+        byte hash[SHA256_SIZE];
+        sha256(data + offset, chunk[i].size, hash);
+        hashed &= !memcmp(hash, chunk[i].hash, SHA256_SIZE);
+        cuts &= chunk[i].size ==
+                reference_next(chunker, data + offset, n - offset);
+        offset += chunk[i].size;
+    }
+    check(tinfo, "contiguous", n, contiguous && offset == n);
+    check(tinfo, "sizes", n, sized);
+    check(tinfo, "hashes", n, hashed);
+    check(tinfo, "matches reference", n, cuts);
+    if (n > 100 * chunker->_avg && chunker->_min < chunker->_avg) {
+        // Zeros never cut so only text and random data are averaged
+        ptrdiff_t mean = n / count;
+        check(tinfo, "mean size", n,
+              data[0] == 0 || (mean >= chunker->_avg / 2 &&
+                               mean <= chunker->_avg * 2));
+    }
+    VecByte vec = vec_byte_alloc();
+    vec_byte_append(&vec, data, n);
+    VecByte vec_chunks = vec_byte_alloc();
+    chunker_vec_byte(chunker, &vec, collect, &vec_chunks);
+    check(tinfo, "vec_byte", n, vec_byte_equal(&vec_chunks, &chunks));
+    vec_byte_free(&vec_chunks);
+    vec_byte_free(&vec);
+    vec_byte_free(&chunks);
+}
+
+// Inserting bytes into the middle may only change the chunks around the
+// insertion.
+static void stability_tests(tinfo* tinfo, const byte* data, ptrdiff_t n) {
+    Chunker cdc = chunker(2048, 8192, 65536);
+    const ptrdiff_t AT = n / 2;
+    const ptrdiff_t INSERTED = 100;
+    byte* edited = malloc(n + INSERTED);
+    memcpy(edited, data, AT);
+    memset(edited + AT, 'x', INSERTED);
+    memcpy(edited + AT + INSERTED, data + AT, n - AT);
+    VecByte chunks = vec_byte_alloc();
+    VecByte edited_chunks = vec_byte_alloc();
+    chunker_buffer(&cdc, data, n, collect, &chunks);
+    chunker_buffer(&cdc, edited, n + INSERTED, collect,
+                   &edited_chunks);
+    ptrdiff_t count = CHUNK_COUNT(edited_chunks);
+    ptrdiff_t shared = 0;
+    for (ptrdiff_t i = 0; i < count; ++i)
+        for (ptrdiff_t j = 0; j < CHUNK_COUNT(chunks); ++j)
+            if (!memcmp(CHUNKS(edited_chunks)[i].hash,
+                        CHUNKS(chunks)[j].hash, SHA256_SIZE)) {
+                ++shared;
+                break;
+            }
+    check(tinfo, "stable after insertion", n,
+          count > 100 && shared >= count - 3);
+    vec_byte_free(&edited_chunks);
+    vec_byte_free(&chunks);
+    free(edited);
+}
+
+static void fd_tests(tinfo* tinfo, const Chunker* chunker,
+                     const byte* data, ptrdiff_t n) {
+    FILE* file = tmpfile();
+    if (!file) {
+        WARN("FAIL: %s tmpfile() failed\n", tinfo->tag);
+        return;
+    }
+    int fd = fileno(file);
+    check(tinfo, "fd write", n, write(fd, data, n) == n);
+    lseek(fd, 0, SEEK_SET);
+    VecByte chunks = vec_byte_alloc();
+    VecByte fd_chunks = vec_byte_alloc();
+    chunker_buffer(chunker, data, n, collect, &chunks);
+    check(tinfo, "fd size", n,
+          chunker_fd(chunker, fd, collect, &fd_chunks) == n);
+    check(tinfo, "fd same as buffer", n,
+          vec_byte_equal(&fd_chunks, &chunks));
+    check(tinfo, "fd bad fd", n,
+          chunker_fd(chunker, -1, collect, &fd_chunks) == -1);
+    vec_byte_free(&fd_chunks);
+    vec_byte_free(&chunks);
+    fclose(file);
+}
+
+static void stop_tests(tinfo* tinfo, const byte* data, ptrdiff_t n) {
+    Chunker cdc = chunker(64, 256, 1024);
+    Seen seen = {0, 0};
+    check(tinfo, "stop", n,
+          !chunker_buffer(&cdc, data, n, stop_after_3, &seen) &&
+              seen.count == 3);
+    int64_t size = seen.size;
+    seen = (Seen){0, 0};
+    FILE* file = tmpfile();
+    if (!file) {
+        WARN("FAIL: %s tmpfile() failed\n", tinfo->tag);
+        return;
+    }
+    int fd = fileno(file);
+    check(tinfo, "fd write", n, write(fd, data, n) == n);
+    lseek(fd, 0, SEEK_SET);
+    check(tinfo, "fd stop", n,
+          chunker_fd(&cdc, fd, stop_after_3, &seen) == size &&
+              seen.count == 3 && seen.size == size);
+    fclose(file);
+}
+
+static bool collect(const Chunk* chunk, const byte* data, void* state) {
+    (void)data;
+    vec_byte_append(state, (const byte*)chunk, sizeof(Chunk));
+    return true;
+}
+
+// Counts and adds up the sizes of the chunks and stops at the third.
+static bool stop_after_3(const Chunk* chunk, const byte* data,
+                         void* state) {
+    (void)data;
+    Seen* seen = state;
+    seen->size += chunk->size;
+    return ++seen->count < 3;
+}
+
+// A straightforward FastCDC with the same Gear table (splitmix64 from the
+// same seed) that rolls one byte at a time.
+static ptrdiff_t reference_next(const Chunker* chunker, const byte* data,
+                                ptrdiff_t n) {
+    static uint64_t gear[256];
+    uint64_t x = 0x6A09E667F3BCC908ULL;
+    for (int i = 0; i < 256; ++i) {
+        uint64_t z = (x += 0x9E3779B97F4A7C15ULL);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        gear[i] = z ^ (z >> 31);
+    }
+    if (n <= chunker->_min)
+        return n;
+    if (n > chunker->_max)
+        n = chunker->_max;
+    uint64_t hash = 0;
+    for (ptrdiff_t i = chunker->_min; i < n; ++i) {
+        hash = (hash << 1) + gear[data[i]];
+        uint64_t mask = i < chunker->_avg ? chunker->_mask_s
+                                          : chunker->_mask_l;
+        if (!(hash & mask))
+            return i + 1;
+    }
+    return n;
+}
+
+static void check(tinfo* tinfo, const char* what, ptrdiff_t n, bool ok) {
+    tinfo->total++;
+    if (!ok)
+        WARN("FAIL: %s %s n=%td\n", tinfo->tag, what, n);
+    else
+        tinfo->ok++;
+}
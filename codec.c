@@ -0,0 +1,509 @@
+// Copyright © 2024-25 Mark Summerfield. All rights reserved.
+// License: GPL-3
+
+#include "codec.h"
+#include "simd.h"
+
+#ifdef SIMD_X86
+#include <immintrin.h>
+#endif
+
+static const char HEX_DIGITS[] = "0123456789ABCDEF";
+
+static const char BASE64_DIGITS[] =
+    "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+// Each char's hex value + 1, or 0 if it isn't a hex digit (so all the
+// non-ASCII chars are 0).
+static const byte HEX_VALUES[256] = {
+    0, 0,  0,  0,  0,  0,  0,  0,  0,  0,  0, 0, 0, 0, 0, 0,
+    0, 0,  0,  0,  0,  0,  0,  0,  0,  0,  0, 0, 0, 0, 0, 0,
+    0, 0,  0,  0,  0,  0,  0,  0,  0,  0,  0, 0, 0, 0, 0, 0,
+    1, 2,  3,  4,  5,  6,  7,  8,  9,  10, 0, 0, 0, 0, 0, 0,
+    0, 11, 12, 13, 14, 15, 16, 0,  0,  0,  0, 0, 0, 0, 0, 0,
+    0, 0,  0,  0,  0,  0,  0,  0,  0,  0,  0, 0, 0, 0, 0, 0,
+    0, 11, 12, 13, 14, 15, 16, 0,  0,  0,  0, 0, 0, 0, 0, 0,
+};
+
+// Each ASCII char's base64 value + 1, or 0 if it isn't a base64 digit.
+static const byte BASE64_VALUES[128] = {
+    0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
+    0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
+    0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  63, 0,  0,  0,  64,
+    53, 54, 55, 56, 57, 58, 59, 60, 61, 62, 0,  0,  0,  0,  0,  0,
+    0,  1,  2,  3,  4,  5,  6,  7,  8,  9,  10, 11, 12, 13, 14, 15,
+    16, 17, 18, 19, 20, 21, 22, 23, 24, 25, 26, 0,  0,  0,  0,  0,
+    0,  27, 28, 29, 30, 31, 32, 33, 34, 35, 36, 37, 38, 39, 40, 41,
+    42, 43, 44, 45, 46, 47, 48, 49, 50, 51, 52, 0,  0,  0,  0,  0,
+};
+
+static void scalar_hex_encode(char* out, const byte* data, ptrdiff_t n,
+                              char sep);
+static ptrdiff_t scalar_hex_decode(byte* out, const char* text,
+                                   ptrdiff_t n, char sep);
+static void scalar_base64_encode(char* out, const byte* data,
+                                 ptrdiff_t n);
+static ptrdiff_t scalar_base64_decode(byte* out, const char* text,
+                                      ptrdiff_t n);
+#ifdef SIMD_X86
+static ptrdiff_t sse2_hex_encode(char* out, const byte* data, ptrdiff_t n);
+static ptrdiff_t sse2_hex_decode(byte* out, const char* text,
+                                 ptrdiff_t n);
+SIMD_AVX2 static ptrdiff_t avx2_hex_encode(char* out, const byte* data,
+                                           ptrdiff_t n);
+SIMD_AVX2 static ptrdiff_t avx2_hex_encode_sep(char* out, const byte* data,
+                                               ptrdiff_t n, char sep);
+SIMD_AVX2 static ptrdiff_t avx2_hex_decode(byte* out, const char* text,
+                                           ptrdiff_t n);
+SIMD_AVX2 static ptrdiff_t avx2_base64_encode(char* out, const byte* data,
+                                              ptrdiff_t n);
+SIMD_AVX2 static ptrdiff_t avx2_base64_decode(byte* out, const char* text,
+                                              ptrdiff_t n);
+#endif
+
+inline ptrdiff_t hex_encoded_size(ptrdiff_t n, char sep) {
+    return n <= 0 ? 0 : sep ? 3 * n - 1 : 2 * n;
+}
+
+// The SIMD functions encode whole blocks and return how many bytes they
+// did, leaving the rest to the scalar code.
+ptrdiff_t hex_encode(char* out, const byte* data, ptrdiff_t n, char sep) {
+    assert_notnull(out);
+    assert(n >= 0 && "can't encode a negative number of bytes");
+    if (!n)
+        return 0;
+    assert_notnull(data);
+    ptrdiff_t done = 0;
+#ifdef SIMD_X86
+    switch (simd_level()) {
+    case SimdAvx2:
+        done = sep ? avx2_hex_encode_sep(out, data, n, sep)
+                   : avx2_hex_encode(out, data, n);
+        break;
+    case SimdSse42:
+    case SimdSse2:
+        if (!sep)
+            done = sse2_hex_encode(out, data, n);
+        break;
+    case SimdScalar:
+        break;
+    }
+#endif
+    scalar_hex_encode(out + (sep ? 3 : 2) * done, data + done, n - done,
+                      sep);
+    return hex_encoded_size(n, sep);
+}
+
+inline ptrdiff_t hex_decoded_size(ptrdiff_t n, char sep) {
+    if (n <= 0)
+        return 0;
+    if (sep)
+        return (n + 1) % 3 ? -1 : (n + 1) / 3;
+    return n % 2 ? -1 : n / 2;
+}
+
+ptrdiff_t hex_decode(byte* out, const char* text, ptrdiff_t n, char sep) {
+    ptrdiff_t size = hex_decoded_size(n, sep);
+    if (size <= 0)
+        return size;
+    assert_notnull(out);
+    assert_notnull(text);
+    ptrdiff_t done = 0;
+#ifdef SIMD_X86
+    if (!sep) {
+        switch (simd_level()) {
+        case SimdAvx2:
+            done = avx2_hex_decode(out, text, n);
+            break;
+        case SimdSse42:
+        case SimdSse2:
+            done = sse2_hex_decode(out, text, n);
+            break;
+        case SimdScalar:
+            break;
+        }
+        if (done < 0)
+            return -1;
+    }
+#endif
+    if (scalar_hex_decode(out + done, text + 2 * done, n - 2 * done,
+                          sep) < 0)
+        return -1;
+    return size;
+}
+
+inline ptrdiff_t base64_encoded_size(ptrdiff_t n) {
+    return n <= 0 ? 0 : (n + 2) / 3 * 4;
+}
+
+ptrdiff_t base64_encode(char* out, const byte* data, ptrdiff_t n) {
+    assert_notnull(out);
+    assert(n >= 0 && "can't encode a negative number of bytes");
+    if (!n)
+        return 0;
+    assert_notnull(data);
+    ptrdiff_t done = 0;
+#ifdef SIMD_X86
+    if (simd_level() == SimdAvx2)
+        done = avx2_base64_encode(out, data, n);
+#endif
+    scalar_base64_encode(out + done / 3 * 4, data + done, n - done);
+    return base64_encoded_size(n);
+}
+
+inline ptrdiff_t base64_decoded_size(ptrdiff_t n) {
+    if (n <= 0)
+        return 0;
+    return n % 4 ? -1 : n / 4 * 3;
+}
+
+// The SIMD function decodes whole blocks of 32 chars (stopping before
+// any block with padding or an invalid char) and returns how many bytes
+// it wrote.
+ptrdiff_t base64_decode(byte* out, const char* text, ptrdiff_t n) {
+    ptrdiff_t size = base64_decoded_size(n);
+    if (size <= 0)
+        return size;
+    assert_notnull(out);
+    assert_notnull(text);
+    ptrdiff_t done = 0;
+#ifdef SIMD_X86
+    if (simd_level() == SimdAvx2)
+        done = avx2_base64_decode(out, text, n);
+#endif
+    size = scalar_base64_decode(out + done, text + done / 3 * 4,
+                                n - done / 3 * 4);
+    return size < 0 ? -1 : done + size;
+}
+
+static void scalar_hex_encode(char* out, const byte* data, ptrdiff_t n,
+                              char sep) {
+    for (ptrdiff_t i = 0; i < n; ++i) {
+        *out++ = HEX_DIGITS[data[i] >> 4];
+        *out++ = HEX_DIGITS[data[i] & 0xF];
+        if (sep && i + 1 < n)
+            *out++ = sep;
+    }
+}
+
+static ptrdiff_t scalar_hex_decode(byte* out, const char* text,
+                                   ptrdiff_t n, char sep) {
+    // Invalid digits are accumulated rather than branched on since
+    // branching on random digits mispredicts
+    const char* end = text + n;
+    byte* start = out;
+    bool invalid = false;
+    while (text < end) {
+        unsigned hi = HEX_VALUES[(byte)text[0]];
+        unsigned lo = HEX_VALUES[(byte)text[1]];
+        invalid |= !hi | !lo;
+        *out++ = (byte)((hi - 1) << 4 | (lo - 1));
+        text += 2;
+        if (sep && text < end)
+            invalid |= *text++ != sep;
+    }
+    return invalid ? -1 : out - start;
+}
+
+static void scalar_base64_encode(char* out, const byte* data,
+                                 ptrdiff_t n) {
+    ptrdiff_t i = 0;
+    for (; i + 3 <= n; i += 3) {
+        unsigned x = data[i] << 16 | data[i + 1] << 8 | data[i + 2];
+        *out++ = BASE64_DIGITS[x >> 18];
+        *out++ = BASE64_DIGITS[(x >> 12) & 0x3F];
+        *out++ = BASE64_DIGITS[(x >> 6) & 0x3F];
+        *out++ = BASE64_DIGITS[x & 0x3F];
+    }
+    if (i < n) {
+        unsigned x = data[i] << 16 | (i + 1 < n ? data[i + 1] << 8 : 0);
+        *out++ = BASE64_DIGITS[x >> 18];
+        *out++ = BASE64_DIGITS[(x >> 12) & 0x3F];
+        *out++ = i + 1 < n ? BASE64_DIGITS[(x >> 6) & 0x3F] : '=';
+        *out++ = '=';
+    }
+}
+
+// Padding may only be in the last quad: "xy==" or "xyz=".
+static ptrdiff_t scalar_base64_decode(byte* out, const char* text,
+                                      ptrdiff_t n) {
+    byte* start = out;
+    for (ptrdiff_t i = 0; i < n; i += 4) {
+        int pad = 0;
+        if (i + 4 == n)
+            pad = text[i + 3] != '=' ? 0 : text[i + 2] != '=' ? 1 : 2;
+        unsigned x = 0;
+        for (int j = 0; j < 4 - pad; ++j) {
+            unsigned char c = text[i + j];
+            if (c >= 128 || !BASE64_VALUES[c])
+                return -1;
+            x = x << 6 | (BASE64_VALUES[c] - 1);
+        }
+        x <<= 6 * pad;
+        *out++ = x >> 16;
+        if (pad < 2)
+            *out++ = (x >> 8) & 0xFF;
+        if (!pad)
+            *out++ = x & 0xFF;
+    }
+    return out - start;
+}
+
+#ifdef SIMD_X86
+
+// SSE2 has no byte shuffle so the digits are computed: '0' + v, plus 7
+// more (to skip from ':' to 'A') if v > 9.
+static inline __m128i sse2_hex_digits(__m128i v) {
+    __m128i letter = _mm_and_si128(_mm_cmpgt_epi8(v, _mm_set1_epi8(9)),
+                                   _mm_set1_epi8(7));
+    return _mm_add_epi8(_mm_add_epi8(v, _mm_set1_epi8('0')), letter);
+}
+
+static ptrdiff_t sse2_hex_encode(char* out, const byte* data,
+                                 ptrdiff_t n) {
+    const __m128i mask = _mm_set1_epi8(0x0F);
+    ptrdiff_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m128i x = _mm_loadu_si128((const __m128i*)(data + i));
+        __m128i hi = sse2_hex_digits(
+            _mm_and_si128(_mm_srli_epi16(x, 4), mask));
+        __m128i lo = sse2_hex_digits(_mm_and_si128(x, mask));
+        __m128i* p = (__m128i*)(out + 2 * i);
+        _mm_storeu_si128(p, _mm_unpacklo_epi8(hi, lo));
+        _mm_storeu_si128(p + 1, _mm_unpackhi_epi8(hi, lo));
+    }
+    return i;
+}
+
+// Returns each hex digit's value and ORs 0xFF into bad for any invalid
+// char. (Chars >= 128 are negative and so fail both range checks.)
+static inline __m128i sse2_unhex(__m128i c, __m128i* bad) {
+    __m128i lower = _mm_or_si128(c, _mm_set1_epi8(0x20));
+    __m128i digit = _mm_and_si128(_mm_cmpgt_epi8(c, _mm_set1_epi8('/')),
+                                  _mm_cmpgt_epi8(_mm_set1_epi8(':'), c));
+    __m128i letter =
+        _mm_and_si128(_mm_cmpgt_epi8(lower, _mm_set1_epi8('a' - 1)),
+                      _mm_cmpgt_epi8(_mm_set1_epi8('g'), lower));
+    *bad = _mm_or_si128(*bad, _mm_cmpeq_epi8(_mm_or_si128(digit, letter),
+                                             _mm_setzero_si128()));
+    return _mm_or_si128(
+        _mm_and_si128(digit, _mm_sub_epi8(c, _mm_set1_epi8('0'))),
+        _mm_and_si128(letter,
+                      _mm_sub_epi8(lower, _mm_set1_epi8('a' - 10))));
+}
+
+// Each 16-bit lane holds a high then a low digit's value.
+static inline __m128i sse2_unhex_pairs(__m128i v) {
+    return _mm_or_si128(
+        _mm_slli_epi16(_mm_and_si128(v, _mm_set1_epi16(0xFF)), 4),
+        _mm_srli_epi16(v, 8));
+}
+
+static ptrdiff_t sse2_hex_decode(byte* out, const char* text,
+                                 ptrdiff_t n) {
+    __m128i bad = _mm_setzero_si128();
+    ptrdiff_t i = 0;
+    for (; i + 32 <= n; i += 32) {
+        const __m128i* p = (const __m128i*)(text + i);
+        __m128i a = sse2_unhex(_mm_loadu_si128(p), &bad);
+        __m128i b = sse2_unhex(_mm_loadu_si128(p + 1), &bad);
+        _mm_storeu_si128(
+            (__m128i*)(out + i / 2),
+            _mm_packus_epi16(sse2_unhex_pairs(a), sse2_unhex_pairs(b)));
+    }
+    return _mm_movemask_epi8(bad) ? -1 : i / 2;
+}
+
+SIMD_AVX2 static inline __m256i avx2_hex_digits(__m256i v) {
+    const __m256i lut = _mm256_setr_epi8(
+        '0', '1', '2', '3', '4', '5', '6', '7', '8', '9', 'A', 'B', 'C',
+        'D', 'E', 'F', '0', '1', '2', '3', '4', '5', '6', '7', '8', '9',
+        'A', 'B', 'C', 'D', 'E', 'F');
+    return _mm256_shuffle_epi8(lut, v);
+}
+
+// unpack works within each 128-bit lane, so the lanes are then permuted
+// back into order.
+SIMD_AVX2 static ptrdiff_t avx2_hex_encode(char* out, const byte* data,
+                                           ptrdiff_t n) {
+    const __m256i mask = _mm256_set1_epi8(0x0F);
+    ptrdiff_t i = 0;
+    for (; i + 32 <= n; i += 32) {
+        __m256i x = _mm256_loadu_si256((const __m256i*)(data + i));
+        __m256i hi = avx2_hex_digits(
+            _mm256_and_si256(_mm256_srli_epi16(x, 4), mask));
+        __m256i lo = avx2_hex_digits(_mm256_and_si256(x, mask));
+        __m256i a = _mm256_unpacklo_epi8(hi, lo);
+        __m256i b = _mm256_unpackhi_epi8(hi, lo);
+        __m256i* p = (__m256i*)(out + 2 * i);
+        _mm256_storeu_si256(p, _mm256_permute2x128_si256(a, b, 0x20));
+        _mm256_storeu_si256(p + 1, _mm256_permute2x128_si256(a, b, 0x31));
+    }
+    return i;
+}
+
+// Each block of 16 bytes is 32 digits (in a and b) which are shuffled
+// into 48 chars with a sep after each pair, including the last since
+// blocks are only done if more bytes follow.
+SIMD_AVX2 static ptrdiff_t avx2_hex_encode_sep(char* out, const byte* data,
+                                               ptrdiff_t n, char sep) {
+    const __m128i mask = _mm_set1_epi8(0x0F);
+    const __m128i lut = _mm_setr_epi8('0', '1', '2', '3', '4', '5', '6',
+                                      '7', '8', '9', 'A', 'B', 'C', 'D',
+                                      'E', 'F');
+    const __m128i a0 = _mm_setr_epi8(0, 1, -1, 2, 3, -1, 4, 5, -1, 6, 7,
+                                     -1, 8, 9, -1, 10);
+    const __m128i a1 = _mm_setr_epi8(11, -1, 12, 13, -1, 14, 15, -1, -1,
+                                     -1, -1, -1, -1, -1, -1, -1);
+    const __m128i b1 = _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, 0, 1,
+                                     -1, 2, 3, -1, 4, 5);
+    const __m128i b2 = _mm_setr_epi8(-1, 6, 7, -1, 8, 9, -1, 10, 11, -1,
+                                     12, 13, -1, 14, 15, -1);
+    const __m128i s = _mm_set1_epi8(sep); // where no digit is shuffled
+    const __m128i none = _mm_set1_epi8(-1);
+    const __m128i s0 = _mm_and_si128(s, _mm_cmpeq_epi8(a0, none));
+    const __m128i s1 =
+        _mm_and_si128(s, _mm_cmpeq_epi8(_mm_and_si128(a1, b1), none));
+    const __m128i s2 = _mm_and_si128(s, _mm_cmpeq_epi8(b2, none));
+    ptrdiff_t i = 0;
+    for (; i + 16 < n; i += 16) {
+        __m128i x = _mm_loadu_si128((const __m128i*)(data + i));
+        __m128i hi = _mm_shuffle_epi8(
+            lut, _mm_and_si128(_mm_srli_epi16(x, 4), mask));
+        __m128i lo = _mm_shuffle_epi8(lut, _mm_and_si128(x, mask));
+        __m128i a = _mm_unpacklo_epi8(hi, lo);
+        __m128i b = _mm_unpackhi_epi8(hi, lo);
+        __m128i* p = (__m128i*)(out + 3 * i);
+        _mm_storeu_si128(p, _mm_or_si128(_mm_shuffle_epi8(a, a0), s0));
+        _mm_storeu_si128(p + 1,
+                         _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(a, a1),
+                                                   _mm_shuffle_epi8(b, b1)),
+                                      s1));
+        _mm_storeu_si128(p + 2, _mm_or_si128(_mm_shuffle_epi8(b, b2), s2));
+    }
+    return i;
+}
+
+SIMD_AVX2 static inline __m256i avx2_unhex(__m256i c, __m256i* bad) {
+    __m256i lower = _mm256_or_si256(c, _mm256_set1_epi8(0x20));
+    __m256i digit =
+        _mm256_and_si256(_mm256_cmpgt_epi8(c, _mm256_set1_epi8('/')),
+                         _mm256_cmpgt_epi8(_mm256_set1_epi8(':'), c));
+    __m256i letter = _mm256_and_si256(
+        _mm256_cmpgt_epi8(lower, _mm256_set1_epi8('a' - 1)),
+        _mm256_cmpgt_epi8(_mm256_set1_epi8('g'), lower));
+    *bad = _mm256_or_si256(
+        *bad, _mm256_cmpeq_epi8(_mm256_or_si256(digit, letter),
+                                _mm256_setzero_si256()));
+    return _mm256_or_si256(
+        _mm256_and_si256(digit, _mm256_sub_epi8(c, _mm256_set1_epi8('0'))),
+        _mm256_and_si256(letter, _mm256_sub_epi8(
+                                     lower, _mm256_set1_epi8('a' - 10))));
+}
+
+// maddubs multiplies each high digit by 16 and adds the low digit giving
+// a 16-bit lane per byte; packus works within lanes so they're then
+// permuted back into order.
+SIMD_AVX2 static ptrdiff_t avx2_hex_decode(byte* out, const char* text,
+                                           ptrdiff_t n) {
+    const __m256i weights = _mm256_set1_epi16(0x0110);
+    __m256i bad = _mm256_setzero_si256();
+    ptrdiff_t i = 0;
+    for (; i + 64 <= n; i += 64) {
+        const __m256i* p = (const __m256i*)(text + i);
+        __m256i a = avx2_unhex(_mm256_loadu_si256(p), &bad);
+        __m256i b = avx2_unhex(_mm256_loadu_si256(p + 1), &bad);
+        __m256i x = _mm256_packus_epi16(_mm256_maddubs_epi16(a, weights),
+                                        _mm256_maddubs_epi16(b, weights));
+        _mm256_storeu_si256((__m256i*)(out + i / 2),
+                            _mm256_permute4x64_epi64(x, 0xD8));
+    }
+    return _mm256_movemask_epi8(bad) ? -1 : i / 2;
+}
+
+// Muła and Lemire's AVX2 base64 encoding: each lane gets 12 bytes which
+// are shuffled so each 32-bit word holds 3 bytes, then the four 6-bit
+// fields of each word are moved into separate bytes by multiplies and
+// converted to ASCII by adding a per-range offset looked up by shuffle.
+SIMD_AVX2 static ptrdiff_t avx2_base64_encode(char* out, const byte* data,
+                                              ptrdiff_t n) {
+    const __m256i shuffle =
+        _mm256_setr_epi8(1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10,
+                         1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10);
+    const __m256i offsets = _mm256_setr_epi8(
+        65, 71, -4, -4, -4, -4, -4, -4, -4, -4, -4, -4, -19, -16, 0, 0, 65,
+        71, -4, -4, -4, -4, -4, -4, -4, -4, -4, -4, -19, -16, 0, 0);
+    ptrdiff_t i = 0;
+    for (; i + 28 <= n; i += 24) { // each lane's load reads 16 bytes
+        __m256i x = _mm256_inserti128_si256(
+            _mm256_castsi128_si256(
+                _mm_loadu_si128((const __m128i*)(data + i))),
+            _mm_loadu_si128((const __m128i*)(data + i + 12)), 1);
+        x = _mm256_shuffle_epi8(x, shuffle);
+        __m256i t0 = _mm256_mulhi_epu16(
+            _mm256_and_si256(x, _mm256_set1_epi32(0x0FC0FC00)),
+            _mm256_set1_epi32(0x04000040));
+        __m256i t1 = _mm256_mullo_epi16(
+            _mm256_and_si256(x, _mm256_set1_epi32(0x003F03F0)),
+            _mm256_set1_epi32(0x01000010));
+        x = _mm256_or_si256(t0, t1); // 32 6-bit values
+        __m256i index = _mm256_subs_epu8(x, _mm256_set1_epi8(51));
+        index = _mm256_sub_epi8(
+            index, _mm256_cmpgt_epi8(x, _mm256_set1_epi8(25)));
+        x = _mm256_add_epi8(x, _mm256_shuffle_epi8(offsets, index));
+        _mm256_storeu_si256((__m256i*)(out + i / 3 * 4), x);
+    }
+    return i;
+}
+
+// Muła and Lemire's AVX2 base64 decoding: the high and low nibbles of
+// each char index tables whose bits only overlap for invalid chars
+// (including '='), another table gives the offset that maps each valid
+// char to its 6-bit value, and multiply-adds pack the values into 24
+// bytes per 32 chars.
+SIMD_AVX2 static ptrdiff_t avx2_base64_decode(byte* out, const char* text,
+                                              ptrdiff_t n) {
+    const __m256i lut_lo = _mm256_setr_epi8(
+        0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x13,
+        0x1A, 0x1B, 0x1B, 0x1B, 0x1A, 0x15, 0x11, 0x11, 0x11, 0x11, 0x11,
+        0x11, 0x11, 0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A);
+    const __m256i lut_hi = _mm256_setr_epi8(
+        0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08, 0x10, 0x10, 0x10,
+        0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x01, 0x02, 0x04, 0x08,
+        0x04, 0x08, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10);
+    const __m256i lut_roll = _mm256_setr_epi8(
+        0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0, 0, 16, 19,
+        4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0);
+    const __m256i mask_2f = _mm256_set1_epi8(0x2F);
+    const __m256i pack = _mm256_setr_epi8(
+        2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1, 2, 1, 0, 6,
+        5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1);
+    ptrdiff_t i = 0;
+    byte* start = out;
+    for (; i + 32 <= n; i += 32) {
+        __m256i x = _mm256_loadu_si256((const __m256i*)(text + i));
+        __m256i hi_nibbles =
+            _mm256_and_si256(_mm256_srli_epi32(x, 4), mask_2f);
+        __m256i lo = _mm256_shuffle_epi8(lut_lo,
+                                         _mm256_and_si256(x, mask_2f));
+        __m256i hi = _mm256_shuffle_epi8(lut_hi, hi_nibbles);
+        if (!_mm256_testz_si256(lo, hi))
+            break; // invalid char or padding: leave to the scalar code
+        __m256i eq_2f = _mm256_cmpeq_epi8(x, mask_2f);
+        __m256i roll = _mm256_shuffle_epi8(
+            lut_roll, _mm256_add_epi8(eq_2f, hi_nibbles));
+        x = _mm256_add_epi8(x, roll); // 32 6-bit values
+        x = _mm256_maddubs_epi16(x, _mm256_set1_epi32(0x01400140));
+        x = _mm256_madd_epi16(x, _mm256_set1_epi32(0x00011000));
+        x = _mm256_shuffle_epi8(x, pack);
+        x = _mm256_permutevar8x32_epi32(
+            x, _mm256_setr_epi32(0, 1, 2, 4, 5, 6, 3, 7));
+        _mm_storeu_si128((__m128i*)out, _mm256_castsi256_si128(x));
+        _mm_storel_epi64((__m128i*)(out + 16),
+                         _mm256_extracti128_si256(x, 1));
+        out += 24;
+    }
+    return out - start;
+}
+
+#endif
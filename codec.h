@@ -0,0 +1,50 @@
+// Copyright © 2024-25 Mark Summerfield. All rights reserved.
+// License: GPL-3
+#pragma once
+
+#include "cx.h"
+#include "vec_byte.h"
+#include <stdbool.h>
+#include <stddef.h>
+
+// Hex and base64 encoders and decoders between byte and char buffers.
+// They use AVX2 (or for hex, SSE2) if available, otherwise tables (see
+// simd.h). The encoders don't write a terminating NUL, and the decoders
+// don't need one. See vec_byte.h for VecByte versions.
+
+// Returns how many chars hex_encode() writes for n bytes: 2 per byte,
+// plus (if sep isn't 0) 1 between each pair of bytes.
+ptrdiff_t hex_encoded_size(ptrdiff_t n, char sep);
+
+// Writes the n bytes from data to out (of at least hex_encoded_size(n,
+// sep) chars) as uppercase hex digits, e.g., "0A 1B 2C" if sep is ' ', or
+// "0A1B2C" if sep is 0, and returns the number of chars written.
+ptrdiff_t hex_encode(char* out, const byte* data, ptrdiff_t n, char sep);
+
+// Returns how many bytes the n chars of hex text (with sep between pairs
+// of digits if sep isn't 0) decode to, or -1 if n can't be right.
+ptrdiff_t hex_decoded_size(ptrdiff_t n, char sep);
+
+// Writes the bytes the n chars of hex text (upper or lowercase, with sep
+// between pairs of digits if sep isn't 0) decode to, to out (of at least
+// hex_decoded_size(n, sep) bytes) and returns the number written, or -1
+// if the text is invalid (in which case out's contents are undefined).
+ptrdiff_t hex_decode(byte* out, const char* text, ptrdiff_t n, char sep);
+
+// Returns how many chars base64_encode() writes for n bytes.
+ptrdiff_t base64_encoded_size(ptrdiff_t n);
+
+// Writes the n bytes from data to out (of at least base64_encoded_size(n)
+// chars) as standard (RFC 4648) base64 with '=' padding and no line
+// breaks, and returns the number of chars written.
+ptrdiff_t base64_encode(char* out, const byte* data, ptrdiff_t n);
+
+// Returns the most bytes n chars of base64 text can decode to (less if
+// the text ends with padding), or -1 if n isn't a multiple of 4.
+ptrdiff_t base64_decoded_size(ptrdiff_t n);
+
+// Writes the bytes the n chars of standard base64 text (with '=' padding
+// and no whitespace) decode to, to out (of at least
+// base64_decoded_size(n) bytes) and returns the number written, or -1 if
+// the text is invalid (in which case out's contents are undefined).
+ptrdiff_t base64_decode(byte* out, const char* text, ptrdiff_t n);
@@ -0,0 +1,70 @@
+// Copyright © 2024-25 Mark Summerfield. All rights reserved.
+// License: GPL-3
+
+#include "codec_bench.h"
+#include "codec.h"
+#include "simd.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+// Each encode or decode is of a whole 1MB buffer (so it stays in cache)
+// repeated many times, at each level the CPU supports. Rates are of the
+// binary bytes encoded or decoded to.
+void codec_benchmarks(binfo* binfo) {
+    const int n = 1000000;
+    int reps = binfo->quick ? 20 : 1000;
+    uint64_t seed = 1;
+    byte* data = malloc(n);
+    for (int i = 0; i < n; ++i)
+        data[i] = (byte)bench_rand(&seed);
+    char* text = malloc(base64_encoded_size(n) + hex_encoded_size(n, ' '));
+    byte* bytes = malloc(n);
+    int64_t total = (int64_t)n * reps;
+    char name[64];
+    simd_set_max_level(SimdAvx2);
+    SimdLevel best = simd_level();
+    for (SimdLevel level = SimdScalar; level <= best; ++level) {
+        simd_set_max_level(level);
+        const char* level_name = simd_level_name(level);
+        ptrdiff_t sum = 0; // so the calls can't be optimized away
+
+        double begin = bench_now();
+        for (int r = 0; r < reps; ++r)
+            sum += hex_encode(text, data, n, 0);
+        snprintf(name, sizeof(name), "hex_encode %s", level_name);
+        bench_report(binfo, name, total, bench_now() - begin, "B");
+
+        ptrdiff_t size = hex_encoded_size(n, 0);
+        begin = bench_now();
+        for (int r = 0; r < reps; ++r)
+            sum += hex_decode(bytes, text, size, 0);
+        snprintf(name, sizeof(name), "hex_decode %s", level_name);
+        bench_report(binfo, name, total, bench_now() - begin, "B");
+
+        begin = bench_now();
+        for (int r = 0; r < reps; ++r)
+            sum += hex_encode(text, data, n, ' ');
+        snprintf(name, sizeof(name), "hex_encode sep %s", level_name);
+        bench_report(binfo, name, total, bench_now() - begin, "B");
+
+        begin = bench_now();
+        for (int r = 0; r < reps; ++r)
+            sum += base64_encode(text, data, n);
+        snprintf(name, sizeof(name), "base64_encode %s", level_name);
+        bench_report(binfo, name, total, bench_now() - begin, "B");
+
+        size = base64_encoded_size(n);
+        begin = bench_now();
+        for (int r = 0; r < reps; ++r)
+            sum += base64_decode(bytes, text, size);
+        snprintf(name, sizeof(name), "base64_decode %s", level_name);
+        bench_report(binfo, name, total, bench_now() - begin, "B");
+
+        if (sum == 42)
+            puts("");
+    }
+    simd_set_max_level(SimdAvx2);
+    free(bytes);
+    free(text);
+    free(data);
+}
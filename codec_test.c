@@ -0,0 +1,228 @@
+// Copyright © 2024-25 Mark Summerfield. All rights reserved.
+// License: GPL-3
+
+#include "codec_test.h"
+#include "codec.h"
+#include "exit.h"
+#include "simd.h"
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static void known_tests(tinfo* tinfo);
+static void hex_tests(tinfo* tinfo, const byte* data, int n, char sep);
+static void base64_tests(tinfo* tinfo, const byte* data, int n);
+static void vec_byte_tests(tinfo* tinfo);
+static ptrdiff_t reference_hex(char* out, const byte* data, int n,
+                               char sep);
+static ptrdiff_t reference_base64(char* out, const byte* data, int n);
+static void check(tinfo* tinfo, const char* what, int n, bool ok);
+
+#define MAX_SIZE 4099
+
+// Every level the CPU supports is tested against known results and
+// against simple reference encoders at every size up to well past each
+// level's block sizes, and with invalid chars placed throughout.
+void codec_tests(tinfo* tinfo) {
+    if (tinfo->verbose)
+        puts(tinfo->tag);
+    byte* data = malloc(MAX_SIZE);
+    uint32_t x = 1;
+    for (int i = 0; i < MAX_SIZE; ++i) {
+        x = x * 1103515245u + 12345u;
+        data[i] = (byte)(x >> 16);
+    }
+    simd_set_max_level(SimdAvx2);
+    SimdLevel best = simd_level();
+    for (SimdLevel level = SimdScalar; level <= best; ++level) {
+        simd_set_max_level(level);
+        if (tinfo->verbose)
+            printf("  %s\n", simd_level_name(level));
+        known_tests(tinfo);
+        for (int n = 0; n <= 130; ++n) {
+            hex_tests(tinfo, data, n, 0);
+            hex_tests(tinfo, data, n, ' ');
+            base64_tests(tinfo, data, n);
+        }
+        hex_tests(tinfo, data, 1000, 0);
+        hex_tests(tinfo, data, MAX_SIZE, ':');
+        base64_tests(tinfo, data, 1000);
+        base64_tests(tinfo, data, MAX_SIZE);
+        vec_byte_tests(tinfo);
+    }
+    simd_set_max_level(SimdAvx2);
+    free(data);
+}
+
+static void known_tests(tinfo* tinfo) {
+    // RFC 4648 test vectors
+    const char* PLAIN[] = {"", "f", "fo", "foo", "foob", "fooba", "foobar"};
+    const char* BASE64[] = {"",         "Zg==",     "Zm8=",    "Zm9v",
+                            "Zm9vYg==", "Zm9vYmE=", "Zm9vYmFy"};
+    const char* HEX[] = {"",         "66",           "666F",
+                         "666F6F",   "666F6F62",     "666F6F6261",
+                         "666F6F626172"};
+    char out[64];
+    byte bytes[64];
+    for (int i = 0; i < 7; ++i) {
+        int n = strlen(PLAIN[i]);
+        ptrdiff_t size = base64_encode(out, (const byte*)PLAIN[i], n);
+        out[size] = 0;
+        check_str_eq(tinfo, out, BASE64[i]);
+        size = base64_decode(bytes, BASE64[i], strlen(BASE64[i]));
+        check_int_eq(tinfo, size, n);
+        check(tinfo, "known base64 decode", n, !memcmp(bytes, PLAIN[i], n));
+        size = hex_encode(out, (const byte*)PLAIN[i], n, 0);
+        out[size] = 0;
+        check_str_eq(tinfo, out, HEX[i]);
+    }
+    const char* TEXT = "0a1B2c3D4e5F6a7B8c9DaEbFcAdBeCfD00ff";
+    const byte EXPECTED[] = {0x0A, 0x1B, 0x2C, 0x3D, 0x4E, 0x5F,
+                             0x6A, 0x7B, 0x8C, 0x9D, 0xAE, 0xBF,
+                             0xCA, 0xDB, 0xEC, 0xFD, 0x00, 0xFF};
+    check_int_eq(tinfo, hex_decode(bytes, TEXT, strlen(TEXT), 0), 18);
+    check(tinfo, "known mixed case hex decode", 18,
+          !memcmp(bytes, EXPECTED, 18));
+    check_int_eq(tinfo, hex_decoded_size(3, 0), -1);
+    check_int_eq(tinfo, hex_decoded_size(4, ' '), -1);
+    check_int_eq(tinfo, hex_decoded_size(5, ' '), 2);
+    check_int_eq(tinfo, base64_decoded_size(6), -1);
+    check_int_eq(tinfo, base64_decode(bytes, "Zg=a", 4), -1);
+    check_int_eq(tinfo, base64_decode(bytes, "Z===", 4), -1);
+    check_int_eq(tinfo, base64_decode(bytes, "Zg==Zg==", 8), -1);
+}
+
+static void hex_tests(tinfo* tinfo, const byte* data, int n, char sep) {
+    ptrdiff_t size = hex_encoded_size(n, sep);
+    char* expected = malloc(size + 1);
+    char* text = malloc(size + 1);
+    byte* bytes = malloc(n + 1);
+    check(tinfo, "hex size", n,
+          reference_hex(expected, data, n, sep) == size);
+    check(tinfo, "hex encode size", n,
+          hex_encode(text, data, n, sep) == size);
+    check(tinfo, "hex encode", n, !memcmp(text, expected, size));
+    check(tinfo, "hex decoded size", n, hex_decoded_size(size, sep) == n);
+    check(tinfo, "hex decode size", n,
+          hex_decode(bytes, text, size, sep) == n);
+    check(tinfo, "hex decode", n, !memcmp(bytes, data, n));
+    for (ptrdiff_t i = 0; i < size; ++i)
+        text[i] = tolower(text[i]);
+    check(tinfo, "hex decode lower", n,
+          hex_decode(bytes, text, size, sep) == n &&
+              !memcmp(bytes, data, n));
+    int step = size > 64 ? size / 29 + 1 : 1;
+    for (ptrdiff_t i = 0; i < size; i += step) {
+        char old = text[i];
+        text[i] = (old == sep) ? '0' : 'g';
+        check(tinfo, "hex decode invalid", n,
+              hex_decode(bytes, text, size, sep) == -1);
+        text[i] = (old == sep) ? '-' : '/';
+        check(tinfo, "hex decode invalid", n,
+              hex_decode(bytes, text, size, sep) == -1);
+        text[i] = old;
+    }
+    free(bytes);
+    free(text);
+    free(expected);
+}
+
+static void base64_tests(tinfo* tinfo, const byte* data, int n) {
+    ptrdiff_t size = base64_encoded_size(n);
+    char* expected = malloc(size + 1);
+    char* text = malloc(size + 1);
+    byte* bytes = malloc(base64_decoded_size(size) + 1);
+    check(tinfo, "base64 size", n,
+          reference_base64(expected, data, n) == size);
+    check(tinfo, "base64 encode size", n,
+          base64_encode(text, data, n) == size);
+    check(tinfo, "base64 encode", n, !memcmp(text, expected, size));
+    check(tinfo, "base64 decode size", n,
+          base64_decode(bytes, text, size) == n);
+    check(tinfo, "base64 decode", n, !memcmp(bytes, data, n));
+    int step = size > 64 ? size / 29 + 1 : 1;
+    for (ptrdiff_t i = 0; i < size; i += step) {
+        char old = text[i];
+        if (old == '=')
+            continue;
+        text[i] = '*';
+        check(tinfo, "base64 decode invalid", n,
+              base64_decode(bytes, text, size) == -1);
+        text[i] = (i < size - 2) ? '=' : '\x80';
+        check(tinfo, "base64 decode invalid", n,
+              base64_decode(bytes, text, size) == -1);
+        text[i] = old;
+    }
+    free(bytes);
+    free(text);
+    free(expected);
+}
+
+static void vec_byte_tests(tinfo* tinfo) {
+    VecByte vec = vec_byte_alloc();
+    char* s = vec_byte_to_hex(&vec, ' ');
+    check_str_eq(tinfo, s, "");
+    free(s);
+    check_bool_eq(tinfo, vec_byte_append_hex(&vec, "DE:AD:be:ef", 11, ':'),
+                  true);
+    check_bool_eq(tinfo, vec_byte_append_hex(&vec, "DE:AD:be:e", 10, ':'),
+                  false);
+    check_bool_eq(tinfo, vec_byte_append_hex(&vec, "DEADXX", 6, 0), false);
+    check_int_eq(tinfo, VEC_SIZE(&vec), 4);
+    s = vec_byte_to_hex(&vec, 0);
+    check_str_eq(tinfo, s, "DEADBEEF");
+    free(s);
+    s = vec_byte_to_str(&vec);
+    check_str_eq(tinfo, s, "DE AD BE EF");
+    free(s);
+    s = vec_byte_to_base64(&vec);
+    check_str_eq(tinfo, s, "3q2+7w==");
+    free(s);
+    check_bool_eq(tinfo, vec_byte_append_base64(&vec, "Zm9vYg==", 8), true);
+    check_bool_eq(tinfo, vec_byte_append_base64(&vec, "Zm9vYg=", 7), false);
+    check_bool_eq(tinfo, vec_byte_append_base64(&vec, "Zm9v!g==", 8),
+                  false);
+    check_int_eq(tinfo, VEC_SIZE(&vec), 8);
+    check(tinfo, "vec_byte_append_base64", 8,
+          !memcmp(vec._values, "\xDE\xAD\xBE\xEF" "foob", 8));
+    vec_byte_free(&vec);
+}
+
+static ptrdiff_t reference_hex(char* out, const byte* data, int n,
+                               char sep) {
+    char* p = out;
+    for (int i = 0; i < n; ++i) {
+        if (sep && i)
+            *p++ = sep;
+        p += sprintf(p, "%02X", data[i]);
+    }
+    return p - out;
+}
+
+static ptrdiff_t reference_base64(char* out, const byte* data, int n) {
+    const char* DIGITS = "ABCDEFGHIJKLMNOPQRSTUVWXYZ"
+                         "abcdefghijklmnopqrstuvwxyz0123456789+/";
+    char* p = out;
+    for (int i = 0; i < n; i += 3) {
+        uint32_t x = data[i] << 16;
+        if (i + 1 < n)
+            x |= data[i + 1] << 8;
+        if (i + 2 < n)
+            x |= data[i + 2];
+        *p++ = DIGITS[x >> 18];
+        *p++ = DIGITS[(x >> 12) & 0x3F];
+        *p++ = (i + 1 < n) ? DIGITS[(x >> 6) & 0x3F] : '=';
+        *p++ = (i + 2 < n) ? DIGITS[x & 0x3F] : '=';
+    }
+    return p - out;
+}
+
+static void check(tinfo* tinfo, const char* what, int n, bool ok) {
+    tinfo->total++;
+    if (!ok)
+        WARN("FAIL: %s %s %s n=%d\n", tinfo->tag,
+             simd_level_name(simd_level()), what, n);
+    else
+        tinfo->ok++;
+}
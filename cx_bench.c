@@ -0,0 +1,63 @@
+// Copyright © 2024-25 Mark Summerfield. All rights reserved.
+// License: GPL-3
+
+#include "byte_io_bench.h"
+#include "checksum_bench.h"
+#include "chunk_bench.h"
+#include "codec_bench.h"
+#include "cx_util_bench.h"
+#include "exit.h"
+#include "lz_bench.h"
+#include "simd_bench.h"
+#include "sort_bench.h"
+#include "str.h"
+#include "vecs_bench.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+const char* get_args(int argc, char** argv, bool* quick);
+
+int main(int argc, char** argv) {
+    bool quick = false;
+    const char* pattern = get_args(argc, argv, &quick);
+    double begin = bench_now();
+    binfo binfo = {"", quick};
+    binfo.tag = "vecs_bench";
+    if (!pattern || strstr(binfo.tag, pattern))
+        vecs_benchmarks(&binfo);
+    binfo.tag = "sort_bench";
+    if (!pattern || strstr(binfo.tag, pattern))
+        sort_benchmarks(&binfo);
+    binfo.tag = "simd_bench";
+    if (!pattern || strstr(binfo.tag, pattern))
+        simd_benchmarks(&binfo);
+    binfo.tag = "codec_bench";
+    if (!pattern || strstr(binfo.tag, pattern))
+        codec_benchmarks(&binfo);
+    binfo.tag = "checksum_bench";
+    if (!pattern || strstr(binfo.tag, pattern))
+        checksum_benchmarks(&binfo);
+    binfo.tag = "lz_bench";
+    if (!pattern || strstr(binfo.tag, pattern))
+        lz_benchmarks(&binfo);
+    binfo.tag = "byte_io_bench";
+    if (!pattern || strstr(binfo.tag, pattern))
+        byte_io_benchmarks(&binfo);
+    binfo.tag = "chunk_bench";
+    if (!pattern || strstr(binfo.tag, pattern))
+        chunk_benchmarks(&binfo);
+    printf("%.3fs\n", bench_now() - begin);
+}
+
+const char* get_args(int argc, char** argv, bool* quick) {
+    for (int n = 1; n < argc; ++n) {
+        if (str_eq(argv[n], "-h") || str_eq(argv[n], "--help"))
+            EXIT("cx_bench [-q|--quick] [pattern]\n");
+        if (str_eq(argv[n], "-q") || str_eq(argv[n], "--quick")) {
+            *quick = true;
+            continue;
+        }
+        return argv[n];
+    }
+    return NULL;
+}
@@ -1,6 +1,10 @@
 // Copyright © 2024-25 Mark Summerfield. All rights reserved.
 // License: GPL-3
 
+#include "byte_io_test.h"
+#include "checksum_test.h"
+#include "chunk_test.h"
+#include "codec_test.h"
 #include "cx_util_test.h"
 #include "deq_int_test.h"
 #include "deq_str_test.h"
@@ -8,18 +12,24 @@
 #include "fx.h"
 #include "fx_test.h"
 #include "ini_test.h"
+#include "lz_test.h"
 #include "map_str_real_test.h"
 #include "mx.h"
 #include "mx_test.h"
 #include "set_int_test.h"
 #include "set_str_test.h"
+#include "simd_test.h"
+#include "sort_test.h"
 #include "str.h"
 #include "str_test.h"
 #include "va_test.h"
 #include "vec_byte_test.h"
 #include "vec_int_test.h"
+#include "vec_num_test.h"
+#include "vec_real_test.h"
 #include "vec_str_test.h"
 #include "vec_test.h"
+#include "vec_val_test.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <sys/utsname.h>
@@ -46,9 +56,36 @@ int main(int argc, char** argv) {
     tinfo.tag = "str_tests";
     if (!pattern || strstr(tinfo.tag, pattern))
         str_tests(&tinfo);
+    tinfo.tag = "sort_tests";
+    if (!pattern || strstr(tinfo.tag, pattern))
+        sort_tests(&tinfo);
+    tinfo.tag = "simd_tests";
+    if (!pattern || strstr(tinfo.tag, pattern))
+        simd_tests(&tinfo);
+    tinfo.tag = "codec_tests";
+    if (!pattern || strstr(tinfo.tag, pattern))
+        codec_tests(&tinfo);
+    tinfo.tag = "checksum_tests";
+    if (!pattern || strstr(tinfo.tag, pattern))
+        checksum_tests(&tinfo);
+    tinfo.tag = "lz_tests";
+    if (!pattern || strstr(tinfo.tag, pattern))
+        lz_tests(&tinfo);
+    tinfo.tag = "byte_io_tests";
+    if (!pattern || strstr(tinfo.tag, pattern))
+        byte_io_tests(&tinfo);
+    tinfo.tag = "chunk_tests";
+    if (!pattern || strstr(tinfo.tag, pattern))
+        chunk_tests(&tinfo);
     tinfo.tag = "vec_int_tests";
     if (!pattern || strstr(tinfo.tag, pattern))
         vec_int_tests(&tinfo);
+    tinfo.tag = "vec_num_tests";
+    if (!pattern || strstr(tinfo.tag, pattern))
+        vec_num_tests(&tinfo);
+    tinfo.tag = "vec_real_tests";
+    if (!pattern || strstr(tinfo.tag, pattern))
+        vec_real_tests(&tinfo);
     tinfo.tag = "vec_byte_tests";
     if (!pattern || strstr(tinfo.tag, pattern))
         vec_byte_tests(&tinfo);
@@ -58,6 +95,9 @@ int main(int argc, char** argv) {
     tinfo.tag = "vec_tests";
     if (!pattern || strstr(tinfo.tag, pattern))
         vec_tests(&tinfo);
+    tinfo.tag = "vec_val_tests";
+    if (!pattern || strstr(tinfo.tag, pattern))
+        vec_val_tests(&tinfo);
     tinfo.tag = "set_int_tests";
     if (!pattern || strstr(tinfo.tag, pattern))
         set_int_tests(&tinfo);
@@ -76,6 +116,9 @@ int main(int argc, char** argv) {
     tinfo.tag = "map_str_real_tests";
     if (!pattern || strstr(tinfo.tag, pattern))
         map_str_real_tests(&tinfo);
+    tinfo.tag = "large_tests"; // only run if asked for, e.g., cx_test large
+    if (pattern && strstr(tinfo.tag, pattern))
+        vec_byte_large_tests(&tinfo);
     double duration = (double)(clock() - begin) / CLOCKS_PER_SEC;
     char commabuf[COMMA_I64_SIZE];
     commas(commabuf, tinfo.ok);
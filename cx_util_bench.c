@@ -0,0 +1,42 @@
+// Copyright © 2024-25 Mark Summerfield. All rights reserved.
+// License: GPL-3
+
+#include "cx_util_bench.h"
+#include "str.h"
+#include <stdio.h>
+#include <time.h>
+
+double bench_now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + (ts.tv_nsec / 1e9);
+}
+
+void bench_report(const binfo* binfo, const char* what, int64_t n,
+                  double secs, const char* unit) {
+    char commabuf[COMMA_I64_SIZE];
+    commas(commabuf, n);
+    double rate = secs > 0 ? n / secs : 0;
+    const char* prefix = "";
+    if (rate >= 1e9) {
+        rate /= 1e9;
+        prefix = "G";
+    } else if (rate >= 1e6) {
+        rate /= 1e6;
+        prefix = "M";
+    } else if (rate >= 1e3) {
+        rate /= 1e3;
+        prefix = "K";
+    }
+    printf("%-16s %-36s %15s %9.4fs %9.2f %s%s/s\n", binfo->tag, what,
+           commabuf, secs, rate, prefix, unit);
+}
+
+uint64_t bench_rand(uint64_t* state) {
+    uint64_t x = *state;
+    x ^= x >> 12;
+    x ^= x << 25;
+    x ^= x >> 27;
+    *state = x;
+    return x * 0x2545F4914F6CDD1DULL;
+}
@@ -0,0 +1,23 @@
+// Copyright © 2024-25 Mark Summerfield. All rights reserved.
+// License: GPL-3
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+typedef struct {
+    char* tag;
+    bool quick; // if true use smaller sizes (e.g., for a quick check)
+} binfo;
+
+// Returns a monotonic time in seconds.
+double bench_now(void);
+
+// Prints a line reporting that n items (e.g., elements or bytes) of what
+// took secs seconds, along with the resultant rate in items/s (or B/s).
+void bench_report(const binfo* binfo, const char* what, int64_t n,
+                  double secs, const char* unit);
+
+// Returns a pseudo-random 64-bit value (xorshift64*) so that benchmarks
+// are repeatable and don't spend their time in rand().
+uint64_t bench_rand(uint64_t* state);
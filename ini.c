@@ -104,27 +104,31 @@ static void parse_line(Ini* ini, const char* line, char* section) {
         parse_item(ini, p, section);
 }
 
+// The key and value are trimmed as views so that only their final
+// (owned) copies are allocated.
 static void parse_item(Ini* ini, const char* p, const char* section) {
     size_t i = strcspn(p, "=:");
-    if (!i) {
+    if (!p[i]) {
         WARN("invalid key-value item, no = or : separator: %s\n", p);
         return;
     }
-    const char* q = p + i - 1; // set q to just _before_ the =
-    char* key = str_trimn(p, q - p);
-    q += 2; // skip _past_ the =
-    if (!q) {
-        WARN("invalid key-value item, missing value: %s\n", p);
+    StrView key_view = str_view_trim(str_view_n(p, i));
+    if (!key_view.n) {
+        WARN("invalid key-value item, missing key: %s\n", p);
         return;
     }
-    char* value = str_trim(q);
+    StrView value_view = str_view_trim(str_view(p + i + 1)); // past =
+    char* key = str_view_dup(key_view);
+    char* value = value_view.n ? str_view_dup(value_view) : NULL;
     int sectid = maybe_add_section(ini, section);
     IniItem* item = find_item(ini, section, key);
     if (item) { // duplicate entry; replace value
-        if (!str_caseeq(item->value, value)) {
+        free(key);
+        if (!item->value || !value || !str_caseeq(item->value, value)) {
             free(item->value);
             item->value = value;
-        }
+        } else
+            free(value);
     } else {
         item = item_alloc(key, value, sectid); // item owns key and value
         vec_push(&ini->items, item);
@@ -0,0 +1,413 @@
+// Copyright © 2024-25 Mark Summerfield. All rights reserved.
+// License: GPL-3
+
+#include "lz.h"
+#include "checksum.h"
+#include <errno.h>
+#include <stdint.h>
+#include <string.h>
+
+#define MIN_MATCH 4
+#define LAST_LITERALS 5 // blocks end with at least this many literals
+#define MATCH_LIMIT 12  // and matches start at least this far from the end
+#define MAX_OFFSET 65535
+#define HASH_BITS 12
+#define SKIP_SHIFT 6 // search faster the longer there's been no match
+
+#define FRAME_MAGIC "cxZ1"
+#define FRAME_BLOCK (1 << 20)
+#define FRAME_STORED 0x80000000u
+#define FRAME_HEADER 12
+
+static inline uint32_t read_u32(const byte* p);
+static inline uint64_t read_u64(const byte* p);
+static inline void write_u32(byte* p, uint32_t x);
+static inline uint32_t hash4(const byte* p);
+static const byte* match_end(const byte* p, const byte* ref,
+                             const byte* limit);
+static byte* put_sequence(byte* out, const byte* literals,
+                          ptrdiff_t literals_size, ptrdiff_t offset,
+                          ptrdiff_t match_size);
+static byte* put_length(byte* out, ptrdiff_t n);
+static bool get_length(const byte** data, const byte* end, ptrdiff_t* n);
+static inline void copy_match(byte* out, ptrdiff_t offset, ptrdiff_t n,
+                              const byte* out_end);
+static void frame_put_block(VecByte* out, const byte* data, ptrdiff_t n);
+static void frame_put_end(VecByte* out);
+static bool frame_header_ok(const byte* header, ptrdiff_t* size);
+static bool frame_get_block(VecByte* out, const byte* header,
+                            const byte* payload);
+static bool frame_decompress(VecByte* out, const byte* data, ptrdiff_t n);
+static ptrdiff_t frame_decompress_fd(VecByte* in, VecByte* raw, int in_fd,
+                                     int out_fd);
+static ptrdiff_t read_full(VecByte* vec, int fd, ptrdiff_t n);
+static ptrdiff_t corrupt(void);
+
+inline ptrdiff_t lz_compress_bound(ptrdiff_t n) {
+    return n + n / 255 + 16;
+}
+
+// Greedy matching (as LZ4's fast mode) using a hash table of the most
+// recent position of each hashed 4-byte sequence.
+ptrdiff_t lz_compress(byte* out, const byte* data, ptrdiff_t n) {
+    assert(n >= 0 && n <= INT32_MAX && "use frames for larger data");
+    byte* p = out;
+    const byte* anchor = data; // the start of the pending literals
+    if (n > MATCH_LIMIT) {
+        uint32_t table[1 << HASH_BITS] = {0};
+        const byte* ip = data + 1;
+        const byte* limit = data + n - MATCH_LIMIT;
+        const byte* end = data + n - LAST_LITERALS;
+        while (ip < limit) {
+            uint32_t h = hash4(ip);
+            const byte* ref = data + table[h];
+            table[h] = ip - data;
+            if (ip - ref > MAX_OFFSET || read_u32(ref) != read_u32(ip)) {
+                ip += 1 + ((ip - anchor) >> SKIP_SHIFT);
+                continue;
+            }
+            while (ip > anchor && ref > data && ip[-1] == ref[-1]) {
+                --ip;
+                --ref;
+            }
+            const byte* q = match_end(ip + MIN_MATCH, ref + MIN_MATCH, end);
+            p = put_sequence(p, anchor, ip - anchor, ip - ref, q - ip);
+            ip = anchor = q;
+            if (ip < limit)
+                table[hash4(ip - 2)] = ip - 2 - data;
+        }
+    }
+    return put_sequence(p, anchor, data + n - anchor, 0, 0) - out;
+}
+
+ptrdiff_t lz_decompress(byte* out, ptrdiff_t cap, const byte* data,
+                        ptrdiff_t n) {
+    const byte* end = data + n;
+    byte* p = out;
+    byte* out_end = out + cap;
+    for (;;) {
+        if (data >= end)
+            return -1;
+        unsigned token = *data++;
+        ptrdiff_t size = token >> 4;
+        if (size == 15 && !get_length(&data, end, &size))
+            return -1;
+        if (size > end - data || size > out_end - p)
+            return -1;
+        if (size <= 16 && end - data >= 16 && out_end - p >= 16)
+            memcpy(p, data, 16); // cheaper than a variable size copy
+        else
+            memcpy(p, data, size);
+        p += size;
+        data += size;
+        if (data == end) // the last sequence is just literals
+            return p - out;
+        if (end - data < 2)
+            return -1;
+        ptrdiff_t offset = data[0] | data[1] << 8;
+        data += 2;
+        if (!offset || offset > p - out)
+            return -1;
+        size = token & 15;
+        if (size == 15 && !get_length(&data, end, &size))
+            return -1;
+        size += MIN_MATCH;
+        if (size > out_end - p)
+            return -1;
+        copy_match(p, offset, size, out_end);
+        p += size;
+    }
+}
+
+void lz_frame_compress(VecByte* out, const byte* data, ptrdiff_t n) {
+    assert_notnull(out);
+    vec_byte_append(out, FRAME_MAGIC, 4);
+    for (ptrdiff_t i = 0; i < n; i += FRAME_BLOCK)
+        frame_put_block(out, data + i,
+                        n - i < FRAME_BLOCK ? n - i : FRAME_BLOCK);
+    frame_put_end(out);
+}
+
+bool lz_frame_decompress(VecByte* out, const byte* data, ptrdiff_t n) {
+    assert_notnull(out);
+    ptrdiff_t size = out->_size;
+    if (frame_decompress(out, data, n))
+        return true;
+    out->_size = size;
+    return false;
+}
+
+ptrdiff_t lz_frame_compress_fd(int in_fd, int out_fd) {
+    VecByte raw = vec_byte_alloc_cap(FRAME_BLOCK);
+    VecByte packed = vec_byte_alloc_cap(
+        4 + FRAME_HEADER + lz_compress_bound(FRAME_BLOCK) + 4);
+    vec_byte_append(&packed, FRAME_MAGIC, 4);
+    ptrdiff_t total = 0;
+    for (;;) {
+        vec_byte_clear(&raw);
+        ptrdiff_t count = read_full(&raw, in_fd, FRAME_BLOCK);
+        if (count < 0) {
+            total = -1;
+            break;
+        }
+        if (count)
+            frame_put_block(&packed, raw._values, count);
+        if (count < FRAME_BLOCK)
+            frame_put_end(&packed);
+        if (vec_byte_write_fd(&packed, out_fd) < 0) {
+            total = -1;
+            break;
+        }
+        total += packed._size;
+        if (count < FRAME_BLOCK)
+            break;
+        vec_byte_clear(&packed);
+    }
+    vec_byte_free(&packed);
+    vec_byte_free(&raw);
+    return total;
+}
+
+ptrdiff_t lz_frame_decompress_fd(int in_fd, int out_fd) {
+    VecByte in =
+        vec_byte_alloc_cap(FRAME_HEADER + lz_compress_bound(FRAME_BLOCK));
+    VecByte raw = vec_byte_alloc_cap(FRAME_BLOCK);
+    ptrdiff_t total = frame_decompress_fd(&in, &raw, in_fd, out_fd);
+    vec_byte_free(&raw);
+    vec_byte_free(&in);
+    return total;
+}
+
+static inline uint32_t read_u32(const byte* p) {
+    return (uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 |
+           (uint32_t)p[3] << 24;
+}
+
+static inline uint64_t read_u64(const byte* p) {
+    return (uint64_t)read_u32(p) | (uint64_t)read_u32(p + 4) << 32;
+}
+
+static inline void write_u32(byte* p, uint32_t x) {
+    p[0] = x & 0xFF;
+    p[1] = (x >> 8) & 0xFF;
+    p[2] = (x >> 16) & 0xFF;
+    p[3] = x >> 24;
+}
+
+static inline uint32_t hash4(const byte* p) {
+    return (read_u32(p) * 2654435761u) >> (32 - HASH_BITS);
+}
+
+// Returns where the match between p and (the earlier) ref ends, at most
+// limit, comparing 8 bytes at a time.
+static const byte* match_end(const byte* p, const byte* ref,
+                             const byte* limit) {
+    while (p + 8 <= limit) {
+        uint64_t x = read_u64(p) ^ read_u64(ref);
+        if (x)
+            return p + (__builtin_ctzll(x) >> 3);
+        p += 8;
+        ref += 8;
+    }
+    while (p < limit && *p == *ref) {
+        ++p;
+        ++ref;
+    }
+    return p;
+}
+
+// Writes a token, the literals, and if match_size isn't 0, the match, and
+// returns where the sequence ends.
+static byte* put_sequence(byte* out, const byte* literals,
+                          ptrdiff_t literals_size, ptrdiff_t offset,
+                          ptrdiff_t match_size) {
+    byte* token = out++;
+    *token = (literals_size < 15 ? literals_size : 15) << 4;
+    if (literals_size >= 15)
+        out = put_length(out, literals_size - 15);
+    memcpy(out, literals, literals_size);
+    out += literals_size;
+    if (match_size) {
+        *out++ = offset & 0xFF;
+        *out++ = offset >> 8;
+        ptrdiff_t size = match_size - MIN_MATCH;
+        *token |= size < 15 ? size : 15;
+        if (size >= 15)
+            out = put_length(out, size - 15);
+    }
+    return out;
+}
+
+// Lengths of 15 or more continue after the token in bytes of up to 255.
+static byte* put_length(byte* out, ptrdiff_t n) {
+    for (; n >= 255; n -= 255)
+        *out++ = 255;
+    *out++ = n;
+    return out;
+}
+
+static bool get_length(const byte** data, const byte* end, ptrdiff_t* n) {
+    const byte* p = *data;
+    byte b;
+    do {
+        if (p >= end || *n > INT32_MAX)
+            return false;
+        b = *p++;
+        *n += b;
+    } while (b == 255);
+    *data = p;
+    return true;
+}
+
+// Copies n bytes from offset bytes back, which may overlap them (e.g.,
+// an offset of 1 repeats the previous byte). Where there's room the copy
+// is done 16 bytes at a time (overrunning by up to 15 bytes), first
+// copying enough bytes singly so that the source is a whole number of
+// periods at least 16 bytes back.
+static inline void copy_match(byte* out, ptrdiff_t offset, ptrdiff_t n,
+                              const byte* out_end) {
+    const byte* ref = out - offset;
+    byte* end = out + n;
+    if (out_end - end < 16) {
+        while (out < end)
+            *out++ = *ref++;
+        return;
+    }
+    if (offset < 16) {
+        ptrdiff_t distance = offset * ((offset + 15) / offset);
+        byte* stop = n < distance ? end : out + distance;
+        while (out < stop)
+            *out++ = *ref++;
+        ref = out - distance;
+    }
+    for (; out < end; out += 16, ref += 16)
+        memcpy(out, ref, 16);
+}
+
+// Stores the block uncompressed if compressing doesn't make it smaller.
+// data mustn't point into out.
+static void frame_put_block(VecByte* out, const byte* data, ptrdiff_t n) {
+    byte* p = vec_byte_spare(out, FRAME_HEADER + lz_compress_bound(n));
+    uint32_t size = lz_compress(p + FRAME_HEADER, data, n);
+    uint32_t stored = 0;
+    if (size >= n) {
+        memcpy(p + FRAME_HEADER, data, n);
+        size = n;
+        stored = FRAME_STORED;
+    }
+    write_u32(p, n);
+    write_u32(p + 4, size | stored);
+    write_u32(p + 8, crc32c(data, n));
+    vec_byte_commit(out, FRAME_HEADER + size);
+}
+
+static void frame_put_end(VecByte* out) {
+    write_u32(vec_byte_spare(out, 4), 0);
+    vec_byte_commit(out, 4);
+}
+
+// Returns true and sets size to the block's payload size if the header's
+// sizes are possible.
+static bool frame_header_ok(const byte* header, ptrdiff_t* size) {
+    uint32_t n = read_u32(header);
+    uint32_t packed = read_u32(header + 4);
+    if (!n || n > FRAME_BLOCK)
+        return false;
+    if (packed & FRAME_STORED) {
+        *size = packed & ~FRAME_STORED;
+        return *size == n;
+    }
+    *size = packed;
+    return packed && packed <= lz_compress_bound(n);
+}
+
+static bool frame_get_block(VecByte* out, const byte* header,
+                            const byte* payload) {
+    ptrdiff_t n = read_u32(header);
+    uint32_t packed = read_u32(header + 4);
+    byte* p = vec_byte_spare(out, n);
+    if (packed & FRAME_STORED)
+        memcpy(p, payload, n);
+    else if (lz_decompress(p, n, payload, packed) != n)
+        return false;
+    if (crc32c(p, n) != read_u32(header + 8))
+        return false;
+    vec_byte_commit(out, n);
+    return true;
+}
+
+static bool frame_decompress(VecByte* out, const byte* data, ptrdiff_t n) {
+    const byte* end = data + n;
+    if (n < 4 || memcmp(data, FRAME_MAGIC, 4))
+        return false;
+    data += 4;
+    for (;;) {
+        if (end - data < 4)
+            return false;
+        if (!read_u32(data))
+            return end - data == 4;
+        ptrdiff_t size;
+        if (end - data < FRAME_HEADER || !frame_header_ok(data, &size) ||
+            end - data - FRAME_HEADER < size ||
+            !frame_get_block(out, data, data + FRAME_HEADER))
+            return false;
+        data += FRAME_HEADER + size;
+    }
+}
+
+static ptrdiff_t frame_decompress_fd(VecByte* in, VecByte* raw, int in_fd,
+                                     int out_fd) {
+    ptrdiff_t count = read_full(in, in_fd, 4);
+    if (count < 0)
+        return -1;
+    if (count < 4 || memcmp(in->_values, FRAME_MAGIC, 4))
+        return corrupt();
+    ptrdiff_t total = 0;
+    for (;;) {
+        vec_byte_clear(in);
+        count = read_full(in, in_fd, 4);
+        if (count < 0)
+            return -1;
+        if (count < 4)
+            return corrupt();
+        if (!read_u32(in->_values))
+            return total;
+        count = read_full(in, in_fd, FRAME_HEADER - 4);
+        if (count < 0)
+            return -1;
+        ptrdiff_t size;
+        if (count < FRAME_HEADER - 4 ||
+            !frame_header_ok(in->_values, &size))
+            return corrupt();
+        count = read_full(in, in_fd, size);
+        if (count < 0)
+            return -1;
+        vec_byte_clear(raw);
+        if (count < size ||
+            !frame_get_block(raw, in->_values, in->_values + FRAME_HEADER))
+            return corrupt();
+        if (vec_byte_write_fd(raw, out_fd) < 0)
+            return -1;
+        total += raw->_size;
+    }
+}
+
+// Reads until n bytes have been appended or end of file and returns how
+// many were, or -1 on error.
+static ptrdiff_t read_full(VecByte* vec, int fd, ptrdiff_t n) {
+    ptrdiff_t total = 0;
+    while (total < n) {
+        ptrdiff_t count = vec_byte_read_fd(vec, fd, n - total);
+        if (count < 0)
+            return -1;
+        if (!count)
+            break;
+        total += count;
+    }
+    return total;
+}
+
+static ptrdiff_t corrupt(void) {
+    errno = EBADMSG;
+    return -1;
+}
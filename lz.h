@@ -0,0 +1,56 @@
+// Copyright © 2024-25 Mark Summerfield. All rights reserved.
+// License: GPL-3
+#pragma once
+
+#include "cx.h"
+#include "vec_byte.h"
+#include <stdbool.h>
+#include <stddef.h>
+
+// A self-contained LZ77 compressor that favors speed over ratio. Blocks
+// use the LZ4 block format (literal runs and matches of at least 4 bytes
+// up to 64KB back) so they can be decompressed by any LZ4 block decoder.
+//
+// Frames wrap data of any size as a sequence of blocks (of at most 1MB
+// of uncompressed data each) so that they can be compressed and
+// decompressed in bounded memory: a 4-byte magic "cxZ1", then for each
+// block its uncompressed size, its compressed size (with the top bit set
+// if the block is stored uncompressed since compressing it didn't help)
+// and the CRC32C of its uncompressed data (all little-endian uint32s),
+// followed by its bytes, and finally a uint32 0. See vec_byte.h for
+// VecByte versions.
+
+// Returns the most bytes lz_compress() can write for n bytes.
+ptrdiff_t lz_compress_bound(ptrdiff_t n);
+
+// Writes the n bytes from data to out (of at least lz_compress_bound(n)
+// bytes) as one compressed block and returns the number of bytes written.
+ptrdiff_t lz_compress(byte* out, const byte* data, ptrdiff_t n);
+
+// Writes the bytes the n bytes of the compressed block at data decompress
+// to, to out (of cap bytes), and returns the number written, or -1 if the
+// block is corrupt or would decompress to more than cap bytes (in which
+// case out's contents are undefined). Never reads or writes out of
+// bounds, whatever the data.
+ptrdiff_t lz_decompress(byte* out, ptrdiff_t cap, const byte* data,
+                        ptrdiff_t n);
+
+// Appends the n bytes from data to out as a whole frame.
+void lz_frame_compress(VecByte* out, const byte* data, ptrdiff_t n);
+
+// Appends the bytes the n bytes of the whole frame at data decompress to,
+// to out, and returns true; or returns false and leaves out unchanged if
+// the frame is corrupt (including checksum mismatches) or incomplete.
+bool lz_frame_decompress(VecByte* out, const byte* data, ptrdiff_t n);
+
+// Reads from the file descriptor in_fd until end of file and writes it to
+// out_fd as a frame, a block at a time. Returns the number of bytes
+// written, or -1 on error (with errno set).
+ptrdiff_t lz_frame_compress_fd(int in_fd, int out_fd);
+
+// Reads a frame from the file descriptor in_fd (up to and including its
+// end marker) and writes the decompressed data to out_fd, a block at a
+// time. Returns the number of bytes written, or -1 on error (with errno
+// set, to EBADMSG if the frame is corrupt or incomplete); after an error
+// out_fd may have been given some of the data.
+ptrdiff_t lz_frame_decompress_fd(int in_fd, int out_fd);
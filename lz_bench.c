@@ -0,0 +1,96 @@
+// Copyright © 2024-25 Mark Summerfield. All rights reserved.
+// License: GPL-3
+
+#include "lz_bench.h"
+#include "lz.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+typedef enum { Text, Binary, Random } Kind;
+
+static void fill(byte* data, ptrdiff_t n, Kind kind);
+static void kind_benchmark(binfo* binfo, const char* kind_name,
+                           const byte* data, ptrdiff_t n, int reps);
+
+// Each kind of data is compressed as a frame and decompressed again many
+// times; rates are of the uncompressed bytes and each compress line
+// shows the compression ratio.
+void lz_benchmarks(binfo* binfo) {
+    ptrdiff_t n = binfo->quick ? 1000000 : 16000000;
+    int reps = binfo->quick ? 2 : 20;
+    byte* data = malloc(n);
+    const char* NAMES[] = {"text", "binary", "random"};
+    for (Kind kind = Text; kind <= Random; ++kind) {
+        fill(data, n, kind);
+        kind_benchmark(binfo, NAMES[kind], data, n, reps);
+    }
+    free(data);
+}
+
+// Text is words with a Zipf-like distribution; binary is records of
+// small ints, a counter, and a few flag bytes.
+static void fill(byte* data, ptrdiff_t n, Kind kind) {
+    const char* WORDS[] = {"the ",    "of ",      "and ",     "to ",
+                           "a ",      "in ",      "is ",      "that ",
+                           "for ",    "it ",      "vector ",  "byte ",
+                           "string ", "compress ", "frame\n", "block, "};
+    uint64_t seed = 1;
+    for (ptrdiff_t i = 0; i < n;) {
+        uint64_t x = bench_rand(&seed);
+        switch (kind) {
+        case Text: {
+            int r = x % 256;
+            const char* word = WORDS[r < 128 ? r % 4
+                                     : r < 224 ? 4 + r % 6
+                                               : 10 + r % 6];
+            for (; *word && i < n; ++word)
+                data[i++] = *word;
+            break;
+        }
+        case Binary: {
+            byte record[16] = {x % 100, 0, 0, 0, (i >> 4) & 0xFF,
+                               (i >> 12) & 0xFF, (i >> 20) & 0xFF, 0,
+                               1, 0, x % 3, 0, 0xFF, 0xFF, 0, 0};
+            for (int j = 0; j < 16 && i < n; ++j)
+                data[i++] = record[j];
+            break;
+        }
+        case Random:
+            for (int j = 0; j < 8 && i < n; ++j, x >>= 8)
+                data[i++] = x & 0xFF;
+            break;
+        }
+    }
+}
+
+static void kind_benchmark(binfo* binfo, const char* kind_name,
+                           const byte* data, ptrdiff_t n, int reps) {
+    VecByte packed = vec_byte_alloc();
+    VecByte out = vec_byte_alloc_cap(n);
+    int64_t total = (int64_t)n * reps;
+    char name[64];
+
+    double begin = bench_now();
+    for (int r = 0; r < reps; ++r) {
+        vec_byte_clear(&packed);
+        lz_frame_compress(&packed, data, n);
+    }
+    double secs = bench_now() - begin;
+    snprintf(name, sizeof(name), "lz_frame_compress %s %.2f:1",
+             kind_name, (double)n / VEC_SIZE(&packed));
+    bench_report(binfo, name, total, secs, "B");
+
+    bool ok = true;
+    begin = bench_now();
+    for (int r = 0; r < reps; ++r) {
+        vec_byte_clear(&out);
+        ok &= lz_frame_decompress(&out, packed._values, packed._size);
+    }
+    snprintf(name, sizeof(name), "lz_frame_decompress %s", kind_name);
+    bench_report(binfo, name, total, bench_now() - begin, "B");
+    if (!ok)
+        puts("lz_frame_decompress failed");
+
+    vec_byte_free(&out);
+    vec_byte_free(&packed);
+}
@@ -0,0 +1,217 @@
+// Copyright © 2024-25 Mark Summerfield. All rights reserved.
+// License: GPL-3
+
+#include "lz_test.h"
+#include "exit.h"
+#include "lz.h"
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+typedef enum { Text, Zeros, Binary, Random } Kind;
+
+static void fill(byte* data, ptrdiff_t n, Kind kind);
+static void known_tests(tinfo* tinfo);
+static void block_tests(tinfo* tinfo, const byte* data, ptrdiff_t n);
+static void corrupt_tests(tinfo* tinfo, const byte* data, ptrdiff_t n);
+static void frame_tests(tinfo* tinfo, const byte* data, ptrdiff_t n);
+static void fd_tests(tinfo* tinfo, const byte* data, ptrdiff_t n);
+static void check(tinfo* tinfo, const char* what, ptrdiff_t n, bool ok);
+
+#define MAX_SIZE (5 * 1000 * 1000 / 2) // spans several frame blocks
+
+// Each kind of data is round-tripped at many small sizes (around the
+// minimum match and end-of-block limits), past the 64KB window, and over
+// several frame blocks; and every decoder is fed corrupt data (which
+// must be detected for frames, and never read or written out of bounds).
+void lz_tests(tinfo* tinfo) {
+    if (tinfo->verbose)
+        puts(tinfo->tag);
+    byte* data = malloc(MAX_SIZE);
+    known_tests(tinfo);
+    for (Kind kind = Text; kind <= Random; ++kind) {
+        fill(data, MAX_SIZE, kind);
+        for (int n = 0; n <= 100; ++n)
+            block_tests(tinfo, data, n);
+        block_tests(tinfo, data, 1000);
+        block_tests(tinfo, data, 70000);
+        corrupt_tests(tinfo, data, 300);
+        frame_tests(tinfo, data, 0);
+        frame_tests(tinfo, data, 1000);
+        frame_tests(tinfo, data, MAX_SIZE);
+        fd_tests(tinfo, data, MAX_SIZE);
+    }
+    free(data);
+}
+
+static void fill(byte* data, ptrdiff_t n, Kind kind) {
+    const char* WORDS[] = {"the ",    "quick ", "brown ", "fox ",
+                           "jumps ",  "over ",  "lazy ",  "dog\n",
+                           "VecByte", "lz ",    "frame ", "block "};
+    uint32_t x = 1;
+    for (ptrdiff_t i = 0; i < n;) {
+        x = x * 1103515245u + 12345u;
+        switch (kind) {
+        case Text: {
+            const char* word = WORDS[(x >> 16) % 12];
+            for (; *word && i < n; ++word)
+                data[i++] = *word;
+            break;
+        }
+        case Zeros:
+            data[i++] = 0;
+            break;
+        case Binary: // little-endian small ints
+            for (int j = 0; j < 4 && i < n; ++j)
+                data[i++] = j ? 0 : (x >> 16) % 64;
+            break;
+        case Random:
+            data[i++] = x >> 16;
+            break;
+        }
+    }
+}
+
+static void known_tests(tinfo* tinfo) {
+    // "abc" then a 9-byte match 3 back, then no final literals
+    const byte BLOCK[] = {0x35, 'a', 'b', 'c', 3, 0, 0x00};
+    byte out[32];
+    ptrdiff_t n = lz_decompress(out, sizeof(out), BLOCK, sizeof(BLOCK));
+    check_int_eq(tinfo, n, 12);
+    check(tinfo, "known overlapping match", n,
+          n == 12 && !memcmp(out, "abcabcabcabc", 12));
+    check_int_eq(tinfo, lz_decompress(out, 11, BLOCK, sizeof(BLOCK)), -1);
+    const byte BAD_OFFSET[] = {0x35, 'a', 'b', 'c', 4, 0, 0x00};
+    check_int_eq(tinfo,
+                 lz_decompress(out, sizeof(out), BAD_OFFSET,
+                               sizeof(BAD_OFFSET)),
+                 -1);
+    check_int_eq(tinfo, lz_decompress(out, sizeof(out), BLOCK, 0), -1);
+    check_int_eq(tinfo, lz_decompress(out, sizeof(out), BLOCK, 5), -1);
+}
+
+static void block_tests(tinfo* tinfo, const byte* data, ptrdiff_t n) {
+    byte* packed = malloc(lz_compress_bound(n));
+    byte* out = malloc(n + 1);
+    ptrdiff_t size = lz_compress(packed, data, n);
+    check(tinfo, "block bound", n, size <= lz_compress_bound(n));
+    check(tinfo, "block round trip", n,
+          lz_decompress(out, n, packed, size) == n &&
+              !memcmp(out, data, n));
+    if (n)
+        check(tinfo, "block too small", n,
+              lz_decompress(out, n - 1, packed, size) == -1);
+    free(out);
+    free(packed);
+}
+
+static void corrupt_tests(tinfo* tinfo, const byte* data, ptrdiff_t n) {
+    byte* packed = malloc(lz_compress_bound(n));
+    byte* out = malloc(n);
+    ptrdiff_t size = lz_compress(packed, data, n);
+    for (ptrdiff_t i = 0; i < size; ++i) {
+        byte old = packed[i];
+        for (int bit = 0; bit < 8; ++bit) {
+            packed[i] = old ^ (1 << bit);
+            ptrdiff_t count = lz_decompress(out, n, packed, size);
+            check(tinfo, "corrupt block", n, count >= -1 && count <= n);
+        }
+        packed[i] = old;
+        check(tinfo, "truncated block", n,
+              lz_decompress(out, n, packed, i) <= n);
+    }
+    VecByte frame = vec_byte_alloc();
+    lz_frame_compress(&frame, data, n);
+    VecByte vec = vec_byte_alloc();
+    vec_byte_push(&vec, 'x');
+    for (ptrdiff_t i = 0; i < VEC_SIZE(&frame); ++i) {
+        byte old = frame._values[i];
+        frame._values[i] = old ^ 0x10;
+        // A changed offset can point to an identical earlier copy, so
+        // corruption need only be caught if it changes the data
+        bool ok = lz_frame_decompress(&vec, frame._values, frame._size);
+        check(tinfo, "corrupt frame", n,
+              ok ? VEC_SIZE(&vec) == n + 1 &&
+                       !memcmp(vec._values + 1, data, n)
+                 : VEC_SIZE(&vec) == 1);
+        vec_byte_resize(&vec, 1, 0);
+        frame._values[i] = old;
+        check(tinfo, "truncated frame", n,
+              !lz_frame_decompress(&vec, frame._values, i) &&
+                  VEC_SIZE(&vec) == 1);
+    }
+    vec_byte_free(&vec);
+    vec_byte_free(&frame);
+    free(out);
+    free(packed);
+}
+
+static void frame_tests(tinfo* tinfo, const byte* data, ptrdiff_t n) {
+    VecByte raw = vec_byte_alloc();
+    vec_byte_append(&raw, data, n);
+    VecByte frame = vec_byte_alloc();
+    vec_byte_compress(&frame, &raw);
+    VecByte out = vec_byte_alloc();
+    vec_byte_append(&out, "xyz", 3);
+    check(tinfo, "frame round trip", n,
+          vec_byte_decompress(&out, &frame) &&
+              VEC_SIZE(&out) == n + 3 && !memcmp(out._values, "xyz", 3) &&
+              !memcmp(out._values + 3, data, n));
+    check(tinfo, "frame bound", n,
+          VEC_SIZE(&frame) <= n + n / 128 + 64);
+    vec_byte_push(&frame, 0); // trailing garbage
+    check(tinfo, "frame trailing", n, !vec_byte_decompress(&out, &frame));
+    vec_byte_free(&out);
+    vec_byte_free(&frame);
+    vec_byte_free(&raw);
+}
+
+static void fd_tests(tinfo* tinfo, const byte* data, ptrdiff_t n) {
+    FILE* files[3] = {tmpfile(), tmpfile(), tmpfile()};
+    if (!files[0] || !files[1] || !files[2]) {
+        WARN("FAIL: %s tmpfile() failed\n", tinfo->tag);
+        return;
+    }
+    int fds[3] = {fileno(files[0]), fileno(files[1]), fileno(files[2])};
+    check(tinfo, "fd write", n, write(fds[0], data, n) == n);
+    lseek(fds[0], 0, SEEK_SET);
+    ptrdiff_t size = lz_frame_compress_fd(fds[0], fds[1]);
+    check(tinfo, "fd compress", n, size > 0);
+    lseek(fds[1], 0, SEEK_SET);
+    check(tinfo, "fd decompress", n,
+          lz_frame_decompress_fd(fds[1], fds[2]) == n);
+    VecByte vec = vec_byte_alloc();
+    lseek(fds[1], 0, SEEK_SET);
+    vec_byte_read_fd_all(&vec, fds[1]);
+    VecByte out = vec_byte_alloc();
+    check(tinfo, "fd frame is a frame", n,
+          VEC_SIZE(&vec) == size && vec_byte_decompress(&out, &vec) &&
+              VEC_SIZE(&out) == n);
+    vec_byte_clear(&out);
+    lseek(fds[2], 0, SEEK_SET);
+    vec_byte_read_fd_all(&out, fds[2]);
+    check(tinfo, "fd round trip", n,
+          VEC_SIZE(&out) == n && !memcmp(out._values, data, n));
+    if (ftruncate(fds[1], size - 1) == 0) {
+        lseek(fds[1], 0, SEEK_SET);
+        lseek(fds[2], 0, SEEK_SET);
+        errno = 0;
+        check(tinfo, "fd truncated", n,
+              lz_frame_decompress_fd(fds[1], fds[2]) == -1 &&
+                  errno == EBADMSG);
+    }
+    vec_byte_free(&out);
+    vec_byte_free(&vec);
+    for (int i = 0; i < 3; ++i)
+        fclose(files[i]);
+}
+
+static void check(tinfo* tinfo, const char* what, ptrdiff_t n, bool ok) {
+    tinfo->total++;
+    if (!ok)
+        WARN("FAIL: %s %s n=%td\n", tinfo->tag, what, n);
+    else
+        tinfo->ok++;
+}
@@ -0,0 +1,1486 @@
+// Copyright © 2024-25 Mark Summerfield. All rights reserved.
+// License: GPL-3
+
+#include "simd.h"
+#include "vecs.h"
+#include <stdint.h>
+
+#ifdef SIMD_X86
+#include <immintrin.h>
+#endif
+
+// Per-lane counts are summed before they can overflow.
+#define COUNT_BLOCK ((ptrdiff_t)1 << 24)
+
+// Per-byte-lane counts are summed before they can overflow (every this
+// many vectors).
+#define BYTE_COUNT_BLOCK 255
+
+// Pairwise sums add runs of at most this many values directly.
+#define PAIRWISE_BLOCK 256
+
+typedef double (*SumFn)(const double* values, ptrdiff_t n);
+typedef double (*SqDiffFn)(const double* values, ptrdiff_t n,
+                           double center);
+typedef double (*DotFn)(const double* a, const double* b, ptrdiff_t n);
+
+static SimdLevel max_level = SimdAvx2;
+
+// The best level the CPU supports, found once at startup (querying it
+// costs as much as a short scan).
+static SimdLevel cpu_level = SimdScalar;
+
+__attribute__((constructor)) static void simd_init(void);
+
+static ptrdiff_t scalar_int_find(const int* values, ptrdiff_t n,
+                                 int value);
+static ptrdiff_t scalar_int_find_last(const int* values, ptrdiff_t n,
+                                      int value);
+static ptrdiff_t scalar_int_count(const int* values, ptrdiff_t n,
+                                  int value);
+static int scalar_int_min(const int* values, ptrdiff_t n);
+static int scalar_int_max(const int* values, ptrdiff_t n);
+static bool scalar_int_all_in_range(const int* values, ptrdiff_t n,
+                                    int lo, int hi);
+static double pairwise_sum(SumFn sum, const double* values, ptrdiff_t n);
+static double pairwise_sq_diff(SqDiffFn sq_diff, const double* values,
+                               ptrdiff_t n, double center);
+static double pairwise_dot(DotFn dot, const double* a, const double* b,
+                           ptrdiff_t n);
+static inline void two_sum(double* sum, double* err, double x);
+static double kahan_finish(const double* sums, const double* errs,
+                           int lanes, const double* values, ptrdiff_t n);
+static double scalar_real_sum(const double* values, ptrdiff_t n);
+static double scalar_real_sum_kahan(const double* values, ptrdiff_t n);
+static double scalar_real_sq_diff(const double* values, ptrdiff_t n,
+                                  double center);
+static double scalar_real_dot(const double* a, const double* b,
+                              ptrdiff_t n);
+static double scalar_real_min(const double* values, ptrdiff_t n);
+static double scalar_real_max(const double* values, ptrdiff_t n);
+static void scalar_real_scale(double* values, ptrdiff_t n, double factor);
+static void scalar_real_axpy(double* values, const double* others,
+                             ptrdiff_t n, double factor);
+static void scalar_real_clamp(double* values, ptrdiff_t n, double lo,
+                              double hi);
+static ptrdiff_t scalar_byte_span_ws(const char* s, ptrdiff_t n);
+static ptrdiff_t scalar_byte_span_nonws(const char* s, ptrdiff_t n);
+static ptrdiff_t scalar_byte_count(const char* s, ptrdiff_t n, char c);
+static ptrdiff_t scalar_byte_count_words(const char* s, ptrdiff_t n,
+                                         bool in_word);
+#ifdef SIMD_X86
+static ptrdiff_t sse2_int_find(const int* values, ptrdiff_t n, int value);
+static ptrdiff_t sse2_int_find_last(const int* values, ptrdiff_t n,
+                                    int value);
+static ptrdiff_t sse2_int_count(const int* values, ptrdiff_t n,
+                                int value);
+static int sse2_int_min(const int* values, ptrdiff_t n);
+static int sse2_int_max(const int* values, ptrdiff_t n);
+static bool sse2_int_all_in_range(const int* values, ptrdiff_t n, int lo,
+                                  int hi);
+SIMD_AVX2 static ptrdiff_t avx2_int_find(const int* values, ptrdiff_t n,
+                                         int value);
+SIMD_AVX2 static ptrdiff_t avx2_int_find_last(const int* values,
+                                              ptrdiff_t n, int value);
+SIMD_AVX2 static ptrdiff_t avx2_int_count(const int* values, ptrdiff_t n,
+                                          int value);
+SIMD_AVX2 static int avx2_int_min(const int* values, ptrdiff_t n);
+SIMD_AVX2 static int avx2_int_max(const int* values, ptrdiff_t n);
+SIMD_AVX2 static bool avx2_int_all_in_range(const int* values, ptrdiff_t n,
+                                            int lo, int hi);
+static double sse2_real_sum(const double* values, ptrdiff_t n);
+static double sse2_real_sum_kahan(const double* values, ptrdiff_t n);
+static double sse2_real_sq_diff(const double* values, ptrdiff_t n,
+                                double center);
+static double sse2_real_dot(const double* a, const double* b, ptrdiff_t n);
+static double sse2_real_min(const double* values, ptrdiff_t n);
+static double sse2_real_max(const double* values, ptrdiff_t n);
+static void sse2_real_scale(double* values, ptrdiff_t n, double factor);
+static void sse2_real_axpy(double* values, const double* others,
+                           ptrdiff_t n, double factor);
+static void sse2_real_clamp(double* values, ptrdiff_t n, double lo,
+                            double hi);
+static ptrdiff_t sse2_byte_span_ws(const char* s, ptrdiff_t n);
+static ptrdiff_t sse2_byte_span_nonws(const char* s, ptrdiff_t n);
+static ptrdiff_t sse2_byte_count(const char* s, ptrdiff_t n, char c);
+static ptrdiff_t sse2_byte_count_words(const char* s, ptrdiff_t n);
+SIMD_AVX2 static double avx2_real_sum(const double* values, ptrdiff_t n);
+SIMD_AVX2 static double avx2_real_sum_kahan(const double* values,
+                                            ptrdiff_t n);
+SIMD_AVX2 static double avx2_real_sq_diff(const double* values,
+                                          ptrdiff_t n, double center);
+SIMD_AVX2 static double avx2_real_dot(const double* a, const double* b,
+                                      ptrdiff_t n);
+SIMD_AVX2 static double avx2_real_min(const double* values, ptrdiff_t n);
+SIMD_AVX2 static double avx2_real_max(const double* values, ptrdiff_t n);
+SIMD_AVX2 static void avx2_real_scale(double* values, ptrdiff_t n,
+                                      double factor);
+SIMD_AVX2 static void avx2_real_axpy(double* values, const double* others,
+                                     ptrdiff_t n, double factor);
+SIMD_AVX2 static void avx2_real_clamp(double* values, ptrdiff_t n,
+                                      double lo, double hi);
+SIMD_AVX2 static ptrdiff_t avx2_byte_span_ws(const char* s, ptrdiff_t n);
+SIMD_AVX2 static ptrdiff_t avx2_byte_span_nonws(const char* s,
+                                                ptrdiff_t n);
+SIMD_AVX2 static ptrdiff_t avx2_byte_count(const char* s, ptrdiff_t n,
+                                           char c);
+SIMD_AVX2 static ptrdiff_t avx2_byte_count_words(const char* s,
+                                                 ptrdiff_t n);
+#endif
+
+SimdLevel simd_level(void) {
+    return cpu_level < max_level ? cpu_level : max_level;
+}
+
+void simd_set_max_level(SimdLevel level) { max_level = level; }
+
+bool simd_has_sha(void) {
+#ifdef SIMD_X86
+    return simd_level() >= SimdSse42 && __builtin_cpu_supports("sha");
+#else
+    return false;
+#endif
+}
+
+const char* simd_level_name(SimdLevel level) {
+    switch (level) {
+    case SimdScalar:
+        return "scalar";
+    case SimdSse2:
+        return "sse2";
+    case SimdSse42:
+        return "sse4.2";
+    case SimdAvx2:
+        return "avx2";
+    }
+    return "?";
+}
+
+ptrdiff_t simd_int_find(const int* values, ptrdiff_t n, int value) {
+#ifdef SIMD_X86
+    switch (simd_level()) {
+    case SimdAvx2:
+        return avx2_int_find(values, n, value);
+    case SimdSse42:
+    case SimdSse2:
+        return sse2_int_find(values, n, value);
+    case SimdScalar:
+        break;
+    }
+#endif
+    return scalar_int_find(values, n, value);
+}
+
+ptrdiff_t simd_int_find_last(const int* values, ptrdiff_t n, int value) {
+#ifdef SIMD_X86
+    switch (simd_level()) {
+    case SimdAvx2:
+        return avx2_int_find_last(values, n, value);
+    case SimdSse42:
+    case SimdSse2:
+        return sse2_int_find_last(values, n, value);
+    case SimdScalar:
+        break;
+    }
+#endif
+    return scalar_int_find_last(values, n, value);
+}
+
+ptrdiff_t simd_int_count(const int* values, ptrdiff_t n, int value) {
+#ifdef SIMD_X86
+    switch (simd_level()) {
+    case SimdAvx2:
+        return avx2_int_count(values, n, value);
+    case SimdSse42:
+    case SimdSse2:
+        return sse2_int_count(values, n, value);
+    case SimdScalar:
+        break;
+    }
+#endif
+    return scalar_int_count(values, n, value);
+}
+
+// Finding the smallest value and then its first index are both
+// vectorizable, whereas tracking the index while finding isn't (cheaply).
+ptrdiff_t simd_int_argmin(const int* values, ptrdiff_t n) {
+    if (n <= 0)
+        return VEC_NOT_FOUND;
+    int min;
+#ifdef SIMD_X86
+    switch (simd_level()) {
+    case SimdAvx2:
+        min = avx2_int_min(values, n);
+        break;
+    case SimdSse42:
+    case SimdSse2:
+        min = sse2_int_min(values, n);
+        break;
+    default:
+        min = scalar_int_min(values, n);
+    }
+#else
+    min = scalar_int_min(values, n);
+#endif
+    return simd_int_find(values, n, min);
+}
+
+ptrdiff_t simd_int_argmax(const int* values, ptrdiff_t n) {
+    if (n <= 0)
+        return VEC_NOT_FOUND;
+    int max;
+#ifdef SIMD_X86
+    switch (simd_level()) {
+    case SimdAvx2:
+        max = avx2_int_max(values, n);
+        break;
+    case SimdSse42:
+    case SimdSse2:
+        max = sse2_int_max(values, n);
+        break;
+    default:
+        max = scalar_int_max(values, n);
+    }
+#else
+    max = scalar_int_max(values, n);
+#endif
+    return simd_int_find(values, n, max);
+}
+
+bool simd_int_all_in_range(const int* values, ptrdiff_t n, int lo,
+                           int hi) {
+#ifdef SIMD_X86
+    switch (simd_level()) {
+    case SimdAvx2:
+        return avx2_int_all_in_range(values, n, lo, hi);
+    case SimdSse42:
+    case SimdSse2:
+        return sse2_int_all_in_range(values, n, lo, hi);
+    case SimdScalar:
+        break;
+    }
+#endif
+    return scalar_int_all_in_range(values, n, lo, hi);
+}
+
+double simd_real_sum(const double* values, ptrdiff_t n) {
+    SumFn sum = scalar_real_sum;
+#ifdef SIMD_X86
+    switch (simd_level()) {
+    case SimdAvx2:
+        sum = avx2_real_sum;
+        break;
+    case SimdSse42:
+    case SimdSse2:
+        sum = sse2_real_sum;
+        break;
+    case SimdScalar:
+        break;
+    }
+#endif
+    return pairwise_sum(sum, values, n);
+}
+
+double simd_real_sum_kahan(const double* values, ptrdiff_t n) {
+#ifdef SIMD_X86
+    switch (simd_level()) {
+    case SimdAvx2:
+        return avx2_real_sum_kahan(values, n);
+    case SimdSse42:
+    case SimdSse2:
+        return sse2_real_sum_kahan(values, n);
+    case SimdScalar:
+        break;
+    }
+#endif
+    return scalar_real_sum_kahan(values, n);
+}
+
+double simd_real_sum_sq_diff(const double* values, ptrdiff_t n,
+                             double center) {
+    SqDiffFn sq_diff = scalar_real_sq_diff;
+#ifdef SIMD_X86
+    switch (simd_level()) {
+    case SimdAvx2:
+        sq_diff = avx2_real_sq_diff;
+        break;
+    case SimdSse42:
+    case SimdSse2:
+        sq_diff = sse2_real_sq_diff;
+        break;
+    case SimdScalar:
+        break;
+    }
+#endif
+    return pairwise_sq_diff(sq_diff, values, n, center);
+}
+
+double simd_real_dot(const double* a, const double* b, ptrdiff_t n) {
+    DotFn dot = scalar_real_dot;
+#ifdef SIMD_X86
+    switch (simd_level()) {
+    case SimdAvx2:
+        dot = avx2_real_dot;
+        break;
+    case SimdSse42:
+    case SimdSse2:
+        dot = sse2_real_dot;
+        break;
+    case SimdScalar:
+        break;
+    }
+#endif
+    return pairwise_dot(dot, a, b, n);
+}
+
+double simd_real_min(const double* values, ptrdiff_t n) {
+#ifdef SIMD_X86
+    switch (simd_level()) {
+    case SimdAvx2:
+        return avx2_real_min(values, n);
+    case SimdSse42:
+    case SimdSse2:
+        return sse2_real_min(values, n);
+    case SimdScalar:
+        break;
+    }
+#endif
+    return scalar_real_min(values, n);
+}
+
+double simd_real_max(const double* values, ptrdiff_t n) {
+#ifdef SIMD_X86
+    switch (simd_level()) {
+    case SimdAvx2:
+        return avx2_real_max(values, n);
+    case SimdSse42:
+    case SimdSse2:
+        return sse2_real_max(values, n);
+    case SimdScalar:
+        break;
+    }
+#endif
+    return scalar_real_max(values, n);
+}
+
+void simd_real_scale(double* values, ptrdiff_t n, double factor) {
+#ifdef SIMD_X86
+    switch (simd_level()) {
+    case SimdAvx2:
+        avx2_real_scale(values, n, factor);
+        return;
+    case SimdSse42:
+    case SimdSse2:
+        sse2_real_scale(values, n, factor);
+        return;
+    case SimdScalar:
+        break;
+    }
+#endif
+    scalar_real_scale(values, n, factor);
+}
+
+void simd_real_axpy(double* values, const double* others, ptrdiff_t n,
+                    double factor) {
+#ifdef SIMD_X86
+    switch (simd_level()) {
+    case SimdAvx2:
+        avx2_real_axpy(values, others, n, factor);
+        return;
+    case SimdSse42:
+    case SimdSse2:
+        sse2_real_axpy(values, others, n, factor);
+        return;
+    case SimdScalar:
+        break;
+    }
+#endif
+    scalar_real_axpy(values, others, n, factor);
+}
+
+void simd_real_clamp(double* values, ptrdiff_t n, double lo, double hi) {
+#ifdef SIMD_X86
+    switch (simd_level()) {
+    case SimdAvx2:
+        avx2_real_clamp(values, n, lo, hi);
+        return;
+    case SimdSse42:
+    case SimdSse2:
+        sse2_real_clamp(values, n, lo, hi);
+        return;
+    case SimdScalar:
+        break;
+    }
+#endif
+    scalar_real_clamp(values, n, lo, hi);
+}
+
+inline bool simd_is_ws(char c) {
+    return c == ' ' || (unsigned char)(c - '\t') <= '\r' - '\t';
+}
+
+ptrdiff_t simd_byte_span_ws(const char* s, ptrdiff_t n) {
+#ifdef SIMD_X86
+    switch (simd_level()) {
+    case SimdAvx2:
+        return avx2_byte_span_ws(s, n);
+    case SimdSse42:
+    case SimdSse2:
+        return sse2_byte_span_ws(s, n);
+    case SimdScalar:
+        break;
+    }
+#endif
+    return scalar_byte_span_ws(s, n);
+}
+
+ptrdiff_t simd_byte_span_nonws(const char* s, ptrdiff_t n) {
+#ifdef SIMD_X86
+    switch (simd_level()) {
+    case SimdAvx2:
+        return avx2_byte_span_nonws(s, n);
+    case SimdSse42:
+    case SimdSse2:
+        return sse2_byte_span_nonws(s, n);
+    case SimdScalar:
+        break;
+    }
+#endif
+    return scalar_byte_span_nonws(s, n);
+}
+
+ptrdiff_t simd_byte_count(const char* s, ptrdiff_t n, char c) {
+#ifdef SIMD_X86
+    switch (simd_level()) {
+    case SimdAvx2:
+        return avx2_byte_count(s, n, c);
+    case SimdSse42:
+    case SimdSse2:
+        return sse2_byte_count(s, n, c);
+    case SimdScalar:
+        break;
+    }
+#endif
+    return scalar_byte_count(s, n, c);
+}
+
+ptrdiff_t simd_byte_count_words(const char* s, ptrdiff_t n) {
+#ifdef SIMD_X86
+    switch (simd_level()) {
+    case SimdAvx2:
+        return avx2_byte_count_words(s, n);
+    case SimdSse42:
+    case SimdSse2:
+        return sse2_byte_count_words(s, n);
+    case SimdScalar:
+        break;
+    }
+#endif
+    return scalar_byte_count_words(s, n, false);
+}
+
+// Constructors may run before the CPU info is, hence __builtin_cpu_init.
+static void simd_init(void) {
+#ifdef SIMD_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2") &&
+        __builtin_cpu_supports("sse4.2"))
+        cpu_level = SimdAvx2;
+    else if (__builtin_cpu_supports("sse4.2"))
+        cpu_level = SimdSse42;
+    else if (__builtin_cpu_supports("sse2"))
+        cpu_level = SimdSse2;
+#endif
+}
+
+static ptrdiff_t scalar_int_find(const int* values, ptrdiff_t n,
+                                 int value) {
+    for (ptrdiff_t i = 0; i < n; ++i)
+        if (values[i] == value)
+            return i;
+    return VEC_NOT_FOUND;
+}
+
+static ptrdiff_t scalar_int_find_last(const int* values, ptrdiff_t n,
+                                      int value) {
+    for (ptrdiff_t i = n - 1; i >= 0; --i)
+        if (values[i] == value)
+            return i;
+    return VEC_NOT_FOUND;
+}
+
+static ptrdiff_t scalar_int_count(const int* values, ptrdiff_t n,
+                                  int value) {
+    ptrdiff_t count = 0;
+    for (ptrdiff_t i = 0; i < n; ++i)
+        count += values[i] == value;
+    return count;
+}
+
+static int scalar_int_min(const int* values, ptrdiff_t n) {
+    int min = values[0];
+    for (ptrdiff_t i = 1; i < n; ++i)
+        if (values[i] < min)
+            min = values[i];
+    return min;
+}
+
+static int scalar_int_max(const int* values, ptrdiff_t n) {
+    int max = values[0];
+    for (ptrdiff_t i = 1; i < n; ++i)
+        if (values[i] > max)
+            max = values[i];
+    return max;
+}
+
+static bool scalar_int_all_in_range(const int* values, ptrdiff_t n,
+                                    int lo, int hi) {
+    for (ptrdiff_t i = 0; i < n; ++i)
+        if (values[i] < lo || values[i] > hi)
+            return false;
+    return true;
+}
+
+// Halves are whole multiples of the SIMD kernels' 16 value steps so
+// that only the last run has a scalar tail.
+static double pairwise_sum(SumFn sum, const double* values, ptrdiff_t n) {
+    if (n <= PAIRWISE_BLOCK)
+        return sum(values, n);
+    ptrdiff_t half = (n / 2) & ~(ptrdiff_t)15;
+    return pairwise_sum(sum, values, half) +
+           pairwise_sum(sum, values + half, n - half);
+}
+
+static double pairwise_sq_diff(SqDiffFn sq_diff, const double* values,
+                               ptrdiff_t n, double center) {
+    if (n <= PAIRWISE_BLOCK)
+        return sq_diff(values, n, center);
+    ptrdiff_t half = (n / 2) & ~(ptrdiff_t)15;
+    return pairwise_sq_diff(sq_diff, values, half, center) +
+           pairwise_sq_diff(sq_diff, values + half, n - half, center);
+}
+
+static double pairwise_dot(DotFn dot, const double* a, const double* b,
+                           ptrdiff_t n) {
+    if (n <= PAIRWISE_BLOCK)
+        return dot(a, b, n);
+    ptrdiff_t half = (n / 2) & ~(ptrdiff_t)15;
+    return pairwise_dot(dot, a, b, half) +
+           pairwise_dot(dot, a + half, b + half, n - half);
+}
+
+// Adds x to sum and the addition's rounding error (computed exactly, by
+// Knuth's TwoSum, whichever of sum and x is larger) to err.
+static inline void two_sum(double* sum, double* err, double x) {
+    double t = *sum + x;
+    double z = t - *sum;
+    *err += (*sum - (t - z)) + (x - z);
+    *sum = t;
+}
+
+// Combines the compensated sums of the SIMD lanes and then adds the n
+// tail values.
+static double kahan_finish(const double* sums, const double* errs,
+                           int lanes, const double* values, ptrdiff_t n) {
+    double sum = 0.0;
+    double err = 0.0;
+    for (int j = 0; j < lanes; ++j) {
+        two_sum(&sum, &err, sums[j]);
+        err += errs[j];
+    }
+    for (ptrdiff_t i = 0; i < n; ++i)
+        two_sum(&sum, &err, values[i]);
+    return sum + err;
+}
+
+static double scalar_real_sum(const double* values, ptrdiff_t n) {
+    double sum = 0.0;
+    for (ptrdiff_t i = 0; i < n; ++i)
+        sum += values[i];
+    return sum;
+}
+
+static double scalar_real_sum_kahan(const double* values, ptrdiff_t n) {
+    return kahan_finish(NULL, NULL, 0, values, n);
+}
+
+static double scalar_real_sq_diff(const double* values, ptrdiff_t n,
+                                  double center) {
+    double sum = 0.0;
+    for (ptrdiff_t i = 0; i < n; ++i) {
+        double d = values[i] - center;
+        sum += d * d;
+    }
+    return sum;
+}
+
+static double scalar_real_dot(const double* a, const double* b,
+                              ptrdiff_t n) {
+    double sum = 0.0;
+    for (ptrdiff_t i = 0; i < n; ++i)
+        sum += a[i] * b[i];
+    return sum;
+}
+
+static double scalar_real_min(const double* values, ptrdiff_t n) {
+    double min = values[0];
+    for (ptrdiff_t i = 1; i < n; ++i)
+        if (values[i] < min)
+            min = values[i];
+    return min;
+}
+
+static double scalar_real_max(const double* values, ptrdiff_t n) {
+    double max = values[0];
+    for (ptrdiff_t i = 1; i < n; ++i)
+        if (values[i] > max)
+            max = values[i];
+    return max;
+}
+
+static void scalar_real_scale(double* values, ptrdiff_t n, double factor) {
+    for (ptrdiff_t i = 0; i < n; ++i)
+        values[i] *= factor;
+}
+
+static void scalar_real_axpy(double* values, const double* others,
+                             ptrdiff_t n, double factor) {
+    for (ptrdiff_t i = 0; i < n; ++i)
+        values[i] += factor * others[i];
+}
+
+// As mx_clampd(); the SIMD versions' min and max instructions return
+// their second operand if either is NaN, just like these comparisons.
+static void scalar_real_clamp(double* values, ptrdiff_t n, double lo,
+                              double hi) {
+    for (ptrdiff_t i = 0; i < n; ++i) {
+        double value = values[i] < hi ? values[i] : hi;
+        values[i] = lo > value ? lo : value;
+    }
+}
+
+static ptrdiff_t scalar_byte_span_ws(const char* s, ptrdiff_t n) {
+    ptrdiff_t i = 0;
+    while (i < n && simd_is_ws(s[i]))
+        ++i;
+    return i;
+}
+
+static ptrdiff_t scalar_byte_span_nonws(const char* s, ptrdiff_t n) {
+    ptrdiff_t i = 0;
+    while (i < n && !simd_is_ws(s[i]))
+        ++i;
+    return i;
+}
+
+static ptrdiff_t scalar_byte_count(const char* s, ptrdiff_t n, char c) {
+    ptrdiff_t count = 0;
+    for (ptrdiff_t i = 0; i < n; ++i)
+        count += s[i] == c;
+    return count;
+}
+
+// in_word is true if the char before s (if any) isn't whitespace.
+static ptrdiff_t scalar_byte_count_words(const char* s, ptrdiff_t n,
+                                         bool in_word) {
+    ptrdiff_t count = 0;
+    for (ptrdiff_t i = 0; i < n; ++i) {
+        bool word = !simd_is_ws(s[i]);
+        count += word && !in_word;
+        in_word = word;
+    }
+    return count;
+}
+
+#ifdef SIMD_X86
+
+// SSE2 has no signed 32-bit min or max (they're SSE4.1) so use a mask.
+static inline __m128i sse2_min_epi32(__m128i a, __m128i b) {
+    __m128i gt = _mm_cmpgt_epi32(a, b);
+    return _mm_or_si128(_mm_and_si128(gt, b), _mm_andnot_si128(gt, a));
+}
+
+static inline __m128i sse2_max_epi32(__m128i a, __m128i b) {
+    __m128i gt = _mm_cmpgt_epi32(a, b);
+    return _mm_or_si128(_mm_and_si128(gt, a), _mm_andnot_si128(gt, b));
+}
+
+static inline int sse2_mask(__m128i eq) {
+    return _mm_movemask_ps(_mm_castsi128_ps(eq));
+}
+
+// Returns 0xFF for each whitespace byte (those from \t to \r are found
+// with one unsigned comparison) and 0 for the others.
+static inline __m128i sse2_ws_bytes(__m128i x) {
+    __m128i d = _mm_sub_epi8(x, _mm_set1_epi8('\t'));
+    __m128i ctrl =
+        _mm_cmpeq_epi8(_mm_min_epu8(d, _mm_set1_epi8('\r' - '\t')), d);
+    return _mm_or_si128(ctrl, _mm_cmpeq_epi8(x, _mm_set1_epi8(' ')));
+}
+
+// Returns the sum of the 16 unsigned bytes.
+static inline ptrdiff_t sse2_sum_bytes(__m128i x) {
+    __m128i sums = _mm_sad_epu8(x, _mm_setzero_si128());
+    return _mm_cvtsi128_si64(sums) +
+           _mm_cvtsi128_si64(_mm_unpackhi_epi64(sums, sums));
+}
+
+// The 16-value loop only detects a match; the 4-value loop locates it.
+static ptrdiff_t sse2_int_find(const int* values, ptrdiff_t n, int value) {
+    const __m128i v = _mm_set1_epi32(value);
+    const __m128i* p = (const __m128i*)values;
+    ptrdiff_t i = 0;
+    for (; i + 16 <= n; i += 16, p += 4) {
+        __m128i eq = _mm_or_si128(
+            _mm_or_si128(_mm_cmpeq_epi32(_mm_loadu_si128(p), v),
+                         _mm_cmpeq_epi32(_mm_loadu_si128(p + 1), v)),
+            _mm_or_si128(_mm_cmpeq_epi32(_mm_loadu_si128(p + 2), v),
+                         _mm_cmpeq_epi32(_mm_loadu_si128(p + 3), v)));
+        if (sse2_mask(eq))
+            break;
+    }
+    for (; i + 4 <= n; i += 4) {
+        __m128i x = _mm_loadu_si128((const __m128i*)(values + i));
+        int mask = sse2_mask(_mm_cmpeq_epi32(x, v));
+        if (mask)
+            return i + __builtin_ctz(mask);
+    }
+    for (; i < n; ++i)
+        if (values[i] == value)
+            return i;
+    return VEC_NOT_FOUND;
+}
+
+static ptrdiff_t sse2_int_find_last(const int* values, ptrdiff_t n,
+                                    int value) {
+    const __m128i v = _mm_set1_epi32(value);
+    ptrdiff_t end = n;
+    for (; end >= 16; end -= 16) {
+        const __m128i* p = (const __m128i*)(values + end - 16);
+        __m128i eq = _mm_or_si128(
+            _mm_or_si128(_mm_cmpeq_epi32(_mm_loadu_si128(p), v),
+                         _mm_cmpeq_epi32(_mm_loadu_si128(p + 1), v)),
+            _mm_or_si128(_mm_cmpeq_epi32(_mm_loadu_si128(p + 2), v),
+                         _mm_cmpeq_epi32(_mm_loadu_si128(p + 3), v)));
+        if (sse2_mask(eq))
+            break;
+    }
+    for (; end >= 4; end -= 4) {
+        __m128i x = _mm_loadu_si128((const __m128i*)(values + end - 4));
+        int mask = sse2_mask(_mm_cmpeq_epi32(x, v));
+        if (mask)
+            return end - 4 + 31 - __builtin_clz(mask);
+    }
+    for (ptrdiff_t i = end - 1; i >= 0; --i)
+        if (values[i] == value)
+            return i;
+    return VEC_NOT_FOUND;
+}
+
+// Each equal lane is -1 so subtracting counts it.
+static ptrdiff_t sse2_int_count(const int* values, ptrdiff_t n,
+                                int value) {
+    const __m128i v = _mm_set1_epi32(value);
+    ptrdiff_t count = 0;
+    ptrdiff_t i = 0;
+    while (i + 4 <= n) {
+        ptrdiff_t end = i + COUNT_BLOCK < n ? i + COUNT_BLOCK : n;
+        __m128i acc = _mm_setzero_si128();
+        for (; i + 4 <= end; i += 4) {
+            __m128i x = _mm_loadu_si128((const __m128i*)(values + i));
+            acc = _mm_sub_epi32(acc, _mm_cmpeq_epi32(x, v));
+        }
+        int lanes[4];
+        _mm_storeu_si128((__m128i*)lanes, acc);
+        count += (ptrdiff_t)lanes[0] + lanes[1] + lanes[2] + lanes[3];
+    }
+    for (; i < n; ++i)
+        count += values[i] == value;
+    return count;
+}
+
+static int sse2_int_min(const int* values, ptrdiff_t n) {
+    ptrdiff_t i = 0;
+    int min = values[0];
+    if (n >= 4) {
+        __m128i acc = _mm_loadu_si128((const __m128i*)values);
+        for (i = 4; i + 4 <= n; i += 4)
+            acc = sse2_min_epi32(
+                acc, _mm_loadu_si128((const __m128i*)(values + i)));
+        int lanes[4];
+        _mm_storeu_si128((__m128i*)lanes, acc);
+        min = scalar_int_min(lanes, 4);
+    }
+    for (; i < n; ++i)
+        if (values[i] < min)
+            min = values[i];
+    return min;
+}
+
+static int sse2_int_max(const int* values, ptrdiff_t n) {
+    ptrdiff_t i = 0;
+    int max = values[0];
+    if (n >= 4) {
+        __m128i acc = _mm_loadu_si128((const __m128i*)values);
+        for (i = 4; i + 4 <= n; i += 4)
+            acc = sse2_max_epi32(
+                acc, _mm_loadu_si128((const __m128i*)(values + i)));
+        int lanes[4];
+        _mm_storeu_si128((__m128i*)lanes, acc);
+        max = scalar_int_max(lanes, 4);
+    }
+    for (; i < n; ++i)
+        if (values[i] > max)
+            max = values[i];
+    return max;
+}
+
+static bool sse2_int_all_in_range(const int* values, ptrdiff_t n, int lo,
+                                  int hi) {
+    const __m128i vlo = _mm_set1_epi32(lo);
+    const __m128i vhi = _mm_set1_epi32(hi);
+    ptrdiff_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m128i x = _mm_loadu_si128((const __m128i*)(values + i));
+        __m128i out = _mm_or_si128(_mm_cmpgt_epi32(vlo, x),
+                                   _mm_cmpgt_epi32(x, vhi));
+        if (sse2_mask(out))
+            return false;
+    }
+    return scalar_int_all_in_range(values + i, n - i, lo, hi);
+}
+
+static inline double sse2_hsum(__m128d x) {
+    return _mm_cvtsd_f64(_mm_add_sd(x, _mm_unpackhi_pd(x, x)));
+}
+
+static inline void sse2_two_sum(__m128d* sum, __m128d* err, __m128d x) {
+    __m128d t = _mm_add_pd(*sum, x);
+    __m128d z = _mm_sub_pd(t, *sum);
+    *err = _mm_add_pd(*err, _mm_add_pd(_mm_sub_pd(*sum, _mm_sub_pd(t, z)),
+                                       _mm_sub_pd(x, z)));
+    *sum = t;
+}
+
+static double sse2_real_sum(const double* values, ptrdiff_t n) {
+    __m128d acc0 = _mm_setzero_pd();
+    __m128d acc1 = _mm_setzero_pd();
+    __m128d acc2 = _mm_setzero_pd();
+    __m128d acc3 = _mm_setzero_pd();
+    ptrdiff_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        acc0 = _mm_add_pd(acc0, _mm_loadu_pd(values + i));
+        acc1 = _mm_add_pd(acc1, _mm_loadu_pd(values + i + 2));
+        acc2 = _mm_add_pd(acc2, _mm_loadu_pd(values + i + 4));
+        acc3 = _mm_add_pd(acc3, _mm_loadu_pd(values + i + 6));
+    }
+    double sum = sse2_hsum(
+        _mm_add_pd(_mm_add_pd(acc0, acc1), _mm_add_pd(acc2, acc3)));
+    return sum + scalar_real_sum(values + i, n - i);
+}
+
+static double sse2_real_sum_kahan(const double* values, ptrdiff_t n) {
+    __m128d sum0 = _mm_setzero_pd();
+    __m128d sum1 = _mm_setzero_pd();
+    __m128d err0 = _mm_setzero_pd();
+    __m128d err1 = _mm_setzero_pd();
+    ptrdiff_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        sse2_two_sum(&sum0, &err0, _mm_loadu_pd(values + i));
+        sse2_two_sum(&sum1, &err1, _mm_loadu_pd(values + i + 2));
+    }
+    double sums[4];
+    double errs[4];
+    _mm_storeu_pd(sums, sum0);
+    _mm_storeu_pd(sums + 2, sum1);
+    _mm_storeu_pd(errs, err0);
+    _mm_storeu_pd(errs + 2, err1);
+    return kahan_finish(sums, errs, 4, values + i, n - i);
+}
+
+static double sse2_real_sq_diff(const double* values, ptrdiff_t n,
+                                double center) {
+    const __m128d c = _mm_set1_pd(center);
+    __m128d acc0 = _mm_setzero_pd();
+    __m128d acc1 = _mm_setzero_pd();
+    __m128d acc2 = _mm_setzero_pd();
+    __m128d acc3 = _mm_setzero_pd();
+    ptrdiff_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m128d d0 = _mm_sub_pd(_mm_loadu_pd(values + i), c);
+        __m128d d1 = _mm_sub_pd(_mm_loadu_pd(values + i + 2), c);
+        __m128d d2 = _mm_sub_pd(_mm_loadu_pd(values + i + 4), c);
+        __m128d d3 = _mm_sub_pd(_mm_loadu_pd(values + i + 6), c);
+        acc0 = _mm_add_pd(acc0, _mm_mul_pd(d0, d0));
+        acc1 = _mm_add_pd(acc1, _mm_mul_pd(d1, d1));
+        acc2 = _mm_add_pd(acc2, _mm_mul_pd(d2, d2));
+        acc3 = _mm_add_pd(acc3, _mm_mul_pd(d3, d3));
+    }
+    double sum = sse2_hsum(
+        _mm_add_pd(_mm_add_pd(acc0, acc1), _mm_add_pd(acc2, acc3)));
+    return sum + scalar_real_sq_diff(values + i, n - i, center);
+}
+
+static double sse2_real_dot(const double* a, const double* b,
+                            ptrdiff_t n) {
+    __m128d acc0 = _mm_setzero_pd();
+    __m128d acc1 = _mm_setzero_pd();
+    __m128d acc2 = _mm_setzero_pd();
+    __m128d acc3 = _mm_setzero_pd();
+    ptrdiff_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        acc0 = _mm_add_pd(
+            acc0, _mm_mul_pd(_mm_loadu_pd(a + i), _mm_loadu_pd(b + i)));
+        acc1 = _mm_add_pd(acc1, _mm_mul_pd(_mm_loadu_pd(a + i + 2),
+                                           _mm_loadu_pd(b + i + 2)));
+        acc2 = _mm_add_pd(acc2, _mm_mul_pd(_mm_loadu_pd(a + i + 4),
+                                           _mm_loadu_pd(b + i + 4)));
+        acc3 = _mm_add_pd(acc3, _mm_mul_pd(_mm_loadu_pd(a + i + 6),
+                                           _mm_loadu_pd(b + i + 6)));
+    }
+    double sum = sse2_hsum(
+        _mm_add_pd(_mm_add_pd(acc0, acc1), _mm_add_pd(acc2, acc3)));
+    return sum + scalar_real_dot(a + i, b + i, n - i);
+}
+
+static double sse2_real_min(const double* values, ptrdiff_t n) {
+    ptrdiff_t i = 0;
+    double min = values[0];
+    if (n >= 4) {
+        __m128d acc0 = _mm_loadu_pd(values);
+        __m128d acc1 = _mm_loadu_pd(values + 2);
+        for (i = 4; i + 4 <= n; i += 4) {
+            acc0 = _mm_min_pd(acc0, _mm_loadu_pd(values + i));
+            acc1 = _mm_min_pd(acc1, _mm_loadu_pd(values + i + 2));
+        }
+        double lanes[2];
+        _mm_storeu_pd(lanes, _mm_min_pd(acc0, acc1));
+        min = scalar_real_min(lanes, 2);
+    }
+    for (; i < n; ++i)
+        if (values[i] < min)
+            min = values[i];
+    return min;
+}
+
+static double sse2_real_max(const double* values, ptrdiff_t n) {
+    ptrdiff_t i = 0;
+    double max = values[0];
+    if (n >= 4) {
+        __m128d acc0 = _mm_loadu_pd(values);
+        __m128d acc1 = _mm_loadu_pd(values + 2);
+        for (i = 4; i + 4 <= n; i += 4) {
+            acc0 = _mm_max_pd(acc0, _mm_loadu_pd(values + i));
+            acc1 = _mm_max_pd(acc1, _mm_loadu_pd(values + i + 2));
+        }
+        double lanes[2];
+        _mm_storeu_pd(lanes, _mm_max_pd(acc0, acc1));
+        max = scalar_real_max(lanes, 2);
+    }
+    for (; i < n; ++i)
+        if (values[i] > max)
+            max = values[i];
+    return max;
+}
+
+static void sse2_real_scale(double* values, ptrdiff_t n, double factor) {
+    const __m128d f = _mm_set1_pd(factor);
+    ptrdiff_t i = 0;
+    for (; i + 2 <= n; i += 2)
+        _mm_storeu_pd(values + i, _mm_mul_pd(_mm_loadu_pd(values + i), f));
+    scalar_real_scale(values + i, n - i, factor);
+}
+
+static void sse2_real_axpy(double* values, const double* others,
+                           ptrdiff_t n, double factor) {
+    const __m128d f = _mm_set1_pd(factor);
+    ptrdiff_t i = 0;
+    for (; i + 2 <= n; i += 2)
+        _mm_storeu_pd(values + i,
+                      _mm_add_pd(_mm_loadu_pd(values + i),
+                                 _mm_mul_pd(f, _mm_loadu_pd(others + i))));
+    scalar_real_axpy(values + i, others + i, n - i, factor);
+}
+
+static void sse2_real_clamp(double* values, ptrdiff_t n, double lo,
+                            double hi) {
+    const __m128d vlo = _mm_set1_pd(lo);
+    const __m128d vhi = _mm_set1_pd(hi);
+    ptrdiff_t i = 0;
+    for (; i + 2 <= n; i += 2)
+        _mm_storeu_pd(values + i,
+                      _mm_max_pd(vlo, _mm_min_pd(_mm_loadu_pd(values + i),
+                                                 vhi)));
+    scalar_real_clamp(values + i, n - i, lo, hi);
+}
+
+static ptrdiff_t sse2_byte_span_ws(const char* s, ptrdiff_t n) {
+    ptrdiff_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m128i x = _mm_loadu_si128((const __m128i*)(s + i));
+        int mask = _mm_movemask_epi8(sse2_ws_bytes(x));
+        if (mask != 0xFFFF)
+            return i + __builtin_ctz(~mask);
+    }
+    return i + scalar_byte_span_ws(s + i, n - i);
+}
+
+static ptrdiff_t sse2_byte_span_nonws(const char* s, ptrdiff_t n) {
+    ptrdiff_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m128i x = _mm_loadu_si128((const __m128i*)(s + i));
+        int mask = _mm_movemask_epi8(sse2_ws_bytes(x));
+        if (mask)
+            return i + __builtin_ctz(mask);
+    }
+    return i + scalar_byte_span_nonws(s + i, n - i);
+}
+
+static ptrdiff_t sse2_byte_count(const char* s, ptrdiff_t n, char c) {
+    const __m128i v = _mm_set1_epi8(c);
+    ptrdiff_t count = 0;
+    ptrdiff_t i = 0;
+    while (i + 16 <= n) {
+        __m128i acc = _mm_setzero_si128();
+        for (int k = 0; k < BYTE_COUNT_BLOCK && i + 16 <= n; ++k, i += 16) {
+            __m128i x = _mm_loadu_si128((const __m128i*)(s + i));
+            acc = _mm_sub_epi8(acc, _mm_cmpeq_epi8(x, v));
+        }
+        count += sse2_sum_bytes(acc);
+    }
+    return count + scalar_byte_count(s + i, n - i, c);
+}
+
+// A word starts at each non-whitespace byte whose predecessor (shifted
+// into place with the previous vector's last byte) is whitespace.
+static ptrdiff_t sse2_byte_count_words(const char* s, ptrdiff_t n) {
+    ptrdiff_t count = 0;
+    ptrdiff_t i = 0;
+    __m128i prev = _mm_setzero_si128(); // no words before s
+    while (i + 16 <= n) {
+        __m128i acc = _mm_setzero_si128();
+        for (int k = 0; k < BYTE_COUNT_BLOCK && i + 16 <= n; ++k, i += 16) {
+            __m128i x = _mm_loadu_si128((const __m128i*)(s + i));
+            __m128i word =
+                _mm_xor_si128(sse2_ws_bytes(x), _mm_set1_epi8(-1));
+            __m128i before = _mm_or_si128(_mm_slli_si128(word, 1),
+                                          _mm_srli_si128(prev, 15));
+            acc = _mm_sub_epi8(acc, _mm_andnot_si128(before, word));
+            prev = word;
+        }
+        count += sse2_sum_bytes(acc);
+    }
+    return count + scalar_byte_count_words(s + i, n - i,
+                                           i && !simd_is_ws(s[i - 1]));
+}
+
+SIMD_AVX2 static inline int avx2_mask(__m256i eq) {
+    return _mm256_movemask_ps(_mm256_castsi256_ps(eq));
+}
+
+// The 32-value loop only detects a match; the 8-value loop locates it.
+SIMD_AVX2 static ptrdiff_t avx2_int_find(const int* values, ptrdiff_t n,
+                                         int value) {
+    const __m256i v = _mm256_set1_epi32(value);
+    const __m256i* p = (const __m256i*)values;
+    ptrdiff_t i = 0;
+    for (; i + 32 <= n; i += 32, p += 4) {
+        __m256i eq = _mm256_or_si256(
+            _mm256_or_si256(_mm256_cmpeq_epi32(_mm256_loadu_si256(p), v),
+                            _mm256_cmpeq_epi32(_mm256_loadu_si256(p + 1),
+                                               v)),
+            _mm256_or_si256(_mm256_cmpeq_epi32(_mm256_loadu_si256(p + 2),
+                                               v),
+                            _mm256_cmpeq_epi32(_mm256_loadu_si256(p + 3),
+                                               v)));
+        if (!_mm256_testz_si256(eq, eq))
+            break;
+    }
+    for (; i + 8 <= n; i += 8) {
+        __m256i x = _mm256_loadu_si256((const __m256i*)(values + i));
+        int mask = avx2_mask(_mm256_cmpeq_epi32(x, v));
+        if (mask)
+            return i + __builtin_ctz(mask);
+    }
+    for (; i < n; ++i)
+        if (values[i] == value)
+            return i;
+    return VEC_NOT_FOUND;
+}
+
+SIMD_AVX2 static ptrdiff_t avx2_int_find_last(const int* values,
+                                              ptrdiff_t n, int value) {
+    const __m256i v = _mm256_set1_epi32(value);
+    ptrdiff_t end = n;
+    for (; end >= 32; end -= 32) {
+        const __m256i* p = (const __m256i*)(values + end - 32);
+        __m256i eq = _mm256_or_si256(
+            _mm256_or_si256(_mm256_cmpeq_epi32(_mm256_loadu_si256(p), v),
+                            _mm256_cmpeq_epi32(_mm256_loadu_si256(p + 1),
+                                               v)),
+            _mm256_or_si256(_mm256_cmpeq_epi32(_mm256_loadu_si256(p + 2),
+                                               v),
+                            _mm256_cmpeq_epi32(_mm256_loadu_si256(p + 3),
+                                               v)));
+        if (!_mm256_testz_si256(eq, eq))
+            break;
+    }
+    for (; end >= 8; end -= 8) {
+        __m256i x = _mm256_loadu_si256((const __m256i*)(values + end - 8));
+        int mask = avx2_mask(_mm256_cmpeq_epi32(x, v));
+        if (mask)
+            return end - 8 + 31 - __builtin_clz(mask);
+    }
+    for (ptrdiff_t i = end - 1; i >= 0; --i)
+        if (values[i] == value)
+            return i;
+    return VEC_NOT_FOUND;
+}
+
+SIMD_AVX2 static ptrdiff_t avx2_int_count(const int* values, ptrdiff_t n,
+                                          int value) {
+    const __m256i v = _mm256_set1_epi32(value);
+    ptrdiff_t count = 0;
+    ptrdiff_t i = 0;
+    while (i + 16 <= n) {
+        ptrdiff_t end = i + COUNT_BLOCK < n ? i + COUNT_BLOCK : n;
+        __m256i acc0 = _mm256_setzero_si256();
+        __m256i acc1 = _mm256_setzero_si256();
+        for (; i + 16 <= end; i += 16) {
+            const __m256i* p = (const __m256i*)(values + i);
+            acc0 = _mm256_sub_epi32(
+                acc0, _mm256_cmpeq_epi32(_mm256_loadu_si256(p), v));
+            acc1 = _mm256_sub_epi32(
+                acc1, _mm256_cmpeq_epi32(_mm256_loadu_si256(p + 1), v));
+        }
+        int lanes[8];
+        _mm256_storeu_si256((__m256i*)lanes,
+                            _mm256_add_epi32(acc0, acc1));
+        for (int j = 0; j < 8; ++j)
+            count += lanes[j];
+    }
+    for (; i < n; ++i)
+        count += values[i] == value;
+    return count;
+}
+
+SIMD_AVX2 static int avx2_int_min(const int* values, ptrdiff_t n) {
+    ptrdiff_t i = 0;
+    int min = values[0];
+    if (n >= 16) {
+        const __m256i* p = (const __m256i*)values;
+        __m256i acc0 = _mm256_loadu_si256(p);
+        __m256i acc1 = _mm256_loadu_si256(p + 1);
+        for (i = 16; i + 16 <= n; i += 16) {
+            p = (const __m256i*)(values + i);
+            acc0 = _mm256_min_epi32(acc0, _mm256_loadu_si256(p));
+            acc1 = _mm256_min_epi32(acc1, _mm256_loadu_si256(p + 1));
+        }
+        int lanes[8];
+        _mm256_storeu_si256((__m256i*)lanes, _mm256_min_epi32(acc0, acc1));
+        min = scalar_int_min(lanes, 8);
+    }
+    for (; i < n; ++i)
+        if (values[i] < min)
+            min = values[i];
+    return min;
+}
+
+SIMD_AVX2 static int avx2_int_max(const int* values, ptrdiff_t n) {
+    ptrdiff_t i = 0;
+    int max = values[0];
+    if (n >= 16) {
+        const __m256i* p = (const __m256i*)values;
+        __m256i acc0 = _mm256_loadu_si256(p);
+        __m256i acc1 = _mm256_loadu_si256(p + 1);
+        for (i = 16; i + 16 <= n; i += 16) {
+            p = (const __m256i*)(values + i);
+            acc0 = _mm256_max_epi32(acc0, _mm256_loadu_si256(p));
+            acc1 = _mm256_max_epi32(acc1, _mm256_loadu_si256(p + 1));
+        }
+        int lanes[8];
+        _mm256_storeu_si256((__m256i*)lanes, _mm256_max_epi32(acc0, acc1));
+        max = scalar_int_max(lanes, 8);
+    }
+    for (; i < n; ++i)
+        if (values[i] > max)
+            max = values[i];
+    return max;
+}
+
+SIMD_AVX2 static bool avx2_int_all_in_range(const int* values, ptrdiff_t n,
+                                            int lo, int hi) {
+    const __m256i vlo = _mm256_set1_epi32(lo);
+    const __m256i vhi = _mm256_set1_epi32(hi);
+    ptrdiff_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        const __m256i* p = (const __m256i*)(values + i);
+        __m256i x0 = _mm256_loadu_si256(p);
+        __m256i x1 = _mm256_loadu_si256(p + 1);
+        __m256i out = _mm256_or_si256(
+            _mm256_or_si256(_mm256_cmpgt_epi32(vlo, x0),
+                            _mm256_cmpgt_epi32(x0, vhi)),
+            _mm256_or_si256(_mm256_cmpgt_epi32(vlo, x1),
+                            _mm256_cmpgt_epi32(x1, vhi)));
+        if (!_mm256_testz_si256(out, out))
+            return false;
+    }
+    return scalar_int_all_in_range(values + i, n - i, lo, hi);
+}
+
+SIMD_AVX2 static inline double avx2_hsum(__m256d x) {
+    return sse2_hsum(_mm_add_pd(_mm256_castpd256_pd128(x),
+                                _mm256_extractf128_pd(x, 1)));
+}
+
+SIMD_AVX2 static inline void avx2_two_sum(__m256d* sum, __m256d* err,
+                                          __m256d x) {
+    __m256d t = _mm256_add_pd(*sum, x);
+    __m256d z = _mm256_sub_pd(t, *sum);
+    *err = _mm256_add_pd(
+        *err, _mm256_add_pd(_mm256_sub_pd(*sum, _mm256_sub_pd(t, z)),
+                            _mm256_sub_pd(x, z)));
+    *sum = t;
+}
+
+SIMD_AVX2 static double avx2_real_sum(const double* values, ptrdiff_t n) {
+    __m256d acc0 = _mm256_setzero_pd();
+    __m256d acc1 = _mm256_setzero_pd();
+    __m256d acc2 = _mm256_setzero_pd();
+    __m256d acc3 = _mm256_setzero_pd();
+    ptrdiff_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        acc0 = _mm256_add_pd(acc0, _mm256_loadu_pd(values + i));
+        acc1 = _mm256_add_pd(acc1, _mm256_loadu_pd(values + i + 4));
+        acc2 = _mm256_add_pd(acc2, _mm256_loadu_pd(values + i + 8));
+        acc3 = _mm256_add_pd(acc3, _mm256_loadu_pd(values + i + 12));
+    }
+    double sum = avx2_hsum(_mm256_add_pd(_mm256_add_pd(acc0, acc1),
+                                         _mm256_add_pd(acc2, acc3)));
+    return sum + scalar_real_sum(values + i, n - i);
+}
+
+SIMD_AVX2 static double avx2_real_sum_kahan(const double* values,
+                                            ptrdiff_t n) {
+    __m256d sum0 = _mm256_setzero_pd();
+    __m256d sum1 = _mm256_setzero_pd();
+    __m256d err0 = _mm256_setzero_pd();
+    __m256d err1 = _mm256_setzero_pd();
+    ptrdiff_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        avx2_two_sum(&sum0, &err0, _mm256_loadu_pd(values + i));
+        avx2_two_sum(&sum1, &err1, _mm256_loadu_pd(values + i + 4));
+    }
+    double sums[8];
+    double errs[8];
+    _mm256_storeu_pd(sums, sum0);
+    _mm256_storeu_pd(sums + 4, sum1);
+    _mm256_storeu_pd(errs, err0);
+    _mm256_storeu_pd(errs + 4, err1);
+    return kahan_finish(sums, errs, 8, values + i, n - i);
+}
+
+SIMD_AVX2 static double avx2_real_sq_diff(const double* values,
+                                          ptrdiff_t n, double center) {
+    const __m256d c = _mm256_set1_pd(center);
+    __m256d acc0 = _mm256_setzero_pd();
+    __m256d acc1 = _mm256_setzero_pd();
+    __m256d acc2 = _mm256_setzero_pd();
+    __m256d acc3 = _mm256_setzero_pd();
+    ptrdiff_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m256d d0 = _mm256_sub_pd(_mm256_loadu_pd(values + i), c);
+        __m256d d1 = _mm256_sub_pd(_mm256_loadu_pd(values + i + 4), c);
+        __m256d d2 = _mm256_sub_pd(_mm256_loadu_pd(values + i + 8), c);
+        __m256d d3 = _mm256_sub_pd(_mm256_loadu_pd(values + i + 12), c);
+        acc0 = _mm256_add_pd(acc0, _mm256_mul_pd(d0, d0));
+        acc1 = _mm256_add_pd(acc1, _mm256_mul_pd(d1, d1));
+        acc2 = _mm256_add_pd(acc2, _mm256_mul_pd(d2, d2));
+        acc3 = _mm256_add_pd(acc3, _mm256_mul_pd(d3, d3));
+    }
+    double sum = avx2_hsum(_mm256_add_pd(_mm256_add_pd(acc0, acc1),
+                                         _mm256_add_pd(acc2, acc3)));
+    return sum + scalar_real_sq_diff(values + i, n - i, center);
+}
+
+SIMD_AVX2 static double avx2_real_dot(const double* a, const double* b,
+                                      ptrdiff_t n) {
+    __m256d acc0 = _mm256_setzero_pd();
+    __m256d acc1 = _mm256_setzero_pd();
+    __m256d acc2 = _mm256_setzero_pd();
+    __m256d acc3 = _mm256_setzero_pd();
+    ptrdiff_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        acc0 = _mm256_add_pd(acc0, _mm256_mul_pd(_mm256_loadu_pd(a + i),
+                                                 _mm256_loadu_pd(b + i)));
+        acc1 = _mm256_add_pd(acc1,
+                             _mm256_mul_pd(_mm256_loadu_pd(a + i + 4),
+                                           _mm256_loadu_pd(b + i + 4)));
+        acc2 = _mm256_add_pd(acc2,
+                             _mm256_mul_pd(_mm256_loadu_pd(a + i + 8),
+                                           _mm256_loadu_pd(b + i + 8)));
+        acc3 = _mm256_add_pd(acc3,
+                             _mm256_mul_pd(_mm256_loadu_pd(a + i + 12),
+                                           _mm256_loadu_pd(b + i + 12)));
+    }
+    double sum = avx2_hsum(_mm256_add_pd(_mm256_add_pd(acc0, acc1),
+                                         _mm256_add_pd(acc2, acc3)));
+    return sum + scalar_real_dot(a + i, b + i, n - i);
+}
+
+SIMD_AVX2 static double avx2_real_min(const double* values, ptrdiff_t n) {
+    ptrdiff_t i = 0;
+    double min = values[0];
+    if (n >= 8) {
+        __m256d acc0 = _mm256_loadu_pd(values);
+        __m256d acc1 = _mm256_loadu_pd(values + 4);
+        for (i = 8; i + 8 <= n; i += 8) {
+            acc0 = _mm256_min_pd(acc0, _mm256_loadu_pd(values + i));
+            acc1 = _mm256_min_pd(acc1, _mm256_loadu_pd(values + i + 4));
+        }
+        double lanes[4];
+        _mm256_storeu_pd(lanes, _mm256_min_pd(acc0, acc1));
+        min = scalar_real_min(lanes, 4);
+    }
+    for (; i < n; ++i)
+        if (values[i] < min)
+            min = values[i];
+    return min;
+}
+
+SIMD_AVX2 static double avx2_real_max(const double* values, ptrdiff_t n) {
+    ptrdiff_t i = 0;
+    double max = values[0];
+    if (n >= 8) {
+        __m256d acc0 = _mm256_loadu_pd(values);
+        __m256d acc1 = _mm256_loadu_pd(values + 4);
+        for (i = 8; i + 8 <= n; i += 8) {
+            acc0 = _mm256_max_pd(acc0, _mm256_loadu_pd(values + i));
+            acc1 = _mm256_max_pd(acc1, _mm256_loadu_pd(values + i + 4));
+        }
+        double lanes[4];
+        _mm256_storeu_pd(lanes, _mm256_max_pd(acc0, acc1));
+        max = scalar_real_max(lanes, 4);
+    }
+    for (; i < n; ++i)
+        if (values[i] > max)
+            max = values[i];
+    return max;
+}
+
+SIMD_AVX2 static void avx2_real_scale(double* values, ptrdiff_t n,
+                                      double factor) {
+    const __m256d f = _mm256_set1_pd(factor);
+    ptrdiff_t i = 0;
+    for (; i + 4 <= n; i += 4)
+        _mm256_storeu_pd(values + i,
+                         _mm256_mul_pd(_mm256_loadu_pd(values + i), f));
+    scalar_real_scale(values + i, n - i, factor);
+}
+
+SIMD_AVX2 static void avx2_real_axpy(double* values, const double* others,
+                                     ptrdiff_t n, double factor) {
+    const __m256d f = _mm256_set1_pd(factor);
+    ptrdiff_t i = 0;
+    for (; i + 4 <= n; i += 4)
+        _mm256_storeu_pd(
+            values + i,
+            _mm256_add_pd(_mm256_loadu_pd(values + i),
+                          _mm256_mul_pd(f, _mm256_loadu_pd(others + i))));
+    scalar_real_axpy(values + i, others + i, n - i, factor);
+}
+
+SIMD_AVX2 static void avx2_real_clamp(double* values, ptrdiff_t n,
+                                      double lo, double hi) {
+    const __m256d vlo = _mm256_set1_pd(lo);
+    const __m256d vhi = _mm256_set1_pd(hi);
+    ptrdiff_t i = 0;
+    for (; i + 4 <= n; i += 4)
+        _mm256_storeu_pd(
+            values + i,
+            _mm256_max_pd(vlo,
+                          _mm256_min_pd(_mm256_loadu_pd(values + i), vhi)));
+    scalar_real_clamp(values + i, n - i, lo, hi);
+}
+
+SIMD_AVX2 static inline __m256i avx2_ws_bytes(__m256i x) {
+    __m256i d = _mm256_sub_epi8(x, _mm256_set1_epi8('\t'));
+    __m256i ctrl = _mm256_cmpeq_epi8(
+        _mm256_min_epu8(d, _mm256_set1_epi8('\r' - '\t')), d);
+    return _mm256_or_si256(ctrl,
+                           _mm256_cmpeq_epi8(x, _mm256_set1_epi8(' ')));
+}
+
+SIMD_AVX2 static inline ptrdiff_t avx2_sum_bytes(__m256i x) {
+    __m256i sums = _mm256_sad_epu8(x, _mm256_setzero_si256());
+    __m128i sum = _mm_add_epi64(_mm256_castsi256_si128(sums),
+                                _mm256_extracti128_si256(sums, 1));
+    return _mm_cvtsi128_si64(sum) +
+           _mm_cvtsi128_si64(_mm_unpackhi_epi64(sum, sum));
+}
+
+SIMD_AVX2 static ptrdiff_t avx2_byte_span_ws(const char* s, ptrdiff_t n) {
+    ptrdiff_t i = 0;
+    for (; i + 32 <= n; i += 32) {
+        __m256i x = _mm256_loadu_si256((const __m256i*)(s + i));
+        uint32_t mask = _mm256_movemask_epi8(avx2_ws_bytes(x));
+        if (mask != UINT32_MAX)
+            return i + __builtin_ctz(~mask);
+    }
+    return i + scalar_byte_span_ws(s + i, n - i);
+}
+
+SIMD_AVX2 static ptrdiff_t avx2_byte_span_nonws(const char* s,
+                                                ptrdiff_t n) {
+    ptrdiff_t i = 0;
+    for (; i + 32 <= n; i += 32) {
+        __m256i x = _mm256_loadu_si256((const __m256i*)(s + i));
+        uint32_t mask = _mm256_movemask_epi8(avx2_ws_bytes(x));
+        if (mask)
+            return i + __builtin_ctz(mask);
+    }
+    return i + scalar_byte_span_nonws(s + i, n - i);
+}
+
+SIMD_AVX2 static ptrdiff_t avx2_byte_count(const char* s, ptrdiff_t n,
+                                           char c) {
+    const __m256i v = _mm256_set1_epi8(c);
+    ptrdiff_t count = 0;
+    ptrdiff_t i = 0;
+    while (i + 32 <= n) {
+        __m256i acc = _mm256_setzero_si256();
+        for (int k = 0; k < BYTE_COUNT_BLOCK && i + 32 <= n; ++k, i += 32) {
+            __m256i x = _mm256_loadu_si256((const __m256i*)(s + i));
+            acc = _mm256_sub_epi8(acc, _mm256_cmpeq_epi8(x, v));
+        }
+        count += avx2_sum_bytes(acc);
+    }
+    return count + scalar_byte_count(s + i, n - i, c);
+}
+
+// A word starts at each non-whitespace byte whose predecessor (shifted
+// into place across the two lanes, with the previous vector's last
+// byte) is whitespace.
+SIMD_AVX2 static ptrdiff_t avx2_byte_count_words(const char* s,
+                                                 ptrdiff_t n) {
+    ptrdiff_t count = 0;
+    ptrdiff_t i = 0;
+    __m256i prev = _mm256_setzero_si256(); // no words before s
+    while (i + 32 <= n) {
+        __m256i acc = _mm256_setzero_si256();
+        for (int k = 0; k < BYTE_COUNT_BLOCK && i + 32 <= n; ++k, i += 32) {
+            __m256i x = _mm256_loadu_si256((const __m256i*)(s + i));
+            __m256i word = _mm256_xor_si256(avx2_ws_bytes(x),
+                                            _mm256_set1_epi8(-1));
+            __m256i before = _mm256_alignr_epi8(
+                word, _mm256_permute2x128_si256(prev, word, 0x21), 15);
+            acc = _mm256_sub_epi8(acc, _mm256_andnot_si256(before, word));
+            prev = word;
+        }
+        count += avx2_sum_bytes(acc);
+    }
+    return count + scalar_byte_count_words(s + i, n - i,
+                                           i && !simd_is_ws(s[i - 1]));
+}
+
+#endif
@@ -0,0 +1,143 @@
+// Copyright © 2024-25 Mark Summerfield. All rights reserved.
+// License: GPL-3
+#pragma once
+
+#include "cx.h"
+#include <stdbool.h>
+#include <stddef.h>
+
+// For kernel implementations (e.g., simd.c, codec.c): SIMD_X86 is
+// defined on x86-64, where SSE2 is always available, and functions that
+// use SSE4.2 or AVX2 intrinsics must be marked SIMD_SSE42 or SIMD_AVX2
+// and only called if simd_level() is at least SimdSse42 or SimdAvx2.
+// The SHA extensions aren't part of the SimdLevel ladder so functions
+// that use them must be marked SIMD_SHA and only called if
+// simd_has_sha() is true.
+#if defined(__x86_64__)
+#define SIMD_X86
+#define SIMD_SSE42 __attribute__((target("sse4.2")))
+#define SIMD_AVX2 __attribute__((target("avx2")))
+#define SIMD_SHA __attribute__((target("sha,sse4.2")))
+#endif
+
+// The instruction sets the simd_ kernels can use. Each kernel has a
+// scalar version and x86 SSE2 and AVX2 versions, and the best one the
+// CPU supports (according to CPUID, queried once at startup) is chosen
+// at runtime on every call.
+// SimdSse42 only adds instructions that some kernels elsewhere (e.g.,
+// checksum.c's CRC32C) use; the others treat it as SimdSse2.
+typedef enum SimdLevel {
+    SimdScalar,
+    SimdSse2,
+    SimdSse42,
+    SimdAvx2,
+} SimdLevel;
+
+// Returns the best SimdLevel the CPU supports (SimdScalar on non-x86),
+// capped by simd_set_max_level().
+SimdLevel simd_level(void);
+
+// Caps the SimdLevel the kernels will use (default SimdAvx2), e.g., to
+// test or benchmark the fallbacks. Not thread-safe: call before using
+// the kernels from other threads.
+void simd_set_max_level(SimdLevel level);
+
+// Returns true if the CPU has the x86 SHA extensions and simd_level() is
+// at least SimdSse42 (so capping the level to SimdSse2 or SimdScalar
+// turns them off too).
+bool simd_has_sha(void);
+
+// Returns the SimdLevel's name, e.g., "avx2".
+const char* simd_level_name(SimdLevel level);
+
+// Returns the index of the first value equal to value in the n values
+// or -1 (VEC_NOT_FOUND).
+ptrdiff_t simd_int_find(const int* values, ptrdiff_t n, int value);
+
+// Returns the index of the last value equal to value in the n values
+// or -1 (VEC_NOT_FOUND).
+ptrdiff_t simd_int_find_last(const int* values, ptrdiff_t n, int value);
+
+// Returns how many of the n values are equal to value.
+ptrdiff_t simd_int_count(const int* values, ptrdiff_t n, int value);
+
+// Returns the index of the first smallest of the n values, or -1 if n is
+// 0.
+ptrdiff_t simd_int_argmin(const int* values, ptrdiff_t n);
+
+// Returns the index of the first largest of the n values, or -1 if n is
+// 0.
+ptrdiff_t simd_int_argmax(const int* values, ptrdiff_t n);
+
+// Returns true if every one of the n values is in the inclusive range
+// [lo, hi] (or if n is 0).
+bool simd_int_all_in_range(const int* values, ptrdiff_t n, int lo, int hi);
+
+// Returns the sum of the n values (0 if n is 0). Runs of values are
+// summed pairwise (by recursively halving them), so the rounding error
+// grows with log(n) rather than with n as for a simple loop. Since each
+// level adds in a different order the results may differ slightly.
+double simd_real_sum(const double* values, ptrdiff_t n);
+
+// Returns the sum of the n values (0 if n is 0) using compensated
+// summation: each addition's rounding error is computed exactly (by
+// TwoSum) and the errors are summed separately and added at the end, so
+// the result is usually as accurate as if the sum had been done with
+// twice the precision and then rounded. About 3x slower than
+// simd_real_sum().
+double simd_real_sum_kahan(const double* values, ptrdiff_t n);
+
+// Returns the sum (summed pairwise) of the squares of the differences
+// between each of the n values and center (0 if n is 0).
+double simd_real_sum_sq_diff(const double* values, ptrdiff_t n,
+                             double center);
+
+// Returns the dot product (summed pairwise) of the n values in a and b
+// (0 if n is 0).
+double simd_real_dot(const double* a, const double* b, ptrdiff_t n);
+
+// Returns the smallest of the n values; n must be at least 1. The result
+// is unspecified if any of the values is NaN.
+double simd_real_min(const double* values, ptrdiff_t n);
+
+// Returns the largest of the n values; n must be at least 1. The result
+// is unspecified if any of the values is NaN.
+double simd_real_max(const double* values, ptrdiff_t n);
+
+// Multiplies each of the n values by factor.
+void simd_real_scale(double* values, ptrdiff_t n, double factor);
+
+// Adds factor times each of the n others to the corresponding value,
+// i.e., values[i] += factor * others[i] (often called axpy).
+void simd_real_axpy(double* values, const double* others, ptrdiff_t n,
+                    double factor);
+
+// Replaces each of the n values with mx_clampd(lo, value, hi) (see
+// mx.h), i.e., max(lo, min(value, hi)), so if lo > hi every value
+// becomes lo, and otherwise NaNs become hi.
+void simd_real_clamp(double* values, ptrdiff_t n, double lo, double hi);
+
+// The byte kernels scan the n chars at s (which needn't be
+// NUL-terminated, and NULs are just chars) and never read beyond them.
+// Whitespace is as for isspace() in the "C" locale: space, \t, \n, \v,
+// \f, and \r.
+
+// Returns true if c is whitespace as the byte kernels see it (and as
+// str.h's trim, split, and skip functions do, whatever the locale).
+bool simd_is_ws(char c);
+
+// Returns how many of the chars are whitespace before the first that
+// isn't (n if they all are).
+ptrdiff_t simd_byte_span_ws(const char* s, ptrdiff_t n);
+
+// Returns how many of the chars are not whitespace before the first
+// that is (n if none are).
+ptrdiff_t simd_byte_span_nonws(const char* s, ptrdiff_t n);
+
+// Returns how many of the chars equal c, e.g., to count a line's
+// delimiters before splitting it.
+ptrdiff_t simd_byte_count(const char* s, ptrdiff_t n, char c);
+
+// Returns how many words (maximal runs of non-whitespace chars) there
+// are, i.e., how many parts splitting on whitespace would give.
+ptrdiff_t simd_byte_count_words(const char* s, ptrdiff_t n);
@@ -0,0 +1,310 @@
+// Copyright © 2024-25 Mark Summerfield. All rights reserved.
+// License: GPL-3
+
+#include "simd_bench.h"
+#include "simd.h"
+#include "str.h"
+#include "vec_byte.h"
+#include "vec_int.h"
+#include "vec_real.h"
+#include "vec_str.h"
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+static void int_benchmarks(binfo* binfo, int n, int reps);
+static void byte_benchmarks(binfo* binfo, int n, int reps);
+static void real_benchmarks(binfo* binfo, int n, int reps);
+static void record_benchmarks(binfo* binfo, int n, int reps,
+                              int max_gap);
+static void csv_benchmarks(binfo* binfo, int n, int reps);
+static char* make_record(int n, char sep, int max_gap);
+static ptrdiff_t isspace_word_count(const char* p);
+
+// Each scan is over a whole 100K value VecInt (the value sought is
+// absent) repeated many times, at each level the CPU supports. The
+// VecReal rates are in floating-point operations (e.g., 2 per value for
+// a dot product) over 64K values (so two vecs fit in L2 cache). The
+// record rates are in bytes of a 16KB record being skipped through or
+// split, first with gaps of up to 3 chars, then (as in column-aligned
+// text) of up to 40, and then by single commas.
+void simd_benchmarks(binfo* binfo) {
+    int reps = binfo->quick ? 100 : 10000;
+    int_benchmarks(binfo, 100000, reps);
+    byte_benchmarks(binfo, 1000000, reps / 10);
+    real_benchmarks(binfo, 65536, reps);
+    record_benchmarks(binfo, 16384, reps / 10, 3);
+    record_benchmarks(binfo, 16384, reps / 10, 40);
+    csv_benchmarks(binfo, 16384, reps / 10);
+}
+
+static void int_benchmarks(binfo* binfo, int n, int reps) {
+    uint64_t seed = 1;
+    VecInt vec = vec_int_alloc_cap(n);
+    for (int i = 0; i < n; ++i)
+        vec_int_push(&vec, (int)(bench_rand(&seed) % 1000000));
+    simd_set_max_level(SimdAvx2);
+    SimdLevel best = simd_level();
+    int64_t total = (int64_t)n * reps;
+    char name[64];
+    for (SimdLevel level = SimdScalar; level <= best; ++level) {
+        simd_set_max_level(level);
+        const char* level_name = simd_level_name(level);
+        ptrdiff_t sum = 0; // so the scans can't be optimized away
+
+        double begin = bench_now();
+        for (int r = 0; r < reps; ++r)
+            sum += vec_int_find(&vec, -1 - r);
+        snprintf(name, sizeof(name), "vec_int_find %s", level_name);
+        bench_report(binfo, name, total, bench_now() - begin, "");
+
+        begin = bench_now();
+        for (int r = 0; r < reps; ++r)
+            sum += vec_int_find_last(&vec, -1 - r);
+        snprintf(name, sizeof(name), "vec_int_find_last %s", level_name);
+        bench_report(binfo, name, total, bench_now() - begin, "");
+
+        begin = bench_now();
+        for (int r = 0; r < reps; ++r)
+            sum += vec_int_count(&vec, r);
+        snprintf(name, sizeof(name), "vec_int_count %s", level_name);
+        bench_report(binfo, name, total, bench_now() - begin, "");
+
+        begin = bench_now();
+        for (int r = 0; r < reps; ++r)
+            sum += vec_int_argmin(&vec);
+        snprintf(name, sizeof(name), "vec_int_argmin %s", level_name);
+        bench_report(binfo, name, total, bench_now() - begin, "");
+
+        begin = bench_now();
+        for (int r = 0; r < reps; ++r)
+            sum += vec_int_all_in_range(&vec, -r, 1000000);
+        snprintf(name, sizeof(name), "vec_int_all_in_range %s",
+                 level_name);
+        bench_report(binfo, name, total, bench_now() - begin, "");
+
+        if (sum == 42)
+            puts("");
+    }
+    simd_set_max_level(SimdAvx2);
+    vec_int_free(&vec);
+}
+
+static void byte_benchmarks(binfo* binfo, int n, int reps) {
+    VecByte vec = vec_byte_alloc_cap(n);
+    for (int i = 0; i < n; ++i)
+        vec_byte_push(&vec, (byte)(i % 251));
+    int64_t total = (int64_t)n * reps;
+    ptrdiff_t sum = 0;
+
+    double begin = bench_now();
+    for (int r = 0; r < reps; ++r)
+        sum += vec_byte_find(&vec, 0xFF);
+    bench_report(binfo, "vec_byte_find", total, bench_now() - begin, "B");
+
+    begin = bench_now();
+    for (int r = 0; r < reps; ++r)
+        sum += vec_byte_find_last(&vec, 0xFF);
+    bench_report(binfo, "vec_byte_find_last", total, bench_now() - begin,
+                 "B");
+
+    if (sum == 42)
+        puts("");
+    vec_byte_free(&vec);
+}
+
+static void real_benchmarks(binfo* binfo, int n, int reps) {
+    uint64_t seed = 1;
+    VecReal vec1 = vec_real_alloc_cap(n);
+    VecReal vec2 = vec_real_alloc_cap(n);
+    for (int i = 0; i < n; ++i) {
+        vec_real_push(&vec1, (double)(bench_rand(&seed) % 1000000) / 7.0);
+        vec_real_push(&vec2, (double)(bench_rand(&seed) % 1000) / 999.0);
+    }
+    simd_set_max_level(SimdAvx2);
+    SimdLevel best = simd_level();
+    int64_t total = (int64_t)n * reps;
+    char name[64];
+    for (SimdLevel level = SimdScalar; level <= best; ++level) {
+        simd_set_max_level(level);
+        const char* level_name = simd_level_name(level);
+        double sum = 0.0; // so the reductions can't be optimized away
+
+        double begin = bench_now();
+        for (int r = 0; r < reps; ++r)
+            sum += vec_real_sum(&vec1);
+        snprintf(name, sizeof(name), "vec_real_sum %s", level_name);
+        bench_report(binfo, name, total, bench_now() - begin, "FLOP");
+
+        begin = bench_now();
+        for (int r = 0; r < reps; ++r)
+            sum += vec_real_sum_kahan(&vec1);
+        snprintf(name, sizeof(name), "vec_real_sum_kahan %s", level_name);
+        bench_report(binfo, name, total, bench_now() - begin, "FLOP");
+
+        begin = bench_now();
+        for (int r = 0; r < reps; ++r)
+            sum += vec_real_variance(&vec1);
+        snprintf(name, sizeof(name), "vec_real_variance %s", level_name);
+        bench_report(binfo, name, 4 * total, bench_now() - begin, "FLOP");
+
+        begin = bench_now();
+        for (int r = 0; r < reps; ++r)
+            sum += vec_real_dot(&vec1, &vec2);
+        snprintf(name, sizeof(name), "vec_real_dot %s", level_name);
+        bench_report(binfo, name, 2 * total, bench_now() - begin, "FLOP");
+
+        begin = bench_now();
+        for (int r = 0; r < reps; ++r)
+            sum += vec_real_max(&vec1);
+        snprintf(name, sizeof(name), "vec_real_max %s", level_name);
+        bench_report(binfo, name, total, bench_now() - begin, "FLOP");
+
+        // Alternately scaling up and down and adding and subtracting
+        // keeps the values (roughly) where they were.
+        begin = bench_now();
+        for (int r = 0; r < reps; ++r)
+            vec_real_scale(&vec1, r % 2 ? 0.5 : 2.0);
+        snprintf(name, sizeof(name), "vec_real_scale %s", level_name);
+        bench_report(binfo, name, total, bench_now() - begin, "FLOP");
+
+        begin = bench_now();
+        for (int r = 0; r < reps; ++r)
+            vec_real_add_scaled(&vec1, r % 2 ? -1.5 : 1.5, &vec2);
+        snprintf(name, sizeof(name), "vec_real_add_scaled %s", level_name);
+        bench_report(binfo, name, 2 * total, bench_now() - begin, "FLOP");
+
+        begin = bench_now();
+        for (int r = 0; r < reps; ++r)
+            vec_real_clamp(&vec1, -1.0, 1e6);
+        snprintf(name, sizeof(name), "vec_real_clamp %s", level_name);
+        bench_report(binfo, name, 2 * total, bench_now() - begin, "FLOP");
+
+        if (sum == 42.0)
+            puts("");
+    }
+    simd_set_max_level(SimdAvx2);
+    vec_real_free(&vec2);
+    vec_real_free(&vec1);
+}
+
+// Compares the isspace() loops that skip_ws() and skip_nonws() used to
+// be with the byte-class scanners they (and the splits) now use, on a
+// long record of fields of 1-16 chars separated by runs of 1-max_gap
+// spaces or tabs. The csv record's fields are separated by commas.
+static void record_benchmarks(binfo* binfo, int n, int reps,
+                              int max_gap) {
+    char* record = make_record(n, 0, max_gap);
+    int64_t total = (int64_t)n * reps;
+    ptrdiff_t sum = 0;
+
+    double begin = bench_now();
+    for (int r = 0; r < reps; ++r)
+        sum += isspace_word_count(record);
+    char name[64];
+    snprintf(name, sizeof(name), "isspace() word walk gap%d", max_gap);
+    bench_report(binfo, name, total, bench_now() - begin, "B");
+
+    simd_set_max_level(SimdAvx2);
+    SimdLevel best = simd_level();
+    VecStr parts = vec_str_alloc();
+    for (SimdLevel level = SimdScalar; level <= best; ++level) {
+        simd_set_max_level(level);
+        const char* level_name = simd_level_name(level);
+
+        begin = bench_now();
+        for (int r = 0; r < reps; ++r)
+            for (const char* p = skip_ws(record); *p;
+                 p = skip_ws(skip_nonws(p)))
+                sum++;
+        snprintf(name, sizeof(name), "skip_ws word walk gap%d %s", max_gap,
+                 level_name);
+        bench_report(binfo, name, total, bench_now() - begin, "B");
+
+        begin = bench_now();
+        for (int r = 0; r < reps; ++r) {
+            StrSplit split = str_split_ws(record);
+            for (StrView part; str_split_next(&split, &part);)
+                sum += part.n;
+        }
+        snprintf(name, sizeof(name), "str_split_ws gap%d %s", max_gap,
+                 level_name);
+        bench_report(binfo, name, total, bench_now() - begin, "B");
+
+        begin = bench_now();
+        for (int r = 0; r < reps; ++r) {
+            vec_str_clear(&parts);
+            vec_str_shrink_to_fit(&parts); // so pre-sizing counts
+            vec_str_append_split_ws(&parts, record);
+            sum += VEC_SIZE(&parts);
+        }
+        snprintf(name, sizeof(name), "split_ws gap%d %s", max_gap,
+                 level_name);
+        bench_report(binfo, name, total, bench_now() - begin, "B");
+
+    }
+    simd_set_max_level(SimdAvx2);
+    if (sum == 42)
+        puts("");
+    vec_str_free(&parts);
+    free(record);
+}
+
+static void csv_benchmarks(binfo* binfo, int n, int reps) {
+    char* csv = make_record(n, ',', 1);
+    int64_t total = (int64_t)n * reps;
+    ptrdiff_t sum = 0;
+    simd_set_max_level(SimdAvx2);
+    SimdLevel best = simd_level();
+    char name[64];
+    VecStr parts = vec_str_alloc();
+    for (SimdLevel level = SimdScalar; level <= best; ++level) {
+        simd_set_max_level(level);
+        double begin = bench_now();
+        for (int r = 0; r < reps; ++r) {
+            vec_str_clear(&parts);
+            vec_str_shrink_to_fit(&parts); // so pre-sizing counts
+            vec_str_append_split_chr(&parts, csv, ',');
+            sum += VEC_SIZE(&parts);
+        }
+        snprintf(name, sizeof(name), "split_chr %s",
+                 simd_level_name(level));
+        bench_report(binfo, name, total, bench_now() - begin, "B");
+    }
+    simd_set_max_level(SimdAvx2);
+    if (sum == 42)
+        puts("");
+    vec_str_free(&parts);
+    free(csv);
+}
+
+// Returns a new record of n - 1 chars: fields separated by sep or (if
+// sep is NUL) by runs of 1-max_gap spaces and tabs.
+static char* make_record(int n, char sep, int max_gap) {
+    uint64_t seed = 7;
+    char* record = malloc(n);
+    int i = 0;
+    while (i < n - 1) {
+        int size = 1 + (int)(bench_rand(&seed) % 16);
+        for (int j = 0; j < size && i < n - 1; ++j)
+            record[i++] = 'a' + (char)(bench_rand(&seed) % 26);
+        int gap = sep ? 1 : 1 + (int)(bench_rand(&seed) % max_gap);
+        for (int j = 0; j < gap && i < n - 1; ++j)
+            record[i++] = sep ? sep : " \t"[bench_rand(&seed) % 2];
+    }
+    record[i] = 0;
+    return record;
+}
+
+static ptrdiff_t isspace_word_count(const char* p) {
+    ptrdiff_t count = 0;
+    for (;;) {
+        while (isspace((unsigned char)*p))
+            p++;
+        if (!*p)
+            return count;
+        count++;
+        while (*p && !isspace((unsigned char)*p))
+            p++;
+    }
+}
@@ -0,0 +1,277 @@
+// Copyright © 2024-25 Mark Summerfield. All rights reserved.
+// License: GPL-3
+
+#include "simd_test.h"
+#include "exit.h"
+#include "mx.h"
+#include "simd.h"
+#include "vecs.h"
+#include <limits.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static void int_find_tests(tinfo* tinfo, int* a, int n);
+static void int_extreme_tests(tinfo* tinfo, int* a, int n);
+static void int_range_tests(tinfo* tinfo, int* a, int n);
+static void real_tests(tinfo* tinfo, double* x, double* y, int n);
+static void real_extreme_tests(tinfo* tinfo, double* x, int n);
+static void real_update_tests(tinfo* tinfo, double* x, double* y, int n);
+static void byte_span_tests(tinfo* tinfo, char* b, int n);
+static void byte_count_tests(tinfo* tinfo, char* b, int n);
+static void byte_count_long_tests(tinfo* tinfo);
+static void check(tinfo* tinfo, const char* what, int n, ptrdiff_t got,
+                  ptrdiff_t expected);
+static void check_real(tinfo* tinfo, const char* what, int n, double got,
+                       double expected);
+
+// Every level the CPU supports is tested against known results at
+// sizes around each level's block sizes and with the target value at
+// positions spread across each array. The real values are multiples of
+// 1/8 small enough that every sum is exact whatever the order of the
+// additions, so the results must match exactly. The byte kernels are
+// checked against straightforward loops over every byte value.
+void simd_tests(tinfo* tinfo) {
+    if (tinfo->verbose)
+        puts(tinfo->tag);
+    const int SIZES[] = {0,  1,  3,  4,  5,  7,  8,  9,   15,   16,
+                         17, 31, 32, 33, 47, 64, 65, 100, 1000, 4099};
+    int* a = malloc(4099 * sizeof(int));
+    double* x = malloc(4099 * sizeof(double));
+    double* y = malloc(4099 * sizeof(double));
+    char* b = malloc(4099);
+    simd_set_max_level(SimdAvx2);
+    SimdLevel best = simd_level();
+    for (SimdLevel level = SimdScalar; level <= best; ++level) {
+        simd_set_max_level(level);
+        if (tinfo->verbose)
+            printf("  %s\n", simd_level_name(level));
+        for (int s = 0; s < (int)(sizeof(SIZES) / sizeof(SIZES[0])); ++s) {
+            int_find_tests(tinfo, a, SIZES[s]);
+            int_extreme_tests(tinfo, a, SIZES[s]);
+            int_range_tests(tinfo, a, SIZES[s]);
+            real_tests(tinfo, x, y, SIZES[s]);
+            real_extreme_tests(tinfo, x, SIZES[s]);
+            real_update_tests(tinfo, x, y, SIZES[s]);
+            byte_span_tests(tinfo, b, SIZES[s]);
+            byte_count_tests(tinfo, b, SIZES[s]);
+        }
+        byte_count_long_tests(tinfo);
+    }
+    simd_set_max_level(SimdAvx2);
+    free(b);
+    free(y);
+    free(x);
+    free(a);
+}
+
+static void int_find_tests(tinfo* tinfo, int* a, int n) {
+    for (int i = 0; i < n; ++i)
+        a[i] = i % 5;
+    check(tinfo, "find none", n, simd_int_find(a, n, 7), VEC_NOT_FOUND);
+    check(tinfo, "find_last none", n, simd_int_find_last(a, n, 7),
+          VEC_NOT_FOUND);
+    check(tinfo, "count none", n, simd_int_count(a, n, 7), 0);
+    check(tinfo, "count", n, simd_int_count(a, n, 3), (n + 1) / 5);
+    int step = n > 16 ? n / 13 + 1 : 1;
+    for (int i = 0; i < n; i += step) {
+        for (int j = i; j < n; j += step) {
+            a[i] = a[j] = -7;
+            check(tinfo, "find", n, simd_int_find(a, n, -7), i);
+            check(tinfo, "find_last", n, simd_int_find_last(a, n, -7), j);
+            check(tinfo, "count two", n, simd_int_count(a, n, -7),
+                  1 + (i != j));
+            a[i] = i % 5;
+            a[j] = j % 5;
+        }
+    }
+}
+
+static void int_extreme_tests(tinfo* tinfo, int* a, int n) {
+    check(tinfo, "argmin empty", n, simd_int_argmin(a, 0), VEC_NOT_FOUND);
+    check(tinfo, "argmax empty", n, simd_int_argmax(a, 0), VEC_NOT_FOUND);
+    if (!n)
+        return;
+    for (int i = 0; i < n; ++i)
+        a[i] = (int)((i * 2654435761u) % 1000) - 500;
+    int step = n > 16 ? n / 13 + 1 : 1;
+    for (int i = 0; i < n; i += step) {
+        int old = a[i];
+        a[i] = INT_MIN;
+        check(tinfo, "argmin", n, simd_int_argmin(a, n), i);
+        a[i] = INT_MAX;
+        check(tinfo, "argmax", n, simd_int_argmax(a, n), i);
+        a[i] = old;
+    }
+    for (int i = 0; i < n; ++i)
+        a[i] = 9;
+    check(tinfo, "argmin equal", n, simd_int_argmin(a, n), 0);
+    check(tinfo, "argmax equal", n, simd_int_argmax(a, n), 0);
+}
+
+static void int_range_tests(tinfo* tinfo, int* a, int n) {
+    for (int i = 0; i < n; ++i)
+        a[i] = -10 + i % 21;
+    check(tinfo, "all_in_range", n, simd_int_all_in_range(a, n, -10, 10),
+          true);
+    int step = n > 16 ? n / 13 + 1 : 1;
+    for (int i = 0; i < n; i += step) {
+        int old = a[i];
+        a[i] = 11;
+        check(tinfo, "all_in_range hi", n,
+              simd_int_all_in_range(a, n, -10, 10), false);
+        a[i] = -11;
+        check(tinfo, "all_in_range lo", n,
+              simd_int_all_in_range(a, n, -10, 10), false);
+        a[i] = old;
+    }
+}
+
+static void real_tests(tinfo* tinfo, double* x, double* y, int n) {
+    double sum = 0.0;
+    double sq_diff = 0.0;
+    double dot = 0.0;
+    for (int i = 0; i < n; ++i) {
+        x[i] = (double)((i * 2654435761u) % 1000) / 8.0 - 60.0;
+        y[i] = (double)(i % 7) - 3.0;
+        sum += x[i];
+        sq_diff += (x[i] - 0.5) * (x[i] - 0.5);
+        dot += x[i] * y[i];
+    }
+    check_real(tinfo, "sum", n, simd_real_sum(x, n), sum);
+    check_real(tinfo, "sum_kahan", n, simd_real_sum_kahan(x, n), sum);
+    check_real(tinfo, "sum_sq_diff", n, simd_real_sum_sq_diff(x, n, 0.5),
+               sq_diff);
+    check_real(tinfo, "dot", n, simd_real_dot(x, y, n), dot);
+}
+
+static void real_extreme_tests(tinfo* tinfo, double* x, int n) {
+    if (!n)
+        return;
+    for (int i = 0; i < n; ++i)
+        x[i] = (double)((i * 2654435761u) % 1000) - 500.5;
+    int step = n > 16 ? n / 13 + 1 : 1;
+    for (int i = 0; i < n; i += step) {
+        double old = x[i];
+        x[i] = -1e300;
+        check_real(tinfo, "min", n, simd_real_min(x, n), -1e300);
+        x[i] = 1e300;
+        check_real(tinfo, "max", n, simd_real_max(x, n), 1e300);
+        x[i] = old;
+    }
+}
+
+static void real_update_tests(tinfo* tinfo, double* x, double* y, int n) {
+    for (int i = 0; i < n; ++i) {
+        x[i] = (double)(i % 11) - 5.0;
+        y[i] = (double)(i % 3);
+    }
+    simd_real_scale(x, n, 0.5);
+    int bad = 0;
+    for (int i = 0; i < n; ++i)
+        bad += x[i] != ((double)(i % 11) - 5.0) * 0.5;
+    check(tinfo, "scale", n, bad, 0);
+    simd_real_axpy(x, y, n, -2.0);
+    bad = 0;
+    for (int i = 0; i < n; ++i)
+        bad += x[i] != ((double)(i % 11) - 5.0) * 0.5 - 2.0 * (i % 3);
+    check(tinfo, "axpy", n, bad, 0);
+    for (int i = 0; i < n; ++i) {
+        x[i] = (double)(i % 11) - 5.0;
+        y[i] = x[i];
+    }
+    if (n)
+        x[n / 2] = y[n / 2] = NAN;
+    simd_real_clamp(x, n, -2.0, 3.5);
+    bad = 0;
+    for (int i = 0; i < n; ++i)
+        bad += x[i] != mx_clampd(-2.0, y[i], 3.5);
+    check(tinfo, "clamp", n, bad, 0);
+    simd_real_clamp(x, n, 1.0, -1.0); // lo > hi
+    bad = 0;
+    for (int i = 0; i < n; ++i)
+        bad += x[i] != 1.0;
+    check(tinfo, "clamp lo > hi", n, bad, 0);
+}
+
+static void byte_span_tests(tinfo* tinfo, char* b, int n) {
+    const char WS[] = " \t\n\v\f\r";
+    const char NONWS[] = {'a', 0, 8, 14, 31, 33, '~', 127, -128, -1};
+    int wrong = 0;
+    for (int i = 0; i < 6; ++i)
+        wrong += !simd_is_ws(WS[i]);
+    for (size_t i = 0; i < sizeof(NONWS); ++i)
+        wrong += simd_is_ws(NONWS[i]);
+    check(tinfo, "is_ws", n, wrong, 0);
+    for (int i = 0; i < n; ++i)
+        b[i] = WS[i % 6];
+    check(tinfo, "span_ws all", n, simd_byte_span_ws(b, n), n);
+    check(tinfo, "span_nonws none", n, simd_byte_span_nonws(b, n), 0);
+    int step = n > 16 ? n / 13 + 1 : 1;
+    for (int i = 0; i < n; i += step) {
+        b[i] = NONWS[i % sizeof(NONWS)];
+        check(tinfo, "span_ws", n, simd_byte_span_ws(b, n), i);
+        b[i] = WS[i % 6];
+    }
+    for (int i = 0; i < n; ++i)
+        b[i] = NONWS[i % sizeof(NONWS)];
+    check(tinfo, "span_nonws all", n, simd_byte_span_nonws(b, n), n);
+    for (int i = 0; i < n; i += step) {
+        b[i] = WS[i % 6];
+        check(tinfo, "span_nonws", n, simd_byte_span_nonws(b, n), i);
+        b[i] = NONWS[i % sizeof(NONWS)];
+    }
+}
+
+static void byte_count_tests(tinfo* tinfo, char* b, int n) {
+    ptrdiff_t count = 0;
+    ptrdiff_t words = 0;
+    bool in_word = false;
+    for (int i = 0; i < n; ++i) {
+        // Runs of 0-3 bytes of each class, including every byte value.
+        unsigned h = (i * 2654435761u) >> 24;
+        b[i] = h % 3 ? (char)(h * 7 + i) : " \t\n\v\f\r"[h % 6];
+        bool word = b[i] != ' ' && (b[i] < '\t' || b[i] > '\r');
+        words += word && !in_word;
+        in_word = word;
+        count += b[i] == ',';
+    }
+    check(tinfo, "count", n, simd_byte_count(b, n, ','), count);
+    check(tinfo, "count_words", n, simd_byte_count_words(b, n), words);
+    memset(b, ',', n);
+    check(tinfo, "count all", n, simd_byte_count(b, n, ','), n);
+    check(tinfo, "count_words one", n, simd_byte_count_words(b, n), n > 0);
+}
+
+// Past 255 vectors the per-byte-lane counts must have been summed.
+static void byte_count_long_tests(tinfo* tinfo) {
+    const int N = 20011;
+    char* b = malloc(N);
+    for (int i = 0; i < N; ++i)
+        b[i] = i % 2 ? ' ' : 'x';
+    check(tinfo, "count long", N, simd_byte_count(b, N, 'x'), N / 2 + 1);
+    check(tinfo, "count_words long", N, simd_byte_count_words(b, N),
+          N / 2 + 1);
+    free(b);
+}
+
+static void check(tinfo* tinfo, const char* what, int n, ptrdiff_t got,
+                  ptrdiff_t expected) {
+    tinfo->total++;
+    if (got != expected)
+        WARN("FAIL: %s %s %s n=%d expected %td got %td\n", tinfo->tag,
+             simd_level_name(simd_level()), what, n, expected, got);
+    else
+        tinfo->ok++;
+}
+
+static void check_real(tinfo* tinfo, const char* what, int n, double got,
+                       double expected) {
+    tinfo->total++;
+    if (got != expected)
+        WARN("FAIL: %s %s %s n=%d expected %.17g got %.17g\n", tinfo->tag,
+             simd_level_name(simd_level()), what, n, expected, got);
+    else
+        tinfo->ok++;
+}
@@ -0,0 +1,379 @@
+// Copyright © 2024-25 Mark Summerfield. All rights reserved.
+// License: GPL-3
+#pragma once
+
+#include "cx.h"
+#include <pthread.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+// Partitions of at most this many values are insertion sorted.
+#define SORT_SMALL 16
+
+// Arrays of fewer than this many values are comparison sorted rather than
+// radix sorted (the radix sorts' per-pass histogram costs dominate).
+#define SORT_RADIX_MIN 64
+
+// Arrays of fewer than this many values are never sorted in parallel.
+#define SORT_PARALLEL_MIN (1 << 16)
+
+// Each thread of a parallel sort gets a run of at least this many values.
+#define SORT_PARALLEL_MIN_RUN (1 << 14)
+
+// Parallel sorts use at most this many threads.
+#define SORT_PARALLEL_MAX_THREADS 64
+
+// Defines static inline functions for sorting arrays of T in-place with
+// the comparison inlined (unlike qsort() which calls a function pointer
+// for every comparison and swaps bytewise):
+//
+//  void name_sort(T* a, ptrdiff_t n, C ctx)
+//      Introsort: median-of-three quicksort, insertion sort for small
+//      partitions, and heapsort if the recursion gets too deep, so
+//      O(n log n) worst case; O(n) if already sorted or strictly
+//      reversed. Not stable.
+//  void name_sort_stable(T* a, ptrdiff_t n, C ctx)
+//      Merge sort using n/2 values of extra memory: O(n log n). Stable.
+//
+// LESS(ctx, x, y) must be true if x sorts before y, where x and y are
+// lvalues of type T, and ctx is the value of type C passed to the sort
+// function (e.g., a cmp function), or ignored.
+//
+// Example:
+// ```
+//  #define INT_LESS(ctx, x, y) ((x) < (y))
+//  SORT_DEFINE(int_array, int, void*, INT_LESS)
+//  ...
+//  int_array_sort(values, size, NULL);
+// ```
+#define SORT_DEFINE(name, T, C, LESS)                                      \
+    SORT_DEFINE_INSERTION(name, T, C, LESS)                                \
+    SORT_DEFINE_HEAP(name, T, C, LESS)                                     \
+    SORT_DEFINE_INTRO(name, T, C, LESS)                                    \
+    SORT_DEFINE_STABLE(name, T, C, LESS)
+
+#define SORT_DEFINE_INSERTION(name, T, C, LESS)                            \
+    static inline void name##_insertion_sort(T* a, ptrdiff_t n, C ctx) {   \
+        (void)ctx;                                                         \
+        for (ptrdiff_t i = 1; i < n; ++i) {                                \
+            T x = a[i];                                                    \
+            ptrdiff_t j = i;                                               \
+            for (; j > 0 && LESS(ctx, x, a[j - 1]); --j)                   \
+                a[j] = a[j - 1];                                           \
+            a[j] = x;                                                      \
+        }                                                                  \
+    }
+
+#define SORT_DEFINE_HEAP(name, T, C, LESS)                                 \
+    static inline void name##_sift_down(T* a, ptrdiff_t root,              \
+                                        ptrdiff_t n, C ctx) {              \
+        (void)ctx;                                                         \
+        T x = a[root];                                                     \
+        for (;;) {                                                         \
+            ptrdiff_t child = 2 * root + 1;                                \
+            if (child >= n)                                                \
+                break;                                                     \
+            if (child + 1 < n && LESS(ctx, a[child], a[child + 1]))        \
+                ++child;                                                   \
+            if (!LESS(ctx, x, a[child]))                                   \
+                break;                                                     \
+            a[root] = a[child];                                            \
+            root = child;                                                  \
+        }                                                                  \
+        a[root] = x;                                                       \
+    }                                                                      \
+                                                                           \
+    static inline void name##_heap_sort(T* a, ptrdiff_t n, C ctx) {        \
+        for (ptrdiff_t i = n / 2 - 1; i >= 0; --i)                         \
+            name##_sift_down(a, i, n, ctx);                                \
+        for (ptrdiff_t i = n - 1; i > 0; --i) {                            \
+            T x = a[0];                                                    \
+            a[0] = a[i];                                                   \
+            a[i] = x;                                                      \
+            name##_sift_down(a, 0, i, ctx);                                \
+        }                                                                  \
+    }
+
+// The median-of-three leaves a[0] <= pivot <= a[n - 1] which act as
+// sentinels for the (Hoare) partitioning, and equal values stop both
+// scans so runs of duplicates are split evenly.
+#define SORT_DEFINE_INTRO(name, T, C, LESS)                                \
+    static inline void name##_swap(T* x, T* y) {                           \
+        T t = *x;                                                          \
+        *x = *y;                                                           \
+        *y = t;                                                            \
+    }                                                                      \
+                                                                           \
+    static inline void name##_intro_sort(T* a, ptrdiff_t n, int depth,     \
+                                         C ctx) {                          \
+        while (n > SORT_SMALL) {                                           \
+            if (!depth--) {                                                \
+                name##_heap_sort(a, n, ctx);                               \
+                return;                                                    \
+            }                                                              \
+            ptrdiff_t mid = n / 2;                                         \
+            if (LESS(ctx, a[mid], a[0]))                                   \
+                name##_swap(&a[mid], &a[0]);                               \
+            if (LESS(ctx, a[n - 1], a[mid])) {                             \
+                name##_swap(&a[n - 1], &a[mid]);                           \
+                if (LESS(ctx, a[mid], a[0]))                               \
+                    name##_swap(&a[mid], &a[0]);                           \
+            }                                                              \
+            T pivot = a[mid];                                              \
+            ptrdiff_t i = 0;                                               \
+            ptrdiff_t j = n - 1;                                           \
+            for (;;) {                                                     \
+                do                                                         \
+                    ++i;                                                   \
+                while (LESS(ctx, a[i], pivot));                            \
+                do                                                         \
+                    --j;                                                   \
+                while (LESS(ctx, pivot, a[j]));                            \
+                if (i >= j)                                                \
+                    break;                                                 \
+                name##_swap(&a[i], &a[j]);                                 \
+            }                                                              \
+            ptrdiff_t left = j + 1; /* recurse on the smaller side */      \
+            if (left < n - left) {                                         \
+                name##_intro_sort(a, left, depth, ctx);                    \
+                a += left;                                                 \
+                n -= left;                                                 \
+            } else {                                                       \
+                name##_intro_sort(a + left, n - left, depth, ctx);         \
+                n = left;                                                  \
+            }                                                              \
+        }                                                                  \
+        name##_insertion_sort(a, n, ctx);                                  \
+    }                                                                      \
+                                                                           \
+    static inline void name##_sort(T* a, ptrdiff_t n, C ctx) {             \
+        ptrdiff_t i = 1; /* already sorted or strictly reversed? */        \
+        while (i < n && !LESS(ctx, a[i], a[i - 1]))                        \
+            ++i;                                                           \
+        if (i >= n)                                                        \
+            return;                                                        \
+        if (i == 1) {                                                      \
+            while (i < n && LESS(ctx, a[i], a[i - 1]))                     \
+                ++i;                                                       \
+            if (i == n) {                                                  \
+                for (ptrdiff_t j = 0; j < n / 2; ++j)                      \
+                    name##_swap(&a[j], &a[n - 1 - j]);                     \
+                return;                                                    \
+            }                                                              \
+        }                                                                  \
+        int depth = 0;                                                     \
+        for (ptrdiff_t m = n; m > 1; m >>= 1)                              \
+            depth += 2;                                                    \
+        name##_intro_sort(a, n, depth, ctx);                               \
+    }
+
+// Insertion sort is stable, and ties in the merge take the left value.
+#define SORT_DEFINE_STABLE(name, T, C, LESS)                               \
+    static inline void name##_merge_sort(T* a, ptrdiff_t n, T* tmp,        \
+                                         C ctx) {                          \
+        if (n <= SORT_SMALL) {                                             \
+            name##_insertion_sort(a, n, ctx);                              \
+            return;                                                        \
+        }                                                                  \
+        ptrdiff_t mid = n / 2;                                             \
+        name##_merge_sort(a, mid, tmp, ctx);                               \
+        name##_merge_sort(a + mid, n - mid, tmp, ctx);                     \
+        if (!LESS(ctx, a[mid], a[mid - 1]))                                \
+            return; /* already in order */                                 \
+        memcpy(tmp, a, mid * sizeof(T));                                   \
+        ptrdiff_t i = 0;                                                   \
+        ptrdiff_t j = mid;                                                 \
+        ptrdiff_t k = 0;                                                   \
+        while (i < mid && j < n) {                                         \
+            if (LESS(ctx, a[j], tmp[i]))                                   \
+                a[k++] = a[j++];                                           \
+            else                                                           \
+                a[k++] = tmp[i++];                                         \
+        }                                                                  \
+        while (i < mid)                                                    \
+            a[k++] = tmp[i++];                                             \
+    }                                                                      \
+                                                                           \
+    static inline void name##_sort_stable(T* a, ptrdiff_t n, C ctx) {      \
+        if (n <= SORT_SMALL) {                                             \
+            name##_insertion_sort(a, n, ctx);                              \
+            return;                                                        \
+        }                                                                  \
+        T* tmp = malloc((n / 2) * sizeof(T));                              \
+        assert_alloc(tmp);                                                 \
+        name##_merge_sort(a, n, tmp, ctx);                                 \
+        free(tmp);                                                         \
+    }
+
+// Defines (after SORT_DEFINE() for the same name, T, C, and LESS):
+//
+//  void name_sort_parallel(T* a, ptrdiff_t n, C ctx, int nthreads,
+//                          bool stable)
+//      Splits a into nthreads runs (or one per online CPU if nthreads
+//      <= 0) each sorted in its own thread by name_sort() (or if stable,
+//      name_sort_stable()), then merges pairs of runs until one is left,
+//      each merge split between all the threads at co-ranked positions
+//      so every thread merges an equal share. Uses n values of extra
+//      memory. Falls back to the serial sort if n < SORT_PARALLEL_MIN or
+//      there would be fewer than two runs of SORT_PARALLEL_MIN_RUN
+//      values. If stable, the result is identical to name_sort_stable()'s,
+//      otherwise values which are not LESS than each other may be in a
+//      different order than name_sort() would leave them.
+//
+// LESS must be safe to call from several threads at once.
+#define SORT_DEFINE_PARALLEL(name, T, C, LESS)                             \
+    typedef struct name##_ParTask {                                        \
+        T* a; /* sort: the run to sort; merge: the left run */             \
+        ptrdiff_t na;                                                      \
+        T* b; /* merge: the right run */                                   \
+        ptrdiff_t nb;                                                      \
+        T* out; /* merge: where the merged values go */                    \
+        C ctx;                                                             \
+        bool stable;                                                       \
+    } name##_ParTask;                                                      \
+                                                                           \
+    static inline void* name##_par_sort(void* arg) {                       \
+        name##_ParTask* task = arg;                                        \
+        if (task->stable)                                                  \
+            name##_sort_stable(task->a, task->na, task->ctx);              \
+        else                                                               \
+            name##_sort(task->a, task->na, task->ctx);                     \
+        return NULL;                                                       \
+    }                                                                      \
+                                                                           \
+    static inline void* name##_par_merge(void* arg) {                      \
+        name##_ParTask* task = arg;                                        \
+        T* a = task->a;                                                    \
+        T* b = task->b;                                                    \
+        T* out = task->out;                                                \
+        ptrdiff_t i = 0;                                                   \
+        ptrdiff_t j = 0;                                                   \
+        while (i < task->na && j < task->nb) {                             \
+            if (LESS(task->ctx, b[j], a[i]))                               \
+                *out++ = b[j++];                                           \
+            else                                                           \
+                *out++ = a[i++];                                           \
+        }                                                                  \
+        memcpy(out, a + i, (task->na - i) * sizeof(T));                    \
+        memcpy(out + task->na - i, b + j, (task->nb - j) * sizeof(T));     \
+        return NULL;                                                       \
+    }                                                                      \
+                                                                           \
+    /* Runs fn on every task, tasks[0] in this thread; if a thread */      \
+    /* can't be created its task is done in this thread instead. */        \
+    static inline void name##_par_run(void* (*fn)(void*),                  \
+                                      name##_ParTask* tasks, int n) {      \
+        pthread_t threads[SORT_PARALLEL_MAX_THREADS + 1];                  \
+        bool started[SORT_PARALLEL_MAX_THREADS + 1];                       \
+        for (int i = 1; i < n; ++i) {                                      \
+            started[i] =                                                   \
+                pthread_create(&threads[i], NULL, fn, &tasks[i]) == 0;     \
+            if (!started[i])                                               \
+                fn(&tasks[i]);                                             \
+        }                                                                  \
+        fn(&tasks[0]);                                                     \
+        for (int i = 1; i < n; ++i)                                        \
+            if (started[i])                                                \
+                pthread_join(threads[i], NULL);                            \
+    }                                                                      \
+                                                                           \
+    /* Returns how many of the first pos merged values come from a */      \
+    /* (the rest come from b) with ties taking a's values first. */        \
+    static inline ptrdiff_t name##_co_rank(ptrdiff_t pos, T* a,            \
+                                           ptrdiff_t na, T* b,             \
+                                           ptrdiff_t nb, C ctx) {          \
+        (void)ctx;                                                         \
+        ptrdiff_t lo = pos > nb ? pos - nb : 0;                            \
+        ptrdiff_t hi = pos < na ? pos : na;                                \
+        while (lo < hi) {                                                  \
+            ptrdiff_t i = lo + (hi - lo) / 2;                              \
+            ptrdiff_t j = pos - i;                                         \
+            if (j > 0 && !LESS(ctx, b[j - 1], a[i]))                       \
+                lo = i + 1;                                                \
+            else                                                           \
+                hi = i;                                                    \
+        }                                                                  \
+        return lo;                                                         \
+    }                                                                      \
+                                                                           \
+    static inline void name##_sort_parallel(T* a, ptrdiff_t n, C ctx,      \
+                                            int nthreads, bool stable) {   \
+        if (nthreads <= 0)                                                 \
+            nthreads = (int)sysconf(_SC_NPROCESSORS_ONLN);                 \
+        if (nthreads > SORT_PARALLEL_MAX_THREADS)                          \
+            nthreads = SORT_PARALLEL_MAX_THREADS;                          \
+        if (nthreads > n / SORT_PARALLEL_MIN_RUN)                          \
+            nthreads = (int)(n / SORT_PARALLEL_MIN_RUN);                   \
+        if (nthreads < 2 || n < SORT_PARALLEL_MIN) {                       \
+            if (stable)                                                    \
+                name##_sort_stable(a, n, ctx);                             \
+            else                                                           \
+                name##_sort(a, n, ctx);                                    \
+            return;                                                        \
+        }                                                                  \
+        name##_ParTask tasks[SORT_PARALLEL_MAX_THREADS + 1];               \
+        ptrdiff_t bounds[SORT_PARALLEL_MAX_THREADS + 1];                   \
+        for (int i = 0; i <= nthreads; ++i)                                \
+            bounds[i] = n * i / nthreads;                                  \
+        for (int i = 0; i < nthreads; ++i)                                 \
+            tasks[i] = (name##_ParTask){.a = a + bounds[i],                \
+                                        .na = bounds[i + 1] - bounds[i],   \
+                                        .ctx = ctx,                        \
+                                        .stable = stable};                 \
+        name##_par_run(name##_par_sort, tasks, nthreads);                  \
+        T* tmp = malloc(n * sizeof(T));                                    \
+        assert_alloc(tmp);                                                 \
+        T* src = a;                                                        \
+        T* dst = tmp;                                                      \
+        int runs = nthreads;                                               \
+        while (runs > 1) { /* merge pairs of runs sharing all threads */   \
+            int pairs = runs / 2;                                          \
+            int parts = nthreads / pairs;                                  \
+            int count = 0;                                                 \
+            for (int p = 0; p < pairs; ++p) {                              \
+                ptrdiff_t lo = bounds[2 * p];                              \
+                ptrdiff_t mid = bounds[2 * p + 1];                         \
+                ptrdiff_t hi = bounds[2 * p + 2];                          \
+                T* left = src + lo;                                        \
+                T* right = src + mid;                                      \
+                ptrdiff_t nleft = mid - lo;                                \
+                ptrdiff_t nright = hi - mid;                               \
+                ptrdiff_t pos = 0;                                         \
+                ptrdiff_t i = 0;                                           \
+                for (int q = 1; q <= parts; ++q) {                         \
+                    ptrdiff_t end = (hi - lo) * q / parts;                 \
+                    ptrdiff_t k = name##_co_rank(end, left, nleft, right,  \
+                                                 nright, ctx);             \
+                    tasks[count++] =                                       \
+                        (name##_ParTask){.a = left + i,                    \
+                                         .na = k - i,                      \
+                                         .b = right + (pos - i),           \
+                                         .nb = (end - k) - (pos - i),      \
+                                         .out = dst + lo + pos,            \
+                                         .ctx = ctx};                      \
+                    pos = end;                                             \
+                    i = k;                                                 \
+                }                                                          \
+            }                                                              \
+            if (runs % 2) /* the odd run out is just copied */             \
+                tasks[count++] = (name##_ParTask){                         \
+                    .a = src + bounds[runs - 1],                           \
+                    .na = bounds[runs] - bounds[runs - 1],                 \
+                    .b = src + n,                                          \
+                    .out = dst + bounds[runs - 1]};                        \
+            name##_par_run(name##_par_merge, tasks, count);                \
+            for (int i = 0; i <= pairs; ++i)                               \
+                bounds[i] = bounds[2 * i];                                 \
+            bounds[(runs + 1) / 2] = n;                                    \
+            runs = (runs + 1) / 2;                                         \
+            T* t = src;                                                    \
+            src = dst;                                                     \
+            dst = t;                                                       \
+        }                                                                  \
+        if (src != a)                                                      \
+            memcpy(a, src, n * sizeof(T));                                 \
+        free(tmp);                                                         \
+    }
@@ -0,0 +1,334 @@
+// Copyright © 2024-25 Mark Summerfield. All rights reserved.
+// License: GPL-3
+
+#include "sort_bench.h"
+#include "sort.h"
+#include "str.h"
+#include "vec.h"
+#include "vec_int.h"
+#include "vec_num.h"
+#include "vec_str.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+// The comparison sorts that vec_str_sort() and vec_str_casesort() used
+// before they were keyed, for comparison.
+#define STR_LESS(ctx, x, y) (strcmp((x), (y)) < 0)
+SORT_DEFINE(str_array, char*, void*, STR_LESS)
+#define STR_CASELESS(ctx, x, y) (strcasecmp((x), (y)) < 0)
+SORT_DEFINE(str_casearray, char*, void*, STR_CASELESS)
+
+typedef enum { Random, Sorted, Reversed, Duplicates } Shape;
+
+static const char* SHAPES[] = {"random", "sorted", "reversed", "dups"};
+
+static void int_benchmark(binfo* binfo, int n, Shape shape);
+static void str_benchmark(binfo* binfo, int n, Shape shape);
+static void prefix_benchmark(binfo* binfo, int n, bool urls);
+static void by_key_benchmark(binfo* binfo, int n);
+static void typed_benchmark(binfo* binfo, int n);
+static void parallel_benchmarks(binfo* binfo, int n);
+static int record_cmp(const void* a, const void* b);
+static uint64_t record_key(const void* value);
+static int intcmp(const void* a, const void* b);
+static int i64cmp(const void* a, const void* b);
+
+void sort_benchmarks(binfo* binfo) {
+    const int N = binfo->quick ? 100000 : 10000000;
+    for (Shape shape = Random; shape <= Duplicates; ++shape)
+        int_benchmark(binfo, N, shape);
+    for (Shape shape = Random; shape <= Duplicates; ++shape)
+        str_benchmark(binfo, N / 10, shape);
+    prefix_benchmark(binfo, N / 10, true);
+    prefix_benchmark(binfo, N / 10, false);
+    by_key_benchmark(binfo, N / 10);
+    typed_benchmark(binfo, N / 10);
+    parallel_benchmarks(binfo, binfo->quick ? 1000000 : 50000000);
+}
+
+static int shaped(uint64_t* seed, int i, int n, Shape shape) {
+    switch (shape) {
+    case Random:
+        return (int)bench_rand(seed);
+    case Sorted:
+        return i;
+    case Reversed:
+        return n - i;
+    case Duplicates:
+        return bench_rand(seed) % 16;
+    }
+    return 0;
+}
+
+static void int_benchmark(binfo* binfo, int n, Shape shape) {
+    uint64_t seed = 1;
+    VecInt vec = vec_int_alloc_cap(n);
+    for (int i = 0; i < n; ++i)
+        vec_int_push(&vec, shaped(&seed, i, n, shape));
+    VecInt copy = vec_int_copy(&vec);
+    VecInt radix = vec_int_copy(&vec);
+    char name[64];
+
+    double begin = bench_now();
+    qsort(copy._values, n, sizeof(int), intcmp);
+    snprintf(name, sizeof(name), "qsort int %s", SHAPES[shape]);
+    bench_report(binfo, name, n, bench_now() - begin, "");
+
+    begin = bench_now();
+    vec_int_sort(&vec);
+    snprintf(name, sizeof(name), "vec_int_sort %s", SHAPES[shape]);
+    bench_report(binfo, name, n, bench_now() - begin, "");
+
+    begin = bench_now();
+    vec_int_sort_radix(&radix);
+    snprintf(name, sizeof(name), "vec_int_sort_radix %s", SHAPES[shape]);
+    bench_report(binfo, name, n, bench_now() - begin, "");
+
+    if (!vec_int_equal(&vec, &copy))
+        fprintf(stderr, "FAIL: %s vec_int_sort != qsort\n", binfo->tag);
+    if (!vec_int_equal(&radix, &copy))
+        fprintf(stderr, "FAIL: %s vec_int_sort_radix != qsort\n",
+                binfo->tag);
+    vec_int_free(&radix);
+    vec_int_free(&copy);
+    vec_int_free(&vec);
+}
+
+static void str_benchmark(binfo* binfo, int n, Shape shape) {
+    uint64_t seed = 1;
+    VecStr vec = vec_str_alloc_custom(n, Owns);
+    char buf[32];
+    for (int i = 0; i < n; ++i) {
+        snprintf(buf, sizeof(buf), "key%010d", shaped(&seed, i, n, shape));
+        vec_str_push(&vec, strdup(buf));
+    }
+    VecStr copy = vec_str_copy(&vec, Borrows);
+    char name[64];
+
+    double begin = bench_now();
+    qsort(copy._values, n, sizeof(char*), str_strcmp);
+    snprintf(name, sizeof(name), "qsort str %s", SHAPES[shape]);
+    bench_report(binfo, name, n, bench_now() - begin, "");
+
+    begin = bench_now();
+    vec_str_sort(&vec);
+    snprintf(name, sizeof(name), "vec_str_sort %s", SHAPES[shape]);
+    bench_report(binfo, name, n, bench_now() - begin, "");
+
+    if (!vec_str_equal(&vec, &copy))
+        fprintf(stderr, "FAIL: %s vec_str_sort != qsort\n", binfo->tag);
+    vec_str_free(&copy);
+    vec_str_free(&vec);
+}
+
+// URL- or path-like strings whose first 20-30 chars are shared by many
+// others, sorted by the comparison sorts and the keyed ones, both case
+// sensitive and not.
+static void prefix_benchmark(binfo* binfo, int n, bool urls) {
+    const char* HOSTS[] = {"example.com", "Example.org", "www.example.com",
+                           "api.example.net"};
+    const char* DIRS[] = {"src", "include", "Docs", "tests", "build"};
+    uint64_t seed = 1;
+    VecStr vec = vec_str_alloc_custom(n, Owns);
+    char buf[128];
+    for (int i = 0; i < n; ++i) {
+        uint64_t r = bench_rand(&seed);
+        if (urls)
+            snprintf(buf, sizeof(buf),
+                     "https://%s/api/v1/users/%d/items/%d?page=%d",
+                     HOSTS[r % 4], (int)(r >> 8) % 1000,
+                     (int)(r >> 20) % 100000, (int)(r >> 40) % 10);
+        else
+            snprintf(buf, sizeof(buf),
+                     "/home/user/projects/cx/%s/module%d/File%d.c",
+                     DIRS[r % 5], (int)(r >> 8) % 100,
+                     (int)(r >> 20) % 100000);
+        vec_str_push(&vec, strdup(buf));
+    }
+    const char* what = urls ? "urls" : "paths";
+    char name[64];
+    for (int fold = 0; fold < 2; ++fold) {
+        VecStr copy = vec_str_copy(&vec, Borrows);
+        VecStr keyed = vec_str_copy(&vec, Borrows);
+        double begin = bench_now();
+        if (fold)
+            str_casearray_sort(copy._values, n, NULL);
+        else
+            str_array_sort(copy._values, n, NULL);
+        snprintf(name, sizeof(name), "introsort str%s %s",
+                 fold ? " case" : "", what);
+        bench_report(binfo, name, n, bench_now() - begin, "");
+
+        begin = bench_now();
+        if (fold)
+            vec_str_casesort(&keyed);
+        else
+            vec_str_sort(&keyed);
+        snprintf(name, sizeof(name), "vec_str_%ssort %s",
+                 fold ? "case" : "", what);
+        bench_report(binfo, name, n, bench_now() - begin, "");
+
+        for (int i = 0; i < n; ++i) {
+            const char* x = VEC_GET(&copy, i);
+            const char* y = VEC_GET(&keyed, i);
+            if (fold ? strcasecmp(x, y) : strcmp(x, y)) {
+                fprintf(stderr, "FAIL: %s vec_str_%ssort != introsort\n",
+                        binfo->tag, fold ? "case" : "");
+                break;
+            }
+        }
+        vec_str_free(&keyed);
+        vec_str_free(&copy);
+    }
+    vec_str_free(&vec);
+}
+
+typedef struct {
+    long id;
+    char name[24];
+} Record;
+
+// Record-like values sorted by an integer field via cmp vs via key.
+static void by_key_benchmark(binfo* binfo, int n) {
+    uint64_t seed = 1;
+    Vec vec = vec_alloc(n, record_cmp, NULL);
+    Vec copy = vec_alloc(n, record_cmp, NULL);
+    for (int i = 0; i < n; ++i) {
+        Record* record = malloc(sizeof(Record));
+        assert_alloc(record);
+        record->id = (long)(bench_rand(&seed) % 1000000000);
+        snprintf(record->name, sizeof(record->name), "r%d", i);
+        vec_push(&vec, record);
+        vec_push(&copy, record);
+    }
+
+    double begin = bench_now();
+    vec_sort_stable(&copy);
+    bench_report(binfo, "vec_sort_stable by id", n, bench_now() - begin,
+                 "");
+
+    begin = bench_now();
+    vec_sort_by_key(&vec, record_key);
+    bench_report(binfo, "vec_sort_by_key by id", n, bench_now() - begin,
+                 "");
+
+    for (int i = 0; i < n; ++i)
+        if (VEC_GET(&vec, i) != VEC_GET(&copy, i)) {
+            fprintf(stderr, "FAIL: %s vec_sort_by_key != vec_sort_stable\n",
+                    binfo->tag);
+            break;
+        }
+    while (VEC_SIZE(&copy))
+        vec_pop(&copy); // borrowed: vec owns the records
+    vec_free(&copy);
+    vec_free(&vec);
+}
+
+// Scaling from 1 thread up to one per online CPU (doubling, plus the CPU
+// count itself if not a power of 2), checking each result against the
+// serial sort.
+// int64_t values boxed in a Vec vs inline in a VecI64 (see vec_num.h),
+// pushed then sorted.
+static void typed_benchmark(binfo* binfo, int n) {
+    uint64_t seed = 1;
+    double begin = bench_now();
+    Vec boxed = vec_alloc(0, i64cmp, NULL);
+    for (int i = 0; i < n; ++i) {
+        int64_t* value = malloc(sizeof(int64_t));
+        assert_alloc(value);
+        *value = (int64_t)bench_rand(&seed);
+        vec_push(&boxed, value);
+    }
+    vec_sort(&boxed);
+    bench_report(binfo, "Vec int64 push+sort", n, bench_now() - begin, "");
+
+    seed = 1;
+    begin = bench_now();
+    VecI64 typed = vec_i64_alloc();
+    for (int i = 0; i < n; ++i)
+        vec_i64_push(&typed, (int64_t)bench_rand(&seed));
+    vec_i64_sort(&typed);
+    bench_report(binfo, "VecI64 push+sort", n, bench_now() - begin, "");
+
+    for (int i = 0; i < n; ++i)
+        if (*(int64_t*)VEC_GET(&boxed, i) != VEC_GET(&typed, i)) {
+            fprintf(stderr, "FAIL: %s vec_i64_sort != vec_sort\n",
+                    binfo->tag);
+            break;
+        }
+    vec_i64_free(&typed);
+    vec_free(&boxed);
+}
+
+static void parallel_benchmarks(binfo* binfo, int n) {
+    int ncpus = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    uint64_t seed = 1;
+    VecInt original = vec_int_alloc_cap(n);
+    for (int i = 0; i < n; ++i)
+        vec_int_push(&original, (int)bench_rand(&seed));
+    VecInt expected = vec_int_copy(&original);
+    vec_int_sort(&expected);
+    int m = n / 5;
+    VecStr strs = vec_str_alloc_custom(m, Owns);
+    char buf[32];
+    for (int i = 0; i < m; ++i) {
+        snprintf(buf, sizeof(buf), "key%010d", (int)bench_rand(&seed));
+        vec_str_push(&strs, strdup(buf));
+    }
+    VecStr expected_strs = vec_str_copy(&strs, Borrows);
+    vec_str_sort(&expected_strs);
+    char name[64];
+    for (int t = 1; t <= ncpus; t = (t < ncpus && t * 2 > ncpus)
+                                         ? ncpus
+                                         : t * 2) {
+        VecInt vec = vec_int_copy(&original);
+        double begin = bench_now();
+        vec_int_sort_parallel(&vec, t);
+        snprintf(name, sizeof(name), "vec_int_sort_parallel %d/%d", t,
+                 ncpus);
+        bench_report(binfo, name, n, bench_now() - begin, "");
+        if (!vec_int_equal(&vec, &expected))
+            fprintf(stderr, "FAIL: %s vec_int_sort_parallel %d\n",
+                    binfo->tag, t);
+        vec_int_free(&vec);
+
+        VecStr copy = vec_str_copy(&strs, Borrows);
+        begin = bench_now();
+        vec_str_sort_parallel(&copy, t);
+        snprintf(name, sizeof(name), "vec_str_sort_parallel %d/%d", t,
+                 ncpus);
+        bench_report(binfo, name, m, bench_now() - begin, "");
+        if (!vec_str_equal(&copy, &expected_strs))
+            fprintf(stderr, "FAIL: %s vec_str_sort_parallel %d\n",
+                    binfo->tag, t);
+        vec_str_free(&copy);
+    }
+    vec_str_free(&expected_strs);
+    vec_str_free(&strs);
+    vec_int_free(&expected);
+    vec_int_free(&original);
+}
+
+static int record_cmp(const void* a, const void* b) {
+    long x = (*(const Record**)a)->id;
+    long y = (*(const Record**)b)->id;
+    return (x > y) - (x < y);
+}
+
+static uint64_t record_key(const void* value) {
+    return (uint64_t)((const Record*)value)->id ^ (UINT64_C(1) << 63);
+}
+
+static int intcmp(const void* a, const void* b) {
+    int x = *(const int*)a;
+    int y = *(const int*)b;
+    return (x > y) - (x < y);
+}
+
+static int i64cmp(const void* a, const void* b) {
+    int64_t x = **(const int64_t**)a;
+    int64_t y = **(const int64_t**)b;
+    return (x > y) - (x < y);
+}
@@ -0,0 +1,208 @@
+// Copyright © 2024-25 Mark Summerfield. All rights reserved.
+// License: GPL-3
+
+#include "sort_test.h"
+#include "exit.h"
+#include "sort.h"
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+typedef struct {
+    int key;
+    int seq; // original position (to check stability)
+} Pair;
+
+#define INT_LESS(ctx, x, y) ((x) < (y))
+SORT_DEFINE(ints, int, void*, INT_LESS)
+SORT_DEFINE_PARALLEL(ints, int, void*, INT_LESS)
+
+#define PAIR_LESS(ctx, x, y) ((x).key < (y).key)
+SORT_DEFINE(pairs, Pair, void*, PAIR_LESS)
+SORT_DEFINE_PARALLEL(pairs, Pair, void*, PAIR_LESS)
+
+// Uses ctx to count the comparisons.
+#define COUNTED_LESS(ctx, x, y) (++*(ctx), (x) < (y))
+SORT_DEFINE(counted, int, long*, COUNTED_LESS)
+
+typedef enum { Random, Sorted, Reversed, Duplicates, Organ } Shape;
+
+static void int_tests(tinfo* tinfo);
+static void heap_tests(tinfo* tinfo);
+static void stable_tests(tinfo* tinfo);
+static void worst_case_tests(tinfo* tinfo);
+static void parallel_tests(tinfo* tinfo);
+static void fill(int* a, int n, Shape shape);
+static void check_sorted(tinfo* tinfo, const int* a, const int* b, int n);
+static int intcmp(const void* a, const void* b);
+
+void sort_tests(tinfo* tinfo) {
+    if (tinfo->verbose)
+        puts(tinfo->tag);
+    int_tests(tinfo);
+    heap_tests(tinfo);
+    stable_tests(tinfo);
+    worst_case_tests(tinfo);
+    parallel_tests(tinfo);
+}
+
+static void int_tests(tinfo* tinfo) {
+    const int SIZES[] = {0, 1, 2, 3, 15, 16, 17, 100, 1000, 10007};
+    for (int s = 0; s < (int)(sizeof(SIZES) / sizeof(SIZES[0])); ++s) {
+        int n = SIZES[s];
+        int* a = malloc((n + 1) * sizeof(int));
+        int* b = malloc((n + 1) * sizeof(int));
+        int* c = malloc((n + 1) * sizeof(int));
+        for (Shape shape = Random; shape <= Organ; ++shape) {
+            fill(c, n, shape);
+            for (int i = 0; i < n; ++i)
+                a[i] = b[i] = c[i];
+            ints_sort(a, n, NULL);
+            qsort(b, n, sizeof(int), intcmp);
+            check_sorted(tinfo, a, b, n);
+            for (int i = 0; i < n; ++i)
+                a[i] = c[i];
+            ints_sort_stable(a, n, NULL);
+            check_sorted(tinfo, a, b, n);
+        }
+        free(c);
+        free(b);
+        free(a);
+    }
+}
+
+static void heap_tests(tinfo* tinfo) {
+    const int N = 1001;
+    int a[N];
+    int b[N];
+    for (Shape shape = Random; shape <= Organ; ++shape) {
+        fill(a, N, shape);
+        for (int i = 0; i < N; ++i)
+            b[i] = a[i];
+        ints_heap_sort(a, N, NULL);
+        qsort(b, N, sizeof(int), intcmp);
+        check_sorted(tinfo, a, b, N);
+    }
+}
+
+static void stable_tests(tinfo* tinfo) {
+    const int N = 5000;
+    Pair* a = malloc(N * sizeof(Pair));
+    for (int i = 0; i < N; ++i)
+        a[i] = (Pair){rand() % 50, i};
+    pairs_sort_stable(a, N, NULL);
+    bool ok = true;
+    for (int i = 1; i < N; ++i)
+        if (a[i - 1].key > a[i].key ||
+            (a[i - 1].key == a[i].key && a[i - 1].seq > a[i].seq)) {
+            ok = false;
+            break;
+        }
+    check_bool_eq(tinfo, ok, true);
+    pairs_sort(a, N, NULL); // unstable but must still be sorted by key
+    ok = true;
+    for (int i = 1; i < N; ++i)
+        if (a[i - 1].key > a[i].key) {
+            ok = false;
+            break;
+        }
+    check_bool_eq(tinfo, ok, true);
+    free(a);
+}
+
+// The introsort must stay O(n log n) even for inputs that are bad for
+// median-of-three quicksort.
+static void worst_case_tests(tinfo* tinfo) {
+    const int N = 1 << 16;
+    int* a = malloc(N * sizeof(int));
+    for (Shape shape = Random; shape <= Organ; ++shape) {
+        fill(a, N, shape);
+        long count = 0;
+        counted_sort(a, N, &count);
+        check_bool_eq(tinfo, count < 4L * N * 16, true);
+    }
+    free(a);
+}
+
+// Odd sizes and thread counts give runs and merge splits of unequal
+// lengths; 0 threads means one per CPU; small sizes are sorted serially.
+static void parallel_tests(tinfo* tinfo) {
+    const int SIZES[] = {0, 1000, SORT_PARALLEL_MIN + 7, 200003};
+    const int THREADS[] = {0, 1, 2, 3, 4, 7};
+    const int N = SIZES[3];
+    int* a = malloc(N * sizeof(int));
+    int* b = malloc(N * sizeof(int));
+    int* c = malloc(N * sizeof(int));
+    for (int s = 0; s < (int)(sizeof(SIZES) / sizeof(SIZES[0])); ++s) {
+        int n = SIZES[s];
+        for (Shape shape = Random; shape <= Organ; ++shape) {
+            fill(c, n, shape);
+            for (int i = 0; i < n; ++i)
+                b[i] = c[i];
+            ints_sort(b, n, NULL);
+            for (int t = 0; t < (int)(sizeof(THREADS) / sizeof(int));
+                 ++t) {
+                for (int i = 0; i < n; ++i)
+                    a[i] = c[i];
+                ints_sort_parallel(a, n, NULL, THREADS[t], false);
+                check_sorted(tinfo, a, b, n);
+            }
+        }
+    }
+    free(c);
+    free(b);
+    free(a);
+
+    Pair* p = malloc(N * sizeof(Pair));
+    for (int i = 0; i < N; ++i)
+        p[i] = (Pair){rand() % 50, i};
+    pairs_sort_parallel(p, N, NULL, 5, true);
+    bool ok = true;
+    for (int i = 1; i < N; ++i)
+        if (p[i - 1].key > p[i].key ||
+            (p[i - 1].key == p[i].key && p[i - 1].seq > p[i].seq)) {
+            ok = false;
+            break;
+        }
+    check_bool_eq(tinfo, ok, true);
+    free(p);
+}
+
+static void fill(int* a, int n, Shape shape) {
+    for (int i = 0; i < n; ++i) {
+        switch (shape) {
+        case Random:
+            a[i] = rand() - RAND_MAX / 2;
+            break;
+        case Sorted:
+            a[i] = i;
+            break;
+        case Reversed:
+            a[i] = n - i;
+            break;
+        case Duplicates:
+            a[i] = rand() % 4;
+            break;
+        case Organ:
+            a[i] = i < n / 2 ? i : n - i;
+            break;
+        }
+    }
+}
+
+static void check_sorted(tinfo* tinfo, const int* a, const int* b, int n) {
+    tinfo->total++;
+    for (int i = 0; i < n; ++i)
+        if (a[i] != b[i]) {
+            WARN("FAIL: %s n=%d [%d] expected %d got %d\n", tinfo->tag, n,
+                 i, b[i], a[i]);
+            return;
+        }
+    tinfo->ok++;
+}
+
+static int intcmp(const void* a, const void* b) {
+    int x = *(const int*)a;
+    int y = *(const int*)b;
+    return (x > y) - (x < y);
+}
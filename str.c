@@ -1,13 +1,27 @@
 // Copyright © 2024-25 Mark Summerfield. All rights reserved.
 // License: GPL-3
 
+#define _GNU_SOURCE // for memmem and memrchr
+
 #include "str.h"
 #include "cx.h"
 #include "exit.h"
+#include "simd.h"
 #include <ctype.h>
 #include <stdio.h>
 #include <stdlib.h>
 
+// Runs of up to this many chars are scanned inline since most words and
+// gaps are shorter than it takes to set up a vector scan.
+#define SHORT_RUN 16
+
+// skip_ws() and skip_nonws() scan longer runs in windows of up to this
+// many chars (the window's NUL found first) so they never read past the
+// string's NUL however long it is, nor far ahead of where they stop.
+#define SKIP_WINDOW 64
+
+static int mem_casecmp(const char* s, const char* t, size_t n);
+
 // Each void* argument is actually a pointer to a pointer, so first we
 // must cast to pointer to pointer to the actual type, then we must
 // dereference the outer pointer to get the inner pointer which is
@@ -21,17 +35,11 @@ int str_strcasecmp(const void* s, const void* t) {
 }
 
 bool str_ends(const char* s, const char* suffix) {
-    size_t size = strlen(s);
-    if (size < strlen(suffix))
-        return false;
-    return strcmp(s + size - strlen(suffix), suffix) == 0;
+    return str_view_ends(str_view(s), str_view(suffix));
 }
 
 bool str_caseends(const char* s, const char* suffix) {
-    size_t size = strlen(s);
-    if (size < strlen(suffix))
-        return false;
-    return strcasecmp(s + size - strlen(suffix), suffix) == 0;
+    return str_view_caseends(str_view(s), str_view(suffix));
 }
 
 void str_uppercase_ip(char* s) {
@@ -44,27 +52,15 @@ void str_uppercase_ip(char* s) {
 
 char* str_uppercase(const char* s) {
     assert(s && "can't uppercase NULL");
-    char* u = malloc(strlen(s) + 1);
-    assert_alloc(u);
-    int i = 0;
-    while (*s) {
-        u[i++] = toupper(*s);
-        s++;
-    }
-    u[i] = 0;
+    char* u = str_view_dup(str_view(s));
+    str_uppercase_ip(u);
     return u;
 }
 
 char* str_uppercasen(const char* s, int n) {
     assert(s && "can't uppercase NULL");
-    char* u = malloc(n + 1); // +1 for terminating 0
-    assert_alloc(u);
-    int i = 0;
-    while (*s && i < n) {
-        u[i++] = toupper(*s);
-        s++;
-    }
-    u[i] = 0;
+    char* u = str_view_dup(str_view_n(s, strnlen(s, n > 0 ? n : 0)));
+    str_uppercase_ip(u);
     return u;
 }
 
@@ -78,53 +74,199 @@ void str_lowercase_ip(char* s) {
 
 char* str_lowercase(const char* s) {
     assert(s && "can't lowercase NULL");
-    char* u = malloc(strlen(s) + 1);
-    assert_alloc(u);
-    int i = 0;
-    while (*s) {
-        u[i++] = tolower(*s);
-        s++;
-    }
-    u[i] = 0;
+    char* u = str_view_dup(str_view(s));
+    str_lowercase_ip(u);
     return u;
 }
 
 const char* str_trim_left(const char* s) {
-    if (!s || !*s)
-        return NULL;
-    const char* p = skip_ws(s);
-    if (!*p)
-        return NULL; // whole string is whitespace
-    return p;
+    StrView view = str_view_trim_left(str_view(s));
+    return view.n ? view.p : NULL; // NULL if empty or all whitespace
 }
 
 char* str_trimn(const char* s, size_t n) {
-    if (!s || !*s)
+    if (!s)
         return NULL;
-    const char* p = skip_ws(s);
-    if (p && !*p)
-        return NULL; // whole string is whitespace
-    const char* q;
-    if (n)
-        q = s + n;
-    else {
-        q = p;
-        assert_notnull(q);
-        while (*q) // find \0
-            q++;
-        q--; // last char
+    StrView view = str_view_trim(n ? str_view_n(s, strnlen(s, n))
+                                   : str_view(s));
+    return view.n ? str_view_dup(view) : NULL; // NULL if all whitespace
+}
+
+StrView str_view(const char* s) {
+    return (StrView){.p = s ? s : "", .n = s ? strlen(s) : 0};
+}
+
+StrView str_view_n(const char* s, size_t n) {
+    assert((s || !n) && "can't view chars at NULL");
+    return (StrView){.p = s ? s : "", .n = n};
+}
+
+StrView str_view_sub(StrView view, size_t pos, size_t n) {
+    pos = pos < view.n ? pos : view.n;
+    size_t rest = view.n - pos;
+    return (StrView){.p = view.p + pos, .n = n < rest ? n : rest};
+}
+
+StrView str_view_trim_left(StrView view) {
+    while (view.n && simd_is_ws(*view.p)) {
+        view.p++;
+        view.n--;
+    }
+    return view;
+}
+
+StrView str_view_trim_right(StrView view) {
+    while (view.n && simd_is_ws(view.p[view.n - 1]))
+        view.n--;
+    return view;
+}
+
+StrView str_view_trim(StrView view) {
+    return str_view_trim_right(str_view_trim_left(view));
+}
+
+ptrdiff_t str_view_find(StrView view, StrView needle) {
+    const char* p = memmem(view.p, view.n, needle.p, needle.n);
+    return p ? p - view.p : STR_VIEW_NOT_FOUND;
+}
+
+ptrdiff_t str_view_rfind(StrView view, StrView needle) {
+    if (!needle.n)
+        return view.n;
+    if (needle.n > view.n)
+        return STR_VIEW_NOT_FOUND;
+    // Only the positions where needle's first char occurs are compared.
+    size_t n = view.n - needle.n + 1;
+    const char* p;
+    while ((p = memrchr(view.p, *needle.p, n))) {
+        if (!memcmp(p, needle.p, needle.n))
+            return p - view.p;
+        n = p - view.p;
+    }
+    return STR_VIEW_NOT_FOUND;
+}
+
+ptrdiff_t str_view_find_chr(StrView view, int c) {
+    const char* p = memchr(view.p, c, view.n);
+    return p ? p - view.p : STR_VIEW_NOT_FOUND;
+}
+
+ptrdiff_t str_view_rfind_chr(StrView view, int c) {
+    const char* p = memrchr(view.p, c, view.n);
+    return p ? p - view.p : STR_VIEW_NOT_FOUND;
+}
+
+bool str_view_begins(StrView view, StrView prefix) {
+    return view.n >= prefix.n && !memcmp(view.p, prefix.p, prefix.n);
+}
+
+bool str_view_casebegins(StrView view, StrView prefix) {
+    return view.n >= prefix.n && !mem_casecmp(view.p, prefix.p, prefix.n);
+}
+
+bool str_view_ends(StrView view, StrView suffix) {
+    return view.n >= suffix.n &&
+           !memcmp(view.p + view.n - suffix.n, suffix.p, suffix.n);
+}
+
+bool str_view_caseends(StrView view, StrView suffix) {
+    return view.n >= suffix.n &&
+           !mem_casecmp(view.p + view.n - suffix.n, suffix.p, suffix.n);
+}
+
+bool str_view_eq(StrView view1, StrView view2) {
+    return view1.n == view2.n && !memcmp(view1.p, view2.p, view1.n);
+}
+
+bool str_view_caseeq(StrView view1, StrView view2) {
+    return view1.n == view2.n && !mem_casecmp(view1.p, view2.p, view1.n);
+}
+
+int str_view_cmp(StrView view1, StrView view2) {
+    int cmp = memcmp(view1.p, view2.p,
+                     view1.n < view2.n ? view1.n : view2.n);
+    if (cmp)
+        return cmp;
+    return (view1.n > view2.n) - (view1.n < view2.n);
+}
+
+char* str_view_dup(StrView view) {
+    char* s = malloc(view.n + 1);
+    assert_alloc(s);
+    memcpy(s, view.p, view.n);
+    s[view.n] = 0;
+    return s;
+}
+
+StrSplit str_split_str(const char* s, const char* sep) {
+    assert_notnull(s);
+    assert_notnull(sep);
+    size_t sep_size = strlen(sep);
+    assert(sep_size && "can't split with empty sep");
+    return (StrSplit){._p = s,
+                      ._sep = sep,
+                      ._sep_size = sep_size,
+                      ._kind = StrSplitStr};
+}
+
+// s is empty or all sep chars only if its leading seps reach its NUL,
+// so only the (usually no) leading seps need checking.
+StrSplit str_split_chr(const char* s, int sep) {
+    assert_notnull(s);
+    assert(sep && "can't split on NUL");
+    const char* p = s;
+    while (*p == (char)sep)
+        p++;
+    return (StrSplit){._p = *p ? s : NULL,
+                      ._sep_chr = sep,
+                      ._kind = StrSplitChr};
+}
+
+StrSplit str_split_ws(const char* s) {
+    assert_notnull(s);
+    return (StrSplit){._p = skip_ws(s), ._kind = StrSplitWs};
+}
+
+bool str_split_next(StrSplit* split, StrView* part) {
+    assert_notnull(split);
+    assert_notnull(part);
+    const char* p = split->_p;
+    if (!p)
+        return false;
+    const char* q = p; // the part's end
+    switch (split->_kind) {
+    case StrSplitStr:
+        q = strstr(p, split->_sep);
+        if (q) {
+            split->_p = q + split->_sep_size;
+            break;
+        }
+        split->_p = NULL;
+        if (!*p)
+            return false; // no final empty part
+        q = p + strlen(p);
+        break;
+    case StrSplitChr:
+        q = strchrnul(p, split->_sep_chr);
+        split->_p = *q ? q + 1 : NULL;
+        break;
+    case StrSplitWs:
+        if (!*p)
+            return false;
+        q = skip_nonws(p);
+        split->_p = skip_ws(q);
+        break;
     }
-    assert_notnull(q);
-    while (isspace(*q)) // trim right
-        q--;
-    if (q < p)
-        return NULL; // all whitespace
-    size_t size = q - p + 1;
-    char* r = malloc(size + 1); // allow for \0
-    assert_alloc(r);
-    strncpy(r, p, size);
-    r[size] = 0;
-    return r;
+    *part = (StrView){.p = p, .n = q - p};
+    return true;
+}
+
+ptrdiff_t str_split_views(StrSplit* split, StrView* parts, ptrdiff_t cap) {
+    assert_notnull(parts);
+    ptrdiff_t n = 0;
+    while (n < cap && str_split_next(split, &parts[n]))
+        n++;
+    return n;
 }
 
 inline const char* bool_to_str(bool b) { return b ? "true" : "false"; }
@@ -161,14 +303,40 @@ void commas(char* s, int64_t n) {
     s[j] = 0;
 }
 
-inline const char* skip_ws(const char* p) {
-    while (p && isspace(*p))
-        p++;
-    return p;
+const char* skip_ws(const char* p) {
+    if (!p)
+        return p;
+    for (int i = 0; i < SHORT_RUN; ++i, ++p)
+        if (!simd_is_ws(*p)) // or the NUL
+            return p;
+    for (;;) {
+        ptrdiff_t n = simd_byte_span_ws(p, strnlen(p, SKIP_WINDOW));
+        p += n;
+        if (n < SKIP_WINDOW) // at a non-whitespace char or the NUL
+            return p;
+    }
 }
 
-inline const char* skip_nonws(const char* p) {
-    while (p && !isspace(*p))
-        p++;
-    return p;
+const char* skip_nonws(const char* p) {
+    if (!p)
+        return p;
+    for (int i = 0; i < SHORT_RUN; ++i, ++p)
+        if (!*p || simd_is_ws(*p))
+            return p;
+    for (;;) {
+        ptrdiff_t n = simd_byte_span_nonws(p, strnlen(p, SKIP_WINDOW));
+        p += n;
+        if (n < SKIP_WINDOW) // at a whitespace char or the NUL
+            return p;
+    }
+}
+
+// Like strncasecmp() but NULs are compared like any other char.
+static int mem_casecmp(const char* s, const char* t, size_t n) {
+    for (size_t i = 0; i < n; ++i) {
+        int c = tolower((unsigned char)s[i]) - tolower((unsigned char)t[i]);
+        if (c)
+            return c;
+    }
+    return 0;
 }
@@ -4,12 +4,134 @@
 
 #include <inttypes.h>
 #include <stdbool.h>
+#include <stddef.h>
 #include <string.h>
 
 // The buffer size required to convert an int of up to 64-bits into a
 // string with comma grouped digits. See commas().
 #define COMMA_I64_SIZE 28
 
+// A non-owning view of the n chars at p (which needn't be NUL-terminated),
+// e.g., of a substring, so that it can be trimmed, searched, and compared
+// without copying it. The chars must outlive the view. None of the
+// str_view functions allocate except str_view_dup(). To print one use
+// printf("%.*s", (int)view.n, view.p).
+typedef struct StrView {
+    const char* p;
+    size_t n;
+} StrView;
+
+// Returned by the str_view find functions if there's no match.
+#define STR_VIEW_NOT_FOUND -1
+
+// Returns a view of the whole of s, or an empty view if s is NULL.
+StrView str_view(const char* s);
+
+// Returns a view of the n chars at s.
+StrView str_view_n(const char* s, size_t n);
+
+// Returns a view of up to n of view's chars from position pos (which is
+// clamped to the view's size).
+StrView str_view_sub(StrView view, size_t pos, size_t n);
+
+// Returns the view without its leading whitespace.
+StrView str_view_trim_left(StrView view);
+
+// Returns the view without its trailing whitespace.
+StrView str_view_trim_right(StrView view);
+
+// Returns the view without its leading or trailing whitespace.
+StrView str_view_trim(StrView view);
+
+// Returns the position of needle's first occurrence in view (0 if needle
+// is empty) or STR_VIEW_NOT_FOUND.
+ptrdiff_t str_view_find(StrView view, StrView needle);
+
+// Returns the position of needle's last occurrence in view (view.n if
+// needle is empty) or STR_VIEW_NOT_FOUND.
+ptrdiff_t str_view_rfind(StrView view, StrView needle);
+
+// Returns the position of c's first occurrence in view or
+// STR_VIEW_NOT_FOUND.
+ptrdiff_t str_view_find_chr(StrView view, int c);
+
+// Returns the position of c's last occurrence in view or
+// STR_VIEW_NOT_FOUND.
+ptrdiff_t str_view_rfind_chr(StrView view, int c);
+
+// Returns true if view begins with prefix.
+bool str_view_begins(StrView view, StrView prefix);
+
+// Returns true if view begins with prefix, regardless of case.
+bool str_view_casebegins(StrView view, StrView prefix);
+
+// Returns true if view ends with suffix.
+bool str_view_ends(StrView view, StrView suffix);
+
+// Returns true if view ends with suffix, regardless of case.
+bool str_view_caseends(StrView view, StrView suffix);
+
+// Returns true if the two views have the same chars.
+bool str_view_eq(StrView view1, StrView view2);
+
+// Returns true if the two views have the same chars, regardless of case.
+bool str_view_caseeq(StrView view1, StrView view2);
+
+// Returns < 0, 0, or > 0 like strcmp() (so a view that is a prefix of the
+// other sorts first).
+int str_view_cmp(StrView view1, StrView view2);
+
+// Returns a new NUL-terminated copy of the view's chars owned by the
+// caller.
+char* str_view_dup(StrView view);
+
+// A lazy split of a string (which must outlive it) that yields each part
+// as a StrView on demand, so splitting allocates nothing and stops as
+// soon as the caller has the parts it wants. The parts are the same as
+// split_str(), split_chr(), and split_ws() (see vec_str.h) return.
+//
+// ```
+// StrSplit split = str_split_ws(line);
+// StrView part;
+// while (str_split_next(&split, &part))
+//     printf("«%.*s»\n", (int)part.n, part.p);
+// ```
+typedef enum StrSplitKind {
+    StrSplitStr,
+    StrSplitChr,
+    StrSplitWs,
+} StrSplitKind;
+
+typedef struct StrSplit {
+    const char* _p; // the next part's start or NULL if there are no more
+    const char* _sep;
+    size_t _sep_size;
+    int _sep_chr;
+    StrSplitKind _kind;
+} StrSplit;
+
+// Returns a split of s on the sep string (neither of which may be NULL
+// and sep may not be empty). Empty parts are yielded except that there
+// is no final empty part if s ends with sep.
+StrSplit str_split_str(const char* s, const char* sep);
+
+// Returns a split of s (which may not be NULL) on the sep char (which
+// may not be NUL). Empty parts are yielded unless s is empty or all sep
+// chars.
+StrSplit str_split_chr(const char* s, int sep);
+
+// Returns a split of s by any amount of whitespace (with no empty parts).
+StrSplit str_split_ws(const char* s);
+
+// Sets part to the split's next part and returns true or returns false
+// if there are no more parts.
+bool str_split_next(StrSplit* split, StrView* part);
+
+// Sets up to cap of parts to the split's next parts and returns how many
+// it set. Any more parts can be had by calling str_split_next() (or this
+// function) again.
+ptrdiff_t str_split_views(StrSplit* split, StrView* parts, ptrdiff_t cap);
+
 // Returns true if char* s equals char* t
 #define str_eq(s, t) (!strcmp((s), (t)))
 
@@ -56,7 +178,8 @@ int str_strcasecmp(const void* s, const void* t);
 const char* str_trim_left(const char* s);
 
 // Like str_trim but only operates on the first n chars of s if n > 0 or
-// the whole of s (i.e., up to the terminating NUL) if n == 0.
+// the whole of s (i.e., up to the terminating NUL) if n == 0. (To trim
+// without allocating, use str_view_trim().)
 char* str_trimn(const char* s, size_t n);
 
 // Returns a new string owned by the caller that is a copy of s with no
@@ -72,10 +195,12 @@ const char* bool_to_str(bool b);
 // `s` should be of size COMMA_I64_SIZE.
 void commas(char* s, int64_t n);
 
-// Returns a pointer to the first non-whitespace char in p or NULL.
+// Returns a pointer to the first non-whitespace char in p (or to its
+// NUL if there isn't one); or NULL if p is NULL.
 const char* skip_ws(const char* p);
 
-// Returns a pointer to the first whitespace char in p or NULL.
+// Returns a pointer to the first whitespace char in p (or to its NUL if
+// there isn't one); or NULL if p is NULL.
 const char* skip_nonws(const char* p);
 
 // Returns the string representing the given object's typename. (For
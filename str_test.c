@@ -17,6 +17,10 @@ static void str_test_lowercase_ip(tinfo*);
 static void str_test_begins_ends(tinfo*);
 static void str_test_filename_ext(tinfo*);
 static void str_test_trim(tinfo*);
+static void str_test_view(tinfo*);
+static void str_test_split(tinfo*);
+static void str_test_skip(tinfo*);
+static void check_split(tinfo* tinfo, StrSplit split, const char* expected);
 
 void str_tests(tinfo* tinfo) {
     if (tinfo->verbose)
@@ -37,6 +41,12 @@ void str_tests(tinfo* tinfo) {
     str_test_filename_ext(tinfo);
     tinfo->tag = "str_test_trim";
     str_test_trim(tinfo);
+    tinfo->tag = "str_test_view";
+    str_test_view(tinfo);
+    tinfo->tag = "str_test_split";
+    str_test_split(tinfo);
+    tinfo->tag = "str_test_skip";
+    str_test_skip(tinfo);
 }
 
 static void str_test_uppercase(tinfo* tinfo) {
@@ -252,3 +262,145 @@ static void str_test_trim(tinfo* tinfo) {
     check_str_eq(tinfo, t, "x");
     free(t);
 }
+
+static void str_test_view(tinfo* tinfo) {
+    if (tinfo->verbose)
+        puts(tinfo->tag);
+    const char* line = "  Key = a value, another value\t\n";
+    StrView view = str_view(line);
+    check_int_eq(tinfo, view.n, strlen(line));
+    check_int_eq(tinfo, str_view(NULL).n, 0);
+    StrView trimmed = str_view_trim(view);
+    check_bool_eq(tinfo, trimmed.p == line + 2, true); // no copy
+    check_bool_eq(tinfo,
+                  str_view_eq(trimmed,
+                              str_view("Key = a value, another value")),
+                  true);
+    check_int_eq(tinfo, str_view_trim_left(view).n, strlen(line) - 2);
+    check_int_eq(tinfo, str_view_trim_right(view).n, strlen(line) - 2);
+    check_int_eq(tinfo, str_view_trim(str_view(" \t\n ")).n, 0);
+    // Whitespace is the same as for splitting whatever the locale, so
+    // the final non-breaking space (in Latin-1) stays.
+    check_int_eq(tinfo, str_view_trim(str_view("\v\f\r x \xA0")).n, 3);
+
+    ptrdiff_t i = str_view_find_chr(trimmed, '=');
+    check_int_eq(tinfo, i, 4);
+    StrView key = str_view_trim(str_view_n(trimmed.p, i));
+    StrView value = str_view_trim(str_view_sub(trimmed, i + 1, 1000));
+    check_bool_eq(tinfo, str_view_caseeq(key, str_view("KEY")), true);
+    check_bool_eq(tinfo, str_view_eq(key, str_view("KEY")), false);
+    check_bool_eq(tinfo, str_view_eq(key, str_view("Ke")), false);
+    check_int_eq(tinfo, str_view_find(value, str_view("value")), 2);
+    check_int_eq(tinfo, str_view_rfind(value, str_view("value")), 17);
+    check_int_eq(tinfo, str_view_find(value, str_view("values")),
+                 STR_VIEW_NOT_FOUND);
+    check_int_eq(tinfo, str_view_rfind(value, str_view("a v")), 0);
+    check_int_eq(tinfo, str_view_rfind(value, str_view("")), value.n);
+    check_int_eq(tinfo, str_view_find(value, str_view("")), 0);
+    check_int_eq(tinfo, str_view_rfind_chr(value, 'a'), 18);
+    check_int_eq(tinfo, str_view_find_chr(value, '!'), STR_VIEW_NOT_FOUND);
+    // The view ends before the NUL, so "value\t" isn't seen.
+    check_int_eq(tinfo, str_view_find_chr(value, '\t'), STR_VIEW_NOT_FOUND);
+
+    check_bool_eq(tinfo, str_view_begins(value, str_view("a val")), true);
+    check_bool_eq(tinfo, str_view_begins(value, str_view("A val")), false);
+    check_bool_eq(tinfo, str_view_casebegins(value, str_view("A VAL")),
+                  true);
+    check_bool_eq(tinfo, str_view_ends(value, str_view("r value")), true);
+    check_bool_eq(tinfo, str_view_caseends(value, str_view("R VALUE")),
+                  true);
+    check_bool_eq(tinfo, str_view_ends(key, str_view("a Key")), false);
+
+    check_bool_eq(tinfo, str_view_cmp(key, str_view("Key")) == 0, true);
+    check_bool_eq(tinfo, str_view_cmp(key, str_view("Kez")) < 0, true);
+    check_bool_eq(tinfo, str_view_cmp(key, str_view("Ke")) > 0, true);
+    check_bool_eq(tinfo, str_view_cmp(str_view(""), key) < 0, true);
+
+    StrView sub = str_view_sub(value, 9, 7);
+    check_bool_eq(tinfo, str_view_eq(sub, str_view("another")), true);
+    check_int_eq(tinfo, str_view_sub(value, 100, 5).n, 0);
+    char* s = str_view_dup(sub);
+    check_str_eq(tinfo, s, "another");
+    free(s);
+}
+
+static void str_test_split(tinfo* tinfo) {
+    if (tinfo->verbose)
+        puts(tinfo->tag);
+    check_split(tinfo, str_split_str("one\ttwo\t\tthree\t", "\t"),
+                "one|two||three");
+    check_split(tinfo, str_split_str("\tone", "\t"), "|one");
+    check_split(tinfo, str_split_str("oneSEPSEPtwo", "SEP"), "one||two");
+    check_split(tinfo, str_split_str("", ","), "");
+    check_split(tinfo, str_split_chr("a,b,,c,", ','), "a|b||c|");
+    check_split(tinfo, str_split_chr(",a", ','), "|a");
+    check_split(tinfo, str_split_chr(",,,", ','), "");
+    check_split(tinfo, str_split_chr("", ','), "");
+    check_split(tinfo, str_split_chr("elephant", ','), "elephant");
+    check_split(tinfo, str_split_ws("  one two\t\tthree \n"),
+                "one|two|three");
+    check_split(tinfo, str_split_ws("one"), "one");
+    check_split(tinfo, str_split_ws(" \t\n "), "");
+    check_split(tinfo, str_split_ws(""), "");
+
+    // The first fields of a log line, into a caller's array
+    const char* line =
+        "2025-01-31 12:00:03 WARN server.c:123 slow request 5ms";
+    StrSplit split = str_split_ws(line);
+    StrView parts[3];
+    check_int_eq(tinfo, str_split_views(&split, parts, 3), 3);
+    check_bool_eq(tinfo, str_view_eq(parts[2], str_view("WARN")), true);
+    check_bool_eq(tinfo, parts[0].p == line, true); // no copy
+    check_int_eq(tinfo, str_split_views(&split, parts, 3), 3);
+    check_bool_eq(tinfo, str_view_eq(parts[0], str_view("server.c:123")),
+                  true);
+    check_int_eq(tinfo, str_split_views(&split, parts, 3), 1);
+    check_bool_eq(tinfo, str_view_eq(parts[0], str_view("5ms")), true);
+    check_int_eq(tinfo, str_split_views(&split, parts, 3), 0);
+
+    // A long record with runs of whitespace longer than a vector
+    char record[1024] = "";
+    for (int i = 0; i < 40; ++i)
+        sprintf(record + strlen(record), "f%d%*s", i, i * 3 % 50, "\t");
+    split = str_split_ws(record);
+    int n = 0;
+    bool ok = true;
+    for (StrView part; str_split_next(&split, &part); ++n) {
+        char field[16];
+        snprintf(field, sizeof(field), "f%d", n);
+        ok &= str_view_eq(part, str_view(field));
+    }
+    check_int_eq(tinfo, n, 40);
+    check_bool_eq(tinfo, ok, true);
+}
+
+static void str_test_skip(tinfo* tinfo) {
+    const char* s = " \t\nword\v\f\rnext";
+    check_str_eq(tinfo, skip_ws(s), "word\v\f\rnext");
+    check_str_eq(tinfo, skip_nonws(skip_ws(s)), "\v\f\rnext");
+    check_str_eq(tinfo, skip_ws(""), "");
+    check_str_eq(tinfo, skip_ws("  "), ""); // stops at the NUL
+    check_str_eq(tinfo, skip_nonws("word"), "");
+    check_bool_eq(tinfo, skip_ws(NULL) == NULL, true);
+    check_bool_eq(tinfo, skip_nonws(NULL) == NULL, true);
+
+    // Runs longer than the scan windows
+    char long_run[300];
+    memset(long_run, ' ', 200);
+    memset(long_run + 200, 'x', 99);
+    long_run[299] = 0;
+    check_int_eq(tinfo, skip_ws(long_run) - long_run, 200);
+    check_int_eq(tinfo, skip_nonws(long_run + 200) - long_run, 299);
+    check_int_eq(tinfo, skip_ws(long_run + 200) - long_run, 200);
+}
+
+// Checks the split's parts joined with | are expected.
+static void check_split(tinfo* tinfo, StrSplit split,
+                        const char* expected) {
+    char actual[256] = "";
+    char* p = actual;
+    StrView part;
+    for (int i = 0; str_split_next(&split, &part); ++i)
+        p += sprintf(p, "%s%.*s", i ? "|" : "", (int)part.n, part.p);
+    check_str_eq(tinfo, actual, expected);
+}
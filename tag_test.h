@@ -15,15 +15,15 @@ typedef struct {
     long id;
 } Tag;
 
-#define _TAG_BUF_SZ 20
+#define _TAG_BUF_SZ 24
 
-Tag tag_make_key(char* name) {
+static inline Tag tag_make_key(char* name) {
     Tag tag = {name, 0};
     return tag;
 }
 
 // caller owns
-Tag* tag_alloc(char* name, long id) {
+static inline Tag* tag_alloc(char* name, long id) {
     Tag* tag = malloc(sizeof(Tag));
     assert_alloc(tag);
     tag->name = name;
@@ -36,7 +36,7 @@ Tag* tag_alloc(char* name, long id) {
 }
 
 // caller owns
-Tag* tag_make(bool reset) {
+static inline Tag* tag_make(bool reset) {
     static char N1 = 'A';
     static char N2 = 'a';
     static long ID = 100;
@@ -61,7 +61,7 @@ Tag* tag_make(bool reset) {
     return tag;
 }
 
-void tag_free(void* t) {
+static inline void tag_free(void* t) {
     Tag* tag = t;
 #ifdef MEMCHECK
     static int x = 0;
@@ -75,19 +75,31 @@ void tag_free(void* t) {
 // must cast to pointer to pointer to the actual type, then we must
 // dereference the outer pointer to get the inner pointer which is
 // actually used.
-int tag_cmp(const void* t1, const void* t2) {
+static inline int tag_cmp(const void* t1, const void* t2) {
     return strcmp((*(const Tag**)t1)->name, (*(const Tag**)t2)->name);
 }
 
+// Like tag_cmp but for Tags stored by value (e.g., in a VecVal), so each
+// void* argument is a pointer to a Tag.
+static inline int tag_val_cmp(const void* t1, const void* t2) {
+    return strcmp(((const Tag*)t1)->name, ((const Tag*)t2)->name);
+}
+
 // caller owns
-void* tag_copy(const void* tag) {
+static inline void* tag_copy(const void* tag) {
     assert_notnull(tag);
     const Tag* t = tag;
     return tag_alloc(strdup(t->name), t->id);
 }
 
+// Like tag_copy but for Tags stored by value (e.g., in a VecVal).
+static inline void tag_val_copy(void* dst, const void* src) {
+    const Tag* t = src;
+    *(Tag*)dst = (Tag){strdup(t->name), t->id};
+}
+
 // caller owns
-char* tag_to_str(Tag* tag) {
+static inline char* tag_to_str(Tag* tag) {
     assert_notnull(tag);
     char buf[_TAG_BUF_SZ];
     int n = sprintf(buf, "\"%s\"#%ld", tag->name, tag->id);
@@ -2,11 +2,33 @@
 // License: GPL-3
 
 #include "vec.h"
+#include "sort.h"
 #include <stdlib.h>
+#include <string.h>
 
-static void vec_grow(Vec* vec);
+static void vec_grow(Vec* vec, ptrdiff_t needed);
+static void vec_set_cap(Vec* vec, ptrdiff_t cap);
+static void vec_open_gap(Vec* vec, ptrdiff_t index, ptrdiff_t n);
+static void vec_close_gap(Vec* vec, ptrdiff_t index, ptrdiff_t n);
+static ptrdiff_t vec_unique_batch(const Vec* vec, void** batch,
+                                 ptrdiff_t n);
 
-Vec vec_alloc(int cap, int (*cmp)(const void*, const void*),
+typedef struct KeyValue {
+    uint64_t key;
+    void* value;
+} KeyValue;
+
+static void key_value_array_sort_radix(KeyValue* items, ptrdiff_t n);
+
+typedef int (*VecCmp)(const void*, const void*);
+#define VEC_LESS(cmp, x, y) ((cmp)(&(x), &(y)) < 0)
+SORT_DEFINE(ptr_array, void*, VecCmp, VEC_LESS)
+SORT_DEFINE_PARALLEL(ptr_array, void*, VecCmp, VEC_LESS)
+
+#define KEY_VALUE_LESS(ctx, x, y) ((x).key < (y).key)
+SORT_DEFINE(key_value_array, KeyValue, void*, KEY_VALUE_LESS)
+
+Vec vec_alloc(ptrdiff_t cap, int (*cmp)(const void*, const void*),
               void (*destroy)(void* value)) {
     assert(cmp && "must provide a cmp function");
     cap = cap > 0 ? cap : 0;
@@ -19,21 +41,23 @@ Vec vec_alloc(int cap, int (*cmp)(const void*, const void*),
                  ._cap = cap,
                  ._values = values,
                  ._cmp = cmp,
-                 ._destroy = destroy};
+                 ._destroy = destroy,
+                 ._growth = VEC_GROWTH_DEFAULT};
 }
 
 void vec_free(Vec* vec) {
     assert_notnull(vec);
     vec_clear(vec);
-    free(vec->_values);
+    vec_buffer_free(vec->_values, vec->_cap * sizeof(void*), vec->_large);
     vec->_values = NULL;
     vec->_cap = 0;
+    vec->_large = false;
     vec->_destroy = NULL;
 }
 
 void vec_clear(Vec* vec) {
     assert_notnull(vec);
-    for (int i = 0; i < vec->_size; ++i) {
+    for (ptrdiff_t i = 0; i < vec->_size; ++i) {
         if (vec->_destroy)
             vec->_destroy(vec->_values[i]); // contents of contained object
         free(vec->_values[i]);              // containing object
@@ -41,7 +65,40 @@ void vec_clear(Vec* vec) {
     vec->_size = 0;
 }
 
-void* vec_get(const Vec* vec, int index) {
+void vec_reserve(Vec* vec, ptrdiff_t cap) {
+    assert_notnull(vec);
+    if (cap > vec->_cap)
+        vec_set_cap(vec, cap);
+}
+
+void vec_shrink_to_fit(Vec* vec) {
+    assert_notnull(vec);
+    if (vec->_cap > vec->_size)
+        vec_set_cap(vec, vec->_size);
+}
+
+void vec_resize(Vec* vec, ptrdiff_t size, const void* value,
+                void* (*cpy)(const void*)) {
+    assert_notnull(vec);
+    assert(size >= 0 && "can't resize to a negative size");
+    if (size < vec->_size) {
+        for (ptrdiff_t i = size; i < vec->_size; ++i) {
+            if (vec->_destroy)
+                vec->_destroy(vec->_values[i]); // contents of object
+            free(vec->_values[i]);              // containing object
+        }
+    } else if (size > vec->_size) {
+        assert_notnull(value);
+        assert_notnull(cpy);
+        if (size > vec->_cap)
+            vec_grow(vec, size);
+        for (ptrdiff_t i = vec->_size; i < size; ++i)
+            vec->_values[i] = cpy(value);
+    }
+    vec->_size = size;
+}
+
+void* vec_get(const Vec* vec, ptrdiff_t index) {
     assert_notnull(vec);
     assert_nonempty(vec);
     assert_valid_index(vec, index);
@@ -60,7 +117,7 @@ inline void* vec_get_last(const Vec* vec) {
     return vec->_values[vec->_size - 1];
 }
 
-void vec_set(Vec* vec, int index, void* value) {
+void vec_set(Vec* vec, ptrdiff_t index, void* value) {
     assert_notnull(vec);
     assert_nonempty(vec);
     assert_notnull(value);
@@ -71,29 +128,66 @@ void vec_set(Vec* vec, int index, void* value) {
     vec->_values[index] = value;
 }
 
-void vec_insert(Vec* vec, int index, void* value) {
+void vec_insert(Vec* vec, ptrdiff_t index, void* value) {
     assert_notnull(vec);
     assert_notnull(value);
     assert_valid_index(vec, index);
-    if (vec->_size == vec->_cap)
-        vec_grow(vec);
-    for (int i = vec->_size; i > index; --i)
-        vec->_values[i] = vec->_values[i - 1];
+    vec_open_gap(vec, index, 1);
     vec->_values[index] = value;
-    vec->_size++;
+}
+
+void vec_insert_n(Vec* vec, ptrdiff_t index, ptrdiff_t n, const void* value,
+                  void* (*cpy)(const void*)) {
+    assert_notnull(vec);
+    assert_notnull(value);
+    assert_notnull(cpy);
+    assert_valid_range(vec, index, 0);
+    assert(n >= 0 && "can't insert a negative number of values");
+    vec_open_gap(vec, index, n);
+    for (ptrdiff_t i = index; i < index + n; ++i)
+        vec->_values[i] = cpy(value);
+}
+
+void vec_insert_range(Vec* vec, ptrdiff_t index, void* const* values,
+                      ptrdiff_t n) {
+    assert_notnull(vec);
+    assert_valid_range(vec, index, 0);
+    assert(n >= 0 && "can't insert a negative number of values");
+    if (n) {
+        assert_notnull(values);
+        vec_open_gap(vec, index, n);
+        memcpy(vec->_values + index, values, n * sizeof(void*));
+    }
+}
+
+void vec_insert_vec(Vec* vec1, ptrdiff_t index, const Vec* vec2,
+                    void* (*cpy)(const void*)) {
+    assert_notnull(vec1);
+    assert_notnull(vec2);
+    assert_notnull(cpy);
+    assert(vec1 != vec2 && "can't insert a vec into itself");
+    assert_valid_range(vec1, index, 0);
+    vec_open_gap(vec1, index, vec2->_size);
+    for (ptrdiff_t i = 0; i < vec2->_size; ++i)
+        vec1->_values[index + i] = cpy(vec2->_values[i]);
+}
+
+inline void vec_append_array(Vec* vec, void* const* values, ptrdiff_t n) {
+    assert_notnull(vec);
+    vec_insert_range(vec, vec->_size, values, n);
 }
 
 void vec_add(Vec* vec, void* value) {
     assert_notnull(vec);
     assert_notnull(value);
-    int high = vec->_size - 1;
+    ptrdiff_t high = vec->_size - 1;
     if (!vec->_size || vec->_cmp(&vec->_values[high], &value) <= 0)
         vec_push(vec,
                  value); // Vec is empty -or- nonempty and value >= high
     else {
-        int low = 0;
+        ptrdiff_t low = 0;
         while (low < high) {
-            int mid = (low + high) / 2;
+            ptrdiff_t mid = (low + high) / 2;
             if (vec->_cmp(&vec->_values[mid], &value) > 0)
                 high = mid;
             else
@@ -103,7 +197,34 @@ void vec_add(Vec* vec, void* value) {
     }
 }
 
-void* vec_replace(Vec* vec, int index, void* value) {
+void vec_add_many(Vec* vec, void* const* values, ptrdiff_t n, bool unique) {
+    assert_notnull(vec);
+    assert(n >= 0 && "can't add a negative number of values");
+    if (!n)
+        return;
+    assert_notnull(values);
+    void** batch = malloc(n * sizeof(void*));
+    assert_alloc(batch);
+    memcpy(batch, values, n * sizeof(void*));
+    ptr_array_sort(batch, n, vec->_cmp);
+    if (unique)
+        n = vec_unique_batch(vec, batch, n);
+    if (vec->_size + n > vec->_cap)
+        vec_grow(vec, vec->_size + n);
+    // Merge from the back; equal values go after those already present
+    ptrdiff_t i = vec->_size - 1;
+    ptrdiff_t k = vec->_size + n - 1;
+    for (ptrdiff_t j = n - 1; j >= 0; --k) {
+        if (i >= 0 && vec->_cmp(&vec->_values[i], &batch[j]) > 0)
+            vec->_values[k] = vec->_values[i--];
+        else
+            vec->_values[k] = batch[j--];
+    }
+    vec->_size += n;
+    free(batch);
+}
+
+void* vec_replace(Vec* vec, ptrdiff_t index, void* value) {
     assert_notnull(vec);
     assert_nonempty(vec);
     assert_notnull(value);
@@ -113,21 +234,62 @@ void* vec_replace(Vec* vec, int index, void* value) {
     return old;
 }
 
-inline void vec_remove(Vec* vec, int index) {
+inline void vec_remove(Vec* vec, ptrdiff_t index) {
     void* value = vec_take(vec, index); // vec_take does asserts
     if (vec->_destroy)
         vec->_destroy(value); // contents of contained object
     free(value);              // containing object
 }
 
-void* vec_take(Vec* vec, int index) {
+void vec_remove_range(Vec* vec, ptrdiff_t index, ptrdiff_t n) {
+    assert_notnull(vec);
+    assert_valid_range(vec, index, n);
+    for (ptrdiff_t i = index; i < index + n; ++i) {
+        if (vec->_destroy)
+            vec->_destroy(vec->_values[i]); // contents of contained object
+        free(vec->_values[i]);              // containing object
+    }
+    vec_close_gap(vec, index, n);
+}
+
+void vec_swap_remove(Vec* vec, ptrdiff_t index) {
+    assert_notnull(vec);
+    assert_nonempty(vec);
+    assert_valid_index(vec, index);
+    void* value = vec->_values[index];
+    if (vec->_destroy)
+        vec->_destroy(value); // contents of contained object
+    free(value);              // containing object
+    vec->_values[index] = vec->_values[--vec->_size];
+    vec->_values[vec->_size] = NULL;
+}
+
+ptrdiff_t vec_retain(Vec* vec, bool (*pred)(const void* value, void* state),
+                     void* state) {
+    assert_notnull(vec);
+    assert_notnull(pred);
+    ptrdiff_t j = 0;
+    for (ptrdiff_t i = 0; i < vec->_size; ++i) {
+        void* value = vec->_values[i];
+        if (pred(value, state))
+            vec->_values[j++] = value;
+        else {
+            if (vec->_destroy)
+                vec->_destroy(value); // contents of contained object
+            free(value);              // containing object
+        }
+    }
+    ptrdiff_t removed = vec->_size - j;
+    vec->_size = j;
+    return removed;
+}
+
+void* vec_take(Vec* vec, ptrdiff_t index) {
     assert_notnull(vec);
     assert_nonempty(vec);
     assert_valid_index(vec, index);
     void* old = vec->_values[index];
-    for (int i = index; i < vec->_size; ++i)
-        vec->_values[i] = vec->_values[i + 1];
-    vec->_size--;
+    vec_close_gap(vec, index, 1);
     vec->_values[vec->_size] = NULL;
     return old;
 }
@@ -142,14 +304,15 @@ void vec_push(Vec* vec, void* value) {
     assert_notnull(vec);
     assert_notnull(value);
     if (vec->_size == vec->_cap)
-        vec_grow(vec);
+        vec_grow(vec, vec->_size + 1);
     vec->_values[vec->_size++] = value;
 }
 
 Vec vec_copy(const Vec* vec, void* (*cpy)(const void*)) {
     Vec out = vec_alloc(vec->_size, vec->_cmp, vec->_destroy);
-    for (int i = 0; i < vec->_size; ++i)
+    for (ptrdiff_t i = 0; i < vec->_size; ++i)
         vec_push(&out, cpy(vec->_values[i]));
+    out._growth = vec->_growth;
     return out;
 }
 
@@ -160,17 +323,14 @@ void vec_merge(Vec* vec1, Vec* vec2) {
            vec_ownership(vec1) == vec_ownership(vec2) &&
            "incompatible vecs");
     if ((vec1->_cap - vec1->_size) <
-        vec2->_size) { // vec1 doesn't have enough cap
-        int cap = vec1->_size + vec2->_size;
-        void** p = realloc(vec1->_values, cap * sizeof(void*));
-        assert_alloc(p);
-        vec1->_values = p;
-        vec1->_cap = cap;
-    }
-    for (int i = 0; i < vec2->_size; ++i)
+        vec2->_size) // vec1 doesn't have enough cap
+        vec_set_cap(vec1, vec1->_size + vec2->_size);
+    for (ptrdiff_t i = 0; i < vec2->_size; ++i)
         vec1->_values[vec1->_size++] = vec2->_values[i]; // push
-    free(vec2->_values);
+    vec_buffer_free(vec2->_values, vec2->_cap * sizeof(void*),
+                    vec2->_large);
     vec2->_values = NULL;
+    vec2->_large = false;
     vec2->_cap = 0;
     vec2->_size = 0;
     vec2->_destroy = NULL;
@@ -181,7 +341,7 @@ bool vec_equal(const Vec* vec1, const Vec* vec2) {
     assert_notnull(vec2);
     if (vec1->_size != vec2->_size)
         return false;
-    for (int i = 0; i < vec1->_size; ++i)
+    for (ptrdiff_t i = 0; i < vec1->_size; ++i)
         if (vec1->_cmp(&vec1->_values[i], &vec2->_values[i]))
             return false;
     return true;
@@ -195,19 +355,19 @@ bool vec_same(const Vec* vec1, const Vec* vec2) {
     return vec_equal(vec1, vec2);
 }
 
-int vec_find(const Vec* vec, const void* value) {
+ptrdiff_t vec_find(const Vec* vec, const void* value) {
     assert_notnull(vec);
     assert_notnull(value);
-    for (int i = 0; i < vec->_size; ++i)
+    for (ptrdiff_t i = 0; i < vec->_size; ++i)
         if (vec->_cmp(&vec->_values[i], &value) == 0)
             return i;
     return VEC_NOT_FOUND;
 }
 
-int vec_find_last(const Vec* vec, const void* value) {
+ptrdiff_t vec_find_last(const Vec* vec, const void* value) {
     assert_notnull(vec);
     assert_notnull(value);
-    for (int i = vec->_size - 1; i >= 0; --i)
+    for (ptrdiff_t i = vec->_size - 1; i >= 0; --i)
         if (vec->_cmp(&vec->_values[i], &value) == 0)
             return i;
     return VEC_NOT_FOUND;
@@ -215,11 +375,36 @@ int vec_find_last(const Vec* vec, const void* value) {
 
 void vec_sort(Vec* vec) {
     assert_notnull(vec);
-    if (vec->_size)
-        qsort(vec->_values, vec->_size, sizeof(void*), vec->_cmp);
+    ptr_array_sort(vec->_values, vec->_size, vec->_cmp);
 }
 
-int vec_search(const Vec* vec, const void* value) {
+void vec_sort_stable(Vec* vec) {
+    assert_notnull(vec);
+    ptr_array_sort_stable(vec->_values, vec->_size, vec->_cmp);
+}
+
+void vec_sort_by_key(Vec* vec, uint64_t (*key_fn)(const void* value)) {
+    assert_notnull(vec);
+    assert_notnull(key_fn);
+    if (vec->_size < 2)
+        return;
+    KeyValue* items = malloc(vec->_size * sizeof(KeyValue));
+    assert_alloc(items);
+    for (ptrdiff_t i = 0; i < vec->_size; ++i)
+        items[i] = (KeyValue){key_fn(vec->_values[i]), vec->_values[i]};
+    key_value_array_sort_radix(items, vec->_size);
+    for (ptrdiff_t i = 0; i < vec->_size; ++i)
+        vec->_values[i] = items[i].value;
+    free(items);
+}
+
+void vec_sort_parallel(Vec* vec, int nthreads) {
+    assert_notnull(vec);
+    ptr_array_sort_parallel(vec->_values, vec->_size, vec->_cmp, nthreads,
+                            true);
+}
+
+ptrdiff_t vec_search(const Vec* vec, const void* value) {
     assert_notnull(vec);
     assert_notnull(value);
     if (vec->_size) {
@@ -231,10 +416,95 @@ int vec_search(const Vec* vec, const void* value) {
     return VEC_NOT_FOUND;
 }
 
-static void vec_grow(Vec* vec) {
-    int cap = vec->_cap;
-    assert((!cap && !vec->_values) || (cap && vec->_values));
-    vec->_cap = VEC_GROW_CAP(cap);
-    vec->_values = realloc(vec->_values, vec->_cap * sizeof(void*));
-    assert_alloc(vec->_values);
+static void vec_grow(Vec* vec, ptrdiff_t needed) {
+    assert((!vec->_cap && !vec->_values) || (vec->_cap && vec->_values));
+    vec_set_cap(vec, vec_grow_cap(&vec->_growth, vec->_cap, needed));
+}
+
+static void vec_set_cap(Vec* vec, ptrdiff_t cap) {
+    assert(cap >= vec->_size && "can't reduce cap below size");
+    vec->_values = vec_buffer_resize(
+        vec->_values, vec->_size * sizeof(void*), vec->_cap * sizeof(void*),
+        cap * sizeof(void*), vec->_growth.large, &vec->_large);
+    vec->_cap = cap;
+}
+
+static void vec_open_gap(Vec* vec, ptrdiff_t index, ptrdiff_t n) {
+    if (!n)
+        return;
+    if (vec->_size + n > vec->_cap)
+        vec_grow(vec, vec->_size + n);
+    memmove(vec->_values + index + n, vec->_values + index,
+            (vec->_size - index) * sizeof(void*));
+    vec->_size += n;
+}
+
+static void vec_close_gap(Vec* vec, ptrdiff_t index, ptrdiff_t n) {
+    if (!n)
+        return;
+    memmove(vec->_values + index, vec->_values + index + n,
+            (vec->_size - index - n) * sizeof(void*));
+    vec->_size -= n;
+}
+
+// Drops (and if owning, frees) values from the sorted batch that are
+// repeats or are already in the vec, and returns the batch's new size.
+static ptrdiff_t vec_unique_batch(const Vec* vec, void** batch,
+                                 ptrdiff_t n) {
+    int (*cmp)(const void*, const void*) = vec->_cmp;
+    ptrdiff_t i = 0;
+    ptrdiff_t k = 0;
+    for (ptrdiff_t j = 0; j < n; ++j) {
+        while (i < vec->_size && cmp(&vec->_values[i], &batch[j]) < 0)
+            ++i;
+        if ((k && cmp(&batch[k - 1], &batch[j]) == 0) ||
+            (i < vec->_size && cmp(&vec->_values[i], &batch[j]) == 0)) {
+            if (vec->_destroy)
+                vec->_destroy(batch[j]); // contents of contained object
+            free(batch[j]);              // containing object
+            continue;
+        }
+        batch[k++] = batch[j];
+    }
+    return k;
+}
+
+// All eight byte histograms are counted in one pass, and passes where
+// every key has the same byte (e.g., the high bytes of small keys) are
+// skipped. Each pass is stable so the whole sort is.
+static void key_value_array_sort_radix(KeyValue* items, ptrdiff_t n) {
+    if (n < SORT_RADIX_MIN) {
+        key_value_array_sort_stable(items, n, NULL);
+        return;
+    }
+    ptrdiff_t counts[8][256] = {{0}};
+    for (ptrdiff_t i = 0; i < n; ++i) {
+        uint64_t key = items[i].key;
+        for (int b = 0; b < 8; ++b)
+            counts[b][(key >> (b * 8)) & 0xFF]++;
+    }
+    KeyValue* tmp = malloc(n * sizeof(KeyValue));
+    assert_alloc(tmp);
+    KeyValue* src = items;
+    KeyValue* dst = tmp;
+    for (int b = 0; b < 8; ++b) {
+        int shift = b * 8;
+        ptrdiff_t* count = counts[b];
+        if (count[(src[0].key >> shift) & 0xFF] == n)
+            continue; // every key has the same byte here
+        ptrdiff_t total = 0;
+        for (int d = 0; d < 256; ++d) {
+            ptrdiff_t c = count[d];
+            count[d] = total;
+            total += c;
+        }
+        for (ptrdiff_t i = 0; i < n; ++i)
+            dst[count[(src[i].key >> shift) & 0xFF]++] = src[i];
+        KeyValue* t = src;
+        src = dst;
+        dst = t;
+    }
+    if (src != items)
+        memcpy(items, src, n * sizeof(KeyValue));
+    free(tmp);
 }
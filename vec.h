@@ -5,6 +5,7 @@
 #include "cx.h"
 #include "vecs.h"
 #include <stdbool.h>
+#include <stdint.h>
 
 // A vector of owned or borrowed void* values.
 // All accesses via functions, but _reading_ `_values` is okay.
@@ -14,24 +15,30 @@
 // Vec see tag_test.h for the Tag struct and vec_test.[hc] for usage
 // examples.
 //
+// To store values (e.g., structs) inline in one contiguous buffer rather
+// than as pointers to individually allocated values, see VecVal in
+// vec_val.h.
+//
 // To iterate:
 // ```
-//  for (int i = 0; i < VEC_SIZE(vec); ++i)
+//  for (ptrdiff_t i = 0; i < VEC_SIZE(vec); ++i)
 //      const MyType* value = VEC_GET(vec, i);
 // ```
 typedef struct Vec {
-    int _size; // This is "end", i.e., one past the last value
-    int _cap;  // The size of the allocated array
+    ptrdiff_t _size; // This is "end", i.e., one past the last value
+    ptrdiff_t _cap;  // The size of the allocated array
     void** _values;
     int (*_cmp)(const void*, const void*);
     void (*_destroy)(void* value);
+    VecGrowth _growth; // See VEC_SET_GROWTH()
+    bool _large;       // _values is in large mode (see VecGrowth)
 } Vec;
 
 // Allocates a new Vec of owned or borrowed void* with the given
 // capacity which may be 0.
 // Caller must supply cmp to compare values (for find, sort, and search),
 // and if owning, destroy to free a value.
-Vec vec_alloc(int cap, int (*cmp)(const void*, const void*),
+Vec vec_alloc(ptrdiff_t cap, int (*cmp)(const void*, const void*),
               void (*destroy)(void* value));
 
 // Destroys the Vec freeing its memory and if owning, also freeing every
@@ -41,13 +48,26 @@ void vec_free(Vec* vec);
 // Calls destroy on all the Vec's values if owning.
 void vec_clear(Vec* vec);
 
+// Ensures the Vec's capacity is at least cap, e.g., before pushing a
+// known number of values.
+void vec_reserve(Vec* vec, ptrdiff_t cap);
+
+// Reduces the Vec's capacity to its size, freeing any unused memory.
+void vec_shrink_to_fit(Vec* vec);
+
+// Resizes the Vec to the given size, either truncating it (destroying
+// and freeing the removed values) or padding it with new values each
+// created by calling cpy(value).
+void vec_resize(Vec* vec, ptrdiff_t size, const void* value,
+                void* (*cpy)(const void*));
+
 // Returns Owns if the Vec is owning, otherwise Borrows.
 #define vec_ownership(vec) ((vec)->_destroy == NULL ? Borrows : Owns)
 
 // Returns the Vec's value at position index.
 // If owning, Vec retains ownership, so do not delete the value.
 // The VEC_GET() macro is faster but unchecked.
-void* vec_get(const Vec* vec, int index);
+void* vec_get(const Vec* vec, ptrdiff_t index);
 
 // Returns the Vec's value at its first valid index.
 // If owning, Vec retains ownership, so do not delete the value.
@@ -62,7 +82,7 @@ void* vec_get_last(const Vec* vec);
 // Sets the Vec's value at position index to the given value.
 // If owning, Vec takes ownership of the new value (e.g., if char* then use
 // strdup()) and frees the old value.
-void vec_set(Vec* vec, int index, void* value);
+void vec_set(Vec* vec, ptrdiff_t index, void* value);
 
 // Inserts the value at position index and moves succeeding values up
 // (right), increasing the Vec's size (and cap if necessary): O(n).
@@ -70,7 +90,32 @@ void vec_set(Vec* vec, int index, void* value);
 // an unsorted Vec.
 // If owning, Vec takes ownership of the new value (e.g., if char* then use
 // strdup()).
-void vec_insert(Vec* vec, int index, void* value);
+void vec_insert(Vec* vec, ptrdiff_t index, void* value);
+
+// Inserts n new values each created by calling cpy(value) at position
+// index (which may be VEC_SIZE(vec) to append) and moves succeeding values
+// up (right) in a single move, increasing the Vec's size (and cap if
+// necessary): O(n).
+void vec_insert_n(Vec* vec, ptrdiff_t index, ptrdiff_t n, const void* value,
+                  void* (*cpy)(const void*));
+
+// Inserts the n values from the values array at position index (which
+// may be VEC_SIZE(vec) to append) and moves succeeding values up (right)
+// in a single move: O(n). The values must not be in the Vec itself.
+// If owning, Vec takes ownership of the new values.
+void vec_insert_range(Vec* vec, ptrdiff_t index, void* const* values,
+                      ptrdiff_t n);
+
+// Inserts copies (made using cpy) of all vec2's values into vec1 at
+// position index (which may be VEC_SIZE(vec1) to append): O(n). vec2 is
+// unchanged.
+void vec_insert_vec(Vec* vec1, ptrdiff_t index, const Vec* vec2,
+                    void* (*cpy)(const void*));
+
+// Appends the n values from the values array, increasing the Vec's size
+// (and cap if necessary): O(n). The values must not be in the Vec itself.
+// If owning, Vec takes ownership of the new values.
+void vec_append_array(Vec* vec, void* const* values, ptrdiff_t n);
 
 // Adds the value in order (in a sorted Vec) and moves succeeding values up
 // (right), increasing the Vec's size (and cap if necessary): O(n).
@@ -78,21 +123,43 @@ void vec_insert(Vec* vec, int index, void* value);
 // strdup()).
 void vec_add(Vec* vec, void* value);
 
+// Adds the n values from the values array in order (in a sorted Vec) by
+// sorting a copy of the array and merging it in a single pass:
+// O(n + m log m) rather than O(n·m) for m calls to vec_add().
+// If unique is true, values already in the Vec or repeated in the array
+// are not added (and if owning, are freed).
+// If owning, Vec takes ownership of the new values.
+void vec_add_many(Vec* vec, void* const* values, ptrdiff_t n, bool unique);
+
 // Sets the Vec's value at position index to the given value and returns
 // the old value from that position.
 // If owning, Vec takes ownership of the new value (e.g., if char* then use
 // strdup()). The returned value is now owned by the caller if it was owned
 // by Vec.
-void* vec_replace(Vec* vec, int index, void* value);
+void* vec_replace(Vec* vec, ptrdiff_t index, void* value);
 
 // Removes and, if owning, frees the value at the given index and closes up
 // the gap: O(n).
-void vec_remove(Vec* vec, int index);
+void vec_remove(Vec* vec, ptrdiff_t index);
+
+// Removes and, if owning, frees the n values from position index onwards
+// and closes up the gap in a single move: O(n).
+void vec_remove_range(Vec* vec, ptrdiff_t index, ptrdiff_t n);
+
+// Removes and, if owning, frees the value at the given index by moving the
+// last value into its place, so the order is not preserved: O(1).
+void vec_swap_remove(Vec* vec, ptrdiff_t index);
+
+// Keeps only the values for which pred(value, state) returns true,
+// preserving their order, and returns how many values were removed (and
+// if owning, freed). Uses a single pass: O(n).
+ptrdiff_t vec_retain(Vec* vec, bool (*pred)(const void* value, void* state),
+                     void* state);
 
 // Returns and removes the value at the given index and closes up the
 // gap.
 // If Vec is owning, the returned value is now owned by the caller: O(n).
-void* vec_take(Vec* vec, int index);
+void* vec_take(Vec* vec, ptrdiff_t index);
 
 // Removes and returns the last value. Only use if vec.isempty() is false.
 // The returned value is now owned by the caller, if Vec is owning: O(1).
@@ -127,18 +194,37 @@ bool vec_same(const Vec* vec1, const Vec* vec2);
 
 // Returns the index where the value was found in the Vec or
 // VEC_NOT_FOUND (-1). Uses a linear search.
-int vec_find(const Vec* vec, const void* value);
+ptrdiff_t vec_find(const Vec* vec, const void* value);
 
 // Returns the last index where the value was found in the Vec or
 // VEC_NOT_FOUND (-1). Uses a linear search.
-int vec_find_last(const Vec* vec, const void* value);
+ptrdiff_t vec_find_last(const Vec* vec, const void* value);
 
 // Sorts the Vec in-place using the cmp function.
 // See tag_test.h's tag_cmp and sx.c's str_strcmp functions for examples
 // of how to create a cmp function.
 void vec_sort(Vec* vec);
 
+// Sorts the Vec in-place using the cmp function like vec_sort(), but
+// stable, i.e., values that compare equal keep their order.
+void vec_sort_stable(Vec* vec);
+
+// Sorts the Vec in-place using the cmp function (which must be safe to
+// call from several threads at once) and nthreads threads (or one per
+// online CPU if nthreads <= 0). The sort is stable so the result is
+// identical to vec_sort_stable()'s, to which it falls back for Vecs of
+// fewer than SORT_PARALLEL_MIN values. See sort.h.
+void vec_sort_parallel(Vec* vec, int nthreads);
+
+// Sorts the Vec in-place in ascending order of the unsigned 64-bit key
+// that key_fn returns for each value, using an LSD radix sort of (key,
+// value) pairs, so key_fn is called once per value and cmp is never
+// called: O(n), using 2n pairs of extra memory. Stable, i.e., values
+// with equal keys keep their order. For a signed key k, return
+// (uint64_t)k ^ (UINT64_C(1) << 63) so negative keys sort first.
+void vec_sort_by_key(Vec* vec, uint64_t (*key_fn)(const void* value));
+
 // Returns the index where the value was found in the Vec or
 // VEC_NOT_FOUND (-1). Uses a binary search that assumes vec_sort() has
 // been used.
-int vec_search(const Vec* vec, const void* value);
+ptrdiff_t vec_search(const Vec* vec, const void* value);
@@ -1,34 +1,78 @@
 // Copyright © 2024-25 Mark Summerfield. All rights reserved.
 // License: GPL-3
 
+#define _GNU_SOURCE // for memrchr
+
 #include "vec_byte.h"
+#include "checksum.h"
+#include "codec.h"
+#include "lz.h"
+#include <errno.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+// vec_byte_read_fd_all() ensures at least this much spare capacity.
+#define READ_MIN 65536
 
-static void vec_byte_grow(VecByte* vec);
+// vec_byte_writev_fd() passes writev() at most this many buffers at once.
+#define WRITEV_MAX 64
 
-VecByte vec_byte_alloc_cap(int cap) {
+static void vec_byte_grow(VecByte* vec, ptrdiff_t needed);
+static void vec_byte_set_cap(VecByte* vec, ptrdiff_t cap);
+static void vec_byte_open_gap(VecByte* vec, ptrdiff_t index, ptrdiff_t n);
+static void vec_byte_close_gap(VecByte* vec, ptrdiff_t index,
+                               ptrdiff_t n);
+
+VecByte vec_byte_alloc_cap(ptrdiff_t cap) {
     cap = cap > 0 ? cap : 0;
     byte* values = NULL;
     if (cap) {
         values = malloc(cap * sizeof(byte));
         assert_alloc(values);
     }
-    return (VecByte){._size = 0, ._cap = cap, ._values = values};
+    return (VecByte){._size = 0,
+                     ._cap = cap,
+                     ._values = values,
+                     ._growth = VEC_GROWTH_DEFAULT};
 }
 
 void vec_byte_free(VecByte* vec) {
     assert_notnull(vec);
-    free(vec->_values);
+    vec_buffer_free(vec->_values, vec->_cap, vec->_large);
     vec->_values = NULL;
     vec->_size = 0;
     vec->_cap = 0;
+    vec->_large = false;
 }
 
 inline void vec_byte_clear(VecByte* vec) { vec->_size = 0; }
 
-byte vec_byte_get(const VecByte* vec, int index) {
+void vec_byte_reserve(VecByte* vec, ptrdiff_t cap) {
+    assert_notnull(vec);
+    if (cap > vec->_cap)
+        vec_byte_set_cap(vec, cap);
+}
+
+void vec_byte_shrink_to_fit(VecByte* vec) {
+    assert_notnull(vec);
+    if (vec->_cap > vec->_size)
+        vec_byte_set_cap(vec, vec->_size);
+}
+
+void vec_byte_resize(VecByte* vec, ptrdiff_t size, byte value) {
+    assert_notnull(vec);
+    assert(size >= 0 && "can't resize to a negative size");
+    if (size > vec->_cap)
+        vec_byte_grow(vec, size);
+    if (size > vec->_size)
+        memset(&vec->_values[vec->_size], value, size - vec->_size);
+    vec->_size = size;
+}
+
+byte vec_byte_get(const VecByte* vec, ptrdiff_t index) {
     assert_notnull(vec);
     assert_nonempty(vec);
     assert_valid_index(vec, index);
@@ -47,25 +91,166 @@ inline byte vec_byte_get_last(const VecByte* vec) {
     return vec->_values[vec->_size - 1];
 }
 
-void vec_byte_set(VecByte* vec, int index, byte value) {
+void vec_byte_set(VecByte* vec, ptrdiff_t index, byte value) {
     assert_notnull(vec);
     assert_nonempty(vec);
     assert_valid_index(vec, index);
     vec->_values[index] = value;
 }
 
-void vec_byte_insert(VecByte* vec, int index, byte value) {
+void vec_byte_insert(VecByte* vec, ptrdiff_t index, byte value) {
     assert_notnull(vec);
     assert_valid_index(vec, index);
-    if (vec->_size == vec->_cap)
-        vec_byte_grow(vec);
-    for (int i = vec->_size; i > index; --i)
-        vec->_values[i] = vec->_values[i - 1];
+    vec_byte_open_gap(vec, index, 1);
     vec->_values[index] = value;
-    vec->_size++;
 }
 
-byte vec_byte_replace(VecByte* vec, int index, byte value) {
+void vec_byte_insert_n(VecByte* vec, ptrdiff_t index, ptrdiff_t n,
+                       byte value) {
+    assert_notnull(vec);
+    assert_valid_range(vec, index, 0);
+    assert(n >= 0 && "can't insert a negative number of values");
+    if (n) {
+        vec_byte_open_gap(vec, index, n);
+        memset(vec->_values + index, value, n);
+    }
+}
+
+void vec_byte_insert_range(VecByte* vec, ptrdiff_t index,
+                           const byte* values, ptrdiff_t n) {
+    assert_notnull(vec);
+    assert_valid_range(vec, index, 0);
+    assert(n >= 0 && "can't insert a negative number of values");
+    if (n) {
+        assert_notnull(values);
+        vec_byte_open_gap(vec, index, n);
+        memcpy(vec->_values + index, values, n);
+    }
+}
+
+inline void vec_byte_insert_vec(VecByte* vec1, ptrdiff_t index,
+                                const VecByte* vec2) {
+    assert_notnull(vec2);
+    assert(vec1 != vec2 && "can't insert a vec into itself");
+    vec_byte_insert_range(vec1, index, vec2->_values, vec2->_size);
+}
+
+inline void vec_byte_append_array(VecByte* vec, const byte* values,
+                                  ptrdiff_t n) {
+    assert_notnull(vec);
+    vec_byte_insert_range(vec, vec->_size, values, n);
+}
+
+void vec_byte_append(VecByte* vec, const void* data, ptrdiff_t n) {
+    assert_notnull(vec);
+    assert(n >= 0 && "can't append a negative number of bytes");
+    if (!n)
+        return;
+    assert_notnull(data);
+    if (vec->_size + n > vec->_cap) {
+        uintptr_t p = (uintptr_t)data; // may be in the buffer being moved
+        uintptr_t start = (uintptr_t)vec->_values;
+        bool inside = vec->_values && p >= start && p < start + vec->_size;
+        vec_byte_grow(vec, vec->_size + n);
+        if (inside)
+            data = vec->_values + (p - start);
+    }
+    memmove(vec->_values + vec->_size, data, n);
+    vec->_size += n;
+}
+
+byte* vec_byte_spare(VecByte* vec, ptrdiff_t n) {
+    assert_notnull(vec);
+    assert(n >= 0 && "can't reserve a negative number of bytes");
+    if (vec->_size + n > vec->_cap)
+        vec_byte_grow(vec, vec->_size + n);
+    return vec->_values + vec->_size;
+}
+
+void vec_byte_commit(VecByte* vec, ptrdiff_t n) {
+    assert_notnull(vec);
+    assert(n >= 0 && vec->_size + n <= vec->_cap &&
+           "can't commit more bytes than vec_byte_spare() gave");
+    vec->_size += n;
+}
+
+ptrdiff_t vec_byte_read_fd(VecByte* vec, int fd, ptrdiff_t n) {
+    assert_notnull(vec);
+    assert(n >= 0 && "can't read a negative number of bytes");
+    if (!n)
+        return 0;
+    byte* p = vec_byte_spare(vec, n);
+    ssize_t count;
+    do
+        count = read(fd, p, n);
+    while (count < 0 && errno == EINTR);
+    if (count > 0)
+        vec->_size += count;
+    return count;
+}
+
+ptrdiff_t vec_byte_read_fd_all(VecByte* vec, int fd) {
+    assert_notnull(vec);
+    ptrdiff_t total = 0;
+    for (;;) {
+        if (vec->_cap - vec->_size < READ_MIN)
+            vec_byte_grow(vec, vec->_size + READ_MIN);
+        ptrdiff_t count = vec_byte_read_fd(vec, fd, vec->_cap - vec->_size);
+        if (count < 0)
+            return -1;
+        if (!count)
+            return total;
+        total += count;
+    }
+}
+
+inline ptrdiff_t vec_byte_write_fd(const VecByte* vec, int fd) {
+    assert_notnull(vec);
+    return vec_byte_writev_fd(&vec, 1, fd);
+}
+
+// Each writev() is given the unwritten parts of up to WRITEV_MAX vecs
+// starting from vecs[i] at offset.
+ptrdiff_t vec_byte_writev_fd(const VecByte* const* vecs, int count,
+                             int fd) {
+    assert_notnull(vecs);
+    ptrdiff_t total = 0;
+    int i = 0;
+    ptrdiff_t offset = 0;
+    while (i < count) {
+        struct iovec iov[WRITEV_MAX];
+        int n = 0;
+        for (int j = i; j < count && n < WRITEV_MAX; ++j) {
+            assert_notnull(vecs[j]);
+            ptrdiff_t start = j == i ? offset : 0;
+            if (vecs[j]->_size > start)
+                iov[n++] = (struct iovec){vecs[j]->_values + start,
+                                          vecs[j]->_size - start};
+        }
+        if (!n)
+            break; // only empty vecs are left
+        ssize_t written = writev(fd, iov, n);
+        if (written < 0) {
+            if (errno == EINTR)
+                continue;
+            return -1;
+        }
+        total += written;
+        while (i < count) { // skip what's been written
+            ptrdiff_t left = vecs[i]->_size - offset;
+            if (written < left) {
+                offset += written;
+                break;
+            }
+            written -= left;
+            offset = 0;
+            ++i;
+        }
+    }
+    return total;
+}
+
+byte vec_byte_replace(VecByte* vec, ptrdiff_t index, byte value) {
     assert_notnull(vec);
     assert_nonempty(vec);
     assert_valid_index(vec, index);
@@ -74,16 +259,41 @@ byte vec_byte_replace(VecByte* vec, int index, byte value) {
     return old;
 }
 
-void vec_byte_remove(VecByte* vec, int index) {
+void vec_byte_remove(VecByte* vec, ptrdiff_t index) {
+    assert_notnull(vec);
+    assert_nonempty(vec);
+    assert_valid_index(vec, index);
+    vec_byte_close_gap(vec, index, 1);
+}
+
+void vec_byte_remove_range(VecByte* vec, ptrdiff_t index, ptrdiff_t n) {
+    assert_notnull(vec);
+    assert_valid_range(vec, index, n);
+    vec_byte_close_gap(vec, index, n);
+}
+
+void vec_byte_swap_remove(VecByte* vec, ptrdiff_t index) {
     assert_notnull(vec);
     assert_nonempty(vec);
     assert_valid_index(vec, index);
-    for (int i = index; i < vec->_size; ++i)
-        vec->_values[i] = vec->_values[i + 1];
-    vec->_size--;
+    vec->_values[index] = vec->_values[--vec->_size];
+}
+
+ptrdiff_t vec_byte_retain(VecByte* vec,
+                          bool (*pred)(byte value, void* state),
+                          void* state) {
+    assert_notnull(vec);
+    assert_notnull(pred);
+    ptrdiff_t j = 0;
+    for (ptrdiff_t i = 0; i < vec->_size; ++i)
+        if (pred(vec->_values[i], state))
+            vec->_values[j++] = vec->_values[i];
+    ptrdiff_t removed = vec->_size - j;
+    vec->_size = j;
+    return removed;
 }
 
-byte vec_byte_take(VecByte* vec, int index) {
+byte vec_byte_take(VecByte* vec, ptrdiff_t index) {
     assert_notnull(vec);
     assert_nonempty(vec);
     assert_valid_index(vec, index);
@@ -101,15 +311,16 @@ byte vec_byte_pop(VecByte* vec) {
 void vec_byte_push(VecByte* vec, byte value) {
     assert_notnull(vec);
     if (vec->_size == vec->_cap)
-        vec_byte_grow(vec);
+        vec_byte_grow(vec, vec->_size + 1);
     vec->_values[vec->_size++] = value;
 }
 
 VecByte vec_byte_copy(const VecByte* vec) {
     assert_notnull(vec);
     VecByte out = vec_byte_alloc_cap(vec->_size);
-    for (int i = 0; i < vec->_size; ++i)
+    for (ptrdiff_t i = 0; i < vec->_size; ++i)
         vec_byte_push(&out, vec->_values[i]);
+    out._growth = vec->_growth;
     return out;
 }
 
@@ -117,14 +328,9 @@ void vec_byte_merge(VecByte* vec1, VecByte* vec2) {
     assert_notnull(vec1);
     assert_notnull(vec2);
     if ((vec1->_cap - vec1->_size) <
-        vec2->_size) { // vec1 doesn't have enough cap
-        int cap = vec1->_size + vec2->_size;
-        byte* p = realloc(vec1->_values, cap * sizeof(byte));
-        assert_alloc(p);
-        vec1->_values = p;
-        vec1->_cap = cap;
-    }
-    for (int i = 0; i < vec2->_size; ++i)
+        vec2->_size) // vec1 doesn't have enough cap
+        vec_byte_set_cap(vec1, vec1->_size + vec2->_size);
+    for (ptrdiff_t i = 0; i < vec2->_size; ++i)
         vec1->_values[vec1->_size++] = vec2->_values[i]; // push
     vec_byte_free(vec2);
 }
@@ -140,50 +346,134 @@ bool vec_byte_equal(const VecByte* vec1, const VecByte* vec2) {
                   sizeof(byte) * vec1->_size) == 0;
 }
 
-int vec_byte_find(const VecByte* vec, byte value) {
+ptrdiff_t vec_byte_find(const VecByte* vec, byte value) {
+    assert_notnull(vec);
+    if (!vec->_size)
+        return VEC_NOT_FOUND;
+    const byte* p = memchr(vec->_values, value, vec->_size);
+    return p ? p - vec->_values : VEC_NOT_FOUND;
+}
+
+ptrdiff_t vec_byte_find_last(const VecByte* vec, byte value) {
+    assert_notnull(vec);
+    if (!vec->_size)
+        return VEC_NOT_FOUND;
+    const byte* p = memrchr(vec->_values, value, vec->_size);
+    return p ? p - vec->_values : VEC_NOT_FOUND;
+}
+
+char* vec_byte_to_hex(const VecByte* vec, char sep) {
+    assert_notnull(vec);
+    char* s = malloc(hex_encoded_size(vec->_size, sep) + 1);
+    assert_alloc(s);
+    s[hex_encode(s, vec->_values, vec->_size, sep)] = 0;
+    return s;
+}
+
+bool vec_byte_append_hex(VecByte* vec, const char* text, ptrdiff_t n,
+                         char sep) {
+    assert_notnull(vec);
+    ptrdiff_t size = hex_decoded_size(n, sep);
+    if (size < 0)
+        return false;
+    size = hex_decode(vec_byte_spare(vec, size), text, n, sep);
+    if (size < 0)
+        return false;
+    vec->_size += size;
+    return true;
+}
+
+char* vec_byte_to_base64(const VecByte* vec) {
+    assert_notnull(vec);
+    char* s = malloc(base64_encoded_size(vec->_size) + 1);
+    assert_alloc(s);
+    s[base64_encode(s, vec->_values, vec->_size)] = 0;
+    return s;
+}
+
+bool vec_byte_append_base64(VecByte* vec, const char* text, ptrdiff_t n) {
+    assert_notnull(vec);
+    ptrdiff_t size = base64_decoded_size(n);
+    if (size < 0)
+        return false;
+    size = base64_decode(vec_byte_spare(vec, size), text, n);
+    if (size < 0)
+        return false;
+    vec->_size += size;
+    return true;
+}
+
+uint32_t vec_byte_crc32c(const VecByte* vec) {
     assert_notnull(vec);
-    for (int i = 0; i < vec->_size; ++i)
-        if (vec->_values[i] == value)
-            return i;
-    return VEC_NOT_FOUND;
+    return crc32c(vec->_values, vec->_size);
 }
 
-int vec_byte_find_last(const VecByte* vec, byte value) {
+uint64_t vec_byte_xxh64(const VecByte* vec, uint64_t seed) {
     assert_notnull(vec);
-    for (int i = vec->_size - 1; i >= 0; --i)
-        if (vec->_values[i] == value)
-            return i;
-    return VEC_NOT_FOUND;
+    return xxh64(vec->_values, vec->_size, seed);
+}
+
+void vec_byte_sha256(const VecByte* vec, byte* digest) {
+    assert_notnull(vec);
+    sha256(vec->_values, vec->_size, digest);
+}
+
+void vec_byte_compress(VecByte* out, const VecByte* vec) {
+    assert_notnull(out);
+    assert_notnull(vec);
+    assert(out != vec && "can't compress a VecByte into itself");
+    lz_frame_compress(out, vec->_values, vec->_size);
+}
+
+bool vec_byte_decompress(VecByte* out, const VecByte* vec) {
+    assert_notnull(out);
+    assert_notnull(vec);
+    assert(out != vec && "can't decompress a VecByte into itself");
+    return lz_frame_decompress(out, vec->_values, vec->_size);
 }
 
 char* vec_byte_to_str(const VecByte* vec) {
     if (!vec->_size)
         return NULL;
-    int size = (vec->_size * 3) + 1; // 2 hex digits + space per byte
-    char* s = malloc(size);
-    assert_alloc(s);
-    s[0] = 0;
-    char* p = s;
-    for (int i = 0; i < vec->_size; ++i) {
-        int n = sprintf(p, "%02X ", vec->_values[i]);
-        p += n;
-    }
-    *--p = 0;
-    return s;
+    return vec_byte_to_hex(vec, ' ');
 }
 
 void vec_byte_dump(const VecByte* vec) {
     if (vec->_size)
-        for (int i = 0; i < vec->_size; ++i)
-            printf("[%d]=%02X\n", i, vec->_values[i]);
+        for (ptrdiff_t i = 0; i < vec->_size; ++i)
+            printf("[%td]=%02X\n", i, vec->_values[i]);
     else
         printf("(empty)");
 }
 
-static void vec_byte_grow(VecByte* vec) {
-    int cap = vec->_cap;
-    assert((!cap && !vec->_values) || (cap && vec->_values));
-    vec->_cap = VEC_GROW_CAP(cap);
-    vec->_values = realloc(vec->_values, vec->_cap * sizeof(byte));
-    assert_alloc(vec->_values);
+static void vec_byte_grow(VecByte* vec, ptrdiff_t needed) {
+    assert((!vec->_cap && !vec->_values) || (vec->_cap && vec->_values));
+    vec_byte_set_cap(vec, vec_grow_cap(&vec->_growth, vec->_cap, needed));
+}
+
+static void vec_byte_set_cap(VecByte* vec, ptrdiff_t cap) {
+    assert(cap >= vec->_size && "can't reduce cap below size");
+    vec->_values = vec_buffer_resize(vec->_values, vec->_size, vec->_cap,
+                                     cap, vec->_growth.large, &vec->_large);
+    vec->_cap = cap;
+}
+
+static void vec_byte_open_gap(VecByte* vec, ptrdiff_t index,
+                              ptrdiff_t n) {
+    if (!n)
+        return;
+    if (vec->_size + n > vec->_cap)
+        vec_byte_grow(vec, vec->_size + n);
+    memmove(vec->_values + index + n, vec->_values + index,
+            vec->_size - index);
+    vec->_size += n;
+}
+
+static void vec_byte_close_gap(VecByte* vec, ptrdiff_t index,
+                               ptrdiff_t n) {
+    if (!n)
+        return;
+    memmove(vec->_values + index, vec->_values + index + n,
+            vec->_size - index - n);
+    vec->_size -= n;
 }
@@ -15,17 +15,19 @@ typedef uint8_t byte;
 //
 // To iterate:
 // ```
-// for (int i = 0; i < VEC_SIZE(vec); ++i)
+// for (ptrdiff_t i = 0; i < VEC_SIZE(vec); ++i)
 //     byte value = VEC_GET(vec, i);
 // ```
 typedef struct VecByte {
-    int _size; // This is "end", i.e., one past the last value
-    int _cap;  // The size of the allocated array
+    ptrdiff_t _size; // This is "end", i.e., one past the last value
+    ptrdiff_t _cap;  // The size of the allocated array
     byte* _values;
+    VecGrowth _growth; // See VEC_SET_GROWTH()
+    bool _large;       // _values is in large mode (see VecGrowth)
 } VecByte;
 
 // Allocates a new empty VecByte with the given capacity.
-VecByte vec_byte_alloc_cap(int cap);
+VecByte vec_byte_alloc_cap(ptrdiff_t cap);
 
 // Allocates a new empty VecByte with a default capacity of 0.
 #define vec_byte_alloc() vec_byte_alloc_cap(0)
@@ -37,9 +39,20 @@ void vec_byte_free(VecByte* vec);
 // Clears all the VecByte's values.
 void vec_byte_clear(VecByte* vec);
 
+// Ensures the VecByte's capacity is at least cap, e.g., before pushing a
+// known number of values.
+void vec_byte_reserve(VecByte* vec, ptrdiff_t cap);
+
+// Reduces the VecByte's capacity to its size, freeing any unused memory.
+void vec_byte_shrink_to_fit(VecByte* vec);
+
+// Resizes the VecByte to the given size, either truncating it or padding
+// it with copies of value.
+void vec_byte_resize(VecByte* vec, ptrdiff_t size, byte value);
+
 // Returns the VecByte's byte value at position index.
 // The VEC_GET() macro is faster but unchecked.
-byte vec_byte_get(const VecByte* vec, int index);
+byte vec_byte_get(const VecByte* vec, ptrdiff_t index);
 
 // Returns the VecByte's int value at its first valid index.
 // The VEC_GET_FIRST() macro is faster but unchecked.
@@ -50,22 +63,101 @@ byte vec_byte_get_first(const VecByte* vec);
 byte vec_byte_get_last(const VecByte* vec);
 
 // Sets the VecByte's value at position index to the given byte.
-void vec_byte_set(VecByte* vec, int index, byte value);
+void vec_byte_set(VecByte* vec, ptrdiff_t index, byte value);
 
 // Inserts the byte at position index and moves succeeding values
 // up (right), increasing the VecByte's size (and cap if necessary): O(n).
-void vec_byte_insert(VecByte* vec, int index, byte value);
+void vec_byte_insert(VecByte* vec, ptrdiff_t index, byte value);
+
+// Inserts n copies of value at position index (which may be VEC_SIZE(vec)
+// to append) and moves succeeding values up (right) in a single move,
+// increasing the VecByte's size (and cap if necessary): O(n).
+void vec_byte_insert_n(VecByte* vec, ptrdiff_t index, ptrdiff_t n,
+                       byte value);
+
+// Inserts the n values from the values array at position index (which
+// may be VEC_SIZE(vec) to append) and moves succeeding values up (right)
+// in a single move: O(n). The values must not be in the VecByte itself.
+void vec_byte_insert_range(VecByte* vec, ptrdiff_t index,
+                           const byte* values, ptrdiff_t n);
+
+// Inserts all vec2's values into vec1 at position index (which may be
+// VEC_SIZE(vec1) to append): O(n). vec2 is unchanged.
+void vec_byte_insert_vec(VecByte* vec1, ptrdiff_t index,
+                         const VecByte* vec2);
+
+// Appends the n values from the values array, increasing the VecByte's
+// size (and cap if necessary): O(n). The values must not be in the
+// VecByte itself.
+void vec_byte_append_array(VecByte* vec, const byte* values, ptrdiff_t n);
+
+// Appends the n bytes at data (e.g., a char* or a struct), with one
+// capacity check and one memcpy(): O(n). Unlike vec_byte_append_array(),
+// data may point into the VecByte itself.
+void vec_byte_append(VecByte* vec, const void* data, ptrdiff_t n);
+
+// Ensures the VecByte has room for at least n more bytes and returns a
+// pointer to its first unused byte, so that up to n bytes can be written
+// there directly (e.g., by read() or a decoder) and then added with
+// vec_byte_commit(). The pointer is only valid until the VecByte is next
+// changed.
+byte* vec_byte_spare(VecByte* vec, ptrdiff_t n);
+
+// Adds the n bytes just written to the VecByte's spare capacity (see
+// vec_byte_spare()) to the end of the VecByte: O(1).
+void vec_byte_commit(VecByte* vec, ptrdiff_t n);
+
+// Reads up to n bytes from the file descriptor fd directly into the
+// VecByte's spare capacity (growing it if necessary) with one read()
+// (retried if interrupted), and appends them. Returns the number of bytes
+// read, 0 at end of file, or -1 on error (with errno set).
+ptrdiff_t vec_byte_read_fd(VecByte* vec, int fd, ptrdiff_t n);
+
+// Reads from the file descriptor fd until end of file, appending the
+// bytes, and reading into all the spare capacity each time so that as
+// the VecByte grows there are fewer reads. Returns the number of bytes
+// read, or -1 on error (with errno set and the bytes read before the
+// error kept).
+ptrdiff_t vec_byte_read_fd_all(VecByte* vec, int fd);
+
+// Writes all the VecByte's bytes to the file descriptor fd, continuing
+// after partial writes and interrupts. Returns the number of bytes
+// written or -1 on error (with errno set).
+ptrdiff_t vec_byte_write_fd(const VecByte* vec, int fd);
+
+// Writes all the bytes of the count VecBytes, in order, to the file
+// descriptor fd, gathering them with writev() so that there are no
+// copies and as few system calls as possible, continuing after partial
+// writes and interrupts. Returns the number of bytes written or -1 on
+// error (with errno set).
+ptrdiff_t vec_byte_writev_fd(const VecByte* const* vecs, int count,
+                             int fd);
 
 // Sets the VecByte's value at position index to the given byte
 // and returns the old byte value from that position.
-byte vec_byte_replace(VecByte* vec, int index, byte value);
+byte vec_byte_replace(VecByte* vec, ptrdiff_t index, byte value);
 
 // Removes the value at the given index and closes up the gap: O(n).
-void vec_byte_remove(VecByte* vec, int index);
+void vec_byte_remove(VecByte* vec, ptrdiff_t index);
+
+// Removes the n values from position index onwards and closes up the gap
+// in a single move: O(n).
+void vec_byte_remove_range(VecByte* vec, ptrdiff_t index, ptrdiff_t n);
+
+// Removes the value at the given index by moving the last value into its
+// place, so the order is not preserved: O(1).
+void vec_byte_swap_remove(VecByte* vec, ptrdiff_t index);
+
+// Keeps only the values for which pred(value, state) returns true,
+// preserving their order, and returns how many values were removed.
+// Uses a single pass: O(n).
+ptrdiff_t vec_byte_retain(VecByte* vec,
+                          bool (*pred)(byte value, void* state),
+                          void* state);
 
 // Returns and removes the value at the given index and closes up the
 // gap: O(n).
-byte vec_byte_take(VecByte* vec, int index);
+byte vec_byte_take(VecByte* vec, ptrdiff_t index);
 
 // Removes and returns the last int value. Only use if
 // vec.isempty() is false: O(1).
@@ -89,12 +181,54 @@ void vec_byte_merge(VecByte* vec1, VecByte* vec2);
 bool vec_byte_equal(const VecByte* vec1, const VecByte* vec2);
 
 // Returns the index where the value was found in the vec or
-// VEC_NOT_FOUND (-1). Uses a linear search.
-int vec_byte_find(const VecByte* vec, byte value);
+// VEC_NOT_FOUND (-1). Uses a linear search (memchr(), which libc
+// vectorizes).
+ptrdiff_t vec_byte_find(const VecByte* vec, byte value);
 
 // Returns the last index where the value was found in the vec or
-// VEC_NOT_FOUND (-1). Uses a linear search.
-int vec_byte_find_last(const VecByte* vec, byte value);
+// VEC_NOT_FOUND (-1). Uses a reverse linear search (memrchr()).
+ptrdiff_t vec_byte_find_last(const VecByte* vec, byte value);
+
+// Returns a string of the vec's bytes as uppercase hex digits (see
+// hex_encode() in codec.h), with sep between each byte's pair of digits
+// if sep isn't 0. The caller owns the returned string.
+char* vec_byte_to_hex(const VecByte* vec, char sep);
+
+// Appends the bytes that the n chars of hex text (with sep between each
+// pair of digits if sep isn't 0) decode to, decoding directly into the
+// vec's spare capacity, and returns true; or returns false and leaves
+// the vec unchanged if the text isn't valid hex.
+bool vec_byte_append_hex(VecByte* vec, const char* text, ptrdiff_t n,
+                         char sep);
+
+// Returns a string of the vec's bytes as standard base64 (see
+// base64_encode() in codec.h). The caller owns the returned string.
+char* vec_byte_to_base64(const VecByte* vec);
+
+// Appends the bytes that the n chars of base64 text decode to, decoding
+// directly into the vec's spare capacity, and returns true; or returns
+// false and leaves the vec unchanged if the text isn't valid base64.
+bool vec_byte_append_base64(VecByte* vec, const char* text, ptrdiff_t n);
+
+// Returns the CRC32C of the vec's bytes (see checksum.h).
+uint32_t vec_byte_crc32c(const VecByte* vec);
+
+// Returns the XXH64 hash of the vec's bytes using the given seed (see
+// checksum.h).
+uint64_t vec_byte_xxh64(const VecByte* vec, uint64_t seed);
+
+// Sets digest (of 32 bytes) to the SHA-256 of the vec's bytes (see
+// checksum.h).
+void vec_byte_sha256(const VecByte* vec, byte* digest);
+
+// Appends the vec's bytes to out (which must be a different VecByte)
+// compressed as an lz frame (see lz.h).
+void vec_byte_compress(VecByte* out, const VecByte* vec);
+
+// Appends the bytes that the vec's lz frame (see lz.h) decompresses to,
+// to out (which must be a different VecByte), and returns true; or
+// returns false and leaves out unchanged if the frame is corrupt.
+bool vec_byte_decompress(VecByte* out, const VecByte* vec);
 
 // Returns a string representing the vec's byte values as
 // space-separated hex numbers or NULL if the vec is empty.
@@ -6,17 +6,30 @@
 #include "str.h"
 #include "vec_byte.h"
 #include "vecs_test.h"
+#include <errno.h>
+#include <limits.h>
 #include <stdlib.h>
+#include <unistd.h>
 
-static void check_size_cap(tinfo* tinfo, VecByte* v, int size, int cap);
+static void check_size_cap(tinfo* tinfo, VecByte* v, ptrdiff_t size,
+                           ptrdiff_t cap);
 static void match(tinfo* tinfo, VecByte* v, char* expected);
 static void equal(tinfo* tinfo, VecByte* v1, VecByte* v2);
 static void merge_tests(tinfo* tinfo);
+static void sparse_tests(tinfo* tinfo);
+static void range_tests(tinfo* tinfo);
+static void buffer_tests(tinfo* tinfo);
+static void fd_tests(tinfo* tinfo);
+static bool is_odd(byte value, void* state);
 
 void vec_byte_tests(tinfo* tinfo) {
     if (tinfo->verbose)
         puts(tinfo->tag);
     merge_tests(tinfo);
+    sparse_tests(tinfo);
+    range_tests(tinfo);
+    buffer_tests(tinfo);
+    fd_tests(tinfo);
 
     VecByte v1 = vec_byte_alloc(); // default of 0
     check_size_cap(tinfo, &v1, 0, 0);
@@ -59,6 +72,17 @@ void vec_byte_tests(tinfo* tinfo) {
     vec_byte_insert(&v1, 0, 0x21);
     match(tinfo, &v1, "21 01 02 03 04 37 05 06 07 08 09 63");
 
+    VecByte v4 = vec_byte_copy(&v1);
+    vec_byte_resize(&v4, 14, 0xEE);
+    match(tinfo, &v4, "21 01 02 03 04 37 05 06 07 08 09 63 EE EE");
+    vec_byte_resize(&v4, 3, 0);
+    vec_byte_shrink_to_fit(&v4);
+    check_size_cap(tinfo, &v4, 3, 3);
+    match(tinfo, &v4, "21 01 02");
+    vec_byte_reserve(&v4, 1000);
+    check_size_cap(tinfo, &v4, 3, 1000);
+    vec_byte_free(&v4);
+
     vec_byte_insert(&v1, 0, 0x17);
     match(tinfo, &v1, "17 21 01 02 03 04 37 05 06 07 08 09 63");
 
@@ -169,23 +193,186 @@ static void merge_tests(tinfo* tinfo) {
     vec_byte_free(&v1);
 }
 
+static void range_tests(tinfo* tinfo) {
+    if (tinfo->verbose)
+        puts(tinfo->tag);
+    VecByte v1 = vec_byte_alloc();
+    const byte A[] = {0x01, 0x02, 0x03};
+    vec_byte_append_array(&v1, A, 3);
+    match(tinfo, &v1, "01 02 03");
+    vec_byte_insert_n(&v1, 1, 4, 0xFF);
+    match(tinfo, &v1, "01 FF FF FF FF 02 03");
+    vec_byte_insert_range(&v1, VEC_SIZE(&v1), A, 2);
+    vec_byte_insert_range(&v1, 0, A + 2, 1);
+    match(tinfo, &v1, "03 01 FF FF FF FF 02 03 01 02");
+    vec_byte_remove_range(&v1, 2, 4);
+    match(tinfo, &v1, "03 01 02 03 01 02");
+    check_size_cap(tinfo, &v1, 6, VEC_INITIAL_CAP);
+
+    VecByte v2 = vec_byte_alloc_cap(2);
+    vec_byte_push(&v2, 0xAA);
+    vec_byte_push(&v2, 0xBB);
+    vec_byte_insert_vec(&v2, 1, &v1);
+    match(tinfo, &v2, "AA 03 01 02 03 01 02 BB");
+    vec_byte_remove_range(&v2, 1, VEC_SIZE(&v2) - 1);
+    match(tinfo, &v2, "AA");
+    vec_byte_remove(&v1, 0);
+    vec_byte_insert(&v1, 2, 0x10);
+    match(tinfo, &v1, "01 02 10 03 01 02");
+    check_int_eq(tinfo, vec_byte_retain(&v1, is_odd, NULL), 3);
+    match(tinfo, &v1, "01 03 01");
+    vec_byte_swap_remove(&v1, 0);
+    match(tinfo, &v1, "01 03");
+    vec_byte_free(&v1);
+    vec_byte_free(&v2);
+}
+
+static bool is_odd(byte value, void* state) {
+    (void)state; // unused
+    return value & 1;
+}
+
+static void buffer_tests(tinfo* tinfo) {
+    if (tinfo->verbose)
+        puts(tinfo->tag);
+    VecByte v1 = vec_byte_alloc();
+    vec_byte_append(&v1, NULL, 0); // no-op
+    check_size_cap(tinfo, &v1, 0, 0);
+    vec_byte_append(&v1, "\x01\x02\x03", 3);
+    match(tinfo, &v1, "01 02 03");
+    vec_byte_append(&v1, v1._values, 3); // from itself: must grow
+    match(tinfo, &v1, "01 02 03 01 02 03");
+    vec_byte_append(&v1, v1._values + 1, 2); // from itself: no growth
+    match(tinfo, &v1, "01 02 03 01 02 03 02 03");
+
+    byte* p = vec_byte_spare(&v1, 100);
+    check_bool_eq(tinfo, VEC_CAP(&v1) >= 108, true);
+    check_int_eq(tinfo, VEC_SIZE(&v1), 8);
+    p[0] = 0xAA;
+    p[1] = 0xBB;
+    vec_byte_commit(&v1, 2);
+    match(tinfo, &v1, "01 02 03 01 02 03 02 03 AA BB");
+    ptrdiff_t cap = VEC_CAP(&v1);
+    vec_byte_spare(&v1, 1); // already room
+    check_int_eq(tinfo, VEC_CAP(&v1), cap);
+    vec_byte_commit(&v1, 0);
+    check_int_eq(tinfo, VEC_SIZE(&v1), 10);
+    vec_byte_free(&v1);
+}
+
+// Writes several vecs (including an empty one) to a temporary file and
+// reads them back in small and then unlimited reads.
+static void fd_tests(tinfo* tinfo) {
+    if (tinfo->verbose)
+        puts(tinfo->tag);
+    FILE* file = tmpfile();
+    if (!file) {
+        WARN("FAIL: %s tmpfile() failed\n", tinfo->tag);
+        return;
+    }
+    int fd = fileno(file);
+    const int N = 200000;
+    VecByte v1 = vec_byte_alloc();
+    VecByte v2 = vec_byte_alloc();
+    VecByte v3 = vec_byte_alloc();
+    for (int i = 0; i < N; ++i)
+        vec_byte_push(&v1, (byte)(i % 253));
+    vec_byte_append(&v3, "tail", 4);
+    const VecByte* vecs[] = {&v1, &v2, &v3, &v1};
+    check_int_eq(tinfo, vec_byte_writev_fd(vecs, 4, fd), 2 * N + 4);
+    check_int_eq(tinfo, vec_byte_write_fd(&v3, fd), 4);
+    check_int_eq(tinfo, vec_byte_write_fd(&v2, fd), 0);
+    lseek(fd, 0, SEEK_SET);
+
+    VecByte v4 = vec_byte_alloc();
+    check_int_eq(tinfo, vec_byte_read_fd(&v4, fd, 10), 10);
+    check_int_eq(tinfo, VEC_SIZE(&v4), 10);
+    check_int_eq(tinfo, vec_byte_read_fd(&v4, fd, 0), 0);
+    check_int_eq(tinfo, vec_byte_read_fd_all(&v4, fd), 2 * N + 8 - 10);
+    check_int_eq(tinfo, vec_byte_read_fd(&v4, fd, 10), 0); // EOF
+    VecByte expected = vec_byte_copy(&v1);
+    vec_byte_append(&expected, "tail", 4);
+    vec_byte_append(&expected, v1._values, N);
+    vec_byte_append(&expected, "tail", 4);
+    equal(tinfo, &v4, &expected);
+    fclose(file);
+
+    check_int_eq(tinfo, vec_byte_read_fd(&v4, fd, 10), -1); // closed
+    check_int_eq(tinfo, errno, EBADF);
+    check_int_eq(tinfo, vec_byte_write_fd(&v3, fd), -1);
+    check_int_eq(tinfo, VEC_SIZE(&v4), 2 * N + 8);
+    vec_byte_free(&expected);
+    vec_byte_free(&v4);
+    vec_byte_free(&v3);
+    vec_byte_free(&v2);
+    vec_byte_free(&v1);
+}
+
+static void sparse_tests(tinfo* tinfo) {
+    if (tinfo->verbose)
+        puts(tinfo->tag);
+    // The memory is allocated but (apart from one page) never touched, so
+    // this only costs address space.
+    const ptrdiff_t BIG = (ptrdiff_t)INT_MAX + 64;
+    VecByte v1 = vec_byte_alloc_cap(BIG);
+    check_size_cap(tinfo, &v1, 0, BIG);
+    vec_byte_push(&v1, 0x7F);
+    vec_byte_push(&v1, 0x80);
+    check_size_cap(tinfo, &v1, 2, BIG);
+    check_int_eq(tinfo, vec_byte_get_last(&v1), 0x80);
+    vec_byte_shrink_to_fit(&v1);
+    check_size_cap(tinfo, &v1, 2, 2);
+    vec_byte_free(&v1);
+
+    VecGrowth growth = VEC_GROWTH_DEFAULT;
+    check_bool_eq(tinfo, vec_grow_cap(&growth, BIG, BIG + 1) == BIG * 2,
+                  true);
+    growth.max_step = 1048576;
+    check_bool_eq(tinfo,
+                  vec_grow_cap(&growth, BIG, BIG + 1) == BIG + 1048576,
+                  true);
+    check_bool_eq(tinfo,
+                  vec_grow_cap(&growth, PTRDIFF_MAX - 1, PTRDIFF_MAX) ==
+                      PTRDIFF_MAX,
+                  true);
+}
+
+void vec_byte_large_tests(tinfo* tinfo) {
+    if (tinfo->verbose)
+        puts(tinfo->tag);
+    const ptrdiff_t BIG = (ptrdiff_t)INT_MAX + 64;
+    VecByte v1 = vec_byte_alloc();
+    vec_byte_resize(&v1, BIG, 0);
+    check_size_cap(tinfo, &v1, BIG, BIG);
+    vec_byte_set(&v1, BIG - 3, 0xAB);
+    check_int_eq(tinfo, vec_byte_get(&v1, BIG - 3), 0xAB);
+    check_bool_eq(tinfo, vec_byte_find_last(&v1, 0xAB) == BIG - 3, true);
+    vec_byte_push(&v1, 0xCD);
+    check_bool_eq(tinfo, VEC_SIZE(&v1) == BIG + 1, true);
+    check_int_eq(tinfo, vec_byte_get_last(&v1), 0xCD);
+    check_int_eq(tinfo, vec_byte_take(&v1, BIG - 3), 0xAB);
+    check_int_eq(tinfo, vec_byte_get(&v1, BIG - 1), 0xCD);
+    vec_byte_free(&v1);
+}
+
 static void match(tinfo* tinfo, VecByte* v, char* expected) {
     char* out = vec_byte_to_str(v);
     check_str_eq(tinfo, out, expected);
     free(out);
 }
 
-static void check_size_cap(tinfo* tinfo, VecByte* v, int size, int cap) {
+static void check_size_cap(tinfo* tinfo, VecByte* v, ptrdiff_t size,
+                           ptrdiff_t cap) {
     tinfo->total++;
     if (VEC_SIZE(v) != size)
-        WARN("FAIL: %s VEC_SIZE() expected %d != %d\n", tinfo->tag, size,
+        WARN("FAIL: %s VEC_SIZE() expected %td != %td\n", tinfo->tag, size,
              VEC_SIZE(v));
     else
         tinfo->ok++;
 
     tinfo->total++;
     if (VEC_ISEMPTY(v) != (size == 0))
-        WARN("FAIL: %s VEC_ISEMPTY() expected %s != %s size=%d\n",
+        WARN("FAIL: %s VEC_ISEMPTY() expected %s != %s size=%td\n",
              tinfo->tag, bool_to_str(size == 0),
              bool_to_str(VEC_ISEMPTY(v)), size);
     else
@@ -193,7 +380,7 @@ static void check_size_cap(tinfo* tinfo, VecByte* v, int size, int cap) {
 
     tinfo->total++;
     if (VEC_CAP(v) != cap)
-        WARN("FAIL: %s VEC_CAP() expected %d != %d\n", tinfo->tag, cap,
+        WARN("FAIL: %s VEC_CAP() expected %td != %td\n", tinfo->tag, cap,
              VEC_CAP(v));
     else
         tinfo->ok++;
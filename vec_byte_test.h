@@ -5,3 +5,6 @@
 #include "cx_util_test.h"
 
 void vec_byte_tests(tinfo* tinfo);
+
+// Only run if asked for since it needs over 2GB of RAM.
+void vec_byte_large_tests(tinfo* tinfo);
@@ -0,0 +1,316 @@
+// Copyright © 2024-25 Mark Summerfield. All rights reserved.
+// License: GPL-3
+#pragma once
+
+#include "cx.h"
+#include "sort.h"
+#include "vecs.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Defines a vector type Name of values of type T (any type that can be
+// copied with = or memcpy(), e.g., a number or a struct of numbers)
+// stored contiguously, with static inline functions whose names begin
+// with name, so there's no boxing and every comparison is inlined. The
+// vecs.h macros (VEC_SIZE(), VEC_GET(), VEC_SET_GROWTH(), etc.) work on
+// it as on the other vecs. See vec_num.h for VecU32, VecI64, and VecF32.
+//
+// LESS(ctx, x, y) must be true if x sorts before y (as for SORT_DEFINE()
+// in sort.h; ctx is always NULL), and EQUAL(ctx, x, y) must be true if x
+// equals y (used by name_equal(), name_find(), name_find_last(), and
+// name_search(); for values like NaNs it may be false even when neither
+// is less than the other). The functions (taking a Name* v unless noted)
+// are:
+//
+//  Name name_alloc(void), name_alloc_cap(ptrdiff_t cap)
+//  void name_free(v), name_clear(v), name_reserve(v, cap),
+//      name_shrink_to_fit(v), name_resize(v, size, value)
+//  T name_get(v, index), name_get_first(v), name_get_last(v), name_pop(v)
+//  void name_set(v, index, value), name_push(v, value),
+//      name_insert(v, index, value),
+//      name_insert_range(v, index, values, n),
+//      name_append_array(v, values, n), name_remove(v, index),
+//      name_remove_range(v, index, n), name_swap_remove(v, index)
+//  ptrdiff_t name_retain(v, pred, state)
+//  Name name_copy(v); void name_merge(v1, v2); bool name_equal(v1, v2)
+//  ptrdiff_t name_find(v, value), name_find_last(v, value)
+//  void name_sort(v), name_sort_stable(v)
+//  ptrdiff_t name_search(v, value), name_lower_bound(v, value)
+//  void name_add(v, value)
+//
+// These behave like the VecInt functions of the same names (see
+// vec_int.h) except that name_insert() may append, copies and merges
+// are single memcpy()s, and name_lower_bound() (for sorted vecs) returns
+// the index of the first value not less than value (which may be
+// VEC_SIZE(v)).
+//
+// Example:
+// ```
+//  typedef struct {
+//      int x;
+//      int y;
+//  } Point;
+//  #define POINT_LESS(ctx, p, q) ((p).x < (q).x)
+//  #define POINT_EQUAL(ctx, p, q) ((p).x == (q).x)
+//  VEC_DEFINE(VecPoint, vec_point, Point, POINT_LESS, POINT_EQUAL)
+//  ...
+//  VecPoint points = vec_point_alloc();
+//  vec_point_push(&points, (Point){3, 4});
+// ```
+#define VEC_DEFINE(Name, name, T, LESS, EQUAL)                             \
+    typedef struct Name {                                                  \
+        ptrdiff_t _size; /* "end", i.e., one past the last value */        \
+        ptrdiff_t _cap;  /* The size of the allocated array */             \
+        T* _values;                                                        \
+        VecGrowth _growth; /* See VEC_SET_GROWTH() */                      \
+        bool _large;       /* _values is in large mode */                  \
+    } Name;                                                                \
+                                                                           \
+    SORT_DEFINE(name##_array, T, void*, LESS)                              \
+                                                                           \
+    static inline void name##_set_cap(Name* v, ptrdiff_t cap) {            \
+        assert(cap >= v->_size && "can't reduce cap below size");          \
+        v->_values = (T*)vec_buffer_resize(                                \
+            v->_values, v->_size * sizeof(T), v->_cap * sizeof(T),         \
+            cap * sizeof(T), v->_growth.large, &v->_large);                \
+        v->_cap = cap;                                                     \
+    }                                                                      \
+                                                                           \
+    static inline void name##_grow(Name* v, ptrdiff_t needed) {            \
+        name##_set_cap(v, vec_grow_cap(&v->_growth, v->_cap, needed));     \
+    }                                                                      \
+                                                                           \
+    /* Makes room for n values at index, growing if necessary. */          \
+    static inline void name##_open_gap(Name* v, ptrdiff_t index,           \
+                                       ptrdiff_t n) {                      \
+        if (v->_size + n > v->_cap)                                        \
+            name##_grow(v, v->_size + n);                                  \
+        memmove(v->_values + index + n, v->_values + index,                \
+                (v->_size - index) * sizeof(T));                           \
+        v->_size += n;                                                     \
+    }                                                                      \
+                                                                           \
+    static inline Name name##_alloc_cap(ptrdiff_t cap) {                   \
+        cap = cap > 0 ? cap : 0;                                           \
+        T* values = NULL;                                                  \
+        if (cap) {                                                         \
+            values = malloc(cap * sizeof(T));                              \
+            assert_alloc(values);                                          \
+        }                                                                  \
+        return (Name){._size = 0,                                          \
+                      ._cap = cap,                                         \
+                      ._values = values,                                   \
+                      ._growth = VEC_GROWTH_DEFAULT};                      \
+    }                                                                      \
+                                                                           \
+    static inline Name name##_alloc(void) { return name##_alloc_cap(0); }  \
+                                                                           \
+    static inline void name##_free(Name* v) {                              \
+        assert_notnull(v);                                                 \
+        vec_buffer_free(v->_values, v->_cap * sizeof(T), v->_large);       \
+        v->_values = NULL;                                                 \
+        v->_size = 0;                                                      \
+        v->_cap = 0;                                                       \
+        v->_large = false;                                                 \
+    }                                                                      \
+                                                                           \
+    static inline void name##_clear(Name* v) { v->_size = 0; }             \
+                                                                           \
+    static inline void name##_reserve(Name* v, ptrdiff_t cap) {            \
+        assert_notnull(v);                                                 \
+        if (cap > v->_cap)                                                 \
+            name##_set_cap(v, cap);                                        \
+    }                                                                      \
+                                                                           \
+    static inline void name##_shrink_to_fit(Name* v) {                     \
+        assert_notnull(v);                                                 \
+        if (v->_cap > v->_size)                                            \
+            name##_set_cap(v, v->_size);                                   \
+    }                                                                      \
+                                                                           \
+    static inline void name##_resize(Name* v, ptrdiff_t size, T value) {   \
+        assert_notnull(v);                                                 \
+        assert(size >= 0 && "can't resize to a negative size");            \
+        if (size > v->_cap)                                                \
+            name##_grow(v, size);                                          \
+        for (ptrdiff_t i = v->_size; i < size; ++i)                        \
+            v->_values[i] = value;                                         \
+        v->_size = size;                                                   \
+    }                                                                      \
+                                                                           \
+    static inline T name##_get(const Name* v, ptrdiff_t index) {           \
+        assert_notnull(v);                                                 \
+        assert_valid_index(v, index);                                      \
+        return v->_values[index];                                          \
+    }                                                                      \
+                                                                           \
+    static inline T name##_get_first(const Name* v) {                      \
+        assert_notnull(v);                                                 \
+        assert_nonempty(v);                                                \
+        return v->_values[0];                                              \
+    }                                                                      \
+                                                                           \
+    static inline T name##_get_last(const Name* v) {                       \
+        assert_notnull(v);                                                 \
+        assert_nonempty(v);                                                \
+        return v->_values[v->_size - 1];                                   \
+    }                                                                      \
+                                                                           \
+    static inline void name##_set(Name* v, ptrdiff_t index, T value) {     \
+        assert_notnull(v);                                                 \
+        assert_valid_index(v, index);                                      \
+        v->_values[index] = value;                                         \
+    }                                                                      \
+                                                                           \
+    static inline void name##_push(Name* v, T value) {                     \
+        assert_notnull(v);                                                 \
+        if (v->_size == v->_cap)                                           \
+            name##_grow(v, v->_size + 1);                                  \
+        v->_values[v->_size++] = value;                                    \
+    }                                                                      \
+                                                                           \
+    static inline T name##_pop(Name* v) {                                  \
+        assert_notnull(v);                                                 \
+        assert_nonempty(v);                                                \
+        return v->_values[--v->_size];                                     \
+    }                                                                      \
+                                                                           \
+    static inline void name##_insert(Name* v, ptrdiff_t index, T value) {  \
+        assert_notnull(v);                                                 \
+        assert_valid_range(v, index, 0);                                   \
+        name##_open_gap(v, index, 1);                                      \
+        v->_values[index] = value;                                         \
+    }                                                                      \
+                                                                           \
+    static inline void name##_insert_range(Name* v, ptrdiff_t index,       \
+                                           const T* values, ptrdiff_t n) { \
+        assert_notnull(v);                                                 \
+        assert_valid_range(v, index, 0);                                   \
+        assert(n >= 0 && "can't insert a negative number of values");      \
+        if (n) {                                                           \
+            assert_notnull(values);                                        \
+            name##_open_gap(v, index, n);                                  \
+            memcpy(v->_values + index, values, n * sizeof(T));             \
+        }                                                                  \
+    }                                                                      \
+                                                                           \
+    static inline void name##_append_array(Name* v, const T* values,       \
+                                           ptrdiff_t n) {                  \
+        name##_insert_range(v, v->_size, values, n);                       \
+    }                                                                      \
+                                                                           \
+    static inline void name##_remove_range(Name* v, ptrdiff_t index,       \
+                                           ptrdiff_t n) {                  \
+        assert_notnull(v);                                                 \
+        assert_valid_range(v, index, n);                                   \
+        memmove(v->_values + index, v->_values + index + n,                \
+                (v->_size - index - n) * sizeof(T));                       \
+        v->_size -= n;                                                     \
+    }                                                                      \
+                                                                           \
+    static inline void name##_remove(Name* v, ptrdiff_t index) {           \
+        assert_notnull(v);                                                 \
+        assert_valid_index(v, index);                                      \
+        name##_remove_range(v, index, 1);                                  \
+    }                                                                      \
+                                                                           \
+    static inline void name##_swap_remove(Name* v, ptrdiff_t index) {      \
+        assert_notnull(v);                                                 \
+        assert_valid_index(v, index);                                      \
+        v->_values[index] = v->_values[--v->_size];                        \
+    }                                                                      \
+                                                                           \
+    static inline ptrdiff_t name##_retain(                                 \
+        Name* v, bool (*pred)(T value, void* state), void* state) {        \
+        assert_notnull(v);                                                 \
+        assert_notnull(pred);                                              \
+        ptrdiff_t j = 0;                                                   \
+        for (ptrdiff_t i = 0; i < v->_size; ++i)                           \
+            if (pred(v->_values[i], state))                                \
+                v->_values[j++] = v->_values[i];                           \
+        ptrdiff_t removed = v->_size - j;                                  \
+        v->_size = j;                                                      \
+        return removed;                                                    \
+    }                                                                      \
+                                                                           \
+    static inline Name name##_copy(const Name* v) {                        \
+        assert_notnull(v);                                                 \
+        Name out = name##_alloc_cap(v->_size);                             \
+        if (v->_size)                                                      \
+            memcpy(out._values, v->_values, v->_size * sizeof(T));         \
+        out._size = v->_size;                                              \
+        out._growth = v->_growth;                                          \
+        return out;                                                        \
+    }                                                                      \
+                                                                           \
+    static inline void name##_merge(Name* v1, Name* v2) {                  \
+        assert_notnull(v1);                                                \
+        assert_notnull(v2);                                                \
+        name##_append_array(v1, v2->_values, v2->_size);                   \
+        name##_free(v2);                                                   \
+    }                                                                      \
+                                                                           \
+    static inline bool name##_equal(const Name* v1, const Name* v2) {      \
+        assert_notnull(v1);                                                \
+        assert_notnull(v2);                                                \
+        if (v1->_size != v2->_size)                                        \
+            return false;                                                  \
+        for (ptrdiff_t i = 0; i < v1->_size; ++i)                          \
+            if (!EQUAL(NULL, v1->_values[i], v2->_values[i]))              \
+                return false;                                              \
+        return true;                                                       \
+    }                                                                      \
+                                                                           \
+    static inline ptrdiff_t name##_find(const Name* v, T value) {          \
+        assert_notnull(v);                                                 \
+        for (ptrdiff_t i = 0; i < v->_size; ++i)                           \
+            if (EQUAL(NULL, v->_values[i], value))                         \
+                return i;                                                  \
+        return VEC_NOT_FOUND;                                              \
+    }                                                                      \
+                                                                           \
+    static inline ptrdiff_t name##_find_last(const Name* v, T value) {     \
+        assert_notnull(v);                                                 \
+        for (ptrdiff_t i = v->_size - 1; i >= 0; --i)                      \
+            if (EQUAL(NULL, v->_values[i], value))                         \
+                return i;                                                  \
+        return VEC_NOT_FOUND;                                              \
+    }                                                                      \
+                                                                           \
+    static inline void name##_sort(Name* v) {                              \
+        assert_notnull(v);                                                 \
+        name##_array_sort(v->_values, v->_size, NULL);                     \
+    }                                                                      \
+                                                                           \
+    static inline void name##_sort_stable(Name* v) {                       \
+        assert_notnull(v);                                                 \
+        name##_array_sort_stable(v->_values, v->_size, NULL);              \
+    }                                                                      \
+                                                                           \
+    /* Returns the index of the first value that isn't less than value. */ \
+    static inline ptrdiff_t name##_lower_bound(const Name* v, T value) {   \
+        assert_notnull(v);                                                 \
+        ptrdiff_t lo = 0;                                                  \
+        ptrdiff_t hi = v->_size;                                           \
+        while (lo < hi) {                                                  \
+            ptrdiff_t mid = lo + (hi - lo) / 2;                            \
+            if (LESS(NULL, v->_values[mid], value))                        \
+                lo = mid + 1;                                              \
+            else                                                           \
+                hi = mid;                                                  \
+        }                                                                  \
+        return lo;                                                         \
+    }                                                                      \
+                                                                           \
+    static inline ptrdiff_t name##_search(const Name* v, T value) {        \
+        ptrdiff_t i = name##_lower_bound(v, value);                        \
+        return (i < v->_size && EQUAL(NULL, v->_values[i], value))         \
+                   ? i                                                     \
+                   : VEC_NOT_FOUND;                                        \
+    }                                                                      \
+                                                                           \
+    static inline void name##_add(Name* v, T value) {                      \
+        name##_insert(v, name##_lower_bound(v, value), value);             \
+    }
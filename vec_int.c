@@ -2,34 +2,90 @@
 // License: GPL-3
 
 #include "vec_int.h"
+#include "simd.h"
+#include "sort.h"
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
-static void vec_int_grow(VecInt* vec);
-static int intcmp(const void* a, const void* b);
+static void vec_int_grow(VecInt* vec, ptrdiff_t needed);
+static void vec_int_set_cap(VecInt* vec, ptrdiff_t cap);
+static void vec_int_open_gap(VecInt* vec, ptrdiff_t index, ptrdiff_t n);
+static void vec_int_close_gap(VecInt* vec, ptrdiff_t index, ptrdiff_t n);
+static ptrdiff_t vec_int_unique_batch(const VecInt* vec, int* batch,
+                                     ptrdiff_t n);
+static void int_array_sort_radix(int* values, ptrdiff_t n);
 
-VecInt vec_int_alloc_cap(int cap) {
+#define INT_LESS(ctx, x, y) ((x) < (y))
+SORT_DEFINE(int_array, int, void*, INT_LESS)
+SORT_DEFINE_PARALLEL(int_array, int, void*, INT_LESS)
+
+VecInt vec_int_alloc_cap(ptrdiff_t cap) {
     cap = cap > 0 ? cap : 0;
     int* values = NULL;
     if (cap) {
         values = malloc(cap * sizeof(int));
         assert_alloc(values);
     }
-    return (VecInt){._size = 0, ._cap = cap, ._values = values};
+    return (VecInt){._size = 0,
+                    ._cap = cap,
+                    ._values = values,
+                    ._growth = VEC_GROWTH_DEFAULT};
+}
+
+VecInt vec_int_alloc_inline(int* buffer, ptrdiff_t cap) {
+    assert_notnull(buffer);
+    assert(cap > 0 && "an inline buffer needs room for a value");
+    return (VecInt){._size = 0,
+                    ._cap = cap,
+                    ._values = buffer,
+                    ._growth = VEC_GROWTH_DEFAULT,
+                    ._inline = true};
+}
+
+void small_vec_int_init(SmallVecInt* small) {
+    assert_notnull(small);
+    small->vec = vec_int_alloc_inline(small->_buffer, VEC_SMALL_CAP);
 }
 
 void vec_int_free(VecInt* vec) {
     assert_notnull(vec);
-    free(vec->_values);
+    if (!vec->_inline)
+        vec_buffer_free(vec->_values, vec->_cap * sizeof(int),
+                        vec->_large);
     vec->_values = NULL;
+    vec->_large = false;
     vec->_size = 0;
     vec->_cap = 0;
+    vec->_inline = false;
 }
 
 inline void vec_int_clear(VecInt* vec) { vec->_size = 0; }
 
-int vec_int_get(const VecInt* vec, int index) {
+void vec_int_reserve(VecInt* vec, ptrdiff_t cap) {
+    assert_notnull(vec);
+    if (cap > vec->_cap)
+        vec_int_set_cap(vec, cap);
+}
+
+void vec_int_shrink_to_fit(VecInt* vec) {
+    assert_notnull(vec);
+    if (vec->_cap > vec->_size)
+        vec_int_set_cap(vec, vec->_size);
+}
+
+void vec_int_resize(VecInt* vec, ptrdiff_t size, int value) {
+    assert_notnull(vec);
+    assert(size >= 0 && "can't resize to a negative size");
+    if (size > vec->_cap)
+        vec_int_grow(vec, size);
+    for (ptrdiff_t i = vec->_size; i < size; ++i)
+        vec->_values[i] = value;
+    vec->_size = size;
+}
+
+int vec_int_get(const VecInt* vec, ptrdiff_t index) {
     assert_notnull(vec);
     assert_nonempty(vec);
     assert_valid_index(vec, index);
@@ -48,35 +104,66 @@ inline int vec_int_get_last(const VecInt* vec) {
     return vec->_values[vec->_size - 1];
 }
 
-void vec_int_set(VecInt* vec, int index, int value) {
+void vec_int_set(VecInt* vec, ptrdiff_t index, int value) {
     assert_notnull(vec);
     assert_nonempty(vec);
     assert_valid_index(vec, index);
     vec->_values[index] = value;
 }
 
-void vec_int_insert(VecInt* vec, int index, int value) {
+void vec_int_insert(VecInt* vec, ptrdiff_t index, int value) {
     assert_notnull(vec);
     assert_valid_index(vec, index);
-    if (vec->_size == vec->_cap)
-        vec_int_grow(vec);
-    for (int i = vec->_size; i > index; --i)
-        vec->_values[i] = vec->_values[i - 1];
+    vec_int_open_gap(vec, index, 1);
     vec->_values[index] = value;
-    vec->_size++;
+}
+
+void vec_int_insert_n(VecInt* vec, ptrdiff_t index, ptrdiff_t n,
+                      int value) {
+    assert_notnull(vec);
+    assert_valid_range(vec, index, 0);
+    assert(n >= 0 && "can't insert a negative number of values");
+    vec_int_open_gap(vec, index, n);
+    for (ptrdiff_t i = index; i < index + n; ++i)
+        vec->_values[i] = value;
+}
+
+void vec_int_insert_range(VecInt* vec, ptrdiff_t index, const int* values,
+                          ptrdiff_t n) {
+    assert_notnull(vec);
+    assert_valid_range(vec, index, 0);
+    assert(n >= 0 && "can't insert a negative number of values");
+    if (n) {
+        assert_notnull(values);
+        vec_int_open_gap(vec, index, n);
+        memcpy(vec->_values + index, values, (size_t)n * sizeof(int));
+    }
+}
+
+inline void vec_int_insert_vec(VecInt* vec1, ptrdiff_t index,
+                               const VecInt* vec2) {
+    assert_notnull(vec2);
+    assert(vec1 != vec2 && "can't insert a vec into itself");
+    vec_int_insert_range(vec1, index, vec2->_values, vec2->_size);
+}
+
+inline void vec_int_append_array(VecInt* vec, const int* values,
+                                 ptrdiff_t n) {
+    assert_notnull(vec);
+    vec_int_insert_range(vec, vec->_size, values, n);
 }
 
 void vec_int_add(VecInt* vec, int value) {
     assert_notnull(vec);
     assert_notnull(value);
-    int high = vec->_size - 1;
+    ptrdiff_t high = vec->_size - 1;
     if (!vec->_size || vec->_values[high] <= value)
         vec_int_push(vec,
                      value); // vec is empty -or- nonempty and value >= high
     else {
-        int low = 0;
+        ptrdiff_t low = 0;
         while (low < high) {
-            int mid = (low + high) / 2;
+            ptrdiff_t mid = (low + high) / 2;
             if (vec->_values[mid] > value)
                 high = mid;
             else
@@ -86,7 +173,35 @@ void vec_int_add(VecInt* vec, int value) {
     }
 }
 
-int vec_int_replace(VecInt* vec, int index, int value) {
+void vec_int_add_many(VecInt* vec, const int* values, ptrdiff_t n,
+                      bool unique) {
+    assert_notnull(vec);
+    assert(n >= 0 && "can't add a negative number of values");
+    if (!n)
+        return;
+    assert_notnull(values);
+    int* batch = malloc(n * sizeof(int));
+    assert_alloc(batch);
+    memcpy(batch, values, n * sizeof(int));
+    int_array_sort(batch, n, NULL);
+    if (unique)
+        n = vec_int_unique_batch(vec, batch, n);
+    if (vec->_size + n > vec->_cap)
+        vec_int_grow(vec, vec->_size + n);
+    // Merge from the back; equal values go after those already present
+    ptrdiff_t i = vec->_size - 1;
+    ptrdiff_t k = vec->_size + n - 1;
+    for (ptrdiff_t j = n - 1; j >= 0; --k) {
+        if (i >= 0 && vec->_values[i] > batch[j])
+            vec->_values[k] = vec->_values[i--];
+        else
+            vec->_values[k] = batch[j--];
+    }
+    vec->_size += n;
+    free(batch);
+}
+
+int vec_int_replace(VecInt* vec, ptrdiff_t index, int value) {
     assert_notnull(vec);
     assert_nonempty(vec);
     assert_valid_index(vec, index);
@@ -95,16 +210,40 @@ int vec_int_replace(VecInt* vec, int index, int value) {
     return old;
 }
 
-void vec_int_remove(VecInt* vec, int index) {
+void vec_int_remove(VecInt* vec, ptrdiff_t index) {
+    assert_notnull(vec);
+    assert_nonempty(vec);
+    assert_valid_index(vec, index);
+    vec_int_close_gap(vec, index, 1);
+}
+
+void vec_int_remove_range(VecInt* vec, ptrdiff_t index, ptrdiff_t n) {
+    assert_notnull(vec);
+    assert_valid_range(vec, index, n);
+    vec_int_close_gap(vec, index, n);
+}
+
+void vec_int_swap_remove(VecInt* vec, ptrdiff_t index) {
     assert_notnull(vec);
     assert_nonempty(vec);
     assert_valid_index(vec, index);
-    for (int i = index; i < vec->_size; ++i)
-        vec->_values[i] = vec->_values[i + 1];
-    vec->_size--;
+    vec->_values[index] = vec->_values[--vec->_size];
 }
 
-int vec_int_take(VecInt* vec, int index) {
+ptrdiff_t vec_int_retain(VecInt* vec, bool (*pred)(int value, void* state),
+                         void* state) {
+    assert_notnull(vec);
+    assert_notnull(pred);
+    ptrdiff_t j = 0;
+    for (ptrdiff_t i = 0; i < vec->_size; ++i)
+        if (pred(vec->_values[i], state))
+            vec->_values[j++] = vec->_values[i];
+    ptrdiff_t removed = vec->_size - j;
+    vec->_size = j;
+    return removed;
+}
+
+int vec_int_take(VecInt* vec, ptrdiff_t index) {
     assert_notnull(vec);
     assert_nonempty(vec);
     assert_valid_index(vec, index);
@@ -122,15 +261,16 @@ int vec_int_pop(VecInt* vec) {
 void vec_int_push(VecInt* vec, int value) {
     assert_notnull(vec);
     if (vec->_size == vec->_cap)
-        vec_int_grow(vec);
+        vec_int_grow(vec, vec->_size + 1);
     vec->_values[vec->_size++] = value;
 }
 
 VecInt vec_int_copy(const VecInt* vec) {
     assert_notnull(vec);
     VecInt out = vec_int_alloc_cap(vec->_size);
-    for (int i = 0; i < vec->_size; ++i)
+    for (ptrdiff_t i = 0; i < vec->_size; ++i)
         vec_int_push(&out, vec->_values[i]);
+    out._growth = vec->_growth;
     return out;
 }
 
@@ -138,14 +278,9 @@ void vec_int_merge(VecInt* vec1, VecInt* vec2) {
     assert_notnull(vec1);
     assert_notnull(vec2);
     if ((vec1->_cap - vec1->_size) <
-        vec2->_size) { // vec1 doesn't have enough cap
-        int cap = vec1->_size + vec2->_size;
-        int* p = realloc(vec1->_values, cap * sizeof(int));
-        assert_alloc(p);
-        vec1->_values = p;
-        vec1->_cap = cap;
-    }
-    for (int i = 0; i < vec2->_size; ++i)
+        vec2->_size) // vec1 doesn't have enough cap
+        vec_int_set_cap(vec1, vec1->_size + vec2->_size);
+    for (ptrdiff_t i = 0; i < vec2->_size; ++i)
         vec1->_values[vec1->_size++] = vec2->_values[i]; // push
     vec_int_free(vec2);
 }
@@ -161,53 +296,90 @@ bool vec_int_equal(const VecInt* vec1, const VecInt* vec2) {
                   sizeof(int) * vec1->_size) == 0;
 }
 
-int vec_int_find(const VecInt* vec, int value) {
+ptrdiff_t vec_int_find(const VecInt* vec, int value) {
     assert_notnull(vec);
-    for (int i = 0; i < vec->_size; ++i)
-        if (vec->_values[i] == value)
-            return i;
-    return VEC_NOT_FOUND;
+    return simd_int_find(vec->_values, vec->_size, value);
 }
 
-int vec_int_find_last(const VecInt* vec, int value) {
+ptrdiff_t vec_int_find_last(const VecInt* vec, int value) {
     assert_notnull(vec);
-    for (int i = vec->_size - 1; i >= 0; --i)
-        if (vec->_values[i] == value)
-            return i;
-    return VEC_NOT_FOUND;
+    return simd_int_find_last(vec->_values, vec->_size, value);
+}
+
+ptrdiff_t vec_int_count(const VecInt* vec, int value) {
+    assert_notnull(vec);
+    return simd_int_count(vec->_values, vec->_size, value);
+}
+
+int vec_int_min(const VecInt* vec) {
+    assert_notnull(vec);
+    assert_nonempty(vec);
+    return vec->_values[simd_int_argmin(vec->_values, vec->_size)];
+}
+
+int vec_int_max(const VecInt* vec) {
+    assert_notnull(vec);
+    assert_nonempty(vec);
+    return vec->_values[simd_int_argmax(vec->_values, vec->_size)];
+}
+
+ptrdiff_t vec_int_argmin(const VecInt* vec) {
+    assert_notnull(vec);
+    return simd_int_argmin(vec->_values, vec->_size);
 }
 
-static int intcmp(const void* a, const void* b) {
-    return (*(int*)a - *(int*)b);
+ptrdiff_t vec_int_argmax(const VecInt* vec) {
+    assert_notnull(vec);
+    return simd_int_argmax(vec->_values, vec->_size);
+}
+
+bool vec_int_all_in_range(const VecInt* vec, int lo, int hi) {
+    assert_notnull(vec);
+    return simd_int_all_in_range(vec->_values, vec->_size, lo, hi);
 }
 
 void vec_int_sort(VecInt* vec) {
     assert_notnull(vec);
-    if (vec->_size)
-        qsort(vec->_values, vec->_size, sizeof(int), intcmp);
+    int_array_sort(vec->_values, vec->_size, NULL);
 }
 
-int vec_int_search(const VecInt* vec, int i) {
+void vec_int_sort_radix(VecInt* vec) {
     assert_notnull(vec);
-    if (vec->_size) {
-        const int* p =
-            bsearch(&i, vec->_values, vec->_size, sizeof(int), intcmp);
-        if (p)
-            return p - vec->_values;
+    int_array_sort_radix(vec->_values, vec->_size);
+}
+
+void vec_int_sort_parallel(VecInt* vec, int nthreads) {
+    assert_notnull(vec);
+    int_array_sort_parallel(vec->_values, vec->_size, NULL, nthreads,
+                            false);
+}
+
+ptrdiff_t vec_int_search(const VecInt* vec, int value) {
+    assert_notnull(vec);
+    ptrdiff_t low = 0;
+    ptrdiff_t high = vec->_size;
+    while (low < high) {
+        ptrdiff_t mid = low + (high - low) / 2;
+        if (vec->_values[mid] < value)
+            low = mid + 1;
+        else
+            high = mid;
     }
+    if (low < vec->_size && vec->_values[low] == value)
+        return low;
     return VEC_NOT_FOUND;
 }
 
 char* vec_int_to_str(const VecInt* vec) {
     assert_notnull(vec);
     const int BUF_SIZE = 128;
-    const int VEC_SIZE = VEC_SIZE(vec);
-    int cap = VEC_SIZE * 4;
+    const ptrdiff_t VEC_SIZE = VEC_SIZE(vec);
+    size_t cap = VEC_SIZE * 4;
     char* s = malloc(cap);
     assert_alloc(s);
-    int pos = 0;
+    size_t pos = 0;
     char buf[BUF_SIZE];
-    for (int i = 0; i < VEC_SIZE; ++i) {
+    for (ptrdiff_t i = 0; i < VEC_SIZE; ++i) {
         size_t n = snprintf(buf, BUF_SIZE, "%d ", VEC_GET(vec, i));
         strncpy(&s[pos], buf, n);
         pos += n;
@@ -224,16 +396,109 @@ char* vec_int_to_str(const VecInt* vec) {
 
 void vec_int_dump(const VecInt* vec) {
     if (vec->_size)
-        for (int i = 0; i < vec->_size; ++i)
-            printf("[%d]=%d\n", i, vec->_values[i]);
+        for (ptrdiff_t i = 0; i < vec->_size; ++i)
+            printf("[%td]=%d\n", i, vec->_values[i]);
     else
         printf("(empty)");
 }
 
-static void vec_int_grow(VecInt* vec) {
-    int cap = vec->_cap;
-    assert((!cap && !vec->_values) || (cap && vec->_values));
-    vec->_cap = VEC_GROW_CAP(cap);
-    vec->_values = realloc(vec->_values, vec->_cap * sizeof(int));
-    assert_alloc(vec->_values);
+static void vec_int_grow(VecInt* vec, ptrdiff_t needed) {
+    assert((!vec->_cap && !vec->_values) || (vec->_cap && vec->_values));
+    vec_int_set_cap(vec, vec_grow_cap(&vec->_growth, vec->_cap, needed));
+}
+
+// Inline values are only ever moved to the heap to grow them.
+static void vec_int_set_cap(VecInt* vec, ptrdiff_t cap) {
+    assert(cap >= vec->_size && "can't reduce cap below size");
+    if (vec->_inline) {
+        if (cap <= vec->_cap)
+            return;
+        int* p = vec_buffer_resize(NULL, 0, 0, cap * sizeof(int),
+                                   vec->_growth.large, &vec->_large);
+        memcpy(p, vec->_values, vec->_size * sizeof(int));
+        vec->_values = p;
+        vec->_inline = false;
+    } else
+        vec->_values = vec_buffer_resize(
+            vec->_values, vec->_size * sizeof(int), vec->_cap * sizeof(int),
+            cap * sizeof(int), vec->_growth.large, &vec->_large);
+    vec->_cap = cap;
+}
+
+static void vec_int_open_gap(VecInt* vec, ptrdiff_t index, ptrdiff_t n) {
+    if (!n)
+        return;
+    if (vec->_size + n > vec->_cap)
+        vec_int_grow(vec, vec->_size + n);
+    memmove(vec->_values + index + n, vec->_values + index,
+            (size_t)(vec->_size - index) * sizeof(int));
+    vec->_size += n;
+}
+
+static void vec_int_close_gap(VecInt* vec, ptrdiff_t index, ptrdiff_t n) {
+    if (!n)
+        return;
+    memmove(vec->_values + index, vec->_values + index + n,
+            (size_t)(vec->_size - index - n) * sizeof(int));
+    vec->_size -= n;
+}
+
+// Drops values from the sorted batch that are repeats or are already in
+// the vec, and returns the batch's new size.
+static ptrdiff_t vec_int_unique_batch(const VecInt* vec, int* batch,
+                                     ptrdiff_t n) {
+    ptrdiff_t i = 0;
+    ptrdiff_t k = 0;
+    for (ptrdiff_t j = 0; j < n; ++j) {
+        if (k && batch[k - 1] == batch[j])
+            continue;
+        while (i < vec->_size && vec->_values[i] < batch[j])
+            ++i;
+        if (i < vec->_size && vec->_values[i] == batch[j])
+            continue;
+        batch[k++] = batch[j];
+    }
+    return k;
+}
+
+// Flipping the sign bit makes the unsigned order of the keys the signed
+// order of the values. All four byte histograms are counted in one pass.
+static void int_array_sort_radix(int* values, ptrdiff_t n) {
+    if (n < SORT_RADIX_MIN) {
+        int_array_sort(values, n, NULL);
+        return;
+    }
+    const uint32_t SIGN = 0x80000000u;
+    ptrdiff_t counts[4][256] = {{0}};
+    for (ptrdiff_t i = 0; i < n; ++i) {
+        uint32_t key = (uint32_t)values[i] ^ SIGN;
+        for (int b = 0; b < 4; ++b)
+            counts[b][(key >> (b * 8)) & 0xFF]++;
+    }
+    int* tmp = malloc(n * sizeof(int));
+    assert_alloc(tmp);
+    int* src = values;
+    int* dst = tmp;
+    for (int b = 0; b < 4; ++b) {
+        int shift = b * 8;
+        ptrdiff_t* count = counts[b];
+        if (count[(((uint32_t)src[0] ^ SIGN) >> shift) & 0xFF] == n)
+            continue; // every value has the same byte here
+        ptrdiff_t total = 0;
+        for (int d = 0; d < 256; ++d) {
+            ptrdiff_t c = count[d];
+            count[d] = total;
+            total += c;
+        }
+        for (ptrdiff_t i = 0; i < n; ++i) {
+            uint32_t key = (uint32_t)src[i] ^ SIGN;
+            dst[count[(key >> shift) & 0xFF]++] = src[i];
+        }
+        int* t = src;
+        src = dst;
+        dst = t;
+    }
+    if (src != values)
+        memcpy(values, src, n * sizeof(int));
+    free(tmp);
 }
@@ -12,21 +12,50 @@
 //
 // To iterate:
 // ```
-// for (int i = 0; i < VEC_SIZE(vec); ++i)
+// for (ptrdiff_t i = 0; i < VEC_SIZE(vec); ++i)
 //     int value = VEC_GET(vec, i);
 // ```
 typedef struct VecInt {
-    int _size; // This is "end", i.e., one past the last value
-    int _cap;  // The size of the allocated array
+    ptrdiff_t _size; // This is "end", i.e., one past the last value
+    ptrdiff_t _cap;  // The size of the allocated array
     int* _values;
+    VecGrowth _growth; // See VEC_SET_GROWTH()
+    bool _inline;      // _values is a caller's buffer, not on the heap
+    bool _large;       // _values is in large mode (see VecGrowth)
 } VecInt;
 
+// A VecInt with room for VEC_SMALL_CAP values of its own so that it only
+// allocates if it grows beyond that, e.g., for the many short-lived vecs
+// of a tokenizer. Use the VecInt functions on its vec (and free it with
+// vec_int_free() as usual). Since the vec points into the struct,
+// initialize it in place with small_vec_int_init() and don't copy or
+// move it (by value).
+//
+// ```
+// SmallVecInt tags;
+// small_vec_int_init(&tags);
+// vec_int_push(&tags.vec, 5);
+// vec_int_free(&tags.vec);
+// ```
+typedef struct SmallVecInt {
+    VecInt vec;
+    int _buffer[VEC_SMALL_CAP];
+} SmallVecInt;
+
 // Allocates a new empty VecInt with the given capacity.
-VecInt vec_int_alloc_cap(int cap);
+VecInt vec_int_alloc_cap(ptrdiff_t cap);
 
 // Allocates a new empty VecInt with a default capacity of 0.
 #define vec_int_alloc() vec_int_alloc_cap(0)
 
+// Returns a new empty VecInt that keeps its values in the given buffer
+// of cap ints (which must outlive it) until it needs more room, when it
+// moves them to the heap like any other VecInt.
+VecInt vec_int_alloc_inline(int* buffer, ptrdiff_t cap);
+
+// Initializes small as an empty SmallVecInt (see above).
+void small_vec_int_init(SmallVecInt* small);
+
 // Destroys the VecInt freeing its memory. The VecInt is not usable
 // after this.
 void vec_int_free(VecInt* vec);
@@ -34,9 +63,21 @@ void vec_int_free(VecInt* vec);
 // Clears all the VecInt's values.
 void vec_int_clear(VecInt* vec);
 
+// Ensures the VecInt's capacity is at least cap, e.g., before pushing a
+// known number of values.
+void vec_int_reserve(VecInt* vec, ptrdiff_t cap);
+
+// Reduces the VecInt's capacity to its size, freeing any unused memory
+// (unless its values are inline, when it does nothing).
+void vec_int_shrink_to_fit(VecInt* vec);
+
+// Resizes the VecInt to the given size, either truncating it or padding
+// it with copies of value.
+void vec_int_resize(VecInt* vec, ptrdiff_t size, int value);
+
 // Returns the VecInt's int value at position index.
 // The VEC_GET() macro is faster but unchecked.
-int vec_int_get(const VecInt* vec, int index);
+int vec_int_get(const VecInt* vec, ptrdiff_t index);
 
 // Returns the VecInt's int value at its first valid index.
 // The VEC_GET_FIRST() macro is faster but unchecked.
@@ -47,26 +88,69 @@ int vec_int_get_first(const VecInt* vec);
 int vec_int_get_last(const VecInt* vec);
 
 // Sets the VecInt's value at position index to the given int.
-void vec_int_set(VecInt* vec, int index, int value);
+void vec_int_set(VecInt* vec, ptrdiff_t index, int value);
 
 // Inserts the int at position index and moves succeeding values
 // up (right), increasing the VecInt's size (and cap if necessary): O(n).
-void vec_int_insert(VecInt* vec, int index, int value);
+void vec_int_insert(VecInt* vec, ptrdiff_t index, int value);
+
+// Inserts n copies of value at position index (which may be VEC_SIZE(vec)
+// to append) and moves succeeding values up (right) in a single move,
+// increasing the VecInt's size (and cap if necessary): O(n).
+void vec_int_insert_n(VecInt* vec, ptrdiff_t index, ptrdiff_t n,
+                      int value);
+
+// Inserts the n values from the values array at position index (which
+// may be VEC_SIZE(vec) to append) and moves succeeding values up (right)
+// in a single move: O(n). The values must not be in the VecInt itself.
+void vec_int_insert_range(VecInt* vec, ptrdiff_t index, const int* values,
+                          ptrdiff_t n);
+
+// Inserts all vec2's values into vec1 at position index (which may be
+// VEC_SIZE(vec1) to append): O(n). vec2 is unchanged.
+void vec_int_insert_vec(VecInt* vec1, ptrdiff_t index,
+                        const VecInt* vec2);
+
+// Appends the n values from the values array, increasing the VecInt's
+// size (and cap if necessary): O(n). The values must not be in the VecInt
+// itself.
+void vec_int_append_array(VecInt* vec, const int* values, ptrdiff_t n);
 
 // Adds the value in order (in a sorted vec) and moves succeeding values up
 // (right), increasing the vec's size (and cap if necessary): O(n).
 void vec_int_add(VecInt* vec, int value);
 
+// Adds the n values from the values array in order (in a sorted vec) by
+// sorting a copy of them and merging it in a single pass: O(n + m log m)
+// rather than O(n·m) for m calls to vec_int_add(). If unique is true,
+// values already in the vec or repeated in the array are not added.
+void vec_int_add_many(VecInt* vec, const int* values, ptrdiff_t n,
+                      bool unique);
+
 // Sets the VecInt's value at position index to the given int
 // and returns the old int value from that position.
-int vec_int_replace(VecInt* vec, int index, int value);
+int vec_int_replace(VecInt* vec, ptrdiff_t index, int value);
 
 // Removes the value at the given index and closes up the gap: O(n).
-void vec_int_remove(VecInt* vec, int index);
+void vec_int_remove(VecInt* vec, ptrdiff_t index);
+
+// Removes the n values from position index onwards and closes up the gap
+// in a single move: O(n).
+void vec_int_remove_range(VecInt* vec, ptrdiff_t index, ptrdiff_t n);
+
+// Removes the value at the given index by moving the last value into its
+// place, so the order is not preserved: O(1).
+void vec_int_swap_remove(VecInt* vec, ptrdiff_t index);
+
+// Keeps only the values for which pred(value, state) returns true,
+// preserving their order, and returns how many values were removed.
+// Uses a single pass: O(n).
+ptrdiff_t vec_int_retain(VecInt* vec, bool (*pred)(int value, void* state),
+                         void* state);
 
 // Returns and removes the value at the given index and closes up the
 // gap: O(n).
-int vec_int_take(VecInt* vec, int index);
+int vec_int_take(VecInt* vec, ptrdiff_t index);
 
 // Removes and returns the last int value. Only use if
 // vec.isempty() is false: O(1).
@@ -91,19 +175,56 @@ bool vec_int_equal(const VecInt* vec1, const VecInt* vec2);
 
 // Returns the index where the value was found in the vec or
 // VEC_NOT_FOUND (-1). Uses a linear search.
-int vec_int_find(const VecInt* vec, int value);
+// This and the following scans use SSE2 or AVX2 if available (see
+// simd.h).
+ptrdiff_t vec_int_find(const VecInt* vec, int value);
 
 // Returns the last index where the value was found in the vec or
 // VEC_NOT_FOUND (-1). Uses a linear search.
-int vec_int_find_last(const VecInt* vec, int value);
+ptrdiff_t vec_int_find_last(const VecInt* vec, int value);
+
+// Returns how many of the vec's values equal value: O(n).
+ptrdiff_t vec_int_count(const VecInt* vec, int value);
+
+// Returns the vec's smallest value. Only use if VEC_ISEMPTY() is false:
+// O(n).
+int vec_int_min(const VecInt* vec);
+
+// Returns the vec's largest value. Only use if VEC_ISEMPTY() is false:
+// O(n).
+int vec_int_max(const VecInt* vec);
+
+// Returns the index of the vec's first smallest value or VEC_NOT_FOUND
+// (-1) if the vec is empty: O(n).
+ptrdiff_t vec_int_argmin(const VecInt* vec);
+
+// Returns the index of the vec's first largest value or VEC_NOT_FOUND
+// (-1) if the vec is empty: O(n).
+ptrdiff_t vec_int_argmax(const VecInt* vec);
+
+// Returns true if every one of the vec's values is in the inclusive range
+// [lo, hi] (or if the vec is empty): O(n).
+bool vec_int_all_in_range(const VecInt* vec, int lo, int hi);
 
 // Sorts the VecInt in-place in ascending order.
 void vec_int_sort(VecInt* vec);
 
+// Sorts the VecInt in-place in ascending order like vec_int_sort() but
+// using nthreads threads (or one per online CPU if nthreads <= 0). Falls
+// back to vec_int_sort() for VecInts of fewer than SORT_PARALLEL_MIN
+// values. See sort.h.
+void vec_int_sort_parallel(VecInt* vec, int nthreads);
+
+// Sorts the VecInt in-place in ascending order (negative values first)
+// like vec_int_sort(), but using an LSD radix sort of the values' four
+// bytes which does no comparisons: O(n), using n values of extra memory.
+// Passes where every value has the same byte are skipped.
+void vec_int_sort_radix(VecInt* vec);
+
 // Returns the index where the value was found in the vec or
 // VEC_NOT_FOUND (-1). Uses a binary search that assumes vec_int_sort() has
 // been used.
-int vec_int_search(const VecInt* vec, int i);
+ptrdiff_t vec_int_search(const VecInt* vec, int value);
 
 // Returns a string of space-separated int values.
 // The returned char* value is now owns by the caller.
@@ -6,17 +6,41 @@
 #include "str.h"
 #include "vec_int.h"
 #include "vecs_test.h"
+#include <limits.h>
+#include <stdint.h>
 #include <stdlib.h>
 
-static void check_size_cap(tinfo* tinfo, VecInt* v, int size, int cap);
+static void check_size_cap(tinfo* tinfo, VecInt* v, ptrdiff_t size,
+                           ptrdiff_t cap);
 static void match(tinfo* tinfo, VecInt* v, char* expected);
 static void equal(tinfo* tinfo, VecInt* v1, VecInt* v2);
 static void merge_tests(tinfo* tinfo);
+static void growth_tests(tinfo* tinfo);
+static void range_tests(tinfo* tinfo);
+static void retain_tests(tinfo* tinfo);
+static void add_many_tests(tinfo* tinfo);
+static void sort_parallel_tests(tinfo* tinfo);
+static void sort_radix_tests(tinfo* tinfo);
+static void scan_tests(tinfo* tinfo);
+static void small_tests(tinfo* tinfo);
+static void large_tests(tinfo* tinfo);
+static bool is_aligned(const VecInt* v);
+static bool has_values(const VecInt* v, int n);
+static bool is_multiple(int value, void* state);
 
 void vec_int_tests(tinfo* tinfo) {
     if (tinfo->verbose)
         puts(tinfo->tag);
     merge_tests(tinfo);
+    growth_tests(tinfo);
+    range_tests(tinfo);
+    retain_tests(tinfo);
+    add_many_tests(tinfo);
+    sort_parallel_tests(tinfo);
+    sort_radix_tests(tinfo);
+    scan_tests(tinfo);
+    small_tests(tinfo);
+    large_tests(tinfo);
 
     VecInt v1 = vec_int_alloc(); // default of 0
     check_size_cap(tinfo, &v1, 0, 0);
@@ -223,23 +247,366 @@ static void merge_tests(tinfo* tinfo) {
     vec_int_free(&v1);
 }
 
+static void range_tests(tinfo* tinfo) {
+    if (tinfo->verbose)
+        puts(tinfo->tag);
+    VecInt v1 = vec_int_alloc();
+    const int A[] = {1, 2, 3, 4};
+    vec_int_append_array(&v1, A, 4);
+    check_size_cap(tinfo, &v1, 4, VEC_INITIAL_CAP);
+    match(tinfo, &v1, "1 2 3 4");
+    vec_int_insert_n(&v1, 2, 3, 0);
+    match(tinfo, &v1, "1 2 0 0 0 3 4");
+    vec_int_insert_n(&v1, 0, 1, -1);
+    vec_int_insert_n(&v1, VEC_SIZE(&v1), 2, 9);
+    vec_int_insert_n(&v1, 3, 0, 7); // no-op
+    match(tinfo, &v1, "-1 1 2 0 0 0 3 4 9 9");
+    const int B[] = {10, 20, 30};
+    vec_int_insert_range(&v1, 1, B, 3);
+    match(tinfo, &v1, "-1 10 20 30 1 2 0 0 0 3 4 9 9");
+    check_size_cap(tinfo, &v1, 13, VEC_INITIAL_CAP);
+    vec_int_remove_range(&v1, 1, 3);
+    match(tinfo, &v1, "-1 1 2 0 0 0 3 4 9 9");
+    vec_int_remove_range(&v1, 3, 3);
+    vec_int_remove_range(&v1, 5, 2);
+    vec_int_remove_range(&v1, 0, 0); // no-op
+    match(tinfo, &v1, "-1 1 2 3 4");
+
+    VecInt v2 = vec_int_alloc();
+    vec_int_insert_vec(&v2, 0, &v1);
+    vec_int_insert_vec(&v2, 2, &v1);
+    match(tinfo, &v2, "-1 1 -1 1 2 3 4 2 3 4");
+    vec_int_remove_range(&v2, 0, VEC_SIZE(&v2));
+    check_size_cap(tinfo, &v2, 0, VEC_INITIAL_CAP);
+    vec_int_append_array(&v2, B, 0); // no-op
+    check_size_cap(tinfo, &v2, 0, VEC_INITIAL_CAP);
+    vec_int_insert(&v1, 1, 5);
+    vec_int_remove(&v1, 4);
+    check_int_eq(tinfo, vec_int_take(&v1, 0), -1);
+    match(tinfo, &v1, "5 1 2 4");
+    vec_int_free(&v1);
+    vec_int_free(&v2);
+}
+
+static void retain_tests(tinfo* tinfo) {
+    if (tinfo->verbose)
+        puts(tinfo->tag);
+    VecInt v1 = vec_int_alloc();
+    for (int i = 1; i <= 12; ++i)
+        vec_int_push(&v1, i);
+    int factor = 3;
+    check_int_eq(tinfo, vec_int_retain(&v1, is_multiple, &factor), 8);
+    match(tinfo, &v1, "3 6 9 12");
+    check_size_cap(tinfo, &v1, 4, VEC_INITIAL_CAP);
+    factor = 1;
+    check_int_eq(tinfo, vec_int_retain(&v1, is_multiple, &factor), 0);
+    match(tinfo, &v1, "3 6 9 12");
+    vec_int_swap_remove(&v1, 0);
+    match(tinfo, &v1, "12 6 9");
+    vec_int_swap_remove(&v1, 2);
+    match(tinfo, &v1, "12 6");
+    factor = 5;
+    check_int_eq(tinfo, vec_int_retain(&v1, is_multiple, &factor), 2);
+    check_size_cap(tinfo, &v1, 0, VEC_INITIAL_CAP);
+    vec_int_free(&v1);
+}
+
+static void add_many_tests(tinfo* tinfo) {
+    if (tinfo->verbose)
+        puts(tinfo->tag);
+    VecInt v1 = vec_int_alloc();
+    vec_int_add_many(&v1, NULL, 0, false); // no-op
+    check_size_cap(tinfo, &v1, 0, 0);
+    const int A[] = {30, 10, 20};
+    vec_int_add_many(&v1, A, 3, false);
+    match(tinfo, &v1, "10 20 30");
+    const int B[] = {25, 5, 40, 20, 5};
+    vec_int_add_many(&v1, B, 5, false);
+    match(tinfo, &v1, "5 5 10 20 20 25 30 40");
+    const int C[] = {5, 35, 35, 1, 40, -3};
+    vec_int_add_many(&v1, C, 6, true);
+    match(tinfo, &v1, "-3 1 5 5 10 20 20 25 30 35 40");
+
+    // Must match adding one at a time
+    VecInt v2 = vec_int_alloc();
+    VecInt v3 = vec_int_alloc();
+    int batch[50];
+    for (int i = 0; i < 4; ++i) {
+        for (int j = 0; j < 50; ++j) {
+            batch[j] = 1 + ((i * 50 + j) * 7919) % 97;
+            vec_int_add(&v2, batch[j]);
+        }
+        vec_int_add_many(&v3, batch, 50, false);
+    }
+    equal(tinfo, &v2, &v3);
+    vec_int_add_many(&v3, batch, 50, true); // all already present
+    equal(tinfo, &v2, &v3);
+    vec_int_free(&v3);
+    vec_int_free(&v2);
+    vec_int_free(&v1);
+}
+
+static void sort_parallel_tests(tinfo* tinfo) {
+    if (tinfo->verbose)
+        puts(tinfo->tag);
+    const int N = 100000;
+    VecInt v1 = vec_int_alloc_cap(N);
+    for (int i = 0; i < N; ++i)
+        vec_int_push(&v1, (i * 7919) % 10007 - 5000);
+    VecInt v2 = vec_int_copy(&v1);
+    vec_int_sort(&v1);
+    vec_int_sort_parallel(&v2, 4);
+    equal(tinfo, &v1, &v2);
+    vec_int_sort_parallel(&v2, 0); // already sorted
+    equal(tinfo, &v1, &v2);
+    vec_int_free(&v2);
+    vec_int_free(&v1);
+}
+
+// Includes the extremes, values differing only in their high bytes, and
+// runs where some byte passes are skipped.
+static void sort_radix_tests(tinfo* tinfo) {
+    if (tinfo->verbose)
+        puts(tinfo->tag);
+    VecInt v1 = vec_int_alloc();
+    vec_int_sort_radix(&v1);
+    check_size_cap(tinfo, &v1, 0, 0);
+    const int A[] = {3, INT_MIN, -1, 0, INT_MAX, -256, 256, 1};
+    vec_int_append_array(&v1, A, 8);
+    vec_int_sort_radix(&v1);
+    match(tinfo, &v1, "-2147483648 -256 -1 0 1 3 256 2147483647");
+    vec_int_clear(&v1);
+
+    const int SIZES[] = {63, 64, 1000, 100003};
+    for (int s = 0; s < (int)(sizeof(SIZES) / sizeof(SIZES[0])); ++s) {
+        for (int shape = 0; shape < 4; ++shape) {
+            for (int i = 0; i < SIZES[s]; ++i) {
+                unsigned u = (unsigned)i * 2654435761u;
+                int value = shape == 0   ? (int)u
+                            : shape == 1 ? (int)(u & 0xFF000000u)
+                            : shape == 2 ? (int)(u % 1000) - 500
+                                         : SIZES[s] - i;
+                vec_int_push(&v1, value);
+            }
+            VecInt v2 = vec_int_copy(&v1);
+            vec_int_sort(&v1);
+            vec_int_sort_radix(&v2);
+            equal(tinfo, &v1, &v2);
+            vec_int_free(&v2);
+            vec_int_clear(&v1);
+        }
+    }
+    vec_int_free(&v1);
+}
+
+static void scan_tests(tinfo* tinfo) {
+    if (tinfo->verbose)
+        puts(tinfo->tag);
+    VecInt v1 = vec_int_alloc();
+    check_found(tinfo, vec_int_argmin(&v1), VEC_NOT_FOUND);
+    check_found(tinfo, vec_int_argmax(&v1), VEC_NOT_FOUND);
+    check_int_eq(tinfo, vec_int_count(&v1, 0), 0);
+    check_bool_eq(tinfo, vec_int_all_in_range(&v1, 0, 0), true);
+    for (int i = 0; i < 100; ++i)
+        vec_int_push(&v1, (i * 37) % 50 - 20);
+    check_int_eq(tinfo, vec_int_min(&v1), -20);
+    check_int_eq(tinfo, vec_int_max(&v1), 29);
+    check_found(tinfo, vec_int_argmin(&v1), 0);
+    check_found(tinfo, vec_int_argmax(&v1), 27);
+    check_int_eq(tinfo, vec_int_count(&v1, -20), 2);
+    check_found(tinfo, vec_int_find(&v1, -20), 0);
+    check_found(tinfo, vec_int_find_last(&v1, -20), 50);
+    check_bool_eq(tinfo, vec_int_all_in_range(&v1, -20, 29), true);
+    check_bool_eq(tinfo, vec_int_all_in_range(&v1, -19, 29), false);
+    check_bool_eq(tinfo, vec_int_all_in_range(&v1, -20, 28), false);
+    vec_int_free(&v1);
+}
+
+static bool is_multiple(int value, void* state) {
+    return value % *(int*)state == 0;
+}
+
+static void growth_tests(tinfo* tinfo) {
+    if (tinfo->verbose)
+        puts(tinfo->tag);
+    VecGrowth growth = VEC_GROWTH_DEFAULT;
+    check_int_eq(tinfo, vec_grow_cap(&growth, 0, 1), VEC_INITIAL_CAP);
+    check_int_eq(tinfo, vec_grow_cap(&growth, 16, 17), 32);
+    check_int_eq(tinfo, vec_grow_cap(&growth, 16, 100), 100);
+    check_int_eq(tinfo, vec_grow_cap(&growth, 4194304, 4194305), 8388608);
+    growth = (VecGrowth){0}; // zeroed is the same as the default
+    check_int_eq(tinfo, vec_grow_cap(&growth, 16, 17), 32);
+    growth = (VecGrowth){.factor = 1.5, .max_step = 1000};
+    check_int_eq(tinfo, vec_grow_cap(&growth, 100, 101), 150);
+    check_int_eq(tinfo, vec_grow_cap(&growth, 1, 2), 2);
+    check_int_eq(tinfo, vec_grow_cap(&growth, 10000, 10001), 11000);
+    growth = (VecGrowth){.exact = true};
+    check_int_eq(tinfo, vec_grow_cap(&growth, 0, 1), 1);
+    check_int_eq(tinfo, vec_grow_cap(&growth, 10, 11), 11);
+
+    VecInt v1 = vec_int_alloc();
+    VEC_SET_GROWTH(&v1, ((VecGrowth){.exact = true}));
+    check_bool_eq(tinfo, VEC_GROWTH(&v1).exact, true);
+    for (int i = 1; i <= 5; ++i) {
+        vec_int_push(&v1, i);
+        check_size_cap(tinfo, &v1, i, i);
+    }
+    vec_int_reserve(&v1, 3); // no-op since already bigger
+    check_size_cap(tinfo, &v1, 5, 5);
+    vec_int_reserve(&v1, 100);
+    check_size_cap(tinfo, &v1, 5, 100);
+    vec_int_shrink_to_fit(&v1);
+    check_size_cap(tinfo, &v1, 5, 5);
+    match(tinfo, &v1, "1 2 3 4 5");
+    vec_int_resize(&v1, 8, -1);
+    check_size_cap(tinfo, &v1, 8, 8);
+    match(tinfo, &v1, "1 2 3 4 5 -1 -1 -1");
+    vec_int_resize(&v1, 2, 0);
+    check_size_cap(tinfo, &v1, 2, 8);
+    match(tinfo, &v1, "1 2");
+    vec_int_resize(&v1, 0, 0);
+    vec_int_shrink_to_fit(&v1);
+    check_size_cap(tinfo, &v1, 0, 0);
+    vec_int_push(&v1, 9);
+    check_size_cap(tinfo, &v1, 1, 1);
+    vec_int_free(&v1);
+
+    VecInt v2 = vec_int_alloc();
+    VEC_SET_GROWTH(&v2, ((VecGrowth){.factor = 1.5}));
+    for (int i = 0; i < 17; ++i)
+        vec_int_push(&v2, i);
+    check_size_cap(tinfo, &v2, 17, 24);
+    VecInt v3 = vec_int_copy(&v2); // keeps the growth policy
+    check_bool_eq(tinfo, VEC_GROWTH(&v3).factor == 1.5, true);
+    vec_int_push(&v3, 17);
+    check_size_cap(tinfo, &v3, 18, 25);
+    vec_int_free(&v3);
+    vec_int_free(&v2);
+}
+
+static void small_tests(tinfo* tinfo) {
+    if (tinfo->verbose)
+        puts(tinfo->tag);
+    SmallVecInt small;
+    small_vec_int_init(&small);
+    VecInt* v1 = &small.vec;
+    check_size_cap(tinfo, v1, 0, VEC_SMALL_CAP);
+    for (int i = 1; i <= VEC_SMALL_CAP; ++i)
+        vec_int_push(v1, i);
+    check_bool_eq(tinfo, v1->_values == small._buffer, true);
+    match(tinfo, v1, "1 2 3 4 5 6 7 8");
+    vec_int_shrink_to_fit(v1); // a no-op while inline
+    vec_int_remove(v1, 0);
+    vec_int_insert(v1, 0, 1);
+    check_size_cap(tinfo, v1, VEC_SMALL_CAP, VEC_SMALL_CAP);
+    check_bool_eq(tinfo, v1->_values == small._buffer, true);
+    vec_int_push(v1, 9); // spills to the heap
+    check_bool_eq(tinfo, v1->_values == small._buffer, false);
+    check_size_cap(tinfo, v1, 9, 2 * VEC_SMALL_CAP);
+    match(tinfo, v1, "1 2 3 4 5 6 7 8 9");
+    vec_int_shrink_to_fit(v1);
+    check_size_cap(tinfo, v1, 9, 9);
+    vec_int_free(v1);
+    check_size_cap(tinfo, v1, 0, 0);
+
+    // The same with a caller's buffer, then merged
+    int buffer[4];
+    VecInt v2 = vec_int_alloc_inline(buffer, 4);
+    vec_int_reserve(&v2, 3);
+    check_bool_eq(tinfo, v2._values == buffer, true);
+    vec_int_append_array(&v2, (int[]){10, 20, 30}, 3);
+    VecInt v3 = vec_int_alloc();
+    vec_int_push(&v3, 5);
+    vec_int_merge(&v3, &v2);
+    match(tinfo, &v3, "5 10 20 30");
+    check_size_cap(tinfo, &v2, 0, 0);
+    small_vec_int_init(&small);
+    vec_int_merge(&small.vec, &v3);
+    match(tinfo, &small.vec, "5 10 20 30");
+    check_bool_eq(tinfo, small.vec._values == small._buffer, true);
+    VecInt v4 = vec_int_copy(&small.vec);
+    equal(tinfo, &v4, &small.vec);
+    vec_int_free(&v4);
+    vec_int_free(&small.vec);
+}
+
+// Grows a large mode vec from aligned heap blocks into a mapping and
+// back again, and switches it in and out of large mode, checking that
+// its values are kept (and aligned while large) throughout.
+static void large_tests(tinfo* tinfo) {
+    if (tinfo->verbose)
+        puts(tinfo->tag);
+    const int N = (int)(VEC_LARGE_MAP_MIN / sizeof(int)) * 3 + 5;
+    VecInt v1 = vec_int_alloc();
+    VEC_SET_GROWTH(&v1, VEC_GROWTH_LARGE);
+    bool aligned = true;
+    for (int i = 0; i < N; ++i) {
+        vec_int_push(&v1, i);
+        if (VEC_SIZE(&v1) == VEC_CAP(&v1))
+            aligned &= is_aligned(&v1);
+    }
+    check_bool_eq(tinfo, aligned && is_aligned(&v1), true);
+    check_bool_eq(tinfo, has_values(&v1, N), true);
+    vec_int_shrink_to_fit(&v1); // mapping shrunk by remapping
+    check_size_cap(tinfo, &v1, N, N);
+    check_bool_eq(tinfo, is_aligned(&v1) && has_values(&v1, N), true);
+    vec_int_resize(&v1, 1000, 0);
+    vec_int_shrink_to_fit(&v1); // back to an aligned heap block
+    check_bool_eq(tinfo, is_aligned(&v1) && has_values(&v1, 1000), true);
+    VEC_SET_GROWTH(&v1, VEC_GROWTH_DEFAULT);
+    vec_int_reserve(&v1, 2000); // out of large mode
+    check_bool_eq(tinfo, has_values(&v1, 1000), true);
+    VEC_SET_GROWTH(&v1, VEC_GROWTH_LARGE);
+    vec_int_reserve(&v1, N); // straight into a mapping
+    check_bool_eq(tinfo, is_aligned(&v1) && has_values(&v1, 1000), true);
+    VecInt v2 = vec_int_alloc();
+    vec_int_merge(&v2, &v1); // frees v1's mapping
+    check_size_cap(tinfo, &v1, 0, 0);
+    check_bool_eq(tinfo, has_values(&v2, 1000), true);
+    vec_int_free(&v2);
+
+    SmallVecInt small; // spills straight into large mode
+    small_vec_int_init(&small);
+    VEC_SET_GROWTH(&small.vec, VEC_GROWTH_LARGE);
+    for (int i = 0; i < 100; ++i)
+        vec_int_push(&small.vec, i);
+    check_bool_eq(tinfo,
+                  is_aligned(&small.vec) && has_values(&small.vec, 100),
+                  true);
+    vec_int_free(&small.vec);
+}
+
+static bool is_aligned(const VecInt* v) {
+    return (uintptr_t)v->_values % VEC_LARGE_ALIGN == 0;
+}
+
+static bool has_values(const VecInt* v, int n) {
+    if (VEC_SIZE(v) != n)
+        return false;
+    for (int i = 0; i < n; ++i)
+        if (VEC_GET(v, i) != i)
+            return false;
+    return true;
+}
+
 static void match(tinfo* tinfo, VecInt* v, char* expected) {
     char* out = vec_int_to_str(v);
     check_str_eq(tinfo, out, expected);
     free(out);
 }
 
-static void check_size_cap(tinfo* tinfo, VecInt* v, int size, int cap) {
+static void check_size_cap(tinfo* tinfo, VecInt* v, ptrdiff_t size,
+                           ptrdiff_t cap) {
     tinfo->total++;
     if (VEC_SIZE(v) != size)
-        WARN("FAIL: %s VEC_SIZE() expected %d != %d\n", tinfo->tag, size,
+        WARN("FAIL: %s VEC_SIZE() expected %td != %td\n", tinfo->tag, size,
              VEC_SIZE(v));
     else
         tinfo->ok++;
 
     tinfo->total++;
     if (VEC_ISEMPTY(v) != (size == 0))
-        WARN("FAIL: %s VEC_ISEMPTY() expected %s != %s size=%d\n",
+        WARN("FAIL: %s VEC_ISEMPTY() expected %s != %s size=%td\n",
              tinfo->tag, bool_to_str(size == 0),
              bool_to_str(VEC_ISEMPTY(v)), size);
     else
@@ -247,7 +614,7 @@ static void check_size_cap(tinfo* tinfo, VecInt* v, int size, int cap) {
 
     tinfo->total++;
     if (VEC_CAP(v) != cap)
-        WARN("FAIL: %s VEC_CAP() expected %d != %d\n", tinfo->tag, cap,
+        WARN("FAIL: %s VEC_CAP() expected %td != %td\n", tinfo->tag, cap,
              VEC_CAP(v));
     else
         tinfo->ok++;
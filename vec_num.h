@@ -0,0 +1,18 @@
+// Copyright © 2024-25 Mark Summerfield. All rights reserved.
+// License: GPL-3
+#pragma once
+
+#include "vec_define.h"
+#include <stdint.h>
+
+// Typed vectors of numbers (see vec_define.h for their functions):
+// VecU32 (vec_u32_…) of uint32_t, VecI64 (vec_i64_…) of int64_t, and
+// VecF32 (vec_f32_…) of float. For VecF32, NaNs are never equal to
+// anything (so can't be found) and sort in unspecified places.
+
+#define VEC_NUM_LESS(ctx, x, y) ((x) < (y))
+#define VEC_NUM_EQUAL(ctx, x, y) ((x) == (y))
+
+VEC_DEFINE(VecU32, vec_u32, uint32_t, VEC_NUM_LESS, VEC_NUM_EQUAL)
+VEC_DEFINE(VecI64, vec_i64, int64_t, VEC_NUM_LESS, VEC_NUM_EQUAL)
+VEC_DEFINE(VecF32, vec_f32, float, VEC_NUM_LESS, VEC_NUM_EQUAL)
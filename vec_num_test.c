@@ -0,0 +1,213 @@
+// Copyright © 2024-25 Mark Summerfield. All rights reserved.
+// License: GPL-3
+
+#include "vec_num_test.h"
+#include "exit.h"
+#include "vec_num.h"
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+
+typedef struct {
+    int key;
+    int order; // the order pushed, to check stability
+} Pair;
+
+#define PAIR_LESS(ctx, p, q) ((p).key < (q).key)
+#define PAIR_EQUAL(ctx, p, q) ((p).key == (q).key)
+VEC_DEFINE(VecPair, vec_pair, Pair, PAIR_LESS, PAIR_EQUAL)
+
+static void u32_tests(tinfo* tinfo);
+static void i64_tests(tinfo* tinfo);
+static void f32_tests(tinfo* tinfo);
+static void pair_tests(tinfo* tinfo);
+static void large_tests(tinfo* tinfo);
+static bool is_even(int64_t value, void* state);
+static void check(tinfo* tinfo, const char* what, bool ok);
+
+void vec_num_tests(tinfo* tinfo) {
+    if (tinfo->verbose)
+        puts(tinfo->tag);
+    u32_tests(tinfo);
+    i64_tests(tinfo);
+    f32_tests(tinfo);
+    pair_tests(tinfo);
+    large_tests(tinfo);
+}
+
+static void u32_tests(tinfo* tinfo) {
+    VecU32 v1 = vec_u32_alloc();
+    check(tinfo, "u32 empty", VEC_ISEMPTY(&v1) && VEC_CAP(&v1) == 0);
+    for (uint32_t i = 0; i < 100; ++i)
+        vec_u32_push(&v1, (i * 37) % 100 + 4000000000u);
+    check(tinfo, "u32 size", VEC_SIZE(&v1) == 100 && VEC_CAP(&v1) == 128);
+    check(tinfo, "u32 get",
+          vec_u32_get(&v1, 1) == 4000000037u &&
+              vec_u32_get_first(&v1) == 4000000000u &&
+              vec_u32_get_last(&v1) == 4000000063u);
+    check(tinfo, "u32 find", vec_u32_find(&v1, 4000000037u) == 1 &&
+                                 vec_u32_find(&v1, 7) == VEC_NOT_FOUND);
+    VecU32 v2 = vec_u32_copy(&v1);
+    check(tinfo, "u32 copy", vec_u32_equal(&v1, &v2));
+    vec_u32_sort(&v1);
+    bool sorted = true;
+    for (ptrdiff_t i = 0; i < VEC_SIZE(&v1); ++i)
+        sorted &= VEC_GET(&v1, i) == 4000000000u + i;
+    check(tinfo, "u32 sort", sorted);
+    check(tinfo, "u32 not equal", !vec_u32_equal(&v1, &v2));
+    check(tinfo, "u32 search",
+          vec_u32_search(&v1, 4000000042u) == 42 &&
+              vec_u32_search(&v1, 4000000100u) == VEC_NOT_FOUND &&
+              vec_u32_lower_bound(&v1, 4000000100u) == 100 &&
+              vec_u32_lower_bound(&v1, 0) == 0);
+    vec_u32_remove(&v1, 42);
+    check(tinfo, "u32 remove", vec_u32_search(&v1, 4000000042u) ==
+                                   VEC_NOT_FOUND);
+    vec_u32_add(&v1, 4000000042u);
+    check(tinfo, "u32 add", vec_u32_search(&v1, 4000000042u) == 42 &&
+                                VEC_SIZE(&v1) == 100);
+    vec_u32_merge(&v1, &v2);
+    check(tinfo, "u32 merge", VEC_SIZE(&v1) == 200 &&
+                                  VEC_GET(&v1, 100) == 4000000000u &&
+                                  VEC_GET(&v1, 101) == 4000000037u &&
+                                  VEC_SIZE(&v2) == 0);
+    vec_u32_shrink_to_fit(&v1);
+    check(tinfo, "u32 shrink", VEC_CAP(&v1) == 200);
+    vec_u32_clear(&v1);
+    vec_u32_shrink_to_fit(&v1);
+    check(tinfo, "u32 clear", VEC_SIZE(&v1) == 0 && VEC_CAP(&v1) == 0 &&
+                                  !v1._values);
+    vec_u32_free(&v1);
+}
+
+static void i64_tests(tinfo* tinfo) {
+    VecI64 v1 = vec_i64_alloc_cap(4);
+    vec_i64_resize(&v1, 3, INT64_MIN);
+    vec_i64_set(&v1, 1, 0);
+    vec_i64_insert(&v1, 3, INT64_MAX); // may append
+    vec_i64_insert(&v1, 0, -5);
+    const int64_t EXPECTED[] = {-5, INT64_MIN, 0, INT64_MIN, INT64_MAX};
+    bool ok = VEC_SIZE(&v1) == 5;
+    for (int i = 0; ok && i < 5; ++i)
+        ok = VEC_GET(&v1, i) == EXPECTED[i];
+    check(tinfo, "i64 insert", ok);
+    check(tinfo, "i64 find_last", vec_i64_find_last(&v1, INT64_MIN) == 3 &&
+                                      vec_i64_find(&v1, INT64_MIN) == 1);
+    vec_i64_insert_range(&v1, 1, (int64_t[]){10, 11, 12}, 3);
+    vec_i64_append_array(&v1, (int64_t[]){20, 21}, 2);
+    vec_i64_remove_range(&v1, 0, 2);
+    // 11 12 MIN 0 MIN MAX 20 21
+    check(tinfo, "i64 ranges",
+          VEC_SIZE(&v1) == 8 && VEC_GET(&v1, 0) == 11 &&
+              VEC_GET(&v1, 2) == INT64_MIN && VEC_GET_LAST(&v1) == 21);
+    vec_i64_swap_remove(&v1, 0);
+    check(tinfo, "i64 swap_remove",
+          VEC_SIZE(&v1) == 7 && VEC_GET(&v1, 0) == 21);
+    vec_i64_pop(&v1);
+    // 21 12 MIN 0 MIN MAX
+    ptrdiff_t removed = vec_i64_retain(&v1, is_even, NULL);
+    check(tinfo, "i64 retain",
+          removed == 2 && VEC_SIZE(&v1) == 4 && VEC_GET(&v1, 0) == 12 &&
+              VEC_GET_LAST(&v1) == INT64_MIN);
+    vec_i64_sort(&v1);
+    check(tinfo, "i64 sort", VEC_GET(&v1, 0) == INT64_MIN &&
+                                 VEC_GET(&v1, 1) == INT64_MIN &&
+                                 VEC_GET(&v1, 3) == 12);
+    VEC_SET_GROWTH(&v1, ((VecGrowth){.exact = true}));
+    vec_i64_shrink_to_fit(&v1);
+    vec_i64_push(&v1, 1);
+    check(tinfo, "i64 growth", VEC_CAP(&v1) == VEC_SIZE(&v1));
+    vec_i64_free(&v1);
+}
+
+static void f32_tests(tinfo* tinfo) {
+    VecF32 v1 = vec_f32_alloc();
+    for (int i = 0; i < 1000; ++i)
+        vec_f32_push(&v1, (float)((i * 7919) % 1000) / 8.0f - 50.0f);
+    vec_f32_push(&v1, -0.0f);
+    check(tinfo, "f32 find zero", vec_f32_find(&v1, 0.0f) >= 0);
+    vec_f32_sort(&v1);
+    bool sorted = true;
+    for (ptrdiff_t i = 1; i < VEC_SIZE(&v1); ++i)
+        sorted &= VEC_GET(&v1, i - 1) <= VEC_GET(&v1, i);
+    check(tinfo, "f32 sort", sorted && VEC_GET_FIRST(&v1) == -50.0f);
+    check(tinfo, "f32 search",
+          vec_f32_search(&v1, 12.5f) >= 0 &&
+              vec_f32_search(&v1, 12.51f) == VEC_NOT_FOUND);
+    vec_f32_free(&v1);
+
+    // NaNs are equal to nothing, not even NaNs.
+    VecF32 v2 = vec_f32_alloc();
+    VecF32 v3 = vec_f32_alloc();
+    vec_f32_append_array(&v2, (float[]){1.0f, 2.0f}, 2);
+    vec_f32_append_array(&v3, (float[]){NAN, 2.0f}, 2);
+    check(tinfo, "f32 find NaN",
+          vec_f32_find(&v2, NAN) == VEC_NOT_FOUND &&
+              vec_f32_find_last(&v3, NAN) == VEC_NOT_FOUND &&
+              vec_f32_search(&v2, NAN) == VEC_NOT_FOUND);
+    check(tinfo, "f32 find past NaN",
+          vec_f32_find(&v3, 1.0f) == VEC_NOT_FOUND &&
+              vec_f32_find(&v3, 2.0f) == 1);
+    check(tinfo, "f32 equal NaN",
+          !vec_f32_equal(&v2, &v3) && !vec_f32_equal(&v3, &v3));
+    vec_f32_free(&v3);
+    vec_f32_free(&v2);
+}
+
+// Sorting structs by key: the stable sort keeps pushes in order.
+static void pair_tests(tinfo* tinfo) {
+    VecPair v1 = vec_pair_alloc();
+    for (int i = 0; i < 500; ++i)
+        vec_pair_push(&v1, (Pair){.key = (i * 13) % 10, .order = i});
+    VecPair v2 = vec_pair_copy(&v1);
+    vec_pair_sort_stable(&v1);
+    bool stable = true;
+    for (ptrdiff_t i = 1; i < VEC_SIZE(&v1); ++i) {
+        Pair p = VEC_GET(&v1, i - 1);
+        Pair q = VEC_GET(&v1, i);
+        stable &= p.key < q.key || (p.key == q.key && p.order < q.order);
+    }
+    check(tinfo, "pair stable sort", stable);
+    vec_pair_sort(&v2);
+    bool sorted = true;
+    for (ptrdiff_t i = 1; i < VEC_SIZE(&v2); ++i)
+        sorted &= VEC_GET(&v2, i - 1).key <= VEC_GET(&v2, i).key;
+    check(tinfo, "pair sort", sorted);
+    check(tinfo, "pair equal by key", vec_pair_equal(&v1, &v2));
+    check(tinfo, "pair search",
+          vec_pair_search(&v1, (Pair){.key = 3}) == 150 &&
+              vec_pair_search(&v1, (Pair){.key = 10}) == VEC_NOT_FOUND);
+    vec_pair_free(&v2);
+    vec_pair_free(&v1);
+}
+
+static void large_tests(tinfo* tinfo) {
+    VecU32 v1 = vec_u32_alloc();
+    VEC_SET_GROWTH(&v1, VEC_GROWTH_LARGE);
+    vec_u32_resize(&v1, VEC_LARGE_MAP_MIN, 7); // 4x the mapping minimum
+    vec_u32_push(&v1, 8);
+    vec_u32_insert(&v1, 0, 6);
+    check(tinfo, "large aligned",
+          (uintptr_t)v1._values % VEC_LARGE_ALIGN == 0);
+    check(tinfo, "large values",
+          VEC_SIZE(&v1) == VEC_LARGE_MAP_MIN + 2 &&
+              VEC_GET_FIRST(&v1) == 6 && VEC_GET(&v1, 1000) == 7 &&
+              VEC_GET_LAST(&v1) == 8);
+    VecU32 v2 = vec_u32_copy(&v1);
+    check(tinfo, "large copy", vec_u32_equal(&v1, &v2));
+    vec_u32_free(&v2);
+    vec_u32_free(&v1);
+}
+
+static bool is_even(int64_t value, void* state) {
+    (void)state; // unused
+    return value % 2 == 0;
+}
+
+static void check(tinfo* tinfo, const char* what, bool ok) {
+    tinfo->total++;
+    if (!ok)
+        WARN("FAIL: %s %s\n", tinfo->tag, what);
+    else
+        tinfo->ok++;
+}
@@ -0,0 +1,66 @@
+// Copyright © 2024-25 Mark Summerfield. All rights reserved.
+// License: GPL-3
+
+#include "vec_real.h"
+#include "simd.h"
+
+double vec_real_sum(const VecReal* vec) {
+    assert_notnull(vec);
+    return simd_real_sum(vec->_values, vec->_size);
+}
+
+double vec_real_sum_kahan(const VecReal* vec) {
+    assert_notnull(vec);
+    return simd_real_sum_kahan(vec->_values, vec->_size);
+}
+
+double vec_real_mean(const VecReal* vec) {
+    assert_notnull(vec);
+    assert_nonempty(vec);
+    return simd_real_sum(vec->_values, vec->_size) / (double)vec->_size;
+}
+
+double vec_real_variance(const VecReal* vec) {
+    assert_notnull(vec);
+    assert(vec->_size > 1 && "need at least two values");
+    double mean = vec_real_mean(vec);
+    return simd_real_sum_sq_diff(vec->_values, vec->_size, mean) /
+           (double)(vec->_size - 1);
+}
+
+double vec_real_min(const VecReal* vec) {
+    assert_notnull(vec);
+    assert_nonempty(vec);
+    return simd_real_min(vec->_values, vec->_size);
+}
+
+double vec_real_max(const VecReal* vec) {
+    assert_notnull(vec);
+    assert_nonempty(vec);
+    return simd_real_max(vec->_values, vec->_size);
+}
+
+double vec_real_dot(const VecReal* vec1, const VecReal* vec2) {
+    assert_notnull(vec1);
+    assert_notnull(vec2);
+    assert(vec1->_size == vec2->_size && "vecs differ in size");
+    return simd_real_dot(vec1->_values, vec2->_values, vec1->_size);
+}
+
+void vec_real_scale(VecReal* vec, double factor) {
+    assert_notnull(vec);
+    simd_real_scale(vec->_values, vec->_size, factor);
+}
+
+void vec_real_add_scaled(VecReal* vec1, double factor,
+                         const VecReal* vec2) {
+    assert_notnull(vec1);
+    assert_notnull(vec2);
+    assert(vec1->_size == vec2->_size && "vecs differ in size");
+    simd_real_axpy(vec1->_values, vec2->_values, vec1->_size, factor);
+}
+
+void vec_real_clamp(VecReal* vec, double lo, double hi) {
+    assert_notnull(vec);
+    simd_real_clamp(vec->_values, vec->_size, lo, hi);
+}
@@ -0,0 +1,67 @@
+// Copyright © 2024-25 Mark Summerfield. All rights reserved.
+// License: GPL-3
+#pragma once
+
+#include "vec_define.h"
+#include "vec_num.h"
+
+// A vector of double values with the usual typed vector functions (see
+// vec_define.h; note that vec_real_add() inserts a value in order) plus
+// the numeric functions below, which use the simd_real_ kernels (see
+// simd.h). NaNs are never equal to anything (so can't be found) and sort
+// in unspecified places.
+//
+// ```
+// VecReal vec = vec_real_alloc();
+// vec_real_push(&vec, 1.5);
+// vec_real_push(&vec, 2.5);
+// double mean = vec_real_mean(&vec); // 2.0
+// vec_real_free(&vec);
+// ```
+VEC_DEFINE(VecReal, vec_real, double, VEC_NUM_LESS, VEC_NUM_EQUAL)
+
+// Returns the sum of the vec's values (0 if it is empty) summed
+// pairwise, so the rounding error grows with log(n) rather than n: O(n).
+double vec_real_sum(const VecReal* vec);
+
+// Returns the sum of the vec's values (0 if it is empty) using
+// compensated (Kahan) summation, so the result is usually correctly
+// rounded even when large values cancel out, but about 3x slower than
+// vec_real_sum(): O(n).
+double vec_real_sum_kahan(const VecReal* vec);
+
+// Returns the mean of the vec's values (using vec_real_sum()). Only use
+// if VEC_ISEMPTY() is false: O(n).
+double vec_real_mean(const VecReal* vec);
+
+// Returns the sample variance of the vec's values (i.e., dividing by
+// n - 1) computed in two passes (the mean and then the sum of squared
+// differences from it) so that there's no cancellation even if the
+// values are large relative to their spread. Only use if the vec has at
+// least two values: O(n).
+double vec_real_variance(const VecReal* vec);
+
+// Returns the vec's smallest value. Only use if VEC_ISEMPTY() is false;
+// unspecified if any of its values is NaN: O(n).
+double vec_real_min(const VecReal* vec);
+
+// Returns the vec's largest value. Only use if VEC_ISEMPTY() is false;
+// unspecified if any of its values is NaN: O(n).
+double vec_real_max(const VecReal* vec);
+
+// Returns the dot product of vec1 and vec2 (summed pairwise), which must
+// be the same size: O(n).
+double vec_real_dot(const VecReal* vec1, const VecReal* vec2);
+
+// Multiplies each of the vec's values by factor in-place: O(n).
+void vec_real_scale(VecReal* vec, double factor);
+
+// Adds factor times each of vec2's values to the corresponding value of
+// vec1 in-place (e.g., with factor 1.0 to add vec2 to vec1, or -1.0 to
+// subtract it). The vecs must be the same size: O(n).
+void vec_real_add_scaled(VecReal* vec1, double factor,
+                         const VecReal* vec2);
+
+// Replaces each of the vec's values with mx_clampd(lo, value, hi) (see
+// mx.h), i.e., max(lo, min(value, hi)), in-place: O(n).
+void vec_real_clamp(VecReal* vec, double lo, double hi);
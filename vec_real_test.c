@@ -0,0 +1,142 @@
+// Copyright © 2024-25 Mark Summerfield. All rights reserved.
+// License: GPL-3
+
+#include "vec_real_test.h"
+#include "exit.h"
+#include "mx.h"
+#include "simd.h"
+#include "vec_real.h"
+#include <math.h>
+#include <stdio.h>
+
+static void basic_tests(tinfo* tinfo);
+static void precision_tests(tinfo* tinfo);
+static void arithmetic_tests(tinfo* tinfo);
+static void check(tinfo* tinfo, const char* what, bool ok);
+
+// The precision and arithmetic tests are run at every level the CPU
+// supports since each level sums in a different order.
+void vec_real_tests(tinfo* tinfo) {
+    if (tinfo->verbose)
+        puts(tinfo->tag);
+    basic_tests(tinfo);
+    simd_set_max_level(SimdAvx2);
+    SimdLevel best = simd_level();
+    for (SimdLevel level = SimdScalar; level <= best; ++level) {
+        simd_set_max_level(level);
+        if (tinfo->verbose)
+            printf("  %s\n", simd_level_name(level));
+        precision_tests(tinfo);
+        arithmetic_tests(tinfo);
+    }
+    simd_set_max_level(SimdAvx2);
+}
+
+static void basic_tests(tinfo* tinfo) {
+    VecReal v1 = vec_real_alloc();
+    check(tinfo, "empty", VEC_ISEMPTY(&v1) && vec_real_sum(&v1) == 0.0 &&
+                              vec_real_sum_kahan(&v1) == 0.0);
+    for (int i = 0; i < 100; ++i)
+        vec_real_push(&v1, (double)((i * 37) % 100) / 4.0 - 10.0);
+    check(tinfo, "size", VEC_SIZE(&v1) == 100 &&
+                             vec_real_get_first(&v1) == -10.0 &&
+                             vec_real_get(&v1, 1) == -0.75);
+    check(tinfo, "min max", vec_real_min(&v1) == -10.0 &&
+                                vec_real_max(&v1) == 14.75);
+    check(tinfo, "find", vec_real_find(&v1, -0.75) == 1 &&
+                             vec_real_find(&v1, 0.1) == VEC_NOT_FOUND);
+    vec_real_sort(&v1);
+    check(tinfo, "sort", vec_real_search(&v1, -0.75) == 37 &&
+                             vec_real_get_last(&v1) == 14.75);
+    vec_real_add(&v1, 0.1); // inserts in order
+    check(tinfo, "add", vec_real_search(&v1, 0.1) == 41);
+    VecReal v2 = vec_real_copy(&v1);
+    check(tinfo, "equal", vec_real_equal(&v1, &v2));
+    vec_real_set(&v2, 41, NAN); // NaNs are equal to nothing
+    check(tinfo, "find NaN", vec_real_find(&v2, NAN) == VEC_NOT_FOUND &&
+                                 vec_real_find(&v2, 0.1) == VEC_NOT_FOUND &&
+                                 vec_real_search(&v1, NAN) ==
+                                     VEC_NOT_FOUND);
+    check(tinfo, "equal NaN",
+          !vec_real_equal(&v1, &v2) && !vec_real_equal(&v2, &v2));
+    vec_real_free(&v2);
+    vec_real_free(&v1);
+}
+
+static void precision_tests(tinfo* tinfo) {
+    // Huge values that cancel out (pushed and later negated in reverse
+    // order) swamp the small ones for a simple loop or pairwise sum,
+    // whereas compensated summation recovers the small ones' sum.
+    VecReal v1 = vec_real_alloc();
+    for (int i = 0; i < 1000; ++i) {
+        vec_real_push(&v1, (double)((i * 2654435761u) % 1000 + 1) * 1e15);
+        vec_real_push(&v1, (double)(i % 8) / 8.0);
+    }
+    for (ptrdiff_t i = VEC_SIZE(&v1) - 2; i >= 0; i -= 2)
+        vec_real_push(&v1, -VEC_GET(&v1, i));
+    check(tinfo, "sum_kahan cancel",
+          fabs(vec_real_sum_kahan(&v1) - 437.5) < 1e-6);
+
+    // A simple loop is out by about 1.3e-6 (relative 1e-11) since the
+    // rounding errors accumulate; pairwise summation's stay near 1e-16.
+    vec_real_clear(&v1);
+    vec_real_resize(&v1, 1000000, 0.1);
+    long double exact = 1000000.0L * (long double)0.1;
+    double sum = vec_real_sum(&v1);
+    check(tinfo, "sum pairwise", fabs(sum - (double)exact) < 1e-9);
+    check(tinfo, "sum_kahan", vec_real_sum_kahan(&v1) == (double)exact);
+    check(tinfo, "mean", fabs(vec_real_mean(&v1) - 0.1) < 1e-15);
+
+    // The one-pass formula (sum of squares less the square of the sum)
+    // loses every digit here.
+    vec_real_clear(&v1);
+    vec_real_append_array(&v1, (double[]){4e9 + 4, 4e9 + 7, 4e9 + 13,
+                                          4e9 + 16},
+                          4);
+    check(tinfo, "mean large", vec_real_mean(&v1) == 4e9 + 10);
+    check(tinfo, "variance large", vec_real_variance(&v1) == 30.0);
+    vec_real_free(&v1);
+}
+
+static void arithmetic_tests(tinfo* tinfo) {
+    VecReal v1 = vec_real_alloc_cap(103);
+    VecReal v2 = vec_real_alloc_cap(103);
+    for (int i = 0; i < 103; ++i) {
+        vec_real_push(&v1, (double)(i % 10) - 4.5);
+        vec_real_push(&v2, (double)(i % 3));
+    }
+    double dot = 0.0;
+    for (int i = 0; i < 103; ++i)
+        dot += ((double)(i % 10) - 4.5) * (i % 3);
+    check(tinfo, "dot", vec_real_dot(&v1, &v2) == dot);
+    vec_real_scale(&v1, 2.0);
+    check(tinfo, "scale", VEC_GET(&v1, 0) == -9.0 &&
+                              VEC_GET(&v1, 102) == -5.0 &&
+                              vec_real_sum(&v1) == -21.0);
+    vec_real_add_scaled(&v1, -1.0, &v2);
+    check(tinfo, "add_scaled", VEC_GET(&v1, 1) == -8.0 &&
+                                   VEC_GET(&v1, 101) == -9.0 &&
+                                   VEC_GET(&v1, 102) == -5.0);
+    VecReal v3 = vec_real_copy(&v1);
+    vec_real_set(&v1, 50, NAN);
+    vec_real_set(&v3, 50, NAN);
+    vec_real_clamp(&v1, -3.0, 2.5);
+    bool ok = true;
+    for (ptrdiff_t i = 0; i < VEC_SIZE(&v1); ++i)
+        ok &= VEC_GET(&v1, i) == mx_clampd(-3.0, VEC_GET(&v3, i), 2.5);
+    check(tinfo, "clamp", ok && VEC_GET(&v1, 50) == 2.5 &&
+                              vec_real_min(&v1) == -3.0 &&
+                              vec_real_max(&v1) == 2.5);
+    vec_real_free(&v3);
+    vec_real_free(&v2);
+    vec_real_free(&v1);
+}
+
+static void check(tinfo* tinfo, const char* what, bool ok) {
+    tinfo->total++;
+    if (!ok)
+        WARN("FAIL: %s %s %s\n", tinfo->tag, simd_level_name(simd_level()),
+             what);
+    else
+        tinfo->ok++;
+}
@@ -3,18 +3,95 @@
 
 #include "vec_str.h"
 #include "exit.h"
+#include "simd.h"
+#include "sort.h"
 #include "str.h"
 #include <ctype.h>
 #include <err.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
+// A packed VecStr's strings are in a list of chunks (newest first) which
+// never move, so pointers to the strings stay valid until the vec is
+// cleared or freed. Each string is preceded by its length (a uint32_t,
+// unaligned) and followed by its NUL. Chunks double in size up to
+// PACK_CHUNK_MAX (or are as big as a string that needs more).
+typedef struct VecStrChunk {
+    struct VecStrChunk* prev;
+    ptrdiff_t size;
+    ptrdiff_t cap;
+    char bytes[];
+} VecStrChunk;
+
+#define PACK_HEADER_SIZE ((ptrdiff_t)sizeof(uint32_t))
+#define PACK_CHUNK_MIN 4096
+#define PACK_CHUNK_MAX ((ptrdiff_t)1 << 24)
+
+// For vec_str_sort() and vec_str_casesort(): each string is paired with a
+// key of its (case-folded if ignore_case) 8 chars from depth onwards,
+// big-endian so that comparing keys compares the chars, and zero-padded
+// past the string's end (so shorter strings sort first). Only if two
+// keys are equal and neither string ends within them must their tails be
+// compared.
+typedef struct StrKey {
+    uint64_t key;
+    char* value;
+} StrKey;
+
+typedef struct StrKeyCtx {
+    ptrdiff_t depth;
+    bool ignore_case;
+} StrKeyCtx;
+
+static void file_read_lines_into(const char* filename, long long max_size,
+                                 bool* ok, VecStr* vec);
 static void fd_read_lines_size(const char* filename, long long max_size,
                                bool* ok, FILE* file, VecStr* vec);
 static void fd_read_lines_populate_vec(FILE* file, VecStr* vec);
-static void vec_str_grow(VecStr* vec);
+static void vec_str_append_split(VecStr* vec, StrSplit split);
+static void vec_str_grow(VecStr* vec, ptrdiff_t needed);
+static void vec_str_set_cap(VecStr* vec, ptrdiff_t cap);
+static void vec_str_open_gap(VecStr* vec, ptrdiff_t index, ptrdiff_t n);
+static void vec_str_close_gap(VecStr* vec, ptrdiff_t index, ptrdiff_t n);
+static void vec_str_add_many_cmp(VecStr* vec, char* const* values,
+                                 ptrdiff_t n, bool unique,
+                                 bool ignore_case);
+static ptrdiff_t vec_str_unique_batch(const VecStr* vec, char** batch,
+                                     ptrdiff_t n,
+                                     int (*cmp)(const void*, const void*));
+static void str_array_sort_keyed(char** values, ptrdiff_t n,
+                                 bool ignore_case);
+static void str_key_sort(StrKey* items, ptrdiff_t n, ptrdiff_t depth,
+                         int limit, bool ignore_case);
+static void str_key_load(StrKey* items, ptrdiff_t n, ptrdiff_t depth,
+                         bool ignore_case);
+static char* vec_str_adopt(VecStr* vec, char* value);
+static char* vec_str_pack(VecStr* vec, const char* s, ptrdiff_t n);
+static VecStrChunk* vec_str_add_chunk(VecStr* vec, ptrdiff_t needed);
+static void vec_str_free_arena(VecStr* vec, bool keep_newest);
+static ptrdiff_t packed_len(const char* value);
+static bool vec_str_is_at(const VecStr* vec, ptrdiff_t index,
+                          const char* value, ptrdiff_t size);
+
+#define STR_LESS(ctx, x, y) (strcmp((x), (y)) < 0)
+SORT_DEFINE(str_array, char*, void*, STR_LESS)
+SORT_DEFINE_PARALLEL(str_array, char*, void*, STR_LESS)
+
+#define STR_CASELESS(ctx, x, y) (strcasecmp((x), (y)) < 0)
+SORT_DEFINE(str_casearray, char*, void*, STR_CASELESS)
 
-VecStr vec_str_alloc_custom(int cap, Ownership ownership) {
+#define STR_KEY_CONTINUES(key) ((key) & 0xFF)
+#define STR_KEY_LESS(ctx, x, y)                                            \
+    ((x).key < (y).key ||                                                  \
+     ((x).key == (y).key && STR_KEY_CONTINUES((x).key) &&                  \
+      str_key_tail_cmp((ctx), (x).value, (y).value) < 0))
+static int str_key_tail_cmp(const StrKeyCtx* ctx, const char* s,
+                            const char* t);
+SORT_DEFINE(str_key_array, StrKey, const StrKeyCtx*, STR_KEY_LESS)
+
+VecStr vec_str_alloc_custom(ptrdiff_t cap, Ownership ownership) {
     cap = cap > 0 ? cap : 0;
     char** values = NULL;
     if (cap) {
@@ -24,32 +101,104 @@ VecStr vec_str_alloc_custom(int cap, Ownership ownership) {
     return (VecStr){._size = 0,
                     ._cap = cap,
                     ._ownership = ownership,
-                    ._values = values};
+                    ._values = values,
+                    ._growth = VEC_GROWTH_DEFAULT};
+}
+
+VecStr vec_str_alloc_inline(char** buffer, ptrdiff_t cap,
+                            Ownership ownership) {
+    assert_notnull(buffer);
+    assert(cap > 0 && "an inline buffer needs room for a value");
+    return (VecStr){._size = 0,
+                    ._cap = cap,
+                    ._ownership = ownership,
+                    ._values = buffer,
+                    ._growth = VEC_GROWTH_DEFAULT,
+                    ._inline = true};
+}
+
+VecStr vec_str_alloc_packed(ptrdiff_t cap) {
+    VecStr vec = vec_str_alloc_custom(cap, Borrows);
+    vec._packed = true;
+    return vec;
+}
+
+void small_vec_str_init(SmallVecStr* small, Ownership ownership) {
+    assert_notnull(small);
+    small->vec =
+        vec_str_alloc_inline(small->_buffer, VEC_SMALL_CAP, ownership);
 }
 
 void vec_str_free(VecStr* vec) {
     assert_notnull(vec);
     vec_str_clear(vec);
-    free(vec->_values);
+    vec_str_free_arena(vec, false);
+    if (!vec->_inline)
+        vec_buffer_free(vec->_values, vec->_cap * sizeof(char*),
+                        vec->_large);
     vec->_values = NULL;
+    vec->_large = false;
     vec->_cap = 0;
+    vec->_inline = false;
 }
 
 void vec_str_clear(VecStr* vec) {
     assert_notnull(vec);
     if (vec->_ownership == Owns)
-        for (int i = 0; i < vec->_size; ++i)
+        for (ptrdiff_t i = 0; i < vec->_size; ++i)
             free(vec->_values[i]);
+    else if (vec->_packed) // keep the newest chunk for reuse
+        vec_str_free_arena(vec, true);
     vec->_size = 0;
 }
 
-char* vec_str_get(const VecStr* vec, int index) {
+void vec_str_reserve(VecStr* vec, ptrdiff_t cap) {
+    assert_notnull(vec);
+    if (cap > vec->_cap)
+        vec_str_set_cap(vec, cap);
+}
+
+void vec_str_shrink_to_fit(VecStr* vec) {
+    assert_notnull(vec);
+    if (vec->_cap > vec->_size)
+        vec_str_set_cap(vec, vec->_size);
+}
+
+void vec_str_resize(VecStr* vec, ptrdiff_t size, const char* value) {
+    assert_notnull(vec);
+    assert(size >= 0 && "can't resize to a negative size");
+    if (size < vec->_size) {
+        if (vec->_ownership == Owns)
+            for (ptrdiff_t i = size; i < vec->_size; ++i)
+                free(vec->_values[i]);
+    } else if (size > vec->_size) {
+        assert_notnull(value);
+        if (size > vec->_cap)
+            vec_str_grow(vec, size);
+        if (vec->_packed) // the new values can share one copy
+            value = vec_str_pack(vec, value, strlen(value));
+        for (ptrdiff_t i = vec->_size; i < size; ++i)
+            vec->_values[i] =
+                vec->_ownership == Owns ? strdup(value) : (char*)value;
+    }
+    vec->_size = size;
+}
+
+char* vec_str_get(const VecStr* vec, ptrdiff_t index) {
     assert_notnull(vec);
     assert_nonempty(vec);
     assert_valid_index(vec, index);
     return vec->_values[index];
 }
 
+ptrdiff_t vec_str_len(const VecStr* vec, ptrdiff_t index) {
+    assert_notnull(vec);
+    assert_nonempty(vec);
+    assert_valid_index(vec, index);
+    const char* value = vec->_values[index];
+    return vec->_packed ? packed_len(value) : (ptrdiff_t)strlen(value);
+}
+
 inline char* vec_str_get_first(const VecStr* vec) {
     assert_notnull(vec);
     assert_nonempty(vec);
@@ -62,39 +211,86 @@ inline char* vec_str_get_last(const VecStr* vec) {
     return vec->_values[vec->_size - 1];
 }
 
-void vec_str_set(VecStr* vec, int index, char* value) {
+void vec_str_set(VecStr* vec, ptrdiff_t index, char* value) {
     assert_notnull(vec);
     assert_nonempty(vec);
     assert_notnull(value);
     assert_valid_index(vec, index);
     if (vec->_ownership == Owns)
         free(vec->_values[index]);
-    vec->_values[index] = value;
+    vec->_values[index] = vec_str_adopt(vec, value);
 }
 
-void vec_str_insert(VecStr* vec, int index, char* value) {
+void vec_str_insert(VecStr* vec, ptrdiff_t index, char* value) {
     assert_notnull(vec);
     assert_notnull(value);
     assert_valid_index(vec, index);
-    if (vec->_size == vec->_cap)
-        vec_str_grow(vec);
-    for (int i = vec->_size; i > index; --i)
-        vec->_values[i] = vec->_values[i - 1];
-    vec->_values[index] = value;
-    vec->_size++;
+    vec_str_open_gap(vec, index, 1);
+    vec->_values[index] = vec_str_adopt(vec, value);
+}
+
+void vec_str_insert_n(VecStr* vec, ptrdiff_t index, ptrdiff_t n,
+                      const char* value) {
+    assert_notnull(vec);
+    assert_notnull(value);
+    assert_valid_range(vec, index, 0);
+    assert(n >= 0 && "can't insert a negative number of values");
+    vec_str_open_gap(vec, index, n);
+    if (n && vec->_packed) // the new values can share one copy
+        value = vec_str_pack(vec, value, strlen(value));
+    for (ptrdiff_t i = index; i < index + n; ++i)
+        vec->_values[i] =
+            vec->_ownership == Owns ? strdup(value) : (char*)value;
+}
+
+void vec_str_insert_range(VecStr* vec, ptrdiff_t index,
+                          char* const* values, ptrdiff_t n) {
+    assert_notnull(vec);
+    assert_valid_range(vec, index, 0);
+    assert(n >= 0 && "can't insert a negative number of values");
+    if (n) {
+        assert_notnull(values);
+        vec_str_open_gap(vec, index, n);
+        if (vec->_packed)
+            for (ptrdiff_t i = 0; i < n; ++i)
+                vec->_values[index + i] = vec_str_adopt(vec, values[i]);
+        else
+            memcpy(vec->_values + index, values, n * sizeof(char*));
+    }
+}
+
+void vec_str_insert_vec(VecStr* vec1, ptrdiff_t index,
+                        const VecStr* vec2) {
+    assert_notnull(vec1);
+    assert_notnull(vec2);
+    assert(vec1 != vec2 && "can't insert a vec into itself");
+    assert_valid_range(vec1, index, 0);
+    vec_str_open_gap(vec1, index, vec2->_size);
+    for (ptrdiff_t i = 0; i < vec2->_size; ++i) {
+        char* value = vec2->_values[i];
+        vec1->_values[index + i] = vec1->_ownership == Owns
+                                       ? strdup(value)
+                                       : vec_str_adopt(vec1, value);
+    }
+}
+
+inline void vec_str_append_array(VecStr* vec, char* const* values,
+                                 ptrdiff_t n) {
+    assert_notnull(vec);
+    vec_str_insert_range(vec, vec->_size, values, n);
 }
 
 void vec_str_add(VecStr* vec, char* value) {
     assert_notnull(vec);
     assert_notnull(value);
-    int high = vec->_size - 1;
+    ptrdiff_t high = vec->_size - 1;
     if (!vec->_size || strcmp(vec->_values[high], value) <= 0)
         vec_str_push(vec,
                      value); // vec is empty -or- nonempty and value >= high
     else {
-        int low = 0;
+        ptrdiff_t low = 0;
         while (low < high) {
-            int mid = (low + high) / 2;
+            ptrdiff_t mid = (low + high) / 2;
             if (strcmp(vec->_values[mid], value) > 0)
                 high = mid;
             else
@@ -104,30 +300,95 @@ void vec_str_add(VecStr* vec, char* value) {
     }
 }
 
-char* vec_str_replace(VecStr* vec, int index, char* value) {
+void vec_str_caseadd(VecStr* vec, char* value) {
+    assert_notnull(vec);
+    assert_notnull(value);
+    ptrdiff_t high = vec->_size - 1;
+    if (!vec->_size || strcasecmp(vec->_values[high], value) <= 0)
+        vec_str_push(vec,
+                     value); // vec is empty -or- nonempty and value >= high
+    else {
+        ptrdiff_t low = 0;
+        while (low < high) {
+            ptrdiff_t mid = (low + high) / 2;
+            if (strcasecmp(vec->_values[mid], value) > 0)
+                high = mid;
+            else
+                low = mid + 1;
+        }
+        vec_str_insert(vec, low, value);
+    }
+}
+
+inline void vec_str_add_many(VecStr* vec, char* const* values, ptrdiff_t n,
+                             bool unique) {
+    vec_str_add_many_cmp(vec, values, n, unique, false);
+}
+
+inline void vec_str_caseadd_many(VecStr* vec, char* const* values,
+                                 ptrdiff_t n, bool unique) {
+    vec_str_add_many_cmp(vec, values, n, unique, true);
+}
+
+char* vec_str_replace(VecStr* vec, ptrdiff_t index, char* value) {
     assert_notnull(vec);
     assert_nonempty(vec);
     assert_notnull(value);
     assert_valid_index(vec, index);
     char* old = vec->_values[index];
-    vec->_values[index] = value;
+    vec->_values[index] = vec_str_adopt(vec, value);
     return old;
 }
 
-inline void vec_str_remove(VecStr* vec, int index) {
+inline void vec_str_remove(VecStr* vec, ptrdiff_t index) {
     char* old = vec_str_take(vec, index); // vec_str_take does asserts
     if (vec->_ownership == Owns)
         free(old);
 }
 
-char* vec_str_take(VecStr* vec, int index) {
+void vec_str_remove_range(VecStr* vec, ptrdiff_t index, ptrdiff_t n) {
+    assert_notnull(vec);
+    assert_valid_range(vec, index, n);
+    if (vec->_ownership == Owns)
+        for (ptrdiff_t i = index; i < index + n; ++i)
+            free(vec->_values[i]);
+    vec_str_close_gap(vec, index, n);
+}
+
+void vec_str_swap_remove(VecStr* vec, ptrdiff_t index) {
+    assert_notnull(vec);
+    assert_nonempty(vec);
+    assert_valid_index(vec, index);
+    if (vec->_ownership == Owns)
+        free(vec->_values[index]);
+    vec->_values[index] = vec->_values[--vec->_size];
+    vec->_values[vec->_size] = NULL;
+}
+
+ptrdiff_t vec_str_retain(VecStr* vec,
+                         bool (*pred)(const char* value, void* state),
+                         void* state) {
+    assert_notnull(vec);
+    assert_notnull(pred);
+    ptrdiff_t j = 0;
+    for (ptrdiff_t i = 0; i < vec->_size; ++i) {
+        char* value = vec->_values[i];
+        if (pred(value, state))
+            vec->_values[j++] = value;
+        else if (vec->_ownership == Owns)
+            free(value);
+    }
+    ptrdiff_t removed = vec->_size - j;
+    vec->_size = j;
+    return removed;
+}
+
+char* vec_str_take(VecStr* vec, ptrdiff_t index) {
     assert_notnull(vec);
     assert_nonempty(vec);
     assert_valid_index(vec, index);
     char* old = vec->_values[index];
-    for (int i = index; i < vec->_size; ++i)
-        vec->_values[i] = vec->_values[i + 1];
-    vec->_size--;
+    vec_str_close_gap(vec, index, 1);
     vec->_values[vec->_size] = NULL;
     return old;
 }
@@ -142,7 +403,25 @@ void vec_str_push(VecStr* vec, char* value) {
     assert_notnull(vec);
     assert_notnull(value);
     if (vec->_size == vec->_cap)
-        vec_str_grow(vec);
+        vec_str_grow(vec, vec->_size + 1);
+    vec->_values[vec->_size++] = vec_str_adopt(vec, value);
+}
+
+void vec_str_push_n(VecStr* vec, const char* s, ptrdiff_t n) {
+    assert_notnull(vec);
+    assert((vec->_ownership == Owns || vec->_packed) &&
+           "pushed copies must be owned or packed");
+    assert_notnull(s);
+    assert(n >= 0 && "can't push a negative number of chars");
+    char* value;
+    if (vec->_packed)
+        value = vec_str_pack(vec, s, n);
+    else {
+        value = strndup(s, n);
+        assert_alloc(value);
+    }
+    if (vec->_size == vec->_cap)
+        vec_str_grow(vec, vec->_size + 1);
     vec->_values[vec->_size++] = value;
 }
 
@@ -150,10 +429,11 @@ VecStr vec_str_copy(const VecStr* vec, Ownership ownership) {
     assert_notnull(vec);
     VecStr out =
         vec_str_alloc_custom(vec->_size ? vec->_size : 0, ownership);
-    for (int i = 0; i < vec->_size; ++i) {
+    for (ptrdiff_t i = 0; i < vec->_size; ++i) {
         char* value = vec->_values[i];
         vec_str_push(&out, ownership == Owns ? strdup(value) : value);
     }
+    out._growth = vec->_growth;
     return out;
 }
 
@@ -161,21 +441,33 @@ void vec_str_merge(VecStr* vec1, VecStr* vec2) {
     assert_notnull(vec1);
     assert_notnull(vec2);
     assert(vec1->_ownership == vec2->_ownership &&
-           "both vec_str's must be owners or both must be borrowers");
+           vec1->_packed == vec2->_packed &&
+           "both vec_str's must be owners or borrowers or packed");
     if ((vec1->_cap - vec1->_size) <
-        vec2->_size) { // vec1 doesn't have enough cap
-        int cap = vec1->_size + vec2->_size;
-        char** p = realloc(vec1->_values, cap * sizeof(char*));
-        assert_alloc(p);
-        vec1->_values = p;
-        vec1->_cap = cap;
-    }
-    for (int i = 0; i < vec2->_size; ++i)
+        vec2->_size) // vec1 doesn't have enough cap
+        vec_str_set_cap(vec1, vec1->_size + vec2->_size);
+    for (ptrdiff_t i = 0; i < vec2->_size; ++i)
         vec1->_values[vec1->_size++] = vec2->_values[i]; // push
     // we do *not* free vec2's individual values even if vec2 owns since
-    // their pointers are now owned by vec1
-    free(vec2->_values);
+    // their pointers are now owned by vec1; likewise vec2's arena's
+    // chunks go behind vec1's newest (which may still have room)
+    if (vec2->_arena) {
+        if (vec1->_arena) {
+            VecStrChunk* oldest = vec2->_arena;
+            while (oldest->prev)
+                oldest = oldest->prev;
+            oldest->prev = vec1->_arena->prev;
+            vec1->_arena->prev = vec2->_arena;
+        } else
+            vec1->_arena = vec2->_arena;
+        vec2->_arena = NULL;
+    }
+    if (!vec2->_inline)
+        vec_buffer_free(vec2->_values, vec2->_cap * sizeof(char*),
+                        vec2->_large);
     vec2->_values = NULL;
+    vec2->_inline = false;
+    vec2->_large = false;
     vec2->_cap = 0;
     vec2->_size = 0;
 }
@@ -185,37 +477,49 @@ bool vec_str_equal(const VecStr* vec1, const VecStr* vec2) {
     assert_notnull(vec2);
     if (vec1->_size != vec2->_size)
         return false;
-    for (int i = 0; i < vec1->_size; ++i)
-        if (strcmp(vec1->_values[i], vec2->_values[i]))
-            return false;
+    if (vec1->_packed && vec2->_packed) {
+        for (ptrdiff_t i = 0; i < vec1->_size; ++i)
+            if (!vec_str_is_at(vec1, i, vec2->_values[i],
+                               packed_len(vec2->_values[i])))
+                return false;
+    } else
+        for (ptrdiff_t i = 0; i < vec1->_size; ++i)
+            if (strcmp(vec1->_values[i], vec2->_values[i]))
+                return false;
     return true;
 }
 
-int vec_str_find(const VecStr* vec, const char* value) {
+ptrdiff_t vec_str_find(const VecStr* vec, const char* value) {
     assert_notnull(vec);
     assert_notnull(value);
-    for (int i = 0; i < vec->_size; ++i)
-        if (strcmp(vec->_values[i], value) == 0)
+    const ptrdiff_t SIZE = vec->_packed ? (ptrdiff_t)strlen(value) : 0;
+    for (ptrdiff_t i = 0; i < vec->_size; ++i)
+        if (vec_str_is_at(vec, i, value, SIZE))
             return i;
     return VEC_NOT_FOUND;
 }
 
-int vec_str_find_last(const VecStr* vec, const char* value) {
+ptrdiff_t vec_str_find_last(const VecStr* vec, const char* value) {
     assert_notnull(vec);
     assert_notnull(value);
-    for (int i = vec->_size - 1; i >= 0; --i)
-        if (strcmp(vec->_values[i], value) == 0)
+    const ptrdiff_t SIZE = vec->_packed ? (ptrdiff_t)strlen(value) : 0;
+    for (ptrdiff_t i = vec->_size - 1; i >= 0; --i)
+        if (vec_str_is_at(vec, i, value, SIZE))
             return i;
     return VEC_NOT_FOUND;
 }
 
 void vec_str_casesort(VecStr* vec) {
     assert_notnull(vec);
-    if (vec->_size)
-        qsort(vec->_values, vec->_size, sizeof(char*), str_strcasecmp);
+    str_array_sort_keyed(vec->_values, vec->_size, true);
+}
+
+void vec_str_casesort_stable(VecStr* vec) {
+    assert_notnull(vec);
+    str_casearray_sort_stable(vec->_values, vec->_size, NULL);
 }
 
-int vec_str_casesearch(const VecStr* vec, const char* s) {
+ptrdiff_t vec_str_casesearch(const VecStr* vec, const char* s) {
     assert_notnull(vec);
     assert_notnull(s);
     if (vec->_size) {
@@ -229,11 +533,16 @@ int vec_str_casesearch(const VecStr* vec, const char* s) {
 
 void vec_str_sort(VecStr* vec) {
     assert_notnull(vec);
-    if (vec->_size)
-        qsort(vec->_values, vec->_size, sizeof(char*), str_strcmp);
+    str_array_sort_keyed(vec->_values, vec->_size, false);
+}
+
+void vec_str_sort_parallel(VecStr* vec, int nthreads) {
+    assert_notnull(vec);
+    str_array_sort_parallel(vec->_values, vec->_size, NULL, nthreads,
+                            false);
 }
 
-int vec_str_search(const VecStr* vec, const char* s) {
+ptrdiff_t vec_str_search(const VecStr* vec, const char* s) {
     assert_notnull(vec);
     assert_notnull(s);
     if (vec->_size) {
@@ -256,7 +565,7 @@ char* vec_str_longest_common_prefix(const VecStr* vec) {
     int i = 0;
     for (; i < size; ++i) {
         char c = first[i];
-        for (int j = 1; j < vec->_size; ++j) {
+        for (ptrdiff_t j = 1; j < vec->_size; ++j) {
             char* s = vec->_values[j];
             if (((int)strlen(s)) - 1 < i || s[i] != c)
                 goto end;
@@ -291,19 +600,27 @@ char* vec_str_longest_common_path(const VecStr* vec) {
 
 char* vec_str_join(const VecStr* vec, const char* sep) {
     assert_notnull(vec);
-    const int SIZE = vec->_size;
+    const ptrdiff_t SIZE = vec->_size;
     if (!SIZE)
         return NULL; // empty
-    const int SEP_SIZE = sep ? strlen(sep) : 0;
-    int size = 0;
-    for (int i = 0; i < SIZE; ++i)
-        size += strlen(vec->_values[i]);
+    const size_t SEP_SIZE = sep ? strlen(sep) : 0;
+    size_t size = 0;
+    for (ptrdiff_t i = 0; i < SIZE; ++i)
+        size += vec->_packed ? (size_t)packed_len(vec->_values[i])
+                             : strlen(vec->_values[i]);
     size += ((SIZE - 1) * SEP_SIZE) + 1; // +1 for 0-terminator
     char* s = malloc(size);
     assert_alloc(s);
     char* p = s;
-    for (int i = 0; i < SIZE; ++i) {
-        p = stpcpy(p, vec->_values[i]);
+    for (ptrdiff_t i = 0; i < SIZE; ++i) {
+        const char* value = vec->_values[i];
+        if (vec->_packed) {
+            ptrdiff_t n = packed_len(value);
+            memcpy(p, value, n);
+            p[n] = 0; // in case this is the last
+            p += n;
+        } else
+            p = stpcpy(p, value);
         if (sep && (i + 1 < SIZE)) // avoid adding sep at the end
             p = stpncpy(p, sep, SEP_SIZE);
     }
@@ -311,103 +628,73 @@ char* vec_str_join(const VecStr* vec, const char* sep) {
 }
 
 VecStr split_str(const char* s, const char* sep) {
-    assert_notnull(s);
-    assert_notnull(sep);
-    const int SEP_SIZE = strlen(sep);
-    assert(SEP_SIZE && "can't split with empty sep");
     VecStr vec = vec_str_alloc();
-    const char* p = s;
-    while (p) {
-        const char* q = strstr(p, sep);
-        if (q) {
-            vec_str_push(&vec, strndup(p, q - p));
-            p = q + SEP_SIZE;
-        } else {
-            if (strlen(p))
-                vec_str_push(&vec, strdup(p));
-            break;
-        }
-    }
+    vec_str_append_split_str(&vec, s, sep);
     return vec;
 }
 
-static inline bool all_sep(const char* p, int sep) {
-    for (; p && *p; ++p)
-        if (sep != *p)
-            return false;
-    return true;
-}
-
 VecStr split_chr(const char* s, int sep) {
-    assert_notnull(s);
-    assert_notnull(sep);
     VecStr vec = vec_str_alloc();
-    if (all_sep(s, sep)) // ∴ empty
-        return vec;
-    const char* p = s;
-    while (p) {
-        const char* q = strchr(p, sep);
-        int size = q ? q - p : (int)strlen(p);
-        char* part = malloc(size + 1);
-        assert_alloc(part);
-        strncpy(part, p, size);
-        part[size] = 0;
-        vec_str_push(&vec, part);
-        if (q)
-            p = q + 1;
-        else
-            break;
-    }
+    vec_str_append_split_chr(&vec, s, sep);
     return vec;
 }
 
-static inline bool all_ws(const char* p) {
-    for (; p && *p; ++p)
-        if (!isspace(*p))
-            return false;
-    return true;
-}
-
 VecStr split_ws(const char* s) {
-    assert_notnull(s);
     VecStr vec = vec_str_alloc();
-    if (!*s) // empty
-        return vec;
-    if (all_ws(s)) // empty;
-        return vec;
-    const char* p = skip_ws(s); // skip leading ws
-    int size = strlen(p);
-    const char* end = p + size;
-    while (p && *p) {
-        const char* q = skip_nonws(p);
-        size = q ? q - p : (int)strlen(p);
-        char* part = malloc(size + 1);
-        assert_alloc(part);
-        strncpy(part, p, size);
-        part[size] = 0;
-        vec_str_push(&vec, part);
-        if (q) {
-            if (q >= end)
-                break;
-            p = skip_ws(q + 1);
-        } else
-            break;
-    }
+    vec_str_append_split_ws(&vec, s);
     return vec;
 }
 
+void vec_str_append_split_str(VecStr* vec, const char* s,
+                              const char* sep) {
+    vec_str_append_split(vec, str_split_str(s, sep));
+}
+
+// The parts are counted ahead (at most one more than the seps) so the
+// values grow at most once.
+void vec_str_append_split_chr(VecStr* vec, const char* s, int sep) {
+    assert_notnull(vec);
+    StrSplit split = str_split_chr(s, sep);
+    ptrdiff_t needed = vec->_size + 1 +
+                       simd_byte_count(s, strlen(s), (char)sep);
+    if (split._p && needed > vec->_cap) // no parts if empty or all sep
+        vec_str_grow(vec, needed);
+    vec_str_append_split(vec, split);
+}
+
+void vec_str_append_split_ws(VecStr* vec, const char* s) {
+    assert_notnull(vec);
+    StrSplit split = str_split_ws(s);
+    ptrdiff_t needed = vec->_size + simd_byte_count_words(s, strlen(s));
+    if (needed > vec->_cap)
+        vec_str_grow(vec, needed);
+    vec_str_append_split(vec, split);
+}
+
 VecStr file_read_lines_size(const char* filename, long long max_size,
                             bool* ok) {
     VecStr vec = vec_str_alloc();
+    file_read_lines_into(filename, max_size, ok, &vec);
+    return vec;
+}
+
+VecStr file_read_lines_packed_size(const char* filename,
+                                   long long max_size, bool* ok) {
+    VecStr vec = vec_str_alloc_packed(0);
+    file_read_lines_into(filename, max_size, ok, &vec);
+    return vec;
+}
+
+static void file_read_lines_into(const char* filename, long long max_size,
+                                 bool* ok, VecStr* vec) {
     FILE* file = fopen(filename, "rt");
     if (!file) { // failed to open
         if (ok)
             *ok = false;
         warn(NULL);
-        return vec;
+        return;
     }
-    fd_read_lines_size(filename, max_size, ok, file, &vec);
-    return vec;
+    fd_read_lines_size(filename, max_size, ok, file, vec);
 }
 
 static void fd_read_lines_size(const char* filename, long long max_size,
@@ -444,25 +731,315 @@ static void fd_read_lines_populate_vec(FILE* file, VecStr* vec) {
     const int LINE_SIZE = 1024;
     char line[LINE_SIZE];
     while (fgets(line, LINE_SIZE, file)) {
-        char* p = strrchr(line, '\n');
-        if (p)
-            *p = 0; // trim newline if present
-        vec_str_push(vec, strdup(line));
+        ptrdiff_t size = strlen(line);
+        if (size && line[size - 1] == '\n')
+            --size; // trim newline if present
+        vec_str_push_n(vec, line, size);
     }
 }
 
 void vec_str_dump(const VecStr* vec) {
     if (vec->_size)
-        for (int i = 0; i < vec->_size; ++i)
-            printf("[%d]«%s»\n", i, vec->_values[i]);
+        for (ptrdiff_t i = 0; i < vec->_size; ++i)
+            printf("[%td]«%s»\n", i, vec->_values[i]);
     else
         printf("(empty)");
 }
 
-static void vec_str_grow(VecStr* vec) {
-    int cap = vec->_cap;
-    assert((!cap && !vec->_values) || (cap && vec->_values));
-    vec->_cap = VEC_GROW_CAP(cap);
-    vec->_values = realloc(vec->_values, vec->_cap * sizeof(char*));
-    assert_alloc(vec->_values);
+static void vec_str_append_split(VecStr* vec, StrSplit split) {
+    assert_notnull(vec);
+    assert((vec->_ownership == Owns || vec->_packed) &&
+           "split parts must be owned or packed");
+    StrView part;
+    while (str_split_next(&split, &part))
+        vec_str_push_n(vec, part.p, part.n);
+}
+
+static void vec_str_grow(VecStr* vec, ptrdiff_t needed) {
+    assert((!vec->_cap && !vec->_values) || (vec->_cap && vec->_values));
+    vec_str_set_cap(vec, vec_grow_cap(&vec->_growth, vec->_cap, needed));
+}
+
+// Inline values are only ever moved to the heap to grow them.
+static void vec_str_set_cap(VecStr* vec, ptrdiff_t cap) {
+    assert(cap >= vec->_size && "can't reduce cap below size");
+    if (vec->_inline) {
+        if (cap <= vec->_cap)
+            return;
+        char** p = vec_buffer_resize(NULL, 0, 0, cap * sizeof(char*),
+                                     vec->_growth.large, &vec->_large);
+        memcpy(p, vec->_values, vec->_size * sizeof(char*));
+        vec->_values = p;
+        vec->_inline = false;
+    } else
+        vec->_values = vec_buffer_resize(vec->_values,
+                                         vec->_size * sizeof(char*),
+                                         vec->_cap * sizeof(char*),
+                                         cap * sizeof(char*),
+                                         vec->_growth.large, &vec->_large);
+    vec->_cap = cap;
+}
+
+static void vec_str_open_gap(VecStr* vec, ptrdiff_t index, ptrdiff_t n) {
+    if (!n)
+        return;
+    if (vec->_size + n > vec->_cap)
+        vec_str_grow(vec, vec->_size + n);
+    memmove(vec->_values + index + n, vec->_values + index,
+            (vec->_size - index) * sizeof(char*));
+    vec->_size += n;
+}
+
+static void vec_str_close_gap(VecStr* vec, ptrdiff_t index, ptrdiff_t n) {
+    if (!n)
+        return;
+    memmove(vec->_values + index, vec->_values + index + n,
+            (vec->_size - index - n) * sizeof(char*));
+    vec->_size -= n;
+}
+
+static void vec_str_add_many_cmp(VecStr* vec, char* const* values,
+                                 ptrdiff_t n, bool unique,
+                                 bool ignore_case) {
+    assert_notnull(vec);
+    assert(n >= 0 && "can't add a negative number of values");
+    if (!n)
+        return;
+    assert_notnull(values);
+    char** batch = malloc(n * sizeof(char*));
+    assert_alloc(batch);
+    memcpy(batch, values, n * sizeof(char*));
+    int (*cmp)(const void*, const void*) =
+        ignore_case ? str_strcasecmp : str_strcmp;
+    str_array_sort_keyed(batch, n, ignore_case);
+    if (unique)
+        n = vec_str_unique_batch(vec, batch, n, cmp);
+    if (vec->_packed)
+        for (ptrdiff_t j = 0; j < n; ++j)
+            batch[j] = vec_str_pack(vec, batch[j], strlen(batch[j]));
+    if (vec->_size + n > vec->_cap)
+        vec_str_grow(vec, vec->_size + n);
+    // Merge from the back; equal values go after those already present
+    ptrdiff_t i = vec->_size - 1;
+    ptrdiff_t k = vec->_size + n - 1;
+    for (ptrdiff_t j = n - 1; j >= 0; --k) {
+        if (i >= 0 && cmp(&vec->_values[i], &batch[j]) > 0)
+            vec->_values[k] = vec->_values[i--];
+        else
+            vec->_values[k] = batch[j--];
+    }
+    vec->_size += n;
+    free(batch);
+}
+
+// Drops (and frees if owns) values from the sorted batch that are repeats
+// or are already in the vec, and returns the batch's new size.
+static ptrdiff_t vec_str_unique_batch(const VecStr* vec, char** batch,
+                                     ptrdiff_t n,
+                                     int (*cmp)(const void*, const void*)) {
+    ptrdiff_t i = 0;
+    ptrdiff_t k = 0;
+    for (ptrdiff_t j = 0; j < n; ++j) {
+        while (i < vec->_size && cmp(&vec->_values[i], &batch[j]) < 0)
+            ++i;
+        if ((k && cmp(&batch[k - 1], &batch[j]) == 0) ||
+            (i < vec->_size && cmp(&vec->_values[i], &batch[j]) == 0)) {
+            if (vec->_ownership == Owns)
+                free(batch[j]);
+            continue;
+        }
+        batch[k++] = batch[j];
+    }
+    return k;
+}
+
+// Sorts with a multikey (three-way radix) quicksort on the values' keys
+// (see StrKey) so that common prefixes are compared 8 chars at a time
+// without re-reading the strings, and each string's chars are only
+// case-folded when its key is loaded (rather than in every comparison).
+// Like the introsort it replaces it is O(n) if the values are already
+// sorted or strictly reversed.
+static void str_array_sort_keyed(char** values, ptrdiff_t n,
+                                 bool ignore_case) {
+    int (*cmp)(const char*, const char*) =
+        ignore_case ? strcasecmp : strcmp;
+    ptrdiff_t i = 1; // already sorted or strictly reversed?
+    while (i < n && cmp(values[i], values[i - 1]) >= 0)
+        ++i;
+    if (i >= n)
+        return;
+    if (i == 1) {
+        while (i < n && cmp(values[i], values[i - 1]) < 0)
+            ++i;
+        if (i == n) {
+            for (ptrdiff_t j = 0; j < n / 2; ++j) {
+                char* t = values[j];
+                values[j] = values[n - 1 - j];
+                values[n - 1 - j] = t;
+            }
+            return;
+        }
+    }
+    StrKey* items = malloc(n * sizeof(StrKey));
+    assert_alloc(items);
+    for (ptrdiff_t j = 0; j < n; ++j)
+        items[j].value = values[j];
+    int limit = 0;
+    for (ptrdiff_t m = n; m > 1; m >>= 1)
+        limit += 2;
+    str_key_load(items, n, 0, ignore_case);
+    str_key_sort(items, n, 0, limit, ignore_case);
+    for (ptrdiff_t j = 0; j < n; ++j)
+        values[j] = items[j].value;
+    free(items);
+}
+
+// The items' keys must be loaded for depth. Each pass partitions the
+// items three ways around the median-of-three key into smaller, equal,
+// and larger parts, where the equal part (if its strings continue) is
+// sorted by keys for the next 8 chars. The two smaller parts (each at
+// most half the items) recurse and the largest loops, so the stack
+// depth is O(log n). Every partition spends one of limit (which isn't
+// reset on descent), and once it is spent the rest is comparison
+// sorted by the introsort, as are partitions of at most SORT_SMALL
+// items, so the worst case is O(n log n) key comparisons.
+static void str_key_sort(StrKey* items, ptrdiff_t n, ptrdiff_t depth,
+                         int limit, bool ignore_case) {
+    while (n > SORT_SMALL && limit--) {
+        uint64_t a = items[0].key;
+        uint64_t b = items[n / 2].key;
+        uint64_t c = items[n - 1].key;
+        uint64_t pivot = a < b ? (b < c ? b : (a < c ? c : a))
+                               : (a < c ? a : (b < c ? c : b));
+        ptrdiff_t lt = 0;
+        ptrdiff_t gt = n;
+        for (ptrdiff_t i = 0; i < gt;) {
+            uint64_t key = items[i].key;
+            if (key < pivot)
+                str_key_array_swap(&items[lt++], &items[i++]);
+            else if (key > pivot)
+                str_key_array_swap(&items[i], &items[--gt]);
+            else
+                ++i;
+        }
+        ptrdiff_t more = n - gt;
+        ptrdiff_t equal = 0; // done if its strings are all equal
+        if (STR_KEY_CONTINUES(pivot)) {
+            equal = gt - lt;
+            str_key_load(items + lt, equal, depth + sizeof(uint64_t),
+                         ignore_case);
+        }
+        if (equal > lt && equal > more) {
+            str_key_sort(items, lt, depth, limit, ignore_case);
+            str_key_sort(items + gt, more, depth, limit, ignore_case);
+            items += lt;
+            n = equal;
+            depth += sizeof(uint64_t);
+            continue;
+        }
+        if (equal)
+            str_key_sort(items + lt, equal, depth + sizeof(uint64_t), limit,
+                         ignore_case);
+        if (lt < more) {
+            str_key_sort(items, lt, depth, limit, ignore_case);
+            items += gt;
+            n = more;
+        } else {
+            str_key_sort(items + gt, more, depth, limit, ignore_case);
+            n = lt;
+        }
+    }
+    str_key_array_sort(items, n,
+                       &(StrKeyCtx){.depth = depth,
+                                    .ignore_case = ignore_case});
+}
+
+// The items' strings must all be at least depth chars long.
+static void str_key_load(StrKey* items, ptrdiff_t n, ptrdiff_t depth,
+                         bool ignore_case) {
+    for (ptrdiff_t i = 0; i < n; ++i) {
+        const unsigned char* p =
+            (const unsigned char*)items[i].value + depth;
+        uint64_t key = 0;
+        int j = 0;
+        for (; j < 8 && p[j]; ++j)
+            key = (key << 8) | (ignore_case ? tolower(p[j]) : p[j]);
+        items[i].key = j ? key << (8 * (8 - j)) : 0;
+    }
+}
+
+// Compares the chars after the ones in two equal keys at ctx's depth.
+static int str_key_tail_cmp(const StrKeyCtx* ctx, const char* s,
+                            const char* t) {
+    ptrdiff_t offset = ctx->depth + sizeof(uint64_t);
+    return ctx->ignore_case ? strcasecmp(s + offset, t + offset)
+                            : strcmp(s + offset, t + offset);
+}
+
+// Returns the value to store for a value the vec takes: a copy in the
+// arena if packed, otherwise the value itself.
+static char* vec_str_adopt(VecStr* vec, char* value) {
+    return vec->_packed ? vec_str_pack(vec, value, strlen(value)) : value;
+}
+
+// Copies the n chars at s (which may be in the arena itself since chunks
+// never move) into the arena and returns the NUL-terminated copy.
+static char* vec_str_pack(VecStr* vec, const char* s, ptrdiff_t n) {
+    assert(n < (ptrdiff_t)UINT32_MAX && "packed strings must be < 4GB");
+    ptrdiff_t needed = PACK_HEADER_SIZE + n + 1;
+    VecStrChunk* chunk = vec->_arena;
+    if (!chunk || chunk->cap - chunk->size < needed)
+        chunk = vec_str_add_chunk(vec, needed);
+    char* p = chunk->bytes + chunk->size;
+    uint32_t size = n;
+    memcpy(p, &size, PACK_HEADER_SIZE);
+    p += PACK_HEADER_SIZE;
+    memcpy(p, s, n);
+    p[n] = 0;
+    chunk->size += needed;
+    return p;
+}
+
+static VecStrChunk* vec_str_add_chunk(VecStr* vec, ptrdiff_t needed) {
+    ptrdiff_t cap = vec->_arena ? vec->_arena->cap * 2 : PACK_CHUNK_MIN;
+    cap = cap < PACK_CHUNK_MAX ? cap : PACK_CHUNK_MAX;
+    cap = cap > needed ? cap : needed;
+    VecStrChunk* chunk = malloc(sizeof(VecStrChunk) + cap);
+    assert_alloc(chunk);
+    chunk->prev = vec->_arena;
+    chunk->size = 0;
+    chunk->cap = cap;
+    vec->_arena = chunk;
+    return chunk;
+}
+
+static void vec_str_free_arena(VecStr* vec, bool keep_newest) {
+    VecStrChunk* chunk = vec->_arena;
+    if (chunk && keep_newest) {
+        chunk->size = 0;
+        chunk = chunk->prev;
+        vec->_arena->prev = NULL;
+    } else
+        vec->_arena = NULL;
+    while (chunk) {
+        VecStrChunk* prev = chunk->prev;
+        free(chunk);
+        chunk = prev;
+    }
+}
+
+static inline ptrdiff_t packed_len(const char* value) {
+    uint32_t size;
+    memcpy(&size, value - PACK_HEADER_SIZE, PACK_HEADER_SIZE);
+    return size;
+}
+
+// Returns true if the vec's value at index equals value, using the cached
+// length (which size must be) if packed.
+static inline bool vec_str_is_at(const VecStr* vec, ptrdiff_t index,
+                                 const char* value, ptrdiff_t size) {
+    const char* s = vec->_values[index];
+    if (vec->_packed)
+        return packed_len(s) == size && !memcmp(s, value, size);
+    return !strcmp(s, value);
 }
@@ -10,40 +10,102 @@
 // A vector of owned or borrowed char* values.
 // All accesses via functions, but reading `values` is okay.
 //
+// A packed VecStr (see vec_str_alloc_packed()) copies the strings added
+// to it into an arena of large chunks that it owns, so that adding a
+// string needs no malloc() and freeing the vec frees just a few chunks
+// rather than every string. Each string's length is kept with it so
+// vec_str_len() is O(1).
+//
 // To iterate:
 // ```
-// for (int i = 0; i < VEC_SIZE(vec); ++i)
+// for (ptrdiff_t i = 0; i < VEC_SIZE(vec); ++i)
 //     const char* value = VEC_GET(vec, i);
 // ```
 typedef struct VecStr {
-    int _size; // This is "end", i.e., one past the last value
-    int _cap;  // The size of the allocated array
+    ptrdiff_t _size; // This is "end", i.e., one past the last value
+    ptrdiff_t _cap;  // The size of the allocated array
     char** _values;
     Ownership _ownership;
+    VecGrowth _growth; // See VEC_SET_GROWTH()
+    bool _inline;      // _values is a caller's buffer, not on the heap
+    bool _large;       // _values is in large mode (see VecGrowth)
+    bool _packed;      // the strings are in _arena (and _ownership is
+                       // Borrows since they're not freed individually)
+    struct VecStrChunk* _arena; // packed: the newest chunk
 } VecStr;
 
+// A VecStr with room for VEC_SMALL_CAP values of its own so that it only
+// allocates its array of values if it grows beyond that, e.g., for split
+// results (see vec_str_append_split_ws()). Use the VecStr functions on
+// its vec (and free it with vec_str_free() as usual). Since the vec
+// points into the struct, initialize it in place with
+// small_vec_str_init() and don't copy or move it (by value).
+typedef struct SmallVecStr {
+    VecStr vec;
+    char* _buffer[VEC_SMALL_CAP];
+} SmallVecStr;
+
 // Allocates a new VecStr of owned char* with default capacity of 0.
 // See also vec_str_alloc_custom().
 #define vec_str_alloc() vec_str_alloc_custom(0, Owns)
 
 // Allocates a new VecStr of char* (owns if owns, otherwise borrowed)
 // with the specified capacity. See also vec_str_alloc().
-VecStr vec_str_alloc_custom(int cap, Ownership ownership);
+VecStr vec_str_alloc_custom(ptrdiff_t cap, Ownership ownership);
+
+// Returns a new empty VecStr (owns if owns, otherwise borrowed) that
+// keeps its values in the given buffer of cap char*s (which must outlive
+// it) until it needs more room, when it moves them to the heap like any
+// other VecStr.
+VecStr vec_str_alloc_inline(char** buffer, ptrdiff_t cap,
+                            Ownership ownership);
+
+// Allocates a new packed VecStr with the specified capacity; see above.
+// Every value added to it (by set, insert, push, add, replace, etc.) is
+// copied into its arena, so unlike an owning VecStr it doesn't take
+// ownership of the caller's values. Values removed (or replaced) stay in
+// the arena until the vec is cleared or freed, so those that are
+// returned (by take, pop, or replace) remain valid until then and must
+// not be freed by the caller. Read-only functions work as for any other
+// VecStr and VEC_GET() values may be used as ordinary char*s.
+VecStr vec_str_alloc_packed(ptrdiff_t cap);
+
+// Initializes small as an empty SmallVecStr (owns if owns, otherwise
+// borrowed); see above.
+void small_vec_str_init(SmallVecStr* small, Ownership ownership);
 
 // Destroys the VecStr freeing its memory and if owns, freeing every
 // value. The VecStr is not usable after this.
 void vec_str_free(VecStr* vec);
 
-// Calls free on all the VecStr's values if owns.
+// Calls free on all the VecStr's values if owns (or frees the arena if
+// packed).
 void vec_str_clear(VecStr* vec);
 
-// Returns Owns if the VecStr owns its strings, otherwise Borrows.
+// Ensures the VecStr's capacity is at least cap, e.g., before pushing a
+// known number of values.
+void vec_str_reserve(VecStr* vec, ptrdiff_t cap);
+
+// Reduces the VecStr's capacity to its size, freeing any unused memory
+// (unless its values are inline, when it does nothing).
+void vec_str_shrink_to_fit(VecStr* vec);
+
+// Resizes the VecStr to the given size, either truncating it (and freeing
+// the removed values if owns) or padding it with value (which is
+// strdup()-ed for each new value if owns).
+void vec_str_resize(VecStr* vec, ptrdiff_t size, const char* value);
+
+// Returns Owns if the VecStr owns its strings, otherwise Borrows
+// (including if packed).
 #define vec_str_ownership(vec) ((vec)->_ownership)
 
+// Returns true if the VecStr is packed (see vec_str_alloc_packed()).
+#define vec_str_is_packed(vec) ((vec)->_packed)
+
 // Returns the VecStr's value at position index.
 // VecStr retains ownership (if owns), so do not delete the value.
 // The VEC_GET() macro is faster but unchecked.
-char* vec_str_get(const VecStr* vec, int index);
+char* vec_str_get(const VecStr* vec, ptrdiff_t index);
 
 // Returns the VecStr's value at its first valid index.
 // VecStr retains ownership (if owns), so do not delete the value.
@@ -55,16 +117,46 @@ char* vec_str_get_first(const VecStr* vec);
 // The VEC_GET_LAST() macro is faster but unchecked.
 char* vec_str_get_last(const VecStr* vec);
 
+// Returns the length of the VecStr's value at position index: O(1) if
+// packed, otherwise it uses strlen().
+ptrdiff_t vec_str_len(const VecStr* vec, ptrdiff_t index);
+
 // Sets the VecStr's value at position index to the given value.
 // If owns, VecStr takes ownership of the new value (e.g., if char*
 // then use strdup()) and frees the old value.
-void vec_str_set(VecStr* vec, int index, char* value);
+void vec_str_set(VecStr* vec, ptrdiff_t index, char* value);
 
 // Inserts the value at position index and moves succeeding values up
 // (right), increasing the VecStr's size (and cap if necessary): O(n).
 // Use vec_str_add() to insert into a sorted VecStr.
 // If owns, VecStr takes ownership of the new value (e.g., use strdup()).
-void vec_str_insert(VecStr* vec, int index, char* value);
+void vec_str_insert(VecStr* vec, ptrdiff_t index, char* value);
+
+// Inserts n copies of value at position index (which may be VEC_SIZE(vec)
+// to append) and moves succeeding values up (right) in a single move,
+// increasing the VecStr's size (and cap if necessary): O(n).
+// If owns, each copy is strdup()-ed, otherwise each is the given value.
+void vec_str_insert_n(VecStr* vec, ptrdiff_t index, ptrdiff_t n,
+                      const char* value);
+
+// Inserts the n values from the values array at position index (which
+// may be VEC_SIZE(vec) to append) and moves succeeding values up (right)
+// in a single move: O(n). The values must not be in the VecStr itself.
+// If owns, VecStr takes ownership of the new values (e.g., use strdup()).
+void vec_str_insert_range(VecStr* vec, ptrdiff_t index,
+                          char* const* values, ptrdiff_t n);
+
+// Inserts all vec2's values into vec1 at position index (which may be
+// VEC_SIZE(vec1) to append): O(n). vec2 is unchanged, so if vec1 owns,
+// the inserted values are strdup()-ed.
+void vec_str_insert_vec(VecStr* vec1, ptrdiff_t index,
+                        const VecStr* vec2);
+
+// Appends the n values from the values array, increasing the VecStr's
+// size (and cap if necessary): O(n). The values must not be in the VecStr
+// itself.
+// If owns, VecStr takes ownership of the new values (e.g., use strdup()).
+void vec_str_append_array(VecStr* vec, char* const* values, ptrdiff_t n);
 
 // Adds the value in order (in a sorted vec) and moves succeeding values up
 // (right), increasing the vec's size (and cap if necessary): O(n).
@@ -77,21 +169,50 @@ void vec_str_add(VecStr* vec, char* value);
 // If owns, vec takes ownership of the new value (e.g., use strdup()).
 void vec_str_caseadd(VecStr* vec, char* value);
 
+// Adds the n values from the values array in order (in a sorted vec) by
+// sorting a copy of the array and merging it in a single pass:
+// O(n + m log m) rather than O(n·m) for m calls to vec_str_add().
+// If unique is true, values already in the vec or repeated in the array
+// are not added (and are freed if owns).
+// If owns, vec takes ownership of the new values (e.g., use strdup()).
+void vec_str_add_many(VecStr* vec, char* const* values, ptrdiff_t n,
+                      bool unique);
+
+// Like vec_str_add_many() but for a case sorted vec (and if unique is
+// true, ignoring case when looking for repeats).
+void vec_str_caseadd_many(VecStr* vec, char* const* values, ptrdiff_t n,
+                          bool unique);
+
 // Sets the VecStr's value at position index to the given value and returns
 // the old value from that position.
 // If owns, VecStr takes ownership of the new value (e.g., if char*
 // then use strdup()). The returned value is now owns by the caller (if
 // it was owns by the VecStr).
-char* vec_str_replace(VecStr* vec, int index, char* value);
+char* vec_str_replace(VecStr* vec, ptrdiff_t index, char* value);
 
 // Removes (and frees if owns) the value at the given index and closes
 // up the gap: O(n).
-void vec_str_remove(VecStr* vec, int index);
+void vec_str_remove(VecStr* vec, ptrdiff_t index);
+
+// Removes (and frees if owns) the n values from position index onwards
+// and closes up the gap in a single move: O(n).
+void vec_str_remove_range(VecStr* vec, ptrdiff_t index, ptrdiff_t n);
+
+// Removes (and frees if owns) the value at the given index by moving the
+// last value into its place, so the order is not preserved: O(1).
+void vec_str_swap_remove(VecStr* vec, ptrdiff_t index);
+
+// Keeps only the values for which pred(value, state) returns true,
+// preserving their order, and returns how many values were removed (and
+// freed if owns). Uses a single pass: O(n).
+ptrdiff_t vec_str_retain(VecStr* vec,
+                         bool (*pred)(const char* value, void* state),
+                         void* state);
 
 // Returns and removes the value at the given index and closes up the
 // gap: O(n).
 // The returned value is now owns by the caller if it was owns by VecStr.
-char* vec_str_take(VecStr* vec, int index);
+char* vec_str_take(VecStr* vec, ptrdiff_t index);
 
 // Removes and returns the last value. Only use if vec.isempty() is false.
 // The returned value is now owns by the caller if it was owns by
@@ -104,13 +225,18 @@ char* vec_str_pop(VecStr* vec);
 // char* then use strdup()).
 void vec_str_push(VecStr* vec, char* value);
 
+// Pushes a copy of the n chars at s (which needn't be NUL-terminated)
+// onto the end of the VecStr (which must own its strings or be packed):
+// O(1). The copy is strndup()-ed if owns or put in the arena if packed.
+void vec_str_push_n(VecStr* vec, const char* s, ptrdiff_t n);
+
 // Returns a copy of the VecStr (a deep copy if owns is true).
 VecStr vec_str_copy(const VecStr* vec, Ownership ownership);
 
 // Moves all vec2's values to the end of vec1's values, after which vec2 is
 // freed and must not be used again.
 // Only callable if both vecs are compatible, i.e., both are owners or both
-// are borrowers.
+// are borrowers or both are packed (when vec1 takes over vec2's arena).
 // Use case: an array of VecStr's each one of which is populated in its own
 // thread and at the end we want to merge all the VecStr's into one.
 void vec_str_merge(VecStr* vec1, VecStr* vec2);
@@ -120,27 +246,37 @@ bool vec_str_equal(const VecStr* vec1, const VecStr* vec2);
 
 // Returns the index where the value was found in the vec or
 // VEC_NOT_FOUND (-1). Uses a linear search.
-int vec_str_find(const VecStr* vec, const char* value);
+ptrdiff_t vec_str_find(const VecStr* vec, const char* value);
 
 // Returns the last index where the value was found in the vec or
 // VEC_NOT_FOUND (-1). Uses a linear search.
-int vec_str_find_last(const VecStr* vec, const char* value);
+ptrdiff_t vec_str_find_last(const VecStr* vec, const char* value);
 
 // Sorts the VecStr in-place with case-folding.
 void vec_str_casesort(VecStr* vec);
 
+// Sorts the VecStr in-place with case-folding like vec_str_casesort(),
+// but stable, i.e., values that only differ in case keep their order.
+void vec_str_casesort_stable(VecStr* vec);
+
 // Returns the index where the value was found in the vec or
 // VEC_NOT_FOUND (-1). Uses a binary search that assumes vec_str_sort() has
 // been used.
-int vec_str_casesearch(const VecStr* vec, const char* s);
+ptrdiff_t vec_str_casesearch(const VecStr* vec, const char* s);
 
 // Sorts the VecStr in-place.
 void vec_str_sort(VecStr* vec);
 
+// Sorts the VecStr in-place like vec_str_sort() but using nthreads
+// threads (or one per online CPU if nthreads <= 0). Falls back to
+// vec_str_sort() for VecStrs of fewer than SORT_PARALLEL_MIN values. See
+// sort.h.
+void vec_str_sort_parallel(VecStr* vec, int nthreads);
+
 // Returns the index where the value was found in the vec or
 // VEC_NOT_FOUND (-1). Uses a binary search that assumes vec_str_sort() has
 // been used.
-int vec_str_search(const VecStr* vec, const char* s);
+ptrdiff_t vec_str_search(const VecStr* vec, const char* s);
 
 // Returns the longest common prefix of all the strings in vec; or NULL
 // if there is no common prefix. The caller owns the returned string.
@@ -158,6 +294,9 @@ char* vec_str_join(const VecStr* vec, const char* sep);
 
 // Splits the given string on the sep string, neither of which may be
 // NULL and returns an owning VecStr (which may be empty).
+// For a lazy split that doesn't allocate (e.g., when only the first few
+// parts are wanted) see str_split_str(), str_split_chr(), and
+// str_split_ws() in str.h.
 VecStr split_str(const char* s, const char* sep);
 
 // Splits the given string (which may not be NULL) on the sep char and
@@ -168,6 +307,14 @@ VecStr split_chr(const char* s, int sep);
 // owning VecStr (which may be empty).
 VecStr split_ws(const char* s);
 
+// Like split_str(), split_chr(), and split_ws() but appending the parts
+// to vec (which must own its strings or be packed), e.g., a SmallVecStr's
+// vec so that short splits don't allocate the vec's array, or a packed
+// vec so that the parts don't each need a malloc().
+void vec_str_append_split_str(VecStr* vec, const char* s, const char* sep);
+void vec_str_append_split_chr(VecStr* vec, const char* s, int sep);
+void vec_str_append_split_ws(VecStr* vec, const char* s);
+
 // Reads a whole file (if smaller than max_size) and returns it as a
 // VecStr of lines (each an owned char*) and sets `ok` if not `NULL`.
 // See also file_read_lines().
@@ -180,5 +327,15 @@ VecStr file_read_lines_size(const char* filename, long long max_size,
 #define file_read_lines(filename, ok) \
     file_read_lines_size(filename, 1024 * 1024, ok)
 
+// Like file_read_lines_size() but returns a packed VecStr (see
+// vec_str_alloc_packed()) which for many lines uses far less memory and
+// is much faster to read and to free.
+VecStr file_read_lines_packed_size(const char* filename,
+                                   long long max_size, bool* ok);
+
+// Like file_read_lines() but returns a packed VecStr.
+#define file_read_lines_packed(filename, ok) \
+    file_read_lines_packed_size(filename, 1024 * 1024, ok)
+
 // For debugging.
 void vec_str_dump(const VecStr* vec);
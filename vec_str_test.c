@@ -12,16 +12,24 @@
 
 static void check_join(tinfo* tinfo, const VecStr* vec, const char* sep,
                        const char* expected);
-static void check_size_cap(tinfo* tinfo, const VecStr* v, int size,
-                           int cap);
+static void check_size_cap(tinfo* tinfo, const VecStr* v,
+                           ptrdiff_t size, ptrdiff_t cap);
 static void match(tinfo* tinfo, const VecStr* v, const char* expected);
 static void equal(tinfo* tinfo, const VecStr* v1, const VecStr* v2);
 static void merge_tests(tinfo*);
+static void range_tests(tinfo*);
+static void retain_tests(tinfo*);
+static void add_many_tests(tinfo*);
+static bool has_prefix(const char* value, void* state);
 static void sort_tests(tinfo*);
+static void keyed_sort_tests(tinfo*);
+static int* median_killer(int n);
 static void prefix_tests(tinfo*);
 static void test_split_chr(tinfo*);
 static void test_split_ws(tinfo*);
 static void test_read_lines(tinfo*);
+static void small_tests(tinfo*);
+static void packed_tests(tinfo*);
 
 const char* WORDS[] = {
     "One",  "Zulu",    "Victor", "Romeo",  "Sierra",   "Whiskey", "X-ray",
@@ -36,8 +44,16 @@ void vec_str_tests(tinfo* tinfo) {
         puts(tinfo->tag);
     tinfo->tag = "merge_tests";
     merge_tests(tinfo);
+    tinfo->tag = "range_tests";
+    range_tests(tinfo);
+    tinfo->tag = "retain_tests";
+    retain_tests(tinfo);
+    tinfo->tag = "add_many_tests";
+    add_many_tests(tinfo);
     tinfo->tag = "sort_tests";
     sort_tests(tinfo);
+    tinfo->tag = "keyed_sort_tests";
+    keyed_sort_tests(tinfo);
     tinfo->tag = "prefix_tests";
     prefix_tests(tinfo);
     tinfo->tag = "test_split_chr";
@@ -46,6 +62,10 @@ void vec_str_tests(tinfo* tinfo) {
     test_split_ws(tinfo);
     tinfo->tag = "test_read_lines";
     test_read_lines(tinfo);
+    tinfo->tag = "small_tests";
+    small_tests(tinfo);
+    tinfo->tag = "packed_tests";
+    packed_tests(tinfo);
 
     tinfo->tag = "vec_str_tests continued";
     if (tinfo->verbose)
@@ -204,6 +224,14 @@ void vec_str_tests(tinfo* tinfo) {
     vec_str_free(&v4);
     VecStr v5 = split_str("oneSEPtwoSEPthreeSEPfourSEPfiveSEPsix", "SEP");
     match(tinfo, &v5, "one|two|three|four|five|six");
+    vec_str_resize(&v5, 8, "x");
+    match(tinfo, &v5, "one|two|three|four|five|six|x|x");
+    vec_str_resize(&v5, 2, NULL);
+    vec_str_shrink_to_fit(&v5);
+    check_size_cap(tinfo, &v5, 2, 2);
+    match(tinfo, &v5, "one|two");
+    vec_str_reserve(&v5, 50);
+    check_size_cap(tinfo, &v5, 2, 50);
     vec_str_free(&v5);
 }
 
@@ -246,6 +274,100 @@ static void merge_tests(tinfo* tinfo) {
     vec_str_free(&v1);
 }
 
+static void range_tests(tinfo* tinfo) {
+    if (tinfo->verbose)
+        puts(tinfo->tag);
+    VecStr v1 = vec_str_alloc();
+    char* words[] = {strdup("one"), strdup("two"), strdup("three")};
+    vec_str_append_array(&v1, words, 3); // v1 now owns the words
+    match(tinfo, &v1, "one|two|three");
+    vec_str_insert_n(&v1, 1, 2, "x");
+    match(tinfo, &v1, "one|x|x|two|three");
+    check_bool_eq(tinfo, VEC_GET(&v1, 1) != VEC_GET(&v1, 2), true);
+    char* more[] = {strdup("four"), strdup("five")};
+    vec_str_insert_range(&v1, VEC_SIZE(&v1), more, 2);
+    match(tinfo, &v1, "one|x|x|two|three|four|five");
+    vec_str_remove_range(&v1, 1, 2); // frees the x's
+    match(tinfo, &v1, "one|two|three|four|five");
+
+    VecStr v2 = vec_str_alloc_custom(0, Borrows);
+    vec_str_insert_vec(&v2, 0, &v1);
+    vec_str_insert_n(&v2, 2, 3, "y");
+    match(tinfo, &v2, "one|two|y|y|y|three|four|five");
+    check_bool_eq(tinfo, VEC_GET(&v2, 2) == VEC_GET(&v2, 4), true);
+    check_bool_eq(tinfo, VEC_GET(&v2, 0) == VEC_GET(&v1, 0), true);
+    vec_str_remove_range(&v2, 2, 3); // borrowed so not freed
+    equal(tinfo, &v1, &v2);
+    vec_str_remove_range(&v2, 0, VEC_SIZE(&v2));
+    check_size_cap(tinfo, &v2, 0, VEC_INITIAL_CAP);
+
+    VecStr v3 = vec_str_alloc();
+    vec_str_push(&v3, strdup("zero"));
+    vec_str_insert_vec(&v3, 0, &v1); // v3 owns strdup()-ed copies
+    check_bool_eq(tinfo, VEC_GET(&v3, 0) != VEC_GET(&v1, 0), true);
+    vec_str_remove(&v3, 1);
+    vec_str_insert(&v3, 0, strdup("six"));
+    match(tinfo, &v3, "six|one|three|four|five|zero");
+    vec_str_free(&v3);
+    vec_str_free(&v2);
+    vec_str_free(&v1);
+}
+
+static void retain_tests(tinfo* tinfo) {
+    if (tinfo->verbose)
+        puts(tinfo->tag);
+    VecStr v1 = split_str("tea toast coffee tonic juice tap", " ");
+    check_int_eq(tinfo, vec_str_retain(&v1, has_prefix, "t"), 2);
+    match(tinfo, &v1, "tea|toast|tonic|tap");
+    vec_str_swap_remove(&v1, 1);
+    match(tinfo, &v1, "tea|tap|tonic");
+
+    VecStr v2 = vec_str_copy(&v1, Borrows);
+    check_int_eq(tinfo, vec_str_retain(&v2, has_prefix, "to"), 2);
+    match(tinfo, &v2, "tonic");
+    vec_str_swap_remove(&v2, 0);
+    check_size_cap(tinfo, &v2, 0, 3);
+    match(tinfo, &v1, "tea|tap|tonic"); // v2 borrowed so v1 unchanged
+    check_int_eq(tinfo, vec_str_retain(&v1, has_prefix, "x"), 3);
+    check_size_cap(tinfo, &v1, 0, VEC_INITIAL_CAP);
+    vec_str_free(&v2);
+    vec_str_free(&v1);
+}
+
+static void add_many_tests(tinfo* tinfo) {
+    if (tinfo->verbose)
+        puts(tinfo->tag);
+    VecStr v1 = vec_str_alloc();
+    vec_str_add(&v1, strdup("delta"));
+    vec_str_add(&v1, strdup("bravo"));
+    char* a[] = {strdup("echo"), strdup("alpha"), strdup("charlie"),
+                 strdup("bravo")};
+    vec_str_add_many(&v1, a, 4, false);
+    match(tinfo, &v1, "alpha|bravo|bravo|charlie|delta|echo");
+    char* b[] = {strdup("golf"), strdup("alpha"), strdup("foxtrot"),
+                 strdup("golf")};
+    vec_str_add_many(&v1, b, 4, true); // frees the extra alpha and golf
+    match(tinfo, &v1, "alpha|bravo|bravo|charlie|delta|echo|foxtrot|golf");
+    check_size_cap(tinfo, &v1, 8, VEC_INITIAL_CAP);
+
+    VecStr v2 = vec_str_alloc_custom(0, Borrows);
+    vec_str_caseadd(&v2, "Delta");
+    vec_str_caseadd(&v2, "alpha");
+    vec_str_caseadd(&v2, "Charlie");
+    match(tinfo, &v2, "alpha|Charlie|Delta");
+    char* c[] = {"bravo", "ALPHA", "echo", "delta", "Echo"};
+    vec_str_caseadd_many(&v2, c, 5, true);
+    match(tinfo, &v2, "alpha|bravo|Charlie|Delta|echo");
+    vec_str_caseadd_many(&v2, c, 2, false);
+    match(tinfo, &v2, "alpha|ALPHA|bravo|bravo|Charlie|Delta|echo");
+    vec_str_free(&v2);
+    vec_str_free(&v1);
+}
+
+static bool has_prefix(const char* value, void* state) {
+    return str_begins(value, (const char*)state);
+}
+
 static void sort_tests(tinfo* tinfo) {
     if (tinfo->verbose)
         puts(tinfo->tag);
@@ -349,10 +471,125 @@ static void sort_tests(tinfo* tinfo) {
     index = vec_str_casesearch(&v2, "delta");
     check_found(tinfo, index, 5);
 
+    VecStr v3 = split_str("b B a A c C d D e E f F g G h H i I j J k K l L "
+                          "m M n N o O p P q Q r R s S t T u U v V",
+                          " ");
+    vec_str_casesort_stable(&v3);
+    match(tinfo, &v3,
+          "a|A|b|B|c|C|d|D|e|E|f|F|g|G|h|H|i|I|j|J|k|K|l|L|m|M|n|N|o|O|p|"
+          "P|q|Q|r|R|s|S|t|T|u|U|v|V");
+    vec_str_casesort_stable(&v3); // already sorted
+    check_str_eq(tinfo, VEC_GET(&v3, 1), "A");
+
+    const int N = 100000;
+    VecStr v4 = vec_str_alloc_custom(N, Owns);
+    char buf[16];
+    for (int i = 0; i < N; ++i) {
+        snprintf(buf, sizeof(buf), "s%d", (i * 7919) % 10007);
+        vec_str_push(&v4, strdup(buf));
+    }
+    VecStr v5 = vec_str_copy(&v4, Borrows);
+    vec_str_sort(&v4);
+    vec_str_sort_parallel(&v5, 3);
+    equal(tinfo, &v4, &v5);
+
+    vec_str_free(&v5);
+    vec_str_free(&v4);
+    vec_str_free(&v3);
     vec_str_free(&v2);
     vec_str_free(&v1);
 }
 
+// Path-like strings with long shared prefixes, some prefixes of others,
+// differing in case, or with non-ASCII chars, plus duplicates and empty
+// strings, sorted and checked against qsort().
+static void keyed_sort_tests(tinfo* tinfo) {
+    if (tinfo->verbose)
+        puts(tinfo->tag);
+    const char* PARTS[] = {"usr",   "Usr",  "local", "lib",  "LIB", "",
+                           "share", "\xc3\xa9t\xc3\xa9", "a",    "libx"};
+    const int N = 20000;
+    VecStr v1 = vec_str_alloc_custom(N, Owns);
+    char buf[128];
+    uint32_t seed = 17;
+    for (int i = 0; i < N; ++i) {
+        char* p = buf;
+        int parts = 1 + i % 7;
+        for (int j = 0; j < parts; ++j) {
+            seed = seed * 1103515245 + 12345;
+            p += sprintf(p, "/%s", PARTS[(seed >> 16) % 10]);
+        }
+        if (i % 5 == 0)
+            p += sprintf(p, "%d", (int)(seed >> 20) % 50);
+        vec_str_push(&v1, strdup(i % 97 ? buf : ""));
+    }
+    VecStr v2 = vec_str_copy(&v1, Borrows);
+    VecStr v3 = vec_str_copy(&v1, Borrows);
+    qsort(v2._values, N, sizeof(char*), str_strcmp);
+    vec_str_sort(&v1);
+    equal(tinfo, &v1, &v2);
+    vec_str_sort(&v1); // already sorted
+    equal(tinfo, &v1, &v2);
+    vec_str_casesort(&v3);
+    bool ok = true;
+    for (ptrdiff_t i = 1; i < N; ++i)
+        ok &= strcasecmp(VEC_GET(&v3, i - 1), VEC_GET(&v3, i)) <= 0;
+    check_bool_eq(tinfo, ok, true);
+    vec_str_sort(&v3);
+    equal(tinfo, &v3, &v2);
+    vec_str_free(&v3);
+    vec_str_free(&v2);
+    vec_str_free(&v1);
+
+    // Distinct keys that defeat the median-of-three every time would be
+    // quadratic (with a deep recursion) but for the introsort fallback.
+    const int M = 100000;
+    int* ranks = median_killer(M);
+    v1 = vec_str_alloc_custom(M, Owns);
+    for (int i = 0; i < M; ++i) {
+        sprintf(buf, "%08d", ranks[i]);
+        vec_str_push(&v1, strdup(buf));
+    }
+    vec_str_sort(&v1);
+    ok = true;
+    for (int i = 0; i < M; ++i) {
+        sprintf(buf, "%08d", i);
+        ok &= str_eq(VEC_GET(&v1, i), buf);
+    }
+    check_bool_eq(tinfo, ok, true);
+    vec_str_free(&v1);
+    free(ranks);
+}
+
+// Returns the ranks (0 to n - 1) of an arrangement that makes each of
+// vec_str.c's keyed-sort partitions take the second smallest key as its
+// pivot. Each partition's first and middle items are given the next two
+// ranks (leaving the last item larger than both), and the partition's
+// swaps then leave its larger part as its items from the fourth on,
+// with the third item in the middle item's place and the second at the
+// end, so one slot array can follow the items through every partition.
+static int* median_killer(int n) {
+    int* slots = malloc(2 * n * sizeof(int)); // the items' first indexes
+    int* ranks = malloc(n * sizeof(int));
+    for (int i = 0; i < n; ++i) {
+        slots[i] = i;
+        ranks[i] = -1;
+    }
+    int rank = 0;
+    for (int head = 0, tail = n; tail - head > 3; head += 3) {
+        int mid = head + (tail - head) / 2;
+        ranks[slots[head]] = rank++;
+        ranks[slots[mid]] = rank++;
+        slots[mid] = slots[head + 2];
+        slots[tail++] = slots[head + 1];
+    }
+    for (int i = 0; i < n; ++i)
+        if (ranks[i] < 0)
+            ranks[i] = rank++;
+    free(slots);
+    return ranks;
+}
+
 static void prefix_tests(tinfo* tinfo) {
     if (tinfo->verbose)
         puts(tinfo->tag);
@@ -642,24 +879,135 @@ static void test_read_lines(tinfo* tinfo) {
     vec_str_free(&vec);
 }
 
+static void small_tests(tinfo* tinfo) {
+    if (tinfo->verbose)
+        puts(tinfo->tag);
+    SmallVecStr small;
+    small_vec_str_init(&small, Owns);
+    VecStr* v1 = &small.vec;
+    check_size_cap(tinfo, v1, 0, VEC_SMALL_CAP);
+    vec_str_append_split_ws(v1, "  one two\tthree  ");
+    match(tinfo, v1, "one|two|three");
+    vec_str_append_split_chr(v1, "four,five", ',');
+    vec_str_append_split_str(v1, "sixSEPseven", "SEP");
+    match(tinfo, v1, "one|two|three|four|five|six|seven");
+    check_size_cap(tinfo, v1, 7, VEC_SMALL_CAP);
+    check_bool_eq(tinfo, v1->_values == small._buffer, true);
+    vec_str_clear(v1);
+    vec_str_append_split_ws(v1, "a b c d e f g h i j");
+    check_bool_eq(tinfo, v1->_values == small._buffer, false);
+    check_size_cap(tinfo, v1, 10, 2 * VEC_SMALL_CAP);
+    match(tinfo, v1, "a|b|c|d|e|f|g|h|i|j");
+    vec_str_free(v1);
+    check_size_cap(tinfo, v1, 0, 0);
+
+    // Borrowing, with a caller's buffer, then merged
+    char* buffer[2];
+    VecStr v2 = vec_str_alloc_inline(buffer, 2, Borrows);
+    vec_str_push(&v2, "x");
+    vec_str_push(&v2, "y");
+    check_bool_eq(tinfo, v2._values == buffer, true);
+    VecStr v3 = vec_str_alloc_custom(0, Borrows);
+    vec_str_push(&v3, "w");
+    vec_str_merge(&v3, &v2);
+    match(tinfo, &v3, "w|x|y");
+    check_size_cap(tinfo, &v2, 0, 0);
+    vec_str_free(&v3);
+}
+
+static void packed_tests(tinfo* tinfo) {
+    if (tinfo->verbose)
+        puts(tinfo->tag);
+    VecStr v1 = vec_str_alloc_packed(0);
+    check_bool_eq(tinfo, vec_str_is_packed(&v1), true);
+    char word[] = "delta";
+    vec_str_push(&v1, word); // copied, so word stays the caller's
+    word[0] = 'D';
+    vec_str_append_split_ws(&v1, " alpha  charlie\tbravo ");
+    vec_str_push_n(&v1, "echoes", 4);
+    match(tinfo, &v1, "delta|alpha|charlie|bravo|echo");
+    check_int_eq(tinfo, vec_str_len(&v1, 2), 7);
+    check_int_eq(tinfo, vec_str_len(&v1, 4), 4);
+    check_int_eq(tinfo, vec_str_find(&v1, "bravo"), 3);
+    check_int_eq(tinfo, vec_str_find(&v1, "brav"), VEC_NOT_FOUND);
+    check_int_eq(tinfo, vec_str_find_last(&v1, "delta"), 0);
+    // Removed values stay in the arena until it is cleared or freed
+    char* old = vec_str_replace(&v1, 0, "foxtrot");
+    check_str_eq(tinfo, old, "delta");
+    char* last = vec_str_pop(&v1);
+    check_str_eq(tinfo, last, "echo");
+    vec_str_insert(&v1, 1, VEC_GET(&v1, 0)); // a value of its own
+    vec_str_insert_n(&v1, 0, 2, "golf");
+    vec_str_sort(&v1);
+    match(tinfo, &v1, "alpha|bravo|charlie|foxtrot|foxtrot|golf|golf");
+    check_int_eq(tinfo, vec_str_search(&v1, "charlie"), 2);
+    vec_str_add(&v1, "delta");
+    vec_str_add_many(&v1, (char*[]){"echo", "alpha", "hotel"}, 3, true);
+    match(tinfo, &v1,
+          "alpha|bravo|charlie|delta|echo|foxtrot|foxtrot|golf|golf|"
+          "hotel");
+    check_int_eq(tinfo, vec_str_len(&v1, 9), 5);
+
+    // Strings longer than a chunk get a chunk of their own
+    VecStr v2 = vec_str_alloc_packed(0);
+    char* big = malloc(10001);
+    memset(big, 'x', 10000);
+    big[10000] = 0;
+    for (int i = 0; i < 3; ++i) {
+        vec_str_push(&v2, "small");
+        vec_str_push(&v2, big);
+    }
+    check_int_eq(tinfo, vec_str_len(&v2, 5), 10000);
+    check_bool_eq(tinfo, strcmp(VEC_GET(&v2, 3), big) == 0, true);
+    check_str_eq(tinfo, VEC_GET(&v2, 4), "small");
+    free(big);
+    VecStr v3 = vec_str_copy(&v2, Owns);
+    check_bool_eq(tinfo, vec_str_is_packed(&v3), false);
+    check_bool_eq(tinfo, vec_str_equal(&v2, &v3), true);
+    vec_str_free(&v3);
+
+    vec_str_merge(&v1, &v2); // v1 takes over v2's arena
+    check_int_eq(tinfo, VEC_SIZE(&v1), 16);
+    check_int_eq(tinfo, vec_str_len(&v1, 15), 10000);
+    check_int_eq(tinfo, vec_str_find(&v1, "small"), 10);
+    VecStr v4 = split_chr("alpha,bravo,charlie", ',');
+    vec_str_remove_range(&v1, 3, 13);
+    equal(tinfo, &v1, &v4);
+    vec_str_clear(&v1);
+    vec_str_resize(&v1, 3, "x");
+    match(tinfo, &v1, "x|x|x");
+    vec_str_free(&v4);
+    vec_str_free(&v1);
+    check_size_cap(tinfo, &v1, 0, 0);
+
+    bool ok;
+    VecStr v5 = file_read_lines_packed("st.sh", &ok);
+    VecStr v6 = file_read_lines("st.sh", &ok);
+    check_bool_eq(tinfo, vec_str_is_packed(&v5), true);
+    equal(tinfo, &v5, &v6);
+    check_int_eq(tinfo, vec_str_len(&v5, 7), 6);
+    vec_str_free(&v6);
+    vec_str_free(&v5);
+}
+
 static void match(tinfo* tinfo, const VecStr* v, const char* expected) {
     char* out = vec_str_join(v, "|");
     check_str_eq(tinfo, out, expected);
     free(out);
 }
 
-static void check_size_cap(tinfo* tinfo, const VecStr* v, int size,
-                           int cap) {
+static void check_size_cap(tinfo* tinfo, const VecStr* v,
+                           ptrdiff_t size, ptrdiff_t cap) {
     tinfo->total++;
     if (VEC_SIZE(v) != size)
-        WARN("FAIL: %s VEC_SIZE() expected %d != %d\n", tinfo->tag, size,
+        WARN("FAIL: %s VEC_SIZE() expected %td != %td\n", tinfo->tag, size,
              VEC_SIZE(v));
     else
         tinfo->ok++;
 
     tinfo->total++;
     if (VEC_ISEMPTY(v) != (size == 0))
-        WARN("FAIL: %s vec_stry_isempty() expected %s != %s size=%d\n",
+        WARN("FAIL: %s vec_stry_isempty() expected %s != %s size=%td\n",
              tinfo->tag, bool_to_str(size == 0),
              bool_to_str(VEC_ISEMPTY(v)), size);
     else
@@ -667,7 +1015,7 @@ static void check_size_cap(tinfo* tinfo, const VecStr* v, int size,
 
     tinfo->total++;
     if (VEC_CAP(v) != cap)
-        WARN("FAIL: %s VEC_CAP() expected %d != %d\n", tinfo->tag, cap,
+        WARN("FAIL: %s VEC_CAP() expected %td != %td\n", tinfo->tag, cap,
              VEC_CAP(v));
     else
         tinfo->ok++;
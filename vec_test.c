@@ -14,13 +14,19 @@
 #pragma GCC diagnostic ignored "-Woverride-init"
 #pragma GCC diagnostic push
 
-static void check_size_cap(tinfo* tinfo, const Vec* v, int size, int cap);
+static void check_size_cap(tinfo* tinfo, const Vec* v, ptrdiff_t size,
+                           ptrdiff_t cap);
 static void match(tinfo* tinfo, const Vec* v, const char* expected);
 static void equal(tinfo* tinfo, const Vec* v1, const Vec* v2, bool same);
 static void merge_tests(tinfo*);
 static void sort_tests(tinfo*);
 static void misc_tests(tinfo* tinfo);
+static void range_tests(tinfo* tinfo);
+static bool has_odd_id(const void* value, void* state);
+static void add_many_tests(tinfo* tinfo);
 static void misc_test2(tinfo* tinfo, const Vec* v1);
+static void sort_by_key_tests(tinfo* tinfo);
+static uint64_t tag_id_key(const void* value);
 
 void vec_tests(tinfo* tinfo) {
     if (tinfo->verbose)
@@ -28,6 +34,9 @@ void vec_tests(tinfo* tinfo) {
     merge_tests(tinfo);
     sort_tests(tinfo);
     misc_tests(tinfo);
+    range_tests(tinfo);
+    add_many_tests(tinfo);
+    sort_by_key_tests(tinfo);
 }
 
 static void misc_tests(tinfo* tinfo) {
@@ -155,6 +164,19 @@ static void misc_tests(tinfo* tinfo) {
     vec_remove(&v1, 0);
     check_size_cap(tinfo, &v1, 0, 10);
 
+    Tag* t3 = tag_alloc("Zz#999", 999); // borrowed name; only copied
+    vec_resize(&v1, 3, t3, tag_copy);
+    free(t3);
+    check_size_cap(tinfo, &v1, 3, 10);
+    match(tinfo, &v1, "Zz#999|Zz#999|Zz#999");
+    vec_resize(&v1, 1, NULL, NULL);
+    vec_shrink_to_fit(&v1);
+    check_size_cap(tinfo, &v1, 1, 1);
+    match(tinfo, &v1, "Zz#999");
+    vec_reserve(&v1, 10);
+    vec_remove(&v1, 0);
+    check_size_cap(tinfo, &v1, 0, 10);
+
     vec_clear(&v1);
     check_size_cap(tinfo, &v1, 0, 10);
     vec_free(&v1);
@@ -175,6 +197,111 @@ static void misc_test2(tinfo* tinfo, const Vec* v1) {
     vec_free(&v3);
 }
 
+static void range_tests(tinfo* tinfo) {
+    tinfo->tag = "vec_tests range_tests";
+    if (tinfo->verbose)
+        puts(tinfo->tag);
+    tag_make(true);
+    Vec v1 = vec_alloc(0, tag_cmp, tag_free);
+    Tag* tags[] = {tag_make(false), tag_make(false), tag_make(false)};
+    vec_append_array(&v1, (void* const*)tags, 3); // v1 now owns the tags
+    match(tinfo, &v1, "Aa#100|Ab#101|Ac#102");
+    Tag key = tag_make_key("x");
+    vec_insert_n(&v1, 1, 2, &key, tag_copy);
+    match(tinfo, &v1, "Aa#100|x|x|Ab#101|Ac#102");
+    Tag* more[] = {tag_make(false), tag_make(false)};
+    vec_insert_range(&v1, VEC_SIZE(&v1), (void* const*)more, 2);
+    match(tinfo, &v1, "Aa#100|x|x|Ab#101|Ac#102|Ad#103|Ae#104");
+    vec_remove_range(&v1, 1, 2); // destroys and frees the x's
+    match(tinfo, &v1, "Aa#100|Ab#101|Ac#102|Ad#103|Ae#104");
+    check_size_cap(tinfo, &v1, 5, VEC_INITIAL_CAP);
+
+    Vec v2 = vec_alloc(0, tag_cmp, tag_free);
+    vec_push(&v2, tag_make(false));
+    vec_insert_vec(&v2, 0, &v1, tag_copy);
+    match(tinfo, &v2, "Aa#100|Ab#101|Ac#102|Ad#103|Ae#104|Af#105");
+    check_bool_eq(tinfo, VEC_GET(&v2, 0) != VEC_GET(&v1, 0), true);
+    vec_remove_range(&v2, 2, 3);
+    match(tinfo, &v2, "Aa#100|Ab#101|Af#105");
+    Tag* tag = vec_take(&v2, 0);
+    check_str_eq(tinfo, tag->name, "Aa#100");
+    vec_insert(&v2, 1, tag);
+    match(tinfo, &v2, "Ab#101|Aa#100|Af#105");
+    vec_remove_range(&v2, 0, VEC_SIZE(&v2));
+    check_size_cap(tinfo, &v2, 0, VEC_INITIAL_CAP);
+    vec_free(&v2);
+
+    int calls = 0;
+    check_int_eq(tinfo, vec_retain(&v1, has_odd_id, &calls), 3);
+    check_int_eq(tinfo, calls, 5);
+    match(tinfo, &v1, "Ab#101|Ad#103");
+    vec_push(&v1, tag_make(false));
+    vec_swap_remove(&v1, 0);
+    match(tinfo, &v1, "Ag#106|Ad#103");
+    vec_free(&v1);
+}
+
+static void add_many_tests(tinfo* tinfo) {
+    tinfo->tag = "vec_tests add_many_tests";
+    if (tinfo->verbose)
+        puts(tinfo->tag);
+    Vec v1 = vec_alloc(0, tag_cmp, tag_free);
+    vec_add(&v1, tag_alloc(strdup("m"), 1));
+    vec_add(&v1, tag_alloc(strdup("c"), 2));
+    Tag* a[] = {tag_alloc(strdup("x"), 3), tag_alloc(strdup("a"), 4),
+                tag_alloc(strdup("m"), 5)};
+    vec_add_many(&v1, (void* const*)a, 3, false);
+    match(tinfo, &v1, "a|c|m|m|x");
+    // equal values go after those already present
+    check_int_eq(tinfo, ((Tag*)VEC_GET(&v1, 3))->id, 5);
+    Tag* b[] = {tag_alloc(strdup("c"), 6), tag_alloc(strdup("d"), 7),
+                tag_alloc(strdup("d"), 8)};
+    vec_add_many(&v1, (void* const*)b, 3, true); // frees c and one d
+    match(tinfo, &v1, "a|c|d|m|m|x");
+    check_int_eq(tinfo, ((Tag*)VEC_GET(&v1, 1))->id, 2);
+    vec_free(&v1);
+}
+
+// Names are the push order, so stability means equal ids keep their
+// names in order. Small sizes use the fallback comparison sort.
+static void sort_by_key_tests(tinfo* tinfo) {
+    if (tinfo->verbose)
+        puts(tinfo->tag);
+    const int SIZES[] = {0, 1, 10, 1000};
+    for (int s = 0; s < (int)(sizeof(SIZES) / sizeof(SIZES[0])); ++s) {
+        Vec v1 = vec_alloc(SIZES[s], tag_cmp, tag_free);
+        char name[16];
+        for (int i = 0; i < SIZES[s]; ++i) {
+            snprintf(name, sizeof(name), "n%04d", i);
+            long id = (i * 7919L) % 101 - 50;
+            if (i % 97 == 1)
+                id = i % 2 ? -3000000000L : 3000000000L;
+            vec_push(&v1, tag_alloc(strdup(name), id));
+        }
+        vec_sort_by_key(&v1, tag_id_key);
+        check_int_eq(tinfo, VEC_SIZE(&v1), SIZES[s]);
+        bool ok = true;
+        for (int i = 1; i < VEC_SIZE(&v1); ++i) {
+            const Tag* a = VEC_GET(&v1, i - 1);
+            const Tag* b = VEC_GET(&v1, i);
+            if (a->id > b->id ||
+                (a->id == b->id && strcmp(a->name, b->name) > 0))
+                ok = false;
+        }
+        check_bool_eq(tinfo, ok, true);
+        vec_free(&v1);
+    }
+}
+
+static uint64_t tag_id_key(const void* value) {
+    return (uint64_t)((const Tag*)value)->id ^ (UINT64_C(1) << 63);
+}
+
+static bool has_odd_id(const void* value, void* state) {
+    ++*(int*)state;
+    return ((const Tag*)value)->id % 2;
+}
+
 static void merge_tests(tinfo* tinfo) {
     if (tinfo->verbose)
         puts(tinfo->tag);
@@ -305,8 +432,44 @@ static void sort_tests(tinfo* tinfo) {
     match(tinfo, &v1,
           "Aa#000|Aa#001|Aa#100|Ab#101|Ac#102|Ad#103|Ae#005|Ae#104|"
           "Af#200|Af#200|Ww#888|Zz#999|zz#999");
-
     vec_free(&v1);
+
+    Vec v2 = vec_alloc(0, tag_cmp, tag_free);
+    const char* NAMES = "mdkbqxacnmdkbq";
+    for (int i = 0; i < 40; ++i) {
+        char name[2] = {NAMES[i % 14], 0};
+        vec_push(&v2, tag_alloc(strdup(name), i));
+    }
+    vec_sort_stable(&v2);
+    bool ok = true;
+    for (int i = 1; i < VEC_SIZE(&v2); ++i) {
+        const Tag* a = VEC_GET(&v2, i - 1);
+        const Tag* b = VEC_GET(&v2, i);
+        int c = strcmp(a->name, b->name);
+        if (c > 0 || (c == 0 && a->id > b->id))
+            ok = false;
+    }
+    check_bool_eq(tinfo, ok, true);
+    vec_free(&v2);
+
+    // Stable, so must match vec_sort_stable() exactly
+    const int N = 100000;
+    Vec v3 = vec_alloc(N, tag_cmp, tag_free);
+    for (int i = 0; i < N; ++i) {
+        char name[2] = {NAMES[(i * 7) % 14], 0};
+        vec_push(&v3, tag_alloc(strdup(name), i));
+    }
+    vec_sort_parallel(&v3, 4);
+    ok = true;
+    for (int i = 1; i < VEC_SIZE(&v3); ++i) {
+        const Tag* a = VEC_GET(&v3, i - 1);
+        const Tag* b = VEC_GET(&v3, i);
+        int c = strcmp(a->name, b->name);
+        if (c > 0 || (c == 0 && a->id > b->id))
+            ok = false;
+    }
+    check_bool_eq(tinfo, ok, true);
+    vec_free(&v3);
 }
 
 static void match(tinfo* tinfo, const Vec* v, const char* expected) {
@@ -321,17 +484,18 @@ static void match(tinfo* tinfo, const Vec* v, const char* expected) {
     check_str_eq(tinfo, &buf[0], expected);
 }
 
-static void check_size_cap(tinfo* tinfo, const Vec* v, int size, int cap) {
+static void check_size_cap(tinfo* tinfo, const Vec* v, ptrdiff_t size,
+                           ptrdiff_t cap) {
     tinfo->total++;
     if (VEC_SIZE(v) != size)
-        WARN("FAIL: %s VEC_SIZE() expected %d != %d\n", tinfo->tag, size,
+        WARN("FAIL: %s VEC_SIZE() expected %td != %td\n", tinfo->tag, size,
              VEC_SIZE(v));
     else
         tinfo->ok++;
 
     tinfo->total++;
     if (VEC_ISEMPTY(v) != (size == 0))
-        WARN("FAIL: %s VEC_ISEMPTY() expected %s != %s size=%d\n",
+        WARN("FAIL: %s VEC_ISEMPTY() expected %s != %s size=%td\n",
              tinfo->tag, bool_to_str(size == 0),
              bool_to_str(VEC_ISEMPTY(v)), size);
     else
@@ -339,7 +503,7 @@ static void check_size_cap(tinfo* tinfo, const Vec* v, int size, int cap) {
 
     tinfo->total++;
     if (VEC_CAP(v) != cap)
-        WARN("FAIL: %s VEC_CAP() expected %d != %d\n", tinfo->tag, cap,
+        WARN("FAIL: %s VEC_CAP() expected %td != %td\n", tinfo->tag, cap,
              VEC_CAP(v));
     else
         tinfo->ok++;
@@ -0,0 +1,465 @@
+// Copyright © 2024-25 Mark Summerfield. All rights reserved.
+// License: GPL-3
+
+#include "vec_val.h"
+#include <stdlib.h>
+#include <string.h>
+
+static void vec_val_grow(VecVal* vec, ptrdiff_t needed);
+static void vec_val_set_cap(VecVal* vec, ptrdiff_t cap);
+static void vec_val_open_gap(VecVal* vec, ptrdiff_t index, ptrdiff_t n);
+static void vec_val_close_gap(VecVal* vec, ptrdiff_t index, ptrdiff_t n);
+static ptrdiff_t vec_val_unique_batch(const VecVal* vec, char* batch,
+                                     ptrdiff_t n);
+
+VecVal vec_val_alloc(ptrdiff_t cap, int elem_size,
+                     int (*cmp)(const void*, const void*),
+                     void (*destroy)(void* value)) {
+    assert(cmp && "must provide a cmp function");
+    assert(elem_size > 0 && "must provide a positive elem_size");
+    cap = cap > 0 ? cap : 0;
+    char* values = NULL;
+    if (cap) {
+        values = malloc(cap * elem_size);
+        assert_alloc(values);
+    }
+    return (VecVal){._size = 0,
+                    ._cap = cap,
+                    ._elem_size = elem_size,
+                    ._values = values,
+                    ._cmp = cmp,
+                    ._destroy = destroy,
+                    ._growth = VEC_GROWTH_DEFAULT};
+}
+
+void vec_val_free(VecVal* vec) {
+    assert_notnull(vec);
+    vec_val_clear(vec);
+    vec_buffer_free(vec->_values, (size_t)vec->_cap * vec->_elem_size,
+                    vec->_large);
+    vec->_values = NULL;
+    vec->_cap = 0;
+    vec->_large = false;
+    vec->_destroy = NULL;
+}
+
+void vec_val_clear(VecVal* vec) {
+    assert_notnull(vec);
+    if (vec->_destroy)
+        for (ptrdiff_t i = 0; i < vec->_size; ++i)
+            vec->_destroy(VEC_VAL_GET(vec, i)); // contents only
+    vec->_size = 0;
+}
+
+void vec_val_reserve(VecVal* vec, ptrdiff_t cap) {
+    assert_notnull(vec);
+    if (cap > vec->_cap)
+        vec_val_set_cap(vec, cap);
+}
+
+void vec_val_shrink_to_fit(VecVal* vec) {
+    assert_notnull(vec);
+    if (vec->_cap > vec->_size)
+        vec_val_set_cap(vec, vec->_size);
+}
+
+void vec_val_resize(VecVal* vec, ptrdiff_t size, const void* value,
+                    void (*cpy)(void* dst, const void* src)) {
+    assert_notnull(vec);
+    assert(size >= 0 && "can't resize to a negative size");
+    if (size < vec->_size) {
+        if (vec->_destroy)
+            for (ptrdiff_t i = size; i < vec->_size; ++i)
+                vec->_destroy(VEC_VAL_GET(vec, i));
+    } else if (size > vec->_size) {
+        assert_notnull(value);
+        if (size > vec->_cap)
+            vec_val_grow(vec, size);
+        for (ptrdiff_t i = vec->_size; i < size; ++i) {
+            if (cpy)
+                cpy(VEC_VAL_GET(vec, i), value);
+            else
+                memcpy(VEC_VAL_GET(vec, i), value, vec->_elem_size);
+        }
+    }
+    vec->_size = size;
+}
+
+void* vec_val_get(const VecVal* vec, ptrdiff_t index) {
+    assert_notnull(vec);
+    assert_nonempty(vec);
+    assert_valid_index(vec, index);
+    return VEC_VAL_GET(vec, index);
+}
+
+inline void* vec_val_get_first(const VecVal* vec) {
+    assert_notnull(vec);
+    assert_nonempty(vec);
+    return vec->_values;
+}
+
+inline void* vec_val_get_last(const VecVal* vec) {
+    assert_notnull(vec);
+    assert_nonempty(vec);
+    return VEC_VAL_GET(vec, vec->_size - 1);
+}
+
+void vec_val_set(VecVal* vec, ptrdiff_t index, const void* value) {
+    assert_notnull(vec);
+    assert_nonempty(vec);
+    assert_notnull(value);
+    assert_valid_index(vec, index);
+    void* p = VEC_VAL_GET(vec, index);
+    if (vec->_destroy)
+        vec->_destroy(p);
+    memcpy(p, value, vec->_elem_size);
+}
+
+void vec_val_insert(VecVal* vec, ptrdiff_t index, const void* value) {
+    assert_notnull(vec);
+    assert_notnull(value);
+    assert_valid_index(vec, index);
+    vec_val_open_gap(vec, index, 1);
+    memcpy(VEC_VAL_GET(vec, index), value, vec->_elem_size);
+}
+
+void vec_val_insert_n(VecVal* vec, ptrdiff_t index, ptrdiff_t n,
+                      const void* value,
+                      void (*cpy)(void* dst, const void* src)) {
+    assert_notnull(vec);
+    assert_notnull(value);
+    assert_valid_range(vec, index, 0);
+    assert(n >= 0 && "can't insert a negative number of values");
+    vec_val_open_gap(vec, index, n);
+    for (ptrdiff_t i = index; i < index + n; ++i) {
+        if (cpy)
+            cpy(VEC_VAL_GET(vec, i), value);
+        else
+            memcpy(VEC_VAL_GET(vec, i), value, vec->_elem_size);
+    }
+}
+
+void vec_val_insert_range(VecVal* vec, ptrdiff_t index, const void* values,
+                          ptrdiff_t n) {
+    assert_notnull(vec);
+    assert_valid_range(vec, index, 0);
+    assert(n >= 0 && "can't insert a negative number of values");
+    if (n) {
+        assert_notnull(values);
+        vec_val_open_gap(vec, index, n);
+        memcpy(VEC_VAL_GET(vec, index), values,
+               (size_t)n * vec->_elem_size);
+    }
+}
+
+void vec_val_insert_vec(VecVal* vec1, ptrdiff_t index, const VecVal* vec2,
+                        void (*cpy)(void* dst, const void* src)) {
+    assert_notnull(vec1);
+    assert_notnull(vec2);
+    assert(vec1 != vec2 && "can't insert a vec into itself");
+    assert(vec1->_elem_size == vec2->_elem_size && "incompatible vecs");
+    if (!cpy) {
+        vec_val_insert_range(vec1, index, vec2->_values, vec2->_size);
+        return;
+    }
+    assert_valid_range(vec1, index, 0);
+    vec_val_open_gap(vec1, index, vec2->_size);
+    for (ptrdiff_t i = 0; i < vec2->_size; ++i)
+        cpy(VEC_VAL_GET(vec1, index + i), VEC_VAL_GET(vec2, i));
+}
+
+inline void vec_val_append_array(VecVal* vec, const void* values,
+                                 ptrdiff_t n) {
+    assert_notnull(vec);
+    vec_val_insert_range(vec, vec->_size, values, n);
+}
+
+void vec_val_add(VecVal* vec, const void* value) {
+    assert_notnull(vec);
+    assert_notnull(value);
+    ptrdiff_t high = vec->_size - 1;
+    if (!vec->_size || vec->_cmp(VEC_VAL_GET(vec, high), value) <= 0)
+        vec_val_push(vec,
+                     value); // VecVal is empty -or- value >= high
+    else {
+        ptrdiff_t low = 0;
+        while (low < high) {
+            ptrdiff_t mid = (low + high) / 2;
+            if (vec->_cmp(VEC_VAL_GET(vec, mid), value) > 0)
+                high = mid;
+            else
+                low = mid + 1;
+        }
+        vec_val_insert(vec, low, value);
+    }
+}
+
+void vec_val_add_many(VecVal* vec, const void* values, ptrdiff_t n,
+                      bool unique) {
+    assert_notnull(vec);
+    assert(n >= 0 && "can't add a negative number of values");
+    if (!n)
+        return;
+    assert_notnull(values);
+    const int SIZE = vec->_elem_size;
+    char* batch = malloc((size_t)n * SIZE);
+    assert_alloc(batch);
+    memcpy(batch, values, (size_t)n * SIZE);
+    qsort(batch, n, SIZE, vec->_cmp);
+    if (unique)
+        n = vec_val_unique_batch(vec, batch, n);
+    if (vec->_size + n > vec->_cap)
+        vec_val_grow(vec, vec->_size + n);
+    // Merge from the back; equal values go after those already present
+    ptrdiff_t i = vec->_size - 1;
+    ptrdiff_t k = vec->_size + n - 1;
+    for (ptrdiff_t j = n - 1; j >= 0; --k) {
+        if (i >= 0 && vec->_cmp(VEC_VAL_GET(vec, i), batch + j * SIZE) > 0)
+            memcpy(VEC_VAL_GET(vec, k), VEC_VAL_GET(vec, i--), SIZE);
+        else
+            memcpy(VEC_VAL_GET(vec, k), batch + j-- * SIZE, SIZE);
+    }
+    vec->_size += n;
+    free(batch);
+}
+
+void vec_val_replace(VecVal* vec, ptrdiff_t index, const void* value,
+                     void* old) {
+    assert_notnull(vec);
+    assert_nonempty(vec);
+    assert_notnull(value);
+    assert_notnull(old);
+    assert_valid_index(vec, index);
+    void* p = VEC_VAL_GET(vec, index);
+    memcpy(old, p, vec->_elem_size);
+    memcpy(p, value, vec->_elem_size);
+}
+
+void vec_val_remove(VecVal* vec, ptrdiff_t index) {
+    assert_notnull(vec);
+    assert_nonempty(vec);
+    assert_valid_index(vec, index);
+    if (vec->_destroy)
+        vec->_destroy(VEC_VAL_GET(vec, index));
+    vec_val_close_gap(vec, index, 1);
+}
+
+void vec_val_remove_range(VecVal* vec, ptrdiff_t index, ptrdiff_t n) {
+    assert_notnull(vec);
+    assert_valid_range(vec, index, n);
+    if (vec->_destroy)
+        for (ptrdiff_t i = index; i < index + n; ++i)
+            vec->_destroy(VEC_VAL_GET(vec, i));
+    vec_val_close_gap(vec, index, n);
+}
+
+void vec_val_swap_remove(VecVal* vec, ptrdiff_t index) {
+    assert_notnull(vec);
+    assert_nonempty(vec);
+    assert_valid_index(vec, index);
+    void* p = VEC_VAL_GET(vec, index);
+    if (vec->_destroy)
+        vec->_destroy(p);
+    if (index != --vec->_size)
+        memcpy(p, VEC_VAL_GET(vec, vec->_size), vec->_elem_size);
+}
+
+ptrdiff_t vec_val_retain(VecVal* vec,
+                         bool (*pred)(const void* value, void* state),
+                         void* state) {
+    assert_notnull(vec);
+    assert_notnull(pred);
+    ptrdiff_t j = 0;
+    for (ptrdiff_t i = 0; i < vec->_size; ++i) {
+        void* p = VEC_VAL_GET(vec, i);
+        if (pred(p, state)) {
+            if (i != j)
+                memcpy(VEC_VAL_GET(vec, j), p, vec->_elem_size);
+            ++j;
+        } else if (vec->_destroy)
+            vec->_destroy(p);
+    }
+    ptrdiff_t removed = vec->_size - j;
+    vec->_size = j;
+    return removed;
+}
+
+void vec_val_take(VecVal* vec, ptrdiff_t index, void* value) {
+    assert_notnull(vec);
+    assert_nonempty(vec);
+    assert_notnull(value);
+    assert_valid_index(vec, index);
+    memcpy(value, VEC_VAL_GET(vec, index), vec->_elem_size);
+    vec_val_close_gap(vec, index, 1);
+}
+
+void vec_val_pop(VecVal* vec, void* value) {
+    assert_notnull(vec);
+    assert_nonempty(vec);
+    assert_notnull(value);
+    memcpy(value, VEC_VAL_GET(vec, --vec->_size), vec->_elem_size);
+}
+
+void vec_val_push(VecVal* vec, const void* value) {
+    assert_notnull(vec);
+    assert_notnull(value);
+    if (vec->_size == vec->_cap)
+        vec_val_grow(vec, vec->_size + 1);
+    memcpy(VEC_VAL_GET(vec, vec->_size++), value, vec->_elem_size);
+}
+
+VecVal vec_val_copy(const VecVal* vec,
+                    void (*cpy)(void* dst, const void* src)) {
+    assert_notnull(vec);
+    VecVal out = vec_val_alloc(vec->_size, vec->_elem_size, vec->_cmp,
+                               vec->_destroy);
+    out._growth = vec->_growth;
+    if (!vec->_size)
+        return out;
+    if (cpy)
+        for (ptrdiff_t i = 0; i < vec->_size; ++i)
+            cpy(VEC_VAL_GET(&out, i), VEC_VAL_GET(vec, i));
+    else
+        memcpy(out._values, vec->_values,
+               (size_t)vec->_size * vec->_elem_size);
+    out._size = vec->_size;
+    return out;
+}
+
+void vec_val_merge(VecVal* vec1, VecVal* vec2) {
+    assert_notnull(vec1);
+    assert_notnull(vec2);
+    assert(vec1->_elem_size == vec2->_elem_size &&
+           vec1->_cmp == vec2->_cmp && vec1->_destroy == vec2->_destroy &&
+           "incompatible vecs");
+    if ((vec1->_cap - vec1->_size) <
+        vec2->_size) // vec1 doesn't have enough cap
+        vec_val_set_cap(vec1, vec1->_size + vec2->_size);
+    if (vec2->_size)
+        memcpy(VEC_VAL_GET(vec1, vec1->_size), vec2->_values,
+               (size_t)vec2->_size * vec2->_elem_size);
+    vec1->_size += vec2->_size;
+    // we do *not* destroy vec2's values since they are now owned by vec1
+    vec_buffer_free(vec2->_values, (size_t)vec2->_cap * vec2->_elem_size,
+                    vec2->_large);
+    vec2->_values = NULL;
+    vec2->_large = false;
+    vec2->_cap = 0;
+    vec2->_size = 0;
+    vec2->_destroy = NULL;
+}
+
+bool vec_val_equal(const VecVal* vec1, const VecVal* vec2) {
+    assert_notnull(vec1);
+    assert_notnull(vec2);
+    if (vec1->_size != vec2->_size)
+        return false;
+    for (ptrdiff_t i = 0; i < vec1->_size; ++i)
+        if (vec1->_cmp(VEC_VAL_GET(vec1, i), VEC_VAL_GET(vec2, i)))
+            return false;
+    return true;
+}
+
+bool vec_val_same(const VecVal* vec1, const VecVal* vec2) {
+    assert_notnull(vec1);
+    assert_notnull(vec2);
+    if (vec1->_elem_size != vec2->_elem_size ||
+        vec1->_cmp != vec2->_cmp || vec1->_destroy != vec2->_destroy)
+        return false;
+    return vec_val_equal(vec1, vec2);
+}
+
+ptrdiff_t vec_val_find(const VecVal* vec, const void* value) {
+    assert_notnull(vec);
+    assert_notnull(value);
+    for (ptrdiff_t i = 0; i < vec->_size; ++i)
+        if (vec->_cmp(VEC_VAL_GET(vec, i), value) == 0)
+            return i;
+    return VEC_NOT_FOUND;
+}
+
+ptrdiff_t vec_val_find_last(const VecVal* vec, const void* value) {
+    assert_notnull(vec);
+    assert_notnull(value);
+    for (ptrdiff_t i = vec->_size - 1; i >= 0; --i)
+        if (vec->_cmp(VEC_VAL_GET(vec, i), value) == 0)
+            return i;
+    return VEC_NOT_FOUND;
+}
+
+void vec_val_sort(VecVal* vec) {
+    assert_notnull(vec);
+    if (vec->_size)
+        qsort(vec->_values, vec->_size, vec->_elem_size, vec->_cmp);
+}
+
+ptrdiff_t vec_val_search(const VecVal* vec, const void* value) {
+    assert_notnull(vec);
+    assert_notnull(value);
+    if (vec->_size) {
+        char* p = bsearch(value, vec->_values, vec->_size,
+                          vec->_elem_size, vec->_cmp);
+        if (p)
+            return (p - vec->_values) / vec->_elem_size;
+    }
+    return VEC_NOT_FOUND;
+}
+
+static void vec_val_grow(VecVal* vec, ptrdiff_t needed) {
+    assert((!vec->_cap && !vec->_values) || (vec->_cap && vec->_values));
+    vec_val_set_cap(vec, vec_grow_cap(&vec->_growth, vec->_cap, needed));
+}
+
+static void vec_val_set_cap(VecVal* vec, ptrdiff_t cap) {
+    assert(cap >= vec->_size && "can't reduce cap below size");
+    vec->_values = vec_buffer_resize(
+        vec->_values, (size_t)vec->_size * vec->_elem_size,
+        (size_t)vec->_cap * vec->_elem_size, (size_t)cap * vec->_elem_size,
+        vec->_growth.large, &vec->_large);
+    vec->_cap = cap;
+}
+
+static void vec_val_open_gap(VecVal* vec, ptrdiff_t index, ptrdiff_t n) {
+    if (!n)
+        return;
+    if (vec->_size + n > vec->_cap)
+        vec_val_grow(vec, vec->_size + n);
+    char* p = VEC_VAL_GET(vec, index);
+    memmove(p + n * vec->_elem_size, p,
+            (size_t)(vec->_size - index) * vec->_elem_size);
+    vec->_size += n;
+}
+
+static void vec_val_close_gap(VecVal* vec, ptrdiff_t index, ptrdiff_t n) {
+    if (!n)
+        return;
+    char* p = VEC_VAL_GET(vec, index);
+    memmove(p, p + n * vec->_elem_size,
+            (size_t)(vec->_size - index - n) * vec->_elem_size);
+    vec->_size -= n;
+}
+
+// Drops (and if destroy is not NULL, destroys) values from the sorted
+// batch that are repeats or are already in the vec, and returns the
+// batch's new size.
+static ptrdiff_t vec_val_unique_batch(const VecVal* vec, char* batch,
+                                     ptrdiff_t n) {
+    const int SIZE = vec->_elem_size;
+    ptrdiff_t i = 0;
+    ptrdiff_t k = 0;
+    for (ptrdiff_t j = 0; j < n; ++j) {
+        char* p = batch + j * SIZE;
+        while (i < vec->_size && vec->_cmp(VEC_VAL_GET(vec, i), p) < 0)
+            ++i;
+        if ((k && vec->_cmp(batch + (k - 1) * SIZE, p) == 0) ||
+            (i < vec->_size && vec->_cmp(VEC_VAL_GET(vec, i), p) == 0)) {
+            if (vec->_destroy)
+                vec->_destroy(p);
+            continue;
+        }
+        if (k != j)
+            memcpy(batch + k * SIZE, p, SIZE);
+        ++k;
+    }
+    return k;
+}
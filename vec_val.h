@@ -0,0 +1,211 @@
+// Copyright © 2024-25 Mark Summerfield. All rights reserved.
+// License: GPL-3
+#pragma once
+
+#include "cx.h"
+#include "vecs.h"
+#include <stdbool.h>
+
+// A vector of values of any one (fixed size) type stored by value in a
+// single contiguous buffer, so there is no per-value malloc() and no
+// pointer to chase to reach a value.
+// All accesses via functions, but _reading_ via VEC_VAL_GET() is okay.
+// See vecs.h for size and capacity macros.
+//
+// Unlike Vec, the cmp function is given pointers to the values
+// themselves (e.g., `const Tag*`, not `const Tag**`), and destroy (if
+// not NULL) is only used to free a value's _contents_ (e.g., a Tag's
+// name), since the values themselves live in the VecVal's buffer. See
+// tag_test.h's tag_val_cmp and vec_val_test.c for examples.
+//
+// Values are copied in and out bitwise, so after pushing (or inserting
+// etc.) a value, the VecVal owns whatever the value's fields point to.
+//
+// To iterate:
+// ```
+//  for (ptrdiff_t i = 0; i < VEC_SIZE(vec); ++i)
+//      const MyType* value = VEC_VAL_GET(vec, i);
+// ```
+typedef struct VecVal {
+    ptrdiff_t _size; // This is "end", i.e., one past the last value
+    ptrdiff_t _cap;  // The size of the allocated array
+    int _elem_size;  // The size of each value, e.g., sizeof(MyType)
+    char* _values;
+    int (*_cmp)(const void*, const void*);
+    void (*_destroy)(void* value);
+    VecGrowth _growth; // See VEC_SET_GROWTH()
+    bool _large;       // _values is in large mode (see VecGrowth)
+} VecVal;
+
+// Fast unchecked access to (a pointer to) an element in a VecVal.
+#define VEC_VAL_GET(vec, index) \
+    ((void*)((vec)->_values + (index) * (vec)->_elem_size))
+
+// Allocates a new VecVal of values of elem_size bytes each with the given
+// capacity which may be 0.
+// Caller must supply cmp to compare values (for find, sort, and search),
+// and if the values own memory (e.g., a char* field), destroy to free a
+// value's contents.
+VecVal vec_val_alloc(ptrdiff_t cap, int elem_size,
+                     int (*cmp)(const void*, const void*),
+                     void (*destroy)(void* value));
+
+// Destroys the VecVal freeing its memory and if destroy is not NULL,
+// also destroying every value. The VecVal is not usable after this.
+void vec_val_free(VecVal* vec);
+
+// Calls destroy on all the VecVal's values if destroy is not NULL.
+void vec_val_clear(VecVal* vec);
+
+// Ensures the VecVal's capacity is at least cap, e.g., before pushing a
+// known number of values.
+void vec_val_reserve(VecVal* vec, ptrdiff_t cap);
+
+// Reduces the VecVal's capacity to its size, freeing any unused memory.
+void vec_val_shrink_to_fit(VecVal* vec);
+
+// Resizes the VecVal to the given size, either truncating it (destroying
+// the removed values) or padding it with copies of value made with cpy,
+// or if cpy is NULL, bitwise.
+void vec_val_resize(VecVal* vec, ptrdiff_t size, const void* value,
+                    void (*cpy)(void* dst, const void* src));
+
+// Returns a pointer to the VecVal's value at position index. The pointer
+// is only valid until the VecVal is next changed.
+// VecVal retains ownership, so do not destroy the value.
+// The VEC_VAL_GET() macro is faster but unchecked.
+void* vec_val_get(const VecVal* vec, ptrdiff_t index);
+
+// Returns a pointer to the VecVal's value at its first valid index.
+// VecVal retains ownership, so do not destroy the value.
+void* vec_val_get_first(const VecVal* vec);
+
+// Returns a pointer to the VecVal's value at its last valid index.
+// VecVal retains ownership, so do not destroy the value.
+void* vec_val_get_last(const VecVal* vec);
+
+// Sets the VecVal's value at position index to a copy of the given
+// value, destroying the old value first.
+void vec_val_set(VecVal* vec, ptrdiff_t index, const void* value);
+
+// Inserts a copy of the value at position index and moves succeeding
+// values up (right), increasing the VecVal's size (and cap if
+// necessary): O(n).
+// Use add to insert into a sorted VecVal, or push to insert at the end of
+// an unsorted VecVal.
+void vec_val_insert(VecVal* vec, ptrdiff_t index, const void* value);
+
+// Inserts n copies of value (made with cpy, or if cpy is NULL, bitwise)
+// at position index (which may be VEC_SIZE(vec) to append) and moves
+// succeeding values up (right) in a single move, increasing the VecVal's
+// size (and cap if necessary): O(n).
+void vec_val_insert_n(VecVal* vec, ptrdiff_t index, ptrdiff_t n,
+                      const void* value,
+                      void (*cpy)(void* dst, const void* src));
+
+// Inserts bitwise copies of the n values from the values array at
+// position index (which may be VEC_SIZE(vec) to append) and moves
+// succeeding values up (right) in a single move: O(n). The values must
+// not be in the VecVal itself.
+void vec_val_insert_range(VecVal* vec, ptrdiff_t index, const void* values,
+                          ptrdiff_t n);
+
+// Inserts copies (made with cpy, or if cpy is NULL, bitwise) of all
+// vec2's values into vec1 at position index (which may be VEC_SIZE(vec1)
+// to append): O(n). vec2 is unchanged.
+void vec_val_insert_vec(VecVal* vec1, ptrdiff_t index, const VecVal* vec2,
+                        void (*cpy)(void* dst, const void* src));
+
+// Appends bitwise copies of the n values from the values array,
+// increasing the VecVal's size (and cap if necessary): O(n). The values
+// must not be in the VecVal itself.
+void vec_val_append_array(VecVal* vec, const void* values, ptrdiff_t n);
+
+// Adds a copy of the value in order (in a sorted VecVal) and moves
+// succeeding values up (right), increasing the VecVal's size (and cap if
+// necessary): O(n).
+void vec_val_add(VecVal* vec, const void* value);
+
+// Adds bitwise copies of the n values from the values array in order (in
+// a sorted VecVal) by sorting a copy of the array and merging it in a
+// single pass: O(n + m log m) rather than O(n·m) for m calls to
+// vec_val_add(). If unique is true, values already in the VecVal or
+// repeated in the array are not added (and if destroy is not NULL, are
+// destroyed).
+void vec_val_add_many(VecVal* vec, const void* values, ptrdiff_t n,
+                      bool unique);
+
+// Sets the VecVal's value at position index to a copy of the given value
+// and copies the old value from that position into old, which the
+// caller now owns.
+void vec_val_replace(VecVal* vec, ptrdiff_t index, const void* value,
+                     void* old);
+
+// Removes and, if destroy is not NULL, destroys the value at the given
+// index and closes up the gap: O(n).
+void vec_val_remove(VecVal* vec, ptrdiff_t index);
+
+// Removes and, if destroy is not NULL, destroys the n values from
+// position index onwards and closes up the gap in a single move: O(n).
+void vec_val_remove_range(VecVal* vec, ptrdiff_t index, ptrdiff_t n);
+
+// Removes and, if destroy is not NULL, destroys the value at the given
+// index by moving the last value into its place, so the order is not
+// preserved: O(1).
+void vec_val_swap_remove(VecVal* vec, ptrdiff_t index);
+
+// Keeps only the values for which pred(value, state) returns true (where
+// value points to the value), preserving their order, and returns how
+// many values were removed (and destroyed if destroy is not NULL).
+// Uses a single pass: O(n).
+ptrdiff_t vec_val_retain(VecVal* vec,
+                         bool (*pred)(const void* value, void* state),
+                         void* state);
+
+// Copies the value at the given index into value (which the caller now
+// owns), and removes it closing up the gap: O(n).
+void vec_val_take(VecVal* vec, ptrdiff_t index, void* value);
+
+// Copies the last value into value (which the caller now owns) and
+// removes it. Only use if vec.isempty() is false: O(1).
+void vec_val_pop(VecVal* vec, void* value);
+
+// Pushes a copy of the value onto the end of the VecVal, increasing the
+// VecVal's size (and cap if necessary): O(1). Use vec_val_add() to insert
+// into a sorted VecVal.
+void vec_val_push(VecVal* vec, const void* value);
+
+// Returns a copy of the given VecVal using the given cpy function to
+// copy each value from src to dst, or if cpy is NULL, a bitwise copy
+// (which is only correct if the values own no memory).
+VecVal vec_val_copy(const VecVal* vec,
+                    void (*cpy)(void* dst, const void* src));
+
+// Moves all vec2's values to the end of vec1's values, after which vec2 is
+// freed and must not be used again.
+// Only callable if both vecs are compatible, i.e., they have matching
+// _elem_size, _cmp(), and _destroy().
+void vec_val_merge(VecVal* vec1, VecVal* vec2);
+
+// Returns true if the two VecVal's have the same values.
+bool vec_val_equal(const VecVal* vec1, const VecVal* vec2);
+
+// Returns true if the two VecVal's have the same values and the same cmp
+// and destroy.
+bool vec_val_same(const VecVal* vec1, const VecVal* vec2);
+
+// Returns the index where the value was found in the VecVal or
+// VEC_NOT_FOUND (-1). Uses a linear search.
+ptrdiff_t vec_val_find(const VecVal* vec, const void* value);
+
+// Returns the last index where the value was found in the VecVal or
+// VEC_NOT_FOUND (-1). Uses a linear search.
+ptrdiff_t vec_val_find_last(const VecVal* vec, const void* value);
+
+// Sorts the VecVal in-place using the cmp function.
+void vec_val_sort(VecVal* vec);
+
+// Returns the index where the value was found in the VecVal or
+// VEC_NOT_FOUND (-1). Uses a binary search that assumes vec_val_sort()
+// has been used.
+ptrdiff_t vec_val_search(const VecVal* vec, const void* value);
@@ -0,0 +1,344 @@
+// Copyright © 2024-25 Mark Summerfield. All rights reserved.
+// License: GPL-3
+
+#include "vec_val_test.h"
+#include "exit.h"
+#include "str.h"
+#include "tag_test.h"
+#include "vec_val.h"
+#include "vecs_test.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static Tag make(void);
+static void check_size_cap(tinfo* tinfo, const VecVal* v,
+                           ptrdiff_t size, ptrdiff_t cap);
+static void match(tinfo* tinfo, const VecVal* v, const char* expected);
+static void merge_tests(tinfo*);
+static void sort_tests(tinfo*);
+static void misc_tests(tinfo* tinfo);
+static void range_tests(tinfo* tinfo);
+static bool has_odd_id(const void* value, void* state);
+static void add_many_tests(tinfo* tinfo);
+
+void vec_val_tests(tinfo* tinfo) {
+    if (tinfo->verbose)
+        puts(tinfo->tag);
+    merge_tests(tinfo);
+    sort_tests(tinfo);
+    misc_tests(tinfo);
+    range_tests(tinfo);
+    add_many_tests(tinfo);
+}
+
+static void misc_tests(tinfo* tinfo) {
+    tinfo->tag = "vec_val_tests misc_tests";
+    if (tinfo->verbose)
+        puts(tinfo->tag);
+    tag_make(true);
+    VecVal v1 = vec_val_alloc(5, sizeof(Tag), tag_val_cmp, tag_free);
+    check_size_cap(tinfo, &v1, 0, 5);
+
+    VecVal v2 = vec_val_copy(&v1, tag_val_copy);
+    check_size_cap(tinfo, &v2, 0, 0);
+    vec_val_free(&v2);
+
+    for (int i = 0; i < 7; ++i) {
+        Tag tag = make();
+        vec_val_push(&v1, &tag);
+    }
+    check_size_cap(tinfo, &v1, 7, 10);
+    match(tinfo, &v1, "Aa#100|Ab#101|Ac#102|Ad#103|Ae#104|Af#105|Ag#106");
+
+    v2 = vec_val_copy(&v1, tag_val_copy);
+    check_size_cap(tinfo, &v2, 7, 7);
+    match(tinfo, &v2, "Aa#100|Ab#101|Ac#102|Ad#103|Ae#104|Af#105|Ag#106");
+    check_bool_eq(tinfo, vec_val_equal(&v1, &v2), true);
+    check_bool_eq(tinfo, vec_val_same(&v1, &v2), true);
+    // deep copy so the names must be distinct
+    check_bool_eq(tinfo,
+                  ((Tag*)VEC_VAL_GET(&v1, 0))->name ==
+                      ((Tag*)VEC_VAL_GET(&v2, 0))->name,
+                  false);
+
+    Tag t1;
+    vec_val_pop(&v1, &t1);
+    check_str_eq(tinfo, t1.name, "Ag#106");
+    check_int_eq(tinfo, t1.id, 106);
+    tag_free(&t1);
+    check_size_cap(tinfo, &v1, 6, 10);
+    match(tinfo, &v1, "Aa#100|Ab#101|Ac#102|Ad#103|Ae#104|Af#105");
+    check_bool_eq(tinfo, vec_val_equal(&v1, &v2), false);
+
+    const Tag* t2 = vec_val_get_first(&v1);
+    check_str_eq(tinfo, t2->name, "Aa#100");
+    check_int_eq(tinfo, t2->id, 100);
+    t2 = vec_val_get_last(&v1);
+    check_str_eq(tinfo, t2->name, "Af#105");
+    check_int_eq(tinfo, t2->id, 105);
+    t2 = vec_val_get(&v1, 2);
+    check_str_eq(tinfo, t2->name, "Ac#102");
+    check_int_eq(tinfo, t2->id, 102);
+    t2 = VEC_VAL_GET(&v1, 3);
+    check_str_eq(tinfo, t2->name, "Ad#103");
+    check_int_eq(tinfo, t2->id, 103);
+
+    t1 = make();
+    vec_val_set(&v1, 0, &t1);
+    t1 = make();
+    vec_val_set(&v1, VEC_SIZE(&v1) - 1, &t1);
+    check_size_cap(tinfo, &v1, 6, 10);
+    match(tinfo, &v1, "Ah#107|Ab#101|Ac#102|Ad#103|Ae#104|Ai#108");
+
+    Tag old;
+    t1 = make();
+    vec_val_replace(&v1, 2, &t1, &old);
+    check_str_eq(tinfo, old.name, "Ac#102");
+    tag_free(&old);
+    match(tinfo, &v1, "Ah#107|Ab#101|Aj#109|Ad#103|Ae#104|Ai#108");
+
+    t1 = make();
+    vec_val_insert(&v1, 0, &t1);
+    t1 = make();
+    vec_val_insert(&v1, 3, &t1);
+    check_size_cap(tinfo, &v1, 8, 10);
+    match(tinfo, &v1,
+          "Ak#110|Ah#107|Ab#101|Al#111|Aj#109|Ad#103|Ae#104|Ai#108");
+
+    vec_val_remove(&v1, 0);
+    match(tinfo, &v1, "Ah#107|Ab#101|Al#111|Aj#109|Ad#103|Ae#104|Ai#108");
+    vec_val_remove(&v1, VEC_SIZE(&v1) - 1);
+    match(tinfo, &v1, "Ah#107|Ab#101|Al#111|Aj#109|Ad#103|Ae#104");
+    vec_val_take(&v1, 2, &t1);
+    check_str_eq(tinfo, t1.name, "Al#111");
+    tag_free(&t1);
+    check_size_cap(tinfo, &v1, 5, 10);
+    match(tinfo, &v1, "Ah#107|Ab#101|Aj#109|Ad#103|Ae#104");
+
+    Tag key = tag_make_key("Zz#999");
+    vec_val_resize(&v1, 7, &key, tag_val_copy);
+    check_size_cap(tinfo, &v1, 7, 10);
+    match(tinfo, &v1, "Ah#107|Ab#101|Aj#109|Ad#103|Ae#104|Zz#999|Zz#999");
+    vec_val_resize(&v1, 4, NULL, NULL);
+    vec_val_shrink_to_fit(&v1);
+    check_size_cap(tinfo, &v1, 4, 4);
+    match(tinfo, &v1, "Ah#107|Ab#101|Aj#109|Ad#103");
+    vec_val_reserve(&v1, 10);
+    check_size_cap(tinfo, &v1, 4, 10);
+
+    vec_val_clear(&v1);
+    check_size_cap(tinfo, &v1, 0, 10);
+    vec_val_free(&v1);
+    check_size_cap(tinfo, &v1, 0, 0);
+    vec_val_clear(&v2);
+    check_size_cap(tinfo, &v2, 0, 7);
+    vec_val_free(&v2);
+    check_size_cap(tinfo, &v2, 0, 0);
+}
+
+static void range_tests(tinfo* tinfo) {
+    tinfo->tag = "vec_val_tests range_tests";
+    if (tinfo->verbose)
+        puts(tinfo->tag);
+    tag_make(true);
+    VecVal v1 = vec_val_alloc(0, sizeof(Tag), tag_val_cmp, tag_free);
+    Tag tags[] = {make(), make(), make()};
+    vec_val_append_array(&v1, tags, 3); // v1 now owns the names
+    match(tinfo, &v1, "Aa#100|Ab#101|Ac#102");
+    Tag key = tag_make_key("x");
+    vec_val_insert_n(&v1, 1, 2, &key, tag_val_copy);
+    match(tinfo, &v1, "Aa#100|x|x|Ab#101|Ac#102");
+    Tag more[] = {make(), make()};
+    vec_val_insert_range(&v1, VEC_SIZE(&v1), more, 2);
+    match(tinfo, &v1, "Aa#100|x|x|Ab#101|Ac#102|Ad#103|Ae#104");
+    vec_val_remove_range(&v1, 1, 2); // destroys the x's
+    match(tinfo, &v1, "Aa#100|Ab#101|Ac#102|Ad#103|Ae#104");
+    check_size_cap(tinfo, &v1, 5, VEC_INITIAL_CAP);
+
+    VecVal v2 = vec_val_alloc(0, sizeof(Tag), tag_val_cmp, tag_free);
+    Tag tag = make();
+    vec_val_push(&v2, &tag);
+    vec_val_insert_vec(&v2, 0, &v1, tag_val_copy);
+    match(tinfo, &v2, "Aa#100|Ab#101|Ac#102|Ad#103|Ae#104|Af#105");
+    vec_val_remove_range(&v2, 2, 3);
+    match(tinfo, &v2, "Aa#100|Ab#101|Af#105");
+    vec_val_take(&v2, 0, &tag);
+    check_str_eq(tinfo, tag.name, "Aa#100");
+    vec_val_insert(&v2, 1, &tag);
+    match(tinfo, &v2, "Ab#101|Aa#100|Af#105");
+    vec_val_remove(&v2, 2);
+    match(tinfo, &v2, "Ab#101|Aa#100");
+    vec_val_free(&v2);
+
+    check_int_eq(tinfo, vec_val_retain(&v1, has_odd_id, NULL), 3);
+    match(tinfo, &v1, "Ab#101|Ad#103");
+    tag = make();
+    vec_val_push(&v1, &tag);
+    vec_val_swap_remove(&v1, 0);
+    match(tinfo, &v1, "Ag#106|Ad#103");
+    vec_val_swap_remove(&v1, 1);
+    match(tinfo, &v1, "Ag#106");
+    vec_val_free(&v1);
+}
+
+static void add_many_tests(tinfo* tinfo) {
+    tinfo->tag = "vec_val_tests add_many_tests";
+    if (tinfo->verbose)
+        puts(tinfo->tag);
+    VecVal v1 = vec_val_alloc(0, sizeof(Tag), tag_val_cmp, tag_free);
+    Tag a[] = {{strdup("m"), 1}, {strdup("c"), 2}};
+    vec_val_add_many(&v1, a, 2, false);
+    Tag b[] = {{strdup("x"), 3}, {strdup("a"), 4}, {strdup("m"), 5}};
+    vec_val_add_many(&v1, b, 3, false);
+    match(tinfo, &v1, "a|c|m|m|x");
+    // equal values go after those already present
+    check_int_eq(tinfo, ((Tag*)VEC_VAL_GET(&v1, 3))->id, 5);
+    Tag c[] = {{strdup("c"), 6}, {strdup("d"), 7}, {strdup("d"), 8}};
+    vec_val_add_many(&v1, c, 3, true); // destroys c and one d
+    match(tinfo, &v1, "a|c|d|m|m|x");
+    check_int_eq(tinfo, ((Tag*)VEC_VAL_GET(&v1, 1))->id, 2);
+    vec_val_free(&v1);
+}
+
+static bool has_odd_id(const void* value, void* state) {
+    (void)state; // unused
+    return ((const Tag*)value)->id % 2;
+}
+
+static void merge_tests(tinfo* tinfo) {
+    tinfo->tag = "vec_val_tests merge_tests";
+    if (tinfo->verbose)
+        puts(tinfo->tag);
+    tag_make(true);
+    VecVal v1 = vec_val_alloc(7, sizeof(Tag), tag_val_cmp, tag_free);
+    for (int i = 0; i < 5; ++i) {
+        Tag tag = make();
+        vec_val_push(&v1, &tag);
+    }
+    check_size_cap(tinfo, &v1, 5, 7);
+    match(tinfo, &v1, "Aa#100|Ab#101|Ac#102|Ad#103|Ae#104");
+
+    VecVal v2 = vec_val_alloc(0, sizeof(Tag), tag_val_cmp, tag_free);
+    for (int i = 0; i < 6; ++i) {
+        Tag tag = make();
+        vec_val_push(&v2, &tag);
+    }
+    check_size_cap(tinfo, &v2, 6, VEC_INITIAL_CAP);
+    match(tinfo, &v2, "Af#105|Ag#106|Ah#107|Ai#108|Aj#109|Ak#110");
+
+    vec_val_merge(&v1, &v2);
+    match(tinfo, &v1,
+          "Aa#100|Ab#101|Ac#102|Ad#103|Ae#104|Af#105|Ag#106|Ah#107|Ai#"
+          "108|Aj#109|Ak#110");
+    check_size_cap(tinfo, &v1, 11, 11);
+    check_size_cap(tinfo, &v2, 0, 0);
+    // v2 already freed by vec_val_merge
+    vec_val_free(&v1);
+    check_size_cap(tinfo, &v1, 0, 0);
+}
+
+static void sort_tests(tinfo* tinfo) {
+    tinfo->tag = "vec_val_tests sort_tests";
+    if (tinfo->verbose)
+        puts(tinfo->tag);
+    tag_make(true);
+    VecVal v1 = vec_val_alloc(7, sizeof(Tag), tag_val_cmp, tag_free);
+    for (int i = 0; i < 5; ++i) {
+        Tag tag = make();
+        vec_val_push(&v1, &tag);
+    }
+    Tag tag = {strdup("Zz#999"), 999};
+    vec_val_insert(&v1, 0, &tag);
+    tag = (Tag){strdup("Ww#888"), 888};
+    vec_val_insert(&v1, 2, &tag);
+    tag = (Tag){strdup("Ae#005"), 5};
+    vec_val_insert(&v1, 4, &tag);
+    tag = (Tag){strdup("Aa#001"), 1};
+    vec_val_insert(&v1, 6, &tag);
+    check_size_cap(tinfo, &v1, 9, 14);
+    match(tinfo, &v1,
+          "Zz#999|Aa#100|Ww#888|Ab#101|Ae#005|Ac#102|Aa#001|Ad#103|Ae#104");
+
+    Tag key = tag_make_key("Ae#005");
+    check_found(tinfo, vec_val_find(&v1, &key), 4);
+    key.name = "Ae#104";
+    check_found(tinfo, vec_val_find(&v1, &key), 8);
+    check_found(tinfo, vec_val_find_last(&v1, &key), 8);
+    key.name = "Xy#000";
+    check_found(tinfo, vec_val_find(&v1, &key), VEC_NOT_FOUND);
+    check_found(tinfo, vec_val_find_last(&v1, &key), VEC_NOT_FOUND);
+
+    vec_val_sort(&v1);
+    check_size_cap(tinfo, &v1, 9, 14);
+    match(tinfo, &v1,
+          "Aa#001|Aa#100|Ab#101|Ac#102|Ad#103|Ae#005|Ae#104|Ww#888|Zz#999");
+
+    key.name = "Ae#005";
+    check_found(tinfo, vec_val_search(&v1, &key), 5);
+    key.name = "Zz#999";
+    check_found(tinfo, vec_val_search(&v1, &key), 8);
+    key.name = "Aa#001";
+    check_found(tinfo, vec_val_search(&v1, &key), 0);
+    key.name = "Xy#000";
+    check_found(tinfo, vec_val_search(&v1, &key), VEC_NOT_FOUND);
+
+    tag = (Tag){strdup("Aa#000"), 0};
+    vec_val_add(&v1, &tag);
+    tag = (Tag){strdup("zz#999"), 0};
+    vec_val_add(&v1, &tag);
+    tag = (Tag){strdup("Af#200"), 0};
+    vec_val_add(&v1, &tag);
+    tag = (Tag){strdup("Af#200"), 0};
+    vec_val_add(&v1, &tag);
+    match(tinfo, &v1,
+          "Aa#000|Aa#001|Aa#100|Ab#101|Ac#102|Ad#103|Ae#005|Ae#104|"
+          "Af#200|Af#200|Ww#888|Zz#999|zz#999");
+
+    vec_val_free(&v1);
+}
+
+// Returns a Tag by value; the Tag's name is owned by the caller.
+static Tag make(void) {
+    Tag* p = tag_make(false);
+    Tag tag = *p;
+    free(p);
+    return tag;
+}
+
+static void match(tinfo* tinfo, const VecVal* v, const char* expected) {
+    char buf[1000] = {0}; // guarantee start with NUL if VecVal is empty
+    int n = 0;
+    for (int i = 0; i < VEC_SIZE(v); ++i) {
+        const Tag* tag = vec_val_get(v, i);
+        n += sprintf(&buf[n], "%s|", tag->name);
+    }
+    if (n)
+        buf[n - 1] = 0;
+    check_str_eq(tinfo, &buf[0], expected);
+}
+
+static void check_size_cap(tinfo* tinfo, const VecVal* v,
+                           ptrdiff_t size, ptrdiff_t cap) {
+    tinfo->total++;
+    if (VEC_SIZE(v) != size)
+        WARN("FAIL: %s VEC_SIZE() expected %td != %td\n", tinfo->tag, size,
+             VEC_SIZE(v));
+    else
+        tinfo->ok++;
+
+    tinfo->total++;
+    if (VEC_ISEMPTY(v) != (size == 0))
+        WARN("FAIL: %s VEC_ISEMPTY() expected %s != %s size=%td\n",
+             tinfo->tag, bool_to_str(size == 0),
+             bool_to_str(VEC_ISEMPTY(v)), size);
+    else
+        tinfo->ok++;
+
+    tinfo->total++;
+    if (VEC_CAP(v) != cap)
+        WARN("FAIL: %s VEC_CAP() expected %td != %td\n", tinfo->tag, cap,
+             VEC_CAP(v));
+    else
+        tinfo->ok++;
+}
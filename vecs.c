@@ -0,0 +1,138 @@
+// Copyright © 2024-25 Mark Summerfield. All rights reserved.
+// License: GPL-3
+
+#define _GNU_SOURCE // for mremap
+#include "vecs.h"
+#include "cx.h"
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+
+static void* large_resize(void* values, ptrdiff_t size, ptrdiff_t cap,
+                          ptrdiff_t new_cap);
+static void large_free(void* values, ptrdiff_t cap);
+static void* map_alloc(ptrdiff_t len);
+static void* map_resize(void* values, ptrdiff_t size, ptrdiff_t len,
+                        ptrdiff_t new_len);
+static ptrdiff_t round_up(ptrdiff_t n, ptrdiff_t multiple);
+
+ptrdiff_t vec_grow_cap(const VecGrowth* growth, ptrdiff_t cap,
+                       ptrdiff_t needed) {
+    assert_notnull(growth);
+    if (growth->exact)
+        return needed > cap ? needed : cap;
+    ptrdiff_t new_cap;
+    if (!cap)
+        new_cap = VEC_INITIAL_CAP;
+    else {
+        double factor = growth->factor > 1.0 ? growth->factor : 2.0;
+        double step = cap * (factor - 1.0);
+        if (growth->max_step > 0 && step > growth->max_step)
+            step = growth->max_step;
+        if (step >= (double)(PTRDIFF_MAX - cap))
+            new_cap = PTRDIFF_MAX; // saturate
+        else
+            new_cap = cap + (step < 1.0 ? 1 : (ptrdiff_t)step);
+    }
+    return new_cap < needed ? needed : new_cap;
+}
+
+void* vec_buffer_resize(void* values, ptrdiff_t size, ptrdiff_t cap,
+                        ptrdiff_t new_cap, bool large, bool* is_large) {
+    assert_notnull(is_large);
+    assert(0 <= size && size <= cap && size <= new_cap && "invalid sizes");
+    if (large == *is_large) {
+        if (large)
+            return large_resize(values, size, cap, new_cap);
+        if (!new_cap) {
+            free(values);
+            return NULL;
+        }
+        void* p = realloc(values, new_cap);
+        assert_alloc(p);
+        return p;
+    }
+    void* p = NULL;
+    if (new_cap) {
+        p = large ? large_resize(NULL, 0, 0, new_cap) : malloc(new_cap);
+        assert_alloc(p);
+        if (size)
+            memcpy(p, values, size);
+    }
+    vec_buffer_free(values, cap, *is_large);
+    *is_large = large;
+    return p;
+}
+
+void vec_buffer_free(void* values, ptrdiff_t cap, bool is_large) {
+    if (is_large)
+        large_free(values, cap);
+    else
+        free(values);
+}
+
+// Small buffers are aligned heap blocks, so changing their cap means
+// copying them (aligned_alloc() has no realloc()); big ones are mappings
+// whose pages mremap() can move and extend without copying.
+static void* large_resize(void* values, ptrdiff_t size, ptrdiff_t cap,
+                          ptrdiff_t new_cap) {
+    bool mapped = cap >= VEC_LARGE_MAP_MIN;
+    bool new_mapped = new_cap >= VEC_LARGE_MAP_MIN;
+    if (mapped && new_mapped)
+        return map_resize(values, size, round_up(cap, VEC_LARGE_MAP_MIN),
+                          round_up(new_cap, VEC_LARGE_MAP_MIN));
+    void* p = NULL;
+    if (new_mapped)
+        p = map_alloc(round_up(new_cap, VEC_LARGE_MAP_MIN));
+    else if (new_cap) {
+        p = aligned_alloc(VEC_LARGE_ALIGN,
+                          round_up(new_cap, VEC_LARGE_ALIGN));
+        assert_alloc(p);
+    }
+    if (size)
+        memcpy(p, values, size);
+    large_free(values, cap);
+    return p;
+}
+
+static void large_free(void* values, ptrdiff_t cap) {
+    if (values && cap >= VEC_LARGE_MAP_MIN)
+        munmap(values, round_up(cap, VEC_LARGE_MAP_MIN));
+    else
+        free(values);
+}
+
+static void* map_alloc(ptrdiff_t len) {
+    void* p = mmap(NULL, len, PROT_READ | PROT_WRITE,
+                   MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    assert(p != MAP_FAILED && "failed to acquire memory");
+#ifdef MADV_HUGEPAGE
+    madvise(p, len, MADV_HUGEPAGE); // only advice so failure is harmless
+#endif
+    return p;
+}
+
+static void* map_resize(void* values, ptrdiff_t size, ptrdiff_t len,
+                        ptrdiff_t new_len) {
+    if (new_len == len)
+        return values;
+#ifdef MREMAP_MAYMOVE
+    (void)size; // the kernel moves the pages, used or not
+    void* p = mremap(values, len, new_len, MREMAP_MAYMOVE);
+    assert(p != MAP_FAILED && "failed to acquire memory");
+#ifdef MADV_HUGEPAGE
+    if (new_len > len)
+        madvise(p, new_len, MADV_HUGEPAGE);
+#endif
+#else
+    void* p = map_alloc(new_len);
+    memcpy(p, values, size);
+    munmap(values, len);
+#endif
+    return p;
+}
+
+static ptrdiff_t round_up(ptrdiff_t n, ptrdiff_t multiple) {
+    return (n + multiple - 1) / multiple * multiple;
+}
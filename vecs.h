@@ -3,6 +3,8 @@
 #pragma once
 
 #include <assert.h>
+#include <stdbool.h>
+#include <stddef.h>
 
 // The index returned by `vec…find()` methods when the value can't be
 // found.
@@ -12,6 +14,10 @@
 // they are first grown to this size.
 #define VEC_INITIAL_CAP 16
 
+// The number of values a SmallVecInt or SmallVecStr holds before it
+// allocates.
+#define VEC_SMALL_CAP 8
+
 // Returns true if the Vec is empty.
 #define VEC_ISEMPTY(vec) ((vec)->_size == 0)
 
@@ -34,12 +40,70 @@
 #define assert_valid_index(vec, index) \
     assert(0 <= (index) && (index) < (vec)->_size && "index out of range")
 
+// Used for the n values from index; an index of _size with n of 0 is
+// valid (e.g., to insert at the end).
+#define assert_valid_range(vec, index, n)                                \
+    assert(0 <= (index) && 0 <= (n) && (index) + (n) <= (vec)->_size && \
+           "invalid range")
+
 #define assert_nonempty(vec) assert((vec)->_size && "empty vec");
 
-/* The initial vec cap is 0 (unless specified). On the first add,
-   insert, or push on cap 0, cap goes to VEC_INITIAL_CAP, then doubles
-   each time until it exceeds 1MB, then grows by 1MB each time the cap
-   is reached.
-*/
-#define VEC_GROW_CAP(cap) \
-    (!(cap) ? VEC_INITIAL_CAP : (cap) < 1048576 ? (cap)*2 : (cap) + 1048576)
+// A vector's growth policy, i.e., how its capacity increases when it
+// needs more room. The initial vec cap is 0 (unless specified). On the
+// first add, insert, or push on cap 0, cap goes to VEC_INITIAL_CAP, then
+// is multiplied by factor each time the cap is reached, but never by more
+// than max_step (if max_step > 0). If exact is true, cap grows to exactly
+// the size needed (which is best combined with a `*_reserve()` call).
+// If large is true, the vector's values are kept in large mode (from
+// the next time its cap changes): aligned to VEC_LARGE_ALIGN bytes so
+// that SIMD code can rely on it and, from VEC_LARGE_MAP_MIN bytes, in
+// their own memory mapping (advised to use transparent huge pages on
+// Linux) that grows by remapping its pages rather than copying them.
+// A zeroed VecGrowth is the same as VEC_GROWTH_DEFAULT.
+// See also VEC_SET_GROWTH() and vec_grow_cap().
+typedef struct VecGrowth {
+    double factor;      // e.g., 2.0 or 1.5; <= 1.0 means 2.0
+    ptrdiff_t max_step; // 0 means unlimited
+    bool exact;
+    bool large; // for vectors that may grow to many MB
+} VecGrowth;
+
+// The default growth policy: start at VEC_INITIAL_CAP then double.
+#define VEC_GROWTH_DEFAULT \
+    ((VecGrowth){.factor = 2.0, .max_step = 0, .exact = false})
+
+// The default growth policy but in large mode.
+#define VEC_GROWTH_LARGE \
+    ((VecGrowth){.factor = 2.0, .max_step = 0, .large = true})
+
+// The alignment (a cache line) of a large mode vector's values.
+#define VEC_LARGE_ALIGN 64
+
+// The size in bytes (a huge page) from which a large mode vector's
+// values are kept in their own memory mapping, whose size is rounded up
+// to a multiple of this. Below it they're aligned heap blocks.
+#define VEC_LARGE_MAP_MIN ((ptrdiff_t)1 << 21)
+
+// Returns the vector's growth policy.
+#define VEC_GROWTH(vec) ((vec)->_growth)
+
+// Sets the vector's growth policy for subsequent growth, e.g.,
+// `VEC_SET_GROWTH(&vec, ((VecGrowth){.factor = 1.5}));`
+#define VEC_SET_GROWTH(vec, growth) ((vec)->_growth = (growth))
+
+// Returns the capacity a vector with the given growth policy and current
+// cap should grow to so that it can hold at least needed values.
+ptrdiff_t vec_grow_cap(const VecGrowth* growth, ptrdiff_t cap,
+                       ptrdiff_t needed);
+
+// For vector implementations: returns values (a buffer of cap bytes, in
+// large mode if *is_large, of which the first size bytes are used)
+// resized to new_cap bytes (NULL if new_cap is 0), keeping the used
+// bytes. If large differs from *is_large the buffer is moved to or from
+// large mode and *is_large is set to large.
+void* vec_buffer_resize(void* values, ptrdiff_t size, ptrdiff_t cap,
+                        ptrdiff_t new_cap, bool large, bool* is_large);
+
+// For vector implementations: frees values (a buffer of cap bytes, in
+// large mode if is_large, as returned by vec_buffer_resize()).
+void vec_buffer_free(void* values, ptrdiff_t cap, bool is_large);
@@ -0,0 +1,361 @@
+// Copyright © 2024-25 Mark Summerfield. All rights reserved.
+// License: GPL-3
+
+#include "vecs_bench.h"
+#include "vec_int.h"
+#include "vec_str.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static void push_benchmarks(binfo* binfo);
+static void push_benchmark(binfo* binfo, const char* name,
+                           VecGrowth growth, int n, bool reserve);
+static void range_benchmarks(binfo* binfo);
+static void range_benchmark(binfo* binfo, int n, int k, bool ranged);
+static void retain_benchmarks(binfo* binfo);
+static void retain_benchmark(binfo* binfo, int n, bool retain);
+static bool is_even_length(const char* value, void* state);
+static void add_many_benchmarks(binfo* binfo);
+static void add_many_benchmark(binfo* binfo, int n, int m, bool many);
+static void small_benchmarks(binfo* binfo);
+static void small_int_benchmark(binfo* binfo, int n, bool small);
+static void small_split_benchmark(binfo* binfo, int n, bool small);
+static void lazy_split_benchmark(binfo* binfo, int n, bool lazy);
+static void large_benchmarks(binfo* binfo);
+static void large_grow_benchmark(binfo* binfo, int n, bool large);
+static void large_random_benchmark(binfo* binfo, int n, bool large);
+static void packed_benchmarks(binfo* binfo);
+static void packed_benchmark(binfo* binfo, int n, bool packed);
+
+void vecs_benchmarks(binfo* binfo) {
+    push_benchmarks(binfo);
+    range_benchmarks(binfo);
+    retain_benchmarks(binfo);
+    add_many_benchmarks(binfo);
+    small_benchmarks(binfo);
+    large_benchmarks(binfo);
+    packed_benchmarks(binfo);
+}
+
+static void push_benchmarks(binfo* binfo) {
+    const int MAX_N = binfo->quick ? 1000000 : 100000000;
+    for (int n = 100000; n <= MAX_N; n *= 10) {
+        push_benchmark(binfo, "push x2 (default)", VEC_GROWTH_DEFAULT, n,
+                       false);
+        push_benchmark(binfo, "push x1.5", (VecGrowth){.factor = 1.5}, n,
+                       false);
+        // The growth policy used before VecGrowth was added.
+        push_benchmark(binfo, "push x2 then +1M",
+                       (VecGrowth){.factor = 2.0, .max_step = 1048576}, n,
+                       false);
+        push_benchmark(binfo, "push exact + reserve",
+                       (VecGrowth){.exact = true}, n, true);
+        push_benchmark(binfo, "push x2 large", VEC_GROWTH_LARGE, n,
+                       false);
+    }
+}
+
+static void push_benchmark(binfo* binfo, const char* name,
+                           VecGrowth growth, int n, bool reserve) {
+    double begin = bench_now();
+    VecInt vec = vec_int_alloc();
+    VEC_SET_GROWTH(&vec, growth);
+    if (reserve)
+        vec_int_reserve(&vec, n);
+    for (int i = 0; i < n; ++i)
+        vec_int_push(&vec, i);
+    vec_int_free(&vec);
+    bench_report(binfo, name, n, bench_now() - begin, "");
+}
+
+static void range_benchmarks(binfo* binfo) {
+    const int N = binfo->quick ? 100000 : 1000000;
+    for (int k = 10; k <= 10000; k *= 10) {
+        range_benchmark(binfo, N, k, false);
+        range_benchmark(binfo, N, k, true);
+    }
+}
+
+// Removes then reinserts k values from the middle of a VecInt of n values
+// either one at a time or as a single range.
+static void range_benchmark(binfo* binfo, int n, int k, bool ranged) {
+    VecInt vec = vec_int_alloc_cap(n);
+    for (int i = 0; i < n; ++i)
+        vec_int_push(&vec, i);
+    VecInt saved = vec_int_alloc_cap(k);
+    const int INDEX = n / 2;
+    double begin = bench_now();
+    if (ranged) {
+        vec_int_append_array(&saved, &VEC_GET(&vec, INDEX), k);
+        vec_int_remove_range(&vec, INDEX, k);
+        vec_int_insert_range(&vec, INDEX, saved._values, k);
+    } else {
+        for (int i = 0; i < k; ++i)
+            vec_int_push(&saved, vec_int_take(&vec, INDEX));
+        for (int i = k - 1; i >= 0; --i)
+            vec_int_insert(&vec, INDEX, VEC_GET(&saved, i));
+    }
+    double secs = bench_now() - begin;
+    char name[64];
+    snprintf(name, sizeof(name), "%s %d of %d",
+             ranged ? "remove+insert range" : "take+insert x1", k, n);
+    bench_report(binfo, name, k, secs, "");
+    vec_int_free(&saved);
+    vec_int_free(&vec);
+}
+
+static void retain_benchmarks(binfo* binfo) {
+    const int MAX_N = binfo->quick ? 100000 : 10000000;
+    for (int n = 10000; n <= MAX_N; n *= 10) {
+        if (n <= 100000) // quadratic so only for small n
+            retain_benchmark(binfo, n, false);
+        retain_benchmark(binfo, n, true);
+    }
+}
+
+// Drops the odd length strings from an owning VecStr of n strings either
+// by repeated vec_str_remove() or by a single vec_str_retain().
+static void retain_benchmark(binfo* binfo, int n, bool retain) {
+    VecStr vec = vec_str_alloc_custom(n, Owns);
+    uint64_t seed = 1;
+    char buf[16] = "abcdefghijklmno";
+    for (int i = 0; i < n; ++i)
+        vec_str_push(&vec, strndup(buf, 1 + bench_rand(&seed) % 15));
+    double begin = bench_now();
+    if (retain)
+        vec_str_retain(&vec, is_even_length, NULL);
+    else
+        for (ptrdiff_t i = VEC_SIZE(&vec) - 1; i >= 0; --i)
+            if (!is_even_length(VEC_GET(&vec, i), NULL))
+                vec_str_remove(&vec, i);
+    double secs = bench_now() - begin;
+    bench_report(binfo, retain ? "VecStr retain" : "VecStr remove x1", n,
+                 secs, "");
+    vec_str_free(&vec);
+}
+
+static bool is_even_length(const char* value, void* state) {
+    (void)state; // unused
+    return strlen(value) % 2 == 0;
+}
+
+static void add_many_benchmarks(binfo* binfo) {
+    const int N = binfo->quick ? 100000 : 1000000;
+    for (int m = 100; m <= 100000; m *= 10) {
+        add_many_benchmark(binfo, N, m, false);
+        add_many_benchmark(binfo, N, m, true);
+    }
+}
+
+// Adds a batch of m random values to a sorted VecInt of n values either
+// one at a time or all at once.
+static void add_many_benchmark(binfo* binfo, int n, int m, bool many) {
+    uint64_t seed = 1;
+    VecInt vec = vec_int_alloc_cap(n + m);
+    for (int i = 0; i < n; ++i)
+        vec_int_push(&vec, i * 2);
+    int* batch = malloc(m * sizeof(int));
+    for (int i = 0; i < m; ++i)
+        batch[i] = bench_rand(&seed) % (n * 2);
+    double begin = bench_now();
+    if (many)
+        vec_int_add_many(&vec, batch, m, false);
+    else
+        for (int i = 0; i < m; ++i)
+            vec_int_add(&vec, batch[i]);
+    double secs = bench_now() - begin;
+    char name[64];
+    snprintf(name, sizeof(name), "%s %d to %d",
+             many ? "add_many" : "add x1", m, n);
+    bench_report(binfo, name, m, secs, "");
+    free(batch);
+    vec_int_free(&vec);
+}
+
+static void small_benchmarks(binfo* binfo) {
+    const int N = binfo->quick ? 100000 : 1000000;
+    small_int_benchmark(binfo, N, false);
+    small_int_benchmark(binfo, N, true);
+    small_split_benchmark(binfo, N, false);
+    small_split_benchmark(binfo, N, true);
+    lazy_split_benchmark(binfo, N, false);
+    lazy_split_benchmark(binfo, N, true);
+}
+
+// Makes n short-lived vecs of a few ints each, as VecInts or
+// SmallVecInts; rates are of vecs.
+static void small_int_benchmark(binfo* binfo, int n, bool small) {
+    int64_t sum = 0; // so the vecs can't be optimized away
+    double begin = bench_now();
+    for (int i = 0; i < n; ++i) {
+        SmallVecInt small_vec;
+        VecInt heap_vec;
+        VecInt* vec = &heap_vec;
+        if (small) {
+            small_vec_int_init(&small_vec);
+            vec = &small_vec.vec;
+        } else
+            heap_vec = vec_int_alloc();
+        for (int j = 0; j < 2 + i % 5; ++j)
+            vec_int_push(vec, i + j);
+        sum += VEC_GET_LAST(vec);
+        vec_int_free(vec);
+    }
+    bench_report(binfo,
+                 small ? "SmallVecInt 2-6 pushes" : "VecInt 2-6 pushes", n,
+                 bench_now() - begin, "");
+    if (sum == 42)
+        puts("");
+}
+
+// Splits n short lines into words (as a tokenizer might) with
+// split_ws() or into a reused SmallVecStr; rates are of lines.
+static void small_split_benchmark(binfo* binfo, int n, bool small) {
+    const char* LINES[] = {"alpha beta gamma", "delta epsilon",
+                           "zeta eta theta iota kappa", "lambda"};
+    int64_t sum = 0;
+    double begin = bench_now();
+    for (int i = 0; i < n; ++i) {
+        const char* line = LINES[i % 4];
+        if (small) {
+            SmallVecStr words;
+            small_vec_str_init(&words, Owns);
+            vec_str_append_split_ws(&words.vec, line);
+            sum += VEC_SIZE(&words.vec);
+            vec_str_free(&words.vec);
+        } else {
+            VecStr words = split_ws(line);
+            sum += VEC_SIZE(&words);
+            vec_str_free(&words);
+        }
+    }
+    bench_report(binfo, small ? "SmallVecStr split_ws" : "VecStr split_ws",
+                 n, bench_now() - begin, "");
+    if (sum == 42)
+        puts("");
+}
+
+// Parses n log lines for their level (the third field) with split_ws()
+// or with a lazy str_split_ws() that stops after the third part; rates
+// are of lines.
+static void lazy_split_benchmark(binfo* binfo, int n, bool lazy) {
+    const char* LINES[] = {
+        "2025-01-31 12:00:03 INFO server.c:123 request handled in 5ms",
+        "2025-01-31 12:00:04 WARN pool.c:88 pool at 90% capacity "
+        "(45 of 50 connections in use)",
+        "2025-01-31 12:00:04 ERROR db.c:301 query failed: timeout",
+        "2025-01-31 12:00:05 INFO server.c:123 request handled in 7ms"};
+    int64_t errors = 0;
+    double begin = bench_now();
+    for (int i = 0; i < n; ++i) {
+        const char* line = LINES[i % 4];
+        if (lazy) {
+            StrSplit split = str_split_ws(line);
+            StrView parts[3];
+            if (str_split_views(&split, parts, 3) == 3 &&
+                str_view_eq(parts[2], str_view("ERROR")))
+                errors++;
+        } else {
+            VecStr parts = split_ws(line);
+            if (VEC_SIZE(&parts) >= 3 &&
+                str_eq(VEC_GET(&parts, 2), "ERROR"))
+                errors++;
+            vec_str_free(&parts);
+        }
+    }
+    bench_report(binfo,
+                 lazy ? "log level str_split_ws" : "log level split_ws", n,
+                 bench_now() - begin, "");
+    if (errors != n / 4 + (n % 4 > 2))
+        fprintf(stderr, "FAIL: %s log level errors %" PRId64 "\n",
+                binfo->tag, errors);
+}
+
+// Compares default and large mode vecs of n ints (1GB for the full run):
+// growing them a few MB at a time (where realloc() may copy but mremap()
+// needn't) and then reading them at random (where huge pages, if the
+// kernel provides them, mean far fewer TLB misses).
+static void large_benchmarks(binfo* binfo) {
+    const int N = binfo->quick ? 4000000 : 256000000;
+    large_grow_benchmark(binfo, N, false);
+    large_grow_benchmark(binfo, N, true);
+    large_random_benchmark(binfo, N, false);
+    large_random_benchmark(binfo, N, true);
+}
+
+// Rates are of ints appended.
+static void large_grow_benchmark(binfo* binfo, int n, bool large) {
+    const int STEP = 1048576;
+    VecInt vec = vec_int_alloc();
+    VEC_SET_GROWTH(&vec, ((VecGrowth){.exact = true, .large = large}));
+    double begin = bench_now();
+    for (int i = 0; i < n; i += STEP)
+        vec_int_resize(&vec, i + STEP < n ? i + STEP : n, i);
+    bench_report(binfo,
+                 large ? "grow by 4MB large" : "grow by 4MB (default)", n,
+                 bench_now() - begin, "");
+    vec_int_free(&vec);
+}
+
+// Rates are of reads.
+static void large_random_benchmark(binfo* binfo, int n, bool large) {
+    VecInt vec = vec_int_alloc();
+    VEC_SET_GROWTH(&vec, ((VecGrowth){.large = large}));
+    vec_int_resize(&vec, n, 1);
+    const int READS = 10000000;
+    uint64_t seed = 1;
+    int64_t sum = 0;
+    double begin = bench_now();
+    for (int i = 0; i < READS; ++i)
+        sum += VEC_GET(&vec, bench_rand(&seed) % (uint64_t)n);
+    bench_report(binfo,
+                 large ? "random reads large" : "random reads (default)",
+                 READS, bench_now() - begin, "");
+    if (sum == 42)
+        puts("");
+    vec_int_free(&vec);
+}
+
+// Compares owning and packed VecStrs of n short lines (as
+// file_read_lines() makes) being loaded, split, and freed.
+static void packed_benchmarks(binfo* binfo) {
+    const int N = binfo->quick ? 1000000 : 10000000;
+    packed_benchmark(binfo, N, false);
+    packed_benchmark(binfo, N, true);
+}
+
+// Rates are of lines, which are taken from a pool of POOL_SIZE random
+// ones so that making them doesn't dominate the timings.
+static void packed_benchmark(binfo* binfo, int n, bool packed) {
+    const char* WORDS[] = {"alpha", "beta", "gamma", "delta", "epsilon",
+                           "zeta", "eta", "theta"};
+    enum { POOL_SIZE = 4096, LINE_SIZE = 40 };
+    static char pool[POOL_SIZE][LINE_SIZE];
+    int sizes[POOL_SIZE];
+    uint64_t seed = 1;
+    for (int i = 0; i < POOL_SIZE; ++i) {
+        uint64_t r = bench_rand(&seed);
+        sizes[i] = snprintf(pool[i], LINE_SIZE, "%s %d %s", WORDS[r % 8],
+                            (int)(r >> 40), WORDS[(r >> 8) % 8]);
+    }
+    VecStr lines =
+        packed ? vec_str_alloc_packed(0) : vec_str_alloc_custom(0, Owns);
+    double begin = bench_now();
+    for (int i = 0; i < n; ++i)
+        vec_str_push_n(&lines, pool[i % POOL_SIZE], sizes[i % POOL_SIZE]);
+    bench_report(binfo, packed ? "load lines packed" : "load lines owned",
+                 n, bench_now() - begin, "");
+    VecStr words =
+        packed ? vec_str_alloc_packed(0) : vec_str_alloc_custom(0, Owns);
+    begin = bench_now();
+    for (int i = 0; i < n; ++i)
+        vec_str_append_split_ws(&words, VEC_GET(&lines, i));
+    bench_report(binfo, packed ? "split lines packed" : "split lines owned",
+                 n, bench_now() - begin, "");
+    begin = bench_now();
+    vec_str_free(&words);
+    vec_str_free(&lines);
+    bench_report(binfo, packed ? "free lines packed" : "free lines owned",
+                 n, bench_now() - begin, "");
+}